@@ -0,0 +1,59 @@
+/*
+	*** Autosave Job
+	*** src/base/autosavejob.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/autosavejob.h"
+#include "base/tracer.h"
+#include <QtCore/QSemaphore>
+
+// Constructor
+AutosaveJob::AutosaveJob(const QuizSnapshot& snapshot, QString fileName, bool extractMedia, QSemaphore* slot) : QRunnable()
+{
+	snapshot_ = snapshot;
+	fileName_ = fileName;
+	extractMedia_ = extractMedia;
+	slot_ = slot;
+
+	// Nothing needs to be collected from the job, so it may be deleted by the thread pool as soon as it finishes
+	setAutoDelete(true);
+}
+
+// Destructor
+AutosaveJob::~AutosaveJob()
+{
+}
+
+/*
+ * Execution
+ */
+
+// Write snapshot (called from worker thread)
+void AutosaveJob::run()
+{
+	TRACESPAN("AutosaveJob::run");
+
+	// Media in an open bundle must be extracted, or the autosave will not be able to find them once the bundle is closed
+	if (extractMedia_) snapshot_.extractBundledMedia(fileName_);
+	snapshot_.write(fileName_);
+
+	// Free the snapshot before releasing our slot, so that only one is ever held by a job
+	snapshot_ = QuizSnapshot();
+	if (slot_) slot_->release();
+}
@@ -0,0 +1,63 @@
+/*
+	*** Autosave Job
+	*** src/base/autosavejob.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_AUTOSAVEJOB_H
+#define QUAPP_AUTOSAVEJOB_H
+
+#include "base/quizsnapshot.h"
+#include <QtCore/QRunnable>
+#include <QtCore/QString>
+
+// Forward Declarations
+class QSemaphore;
+
+// Autosave Job
+class AutosaveJob : public QRunnable
+{
+	public:
+	// Constructor / Destructor
+	AutosaveJob(const QuizSnapshot& snapshot, QString fileName, bool extractMedia, QSemaphore* slot);
+	~AutosaveJob();
+
+
+	/*
+	 * Job Data
+	 */
+	private:
+	// Snapshot to write
+	QuizSnapshot snapshot_;
+	// Filename to write to
+	QString fileName_;
+	// Whether bundled media are to be extracted alongside the file
+	bool extractMedia_;
+	// Semaphore marking an autosave in progress (released when the job finishes)
+	QSemaphore* slot_;
+
+
+	/*
+	 * Execution
+	 */
+	public:
+	// Write snapshot (called from worker thread)
+	void run();
+};
+
+#endif
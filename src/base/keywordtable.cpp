@@ -0,0 +1,74 @@
+/*
+	*** Keyword Table
+	*** src/base/keywordtable.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/keywordtable.h"
+#include <string.h>
+#include <stdio.h>
+
+// Constructor
+KeywordTable::KeywordTable(const char** keywords, int nKeywords)
+{
+	keywords_ = keywords;
+	nKeywords_ = nKeywords;
+	for (int n=0; n<nSlots_; ++n) slots_[n] = -1;
+
+	if (nKeywords_ > nSlots_)
+	{
+		printf("Internal Error: Too many keywords (%i) for KeywordTable.\n", nKeywords_);
+		nKeywords_ = nSlots_;
+	}
+
+	// Insert keywords, probing forwards from the hashed slot if it is already taken
+	int slot;
+	for (int n=0; n<nKeywords_; ++n)
+	{
+		lengths_[n] = strlen(keywords_[n]);
+		slot = hash(keywords_[n], lengths_[n]);
+		while (slots_[slot] != -1) slot = (slot+1) & (nSlots_-1);
+		slots_[slot] = n;
+	}
+}
+
+/*
+ * Table
+ */
+
+// Return slot for text specified
+int KeywordTable::hash(const char* text, int length)
+{
+	if (length == 0) return 0;
+	return (length*8 + (unsigned char) text[0] + (unsigned char) text[length-1]*3) & (nSlots_-1);
+}
+
+// Return index of keyword matching text specified, or the number of keywords if there is no match
+int KeywordTable::find(const char* text, int length) const
+{
+	int slot = hash(text, length), index;
+	for (int n=0; n<nSlots_; ++n)
+	{
+		index = slots_[slot];
+		if (index == -1) break;
+		if ((lengths_[index] == length) && (memcmp(keywords_[index], text, length) == 0)) return index;
+		slot = (slot+1) & (nSlots_-1);
+	}
+
+	return nKeywords_;
+}
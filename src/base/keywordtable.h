@@ -0,0 +1,66 @@
+/*
+	*** Keyword Table
+	*** src/base/keywordtable.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_KEYWORDTABLE_H
+#define QUAPP_KEYWORDTABLE_H
+
+// Forward Declarations
+/* none */
+
+/*!
+ * \brief Keyword Table
+ * \details Fixed-size hash table mapping keyword text to its index in a keyword array, without creating any strings. The hash uses only
+ * the length and the first and last characters, and is chosen so that each of the quiz file keyword sets fills distinct slots - a
+ * lookup is then a single slot check and one comparison. Collisions from keywords added later are still resolved (by probing), just
+ * not for free.
+ */
+class KeywordTable
+{
+	public:
+	// Constructor
+	KeywordTable(const char** keywords, int nKeywords);
+
+
+	/*
+	 * Table
+	 */
+	private:
+	// Number of slots in table (must be a power of two, and at least the number of keywords)
+	static const int nSlots_ = 32;
+	// Keyword array
+	const char** keywords_;
+	// Number of keywords
+	int nKeywords_;
+	// Length of each keyword
+	int lengths_[nSlots_];
+	// Keyword index held in each slot (-1 if empty)
+	int slots_[nSlots_];
+
+	private:
+	// Return slot for text specified
+	static int hash(const char* text, int length);
+
+	public:
+	// Return index of keyword matching text specified, or the number of keywords if there is no match
+	int find(const char* text, int length) const;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "base/messenger.h"
 #include <string.h>
 #include <stdarg.h>
+#include <stdio.h>
 
 // Constructors
 LineParser::LineParser(QString fileName, bool writeFile)
@@ -38,6 +39,9 @@ LineParser::LineParser(QString fileName, bool writeFile)
 	{
 		file_.open(QFile::WriteOnly);
 		if (file_.isOpen() && (file_.isWritable())) stream_ = new QTextStream(&file_);
+
+		// Quiz files are written as UTF-8, whatever the locale
+		if (stream_) stream_->setCodec("UTF-8");
 	}
 	else
 	{
@@ -103,17 +107,23 @@ bool LineParser::writeLineF(const char* fmt, ...)
 {
 	if ((!writing_) || (!stream_)) return false;
 
-	// Construct line
+	// Construct line - format into a local buffer, so that we are safe to call from more than one thread, moving to a larger one if necessary
 	va_list arguments;
-	static char s[8096];
-	s[0] = '\0';
-	// Parse the argument list (...) and internally write the output string into s[]
+	char buffer[8096];
 	va_start(arguments,fmt);
-	vsprintf(s,fmt,arguments);
+	int length = vsnprintf(buffer, sizeof(buffer), fmt, arguments);
 	va_end(arguments);
+	if (length < 0) return false;
+	if (length < (int) sizeof(buffer)) (*stream_) << buffer;
+	else
+	{
+		QByteArray line(length, '\0');
+		va_start(arguments,fmt);
+		vsnprintf(line.data(), length+1, fmt, arguments);
+		va_end(arguments);
+		(*stream_) << line.constData();
+	}
 
-	(*stream_) << s;
-	
 	return true;
 }
 
@@ -139,7 +149,6 @@ bool LineParser::skipLines(int nSkip)
 bool LineParser::getNextArg(int optionMask, QString& destArg)
 {
 	// Get the next input chunk from the internal string and put into argument specified.
-	msg.enter("LineParser::getNextArg");
 	bool done, hadquotes;
 	QChar c, quotechar;
 	done = false;
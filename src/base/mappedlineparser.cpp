@@ -0,0 +1,263 @@
+/*
+	*** Memory-Mapped Line Parser
+	*** src/base/mappedlineparser.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mappedlineparser.h"
+#include "base/messenger.h"
+#include <QtCore/QTextCodec>
+#include <string.h>
+#include <stdio.h>
+
+// Constructor
+MappedLineParser::MappedLineParser(QString fileName) : file_(fileName)
+{
+	map_ = NULL;
+	ready_ = false;
+	position_ = NULL;
+	end_ = NULL;
+	nArgs_ = 0;
+	scratch_ = NULL;
+	scratchSize_ = 0;
+	lineNumber_ = 0;
+	arguments_.resize(8);
+
+	if (!file_.open(QIODevice::ReadOnly))
+	{
+		msg.print("Error: Couldn't open file '%s' for reading.\n", qPrintable(fileName));
+		return;
+	}
+	ready_ = true;
+
+	// Map the file if we can, or read it in one go if we can't (or if it is empty, which can't be mapped)
+	qint64 size = file_.size();
+	if (size > 0) map_ = file_.map(0, size);
+	if (map_)
+	{
+		position_ = (const char*) map_;
+		end_ = position_ + size;
+	}
+	else
+	{
+		contents_ = file_.readAll();
+		position_ = contents_.constData();
+		end_ = position_ + contents_.size();
+	}
+
+	// Skip UTF-8 byte order mark, if present
+	if (((end_ - position_) >= 3) && (memcmp(position_, "\xEF\xBB\xBF", 3) == 0)) position_ += 3;
+}
+
+// Destructor
+MappedLineParser::~MappedLineParser()
+{
+	closeFiles();
+	delete[] scratch_;
+}
+
+/*
+ * Source
+ */
+
+// Close file
+void MappedLineParser::closeFiles()
+{
+	if (map_) file_.unmap(map_);
+	map_ = NULL;
+	contents_.clear();
+	file_.close();
+	position_ = NULL;
+	end_ = NULL;
+	nArgs_ = 0;
+}
+
+// Return whether the file is ready for use
+bool MappedLineParser::ready() const
+{
+	return ready_;
+}
+
+// Return whether the end of the file has been reached
+bool MappedLineParser::atEnd() const
+{
+	return (position_ >= end_);
+}
+
+/*
+ * Arguments
+ */
+
+// Extend view over the character specified, moving it to scratch space if the character is not contiguous with the rest of the argument
+void MappedLineParser::extendView(TextView& view, const char* c, bool& copied, char* scratch)
+{
+	if (view.length == 0) view.data = c;
+	else if ((!copied) && (view.data + view.length != c))
+	{
+		memcpy(scratch, view.data, view.length);
+		view.data = scratch;
+		copied = true;
+	}
+	if (copied) scratch[view.length] = *c;
+	++view.length;
+}
+
+// Parse arguments from line specified
+void MappedLineParser::parseLine(const char* line, const char* lineEnd)
+{
+	// Arguments assembled in scratch space are never longer than the line, so make sure there is room for them all
+	int lineLength = lineEnd - line;
+	if (lineLength > scratchSize_)
+	{
+		delete[] scratch_;
+		scratchSize_ = lineLength;
+		scratch_ = new char[scratchSize_];
+	}
+	char* scratch = scratch_;
+
+	nArgs_ = 0;
+	const char* c = line;
+	char quoteChar;
+	bool done, hadQuotes, copied, endOfLine = false;
+	TextView view;
+	while ((!endOfLine) && (c < lineEnd))
+	{
+		// Find next argument
+		view.data = NULL;
+		view.length = 0;
+		quoteChar = '\0';
+		done = false;
+		hadQuotes = false;
+		copied = false;
+		while (c < lineEnd)
+		{
+			switch (*c)
+			{
+				// End of line markers
+				case ('\n'):
+				case ('\r'):
+					done = true;
+					endOfLine = true;
+					break;
+				// Delimiters (unless quoted)
+				case (','):
+				case ('\t'):
+				case (' '):
+					if (quoteChar != '\0') extendView(view, c, copied, scratch);
+					else if (view.length != 0) done = true;
+					break;
+				// Quote marks
+				case ('"'):
+				case ('\''):
+					if (quoteChar == '\0') quoteChar = *c;
+					else if (quoteChar == *c)
+					{
+						hadQuotes = true;
+						done = true;
+					}
+					else extendView(view, c, copied, scratch);
+					break;
+				// Comment marker - rest of line is ignored
+				case ('#'):
+					done = true;
+					endOfLine = true;
+					break;
+				// Some other character
+				default:
+					extendView(view, c, copied, scratch);
+					break;
+			}
+
+			++c;
+			if (done) break;
+		}
+
+		// Store argument (quoted arguments are kept even if empty)
+		if ((view.length != 0) || hadQuotes)
+		{
+			if (nArgs_ == arguments_.size()) arguments_.resize(nArgs_*2);
+			if (view.length == 0) view.data = c;
+			arguments_[nArgs_++] = view;
+			if (copied) scratch += view.length;
+		}
+	}
+}
+
+// Read next non-blank line from file and parse its arguments, returning false at the end of the file
+bool MappedLineParser::getArgs()
+{
+	nArgs_ = 0;
+	while (position_ < end_)
+	{
+		// Find end of line
+		const char* lineEnd = (const char*) memchr(position_, '\n', end_ - position_);
+		if (!lineEnd) lineEnd = end_;
+		++lineNumber_;
+
+		parseLine(position_, lineEnd);
+		position_ = (lineEnd == end_ ? end_ : lineEnd+1);
+
+		if (nArgs_ > 0) return true;
+	}
+
+	return false;
+}
+
+// Return number of arguments parsed from the current line
+int MappedLineParser::nArgs() const
+{
+	return nArgs_;
+}
+
+// Return current line number
+int MappedLineParser::lineNumber() const
+{
+	return lineNumber_;
+}
+
+// Return view of specified argument
+const TextView& MappedLineParser::arg(int i) const
+{
+	static TextView dummy = { "NULL", 4 };
+	if ((i < 0) || (i >= nArgs_))
+	{
+		printf("Warning: Argument %i is out of range - returning \"NULL\"...\n", i);
+		return dummy;
+	}
+	return arguments_.at(i);
+}
+
+// Return specified argument as a QString (decoded as UTF-8, or in the locale's encoding if it is not valid UTF-8)
+QString MappedLineParser::argString(int i) const
+{
+	const TextView& view = arg(i);
+
+	// Files written by older versions are in the locale's encoding, which for non-ASCII text is rarely also valid UTF-8
+	static QTextCodec* utf8Codec = QTextCodec::codecForName("UTF-8");
+	QTextCodec::ConverterState state;
+	QString text = utf8Codec->toUnicode(view.data, view.length, &state);
+	if ((state.invalidChars == 0) && (state.remainingChars == 0)) return text;
+	return QTextCodec::codecForLocale()->toUnicode(view.data, view.length);
+}
+
+// Return specified argument as a double
+double MappedLineParser::argd(int i) const
+{
+	const TextView& view = arg(i);
+	return QByteArray::fromRawData(view.data, view.length).toDouble();
+}
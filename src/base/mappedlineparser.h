@@ -0,0 +1,119 @@
+/*
+	*** Memory-Mapped Line Parser
+	*** src/base/mappedlineparser.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MAPPEDLINEPARSER_H
+#define QUAPP_MAPPEDLINEPARSER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Forward Declarations
+/* none */
+
+// Text View (bytes from file, not null-terminated)
+struct TextView
+{
+	// Start of text
+	const char* data;
+	// Length of text (in bytes)
+	int length;
+};
+
+/*!
+ * \brief Memory-Mapped Line Parser
+ * \details Reads delimited arguments from a file in the same way as LineParser::getArgs() with UseQuotes and SkipBlanks, but over a
+ * memory-mapped copy of the file. Each argument is returned as a view onto the mapped bytes, with quote marks removed by
+ * viewing only the text between them, so no strings are created unless the caller asks for one. An argument whose characters are
+ * not contiguous in the file (e.g. one with quote marks part-way through) is assembled in a scratch buffer instead. Quiz files are
+ * written as UTF-8, but those written by older versions are in the locale's encoding, so text which is not valid UTF-8 is decoded
+ * with the locale's codec instead.
+ */
+class MappedLineParser
+{
+	public:
+	// Constructor / Destructor
+	MappedLineParser(QString fileName);
+	~MappedLineParser();
+
+
+	/*
+	 * Source
+	 */
+	private:
+	// Source file
+	QFile file_;
+	// Mapped file data (if the file could be mapped)
+	uchar* map_;
+	// File contents (if the file could not be mapped)
+	QByteArray contents_;
+	// Whether the file was opened successfully
+	bool ready_;
+	// Current read position, and end of data
+	const char* position_, *end_;
+
+	public:
+	// Close file
+	void closeFiles();
+	// Return whether the file is ready for use
+	bool ready() const;
+	// Return whether the end of the file has been reached
+	bool atEnd() const;
+
+
+	/*
+	 * Arguments
+	 */
+	private:
+	// Argument views for the current line (may be larger than the number of arguments)
+	QVector<TextView> arguments_;
+	// Number of arguments in the current line
+	int nArgs_;
+	// Scratch space for arguments which cannot be viewed in place
+	char* scratch_;
+	// Size of scratch space
+	int scratchSize_;
+	// Current line number
+	int lineNumber_;
+
+	private:
+	// Extend view over the character specified, moving it to scratch space if the character is not contiguous with the rest of the argument
+	static void extendView(TextView& view, const char* c, bool& copied, char* scratch);
+	// Parse arguments from line specified
+	void parseLine(const char* line, const char* lineEnd);
+
+	public:
+	// Read next non-blank line from file and parse its arguments, returning false at the end of the file
+	bool getArgs();
+	// Return number of arguments parsed from the current line
+	int nArgs() const;
+	// Return current line number
+	int lineNumber() const;
+	// Return view of specified argument
+	const TextView& arg(int i) const;
+	// Return specified argument as a QString (decoded as UTF-8, or in the locale's encoding if it is not valid UTF-8)
+	QString argString(int i) const;
+	// Return specified argument as a double
+	double argd(int i) const;
+};
+
+#endif
@@ -0,0 +1,428 @@
+/*
+	*** Media Bundle
+	*** src/base/mediabundle.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mediabundle.h"
+#include "base/mediaregistry.h"
+#include "base/messenger.h"
+#include "base/sysfunc.h"
+#include "base/tracer.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/qendian.h>
+#include <string.h>
+
+// Bundle Magic
+const char BundleMagic[] = { 'Q', 'A', 'P', 'Z' };
+
+// Size of bundle header (magic, version, number of entries, reserved, index offset)
+const int BundleHeaderSize = 24;
+
+// Bundle Path Prefix
+const char BundlePathPrefix[] = "bundle:";
+
+// Static Members
+QFile MediaBundle::file_;
+uchar* MediaBundle::map_ = NULL;
+QHash<QString,MediaBundleEntry> MediaBundle::entries_;
+
+/*
+ * Format
+ */
+
+// Return current format version
+int MediaBundle::version()
+{
+	return 1;
+}
+
+// Return standard file extension
+const char* MediaBundle::extension()
+{
+	return "qapz";
+}
+
+// Return name of quiz archive entry
+const char* MediaBundle::quizEntryName()
+{
+	return "quiz.qab";
+}
+
+// Return whether the specified file is a media bundle
+bool MediaBundle::isBundle(QString fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) return false;
+	char magic[4];
+	return ((file.read(magic, 4) == 4) && (memcmp(magic, BundleMagic, 4) == 0));
+}
+
+// Return whether the specified media filename refers to an entry in a bundle
+bool MediaBundle::isBundlePath(QString fileName)
+{
+	return fileName.startsWith(BundlePathPrefix);
+}
+
+// Return bundle path for entry with specified name
+QString MediaBundle::bundlePath(QString entryName)
+{
+	return BundlePathPrefix + entryName;
+}
+
+/*
+ * Open Bundle
+ */
+
+// Return entry for specified media filename (or NULL if there is none)
+const MediaBundleEntry* MediaBundle::entry(QString fileName)
+{
+	if ((!map_) || (!isBundlePath(fileName))) return NULL;
+	QHash<QString,MediaBundleEntry>::const_iterator it = entries_.constFind(fileName.mid(strlen(BundlePathPrefix)));
+	return (it == entries_.constEnd() ? NULL : &it.value());
+}
+
+// Open (and map) specified bundle, closing any other
+bool MediaBundle::open(QString fileName)
+{
+	TRACESPAN("MediaBundle::open");
+
+	close();
+
+	file_.setFileName(fileName);
+	if (!file_.open(QIODevice::ReadOnly))
+	{
+		msg.print("Error: Couldn't open file '%s' for reading.\n", qPrintable(fileName));
+		return false;
+	}
+	qint64 size = file_.size();
+	if (size >= BundleHeaderSize) map_ = file_.map(0, size);
+	if (!map_)
+	{
+		msg.print("Error: Couldn't map bundle '%s'.\n", qPrintable(fileName));
+		close();
+		return false;
+	}
+
+	// Check header
+	if ((memcmp(map_, BundleMagic, 4) != 0) || (qFromLittleEndian<quint32>(map_+4) > (quint32) version()))
+	{
+		msg.print("Error: File '%s' is not a bundle that can be read by this version.\n", qPrintable(fileName));
+		close();
+		return false;
+	}
+	quint32 nEntries = qFromLittleEndian<quint32>(map_+8);
+	quint64 indexOffset = qFromLittleEndian<quint64>(map_+16);
+
+	// Read index - each entry is the name length and name, followed by offset, size, and hash
+	const uchar* c = map_ + indexOffset, *end = map_ + size;
+	bool success = (indexOffset <= (quint64) size);
+	for (quint32 n=0; (n<nEntries) && success; ++n)
+	{
+		if (end - c < 4) success = false;
+		else
+		{
+			quint32 nameLength = qFromLittleEndian<quint32>(c);
+			c += 4;
+			if ((quint64) (end - c) < nameLength + 32) success = false;
+			else
+			{
+				QString name = QString::fromUtf8((const char*) c, nameLength);
+				c += nameLength;
+				MediaBundleEntry bundleEntry;
+				bundleEntry.offset = qFromLittleEndian<qint64>(c);
+				bundleEntry.size = qFromLittleEndian<qint64>(c+8);
+				bundleEntry.hash = QByteArray((const char*) c+16, 16);
+				c += 32;
+				if ((bundleEntry.offset < BundleHeaderSize) || (bundleEntry.size < 0) || (bundleEntry.offset > size) || (bundleEntry.size > size - bundleEntry.offset)) success = false;
+				else entries_.insert(name, bundleEntry);
+			}
+		}
+	}
+	if (!success)
+	{
+		msg.print("Error: Bundle '%s' has a damaged index.\n", qPrintable(fileName));
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+// Close current bundle
+void MediaBundle::close()
+{
+	// Images may be being decoded straight from the mapping (autosaves may also be reading it, so callers must wait for those)
+	if (map_) MediaRegistry::waitForPending();
+
+	if (map_) file_.unmap(map_);
+	map_ = NULL;
+	file_.close();
+	file_.setFileName(QString());
+	entries_.clear();
+}
+
+// Return filename of current bundle
+QString MediaBundle::fileName()
+{
+	return file_.fileName();
+}
+
+// Return offset and size of quiz archive entry in current bundle
+bool MediaBundle::quizEntry(qint64& offset, qint64& size)
+{
+	const MediaBundleEntry* quiz = entry(bundlePath(quizEntryName()));
+	if (!quiz) return false;
+	offset = quiz->offset;
+	size = quiz->size;
+	return true;
+}
+
+/*
+ * Media Access
+ */
+
+// Return whether the specified media file exists (in the current bundle, or on disk)
+bool MediaBundle::exists(QString fileName)
+{
+	if (fileName.isEmpty()) return false;
+	if (isBundlePath(fileName)) return (entry(fileName) != NULL);
+	return QFile::exists(fileName);
+}
+
+// Return content of specified media file (read directly from the mapped bundle, without copying, if it is bundled)
+QByteArray MediaBundle::data(QString fileName)
+{
+	if (isBundlePath(fileName))
+	{
+		const MediaBundleEntry* bundleEntry = entry(fileName);
+		return (bundleEntry ? QByteArray::fromRawData((const char*) map_ + bundleEntry->offset, bundleEntry->size) : QByteArray());
+	}
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+	return file.readAll();
+}
+
+// Return stored content hash for specified media file, if it is bundled
+QByteArray MediaBundle::contentHash(QString fileName)
+{
+	const MediaBundleEntry* bundleEntry = entry(fileName);
+	return (bundleEntry ? bundleEntry->hash : QByteArray());
+}
+
+// Return new (unopened) device from which the specified media file can be read
+QIODevice* MediaBundle::device(QString fileName)
+{
+	if (isBundlePath(fileName))
+	{
+		const MediaBundleEntry* bundleEntry = entry(fileName);
+		return (bundleEntry ? new MediaBundleStream(file_.fileName(), bundleEntry->offset, bundleEntry->size) : NULL);
+	}
+	return new QFile(fileName);
+}
+
+/*
+ * Output
+ */
+
+// Write bundle containing specified quiz archive data and media, given as source filenames keyed by entry name
+bool MediaBundle::write(QString fileName, QByteArray quizData, const QHash<QString,QString>& media)
+{
+	TRACESPAN("MediaBundle::write");
+
+	// Write to a temporary file first, since media may be being read from the bundle we are replacing
+	QString tempFileName = fileName + ".tmp";
+	QFile file(tempFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		msg.print("Error: Couldn't open file '%s' for writing.\n", qPrintable(tempFileName));
+		return false;
+	}
+
+	// Write placeholder header, then entry data, building the index as we go
+	QByteArray index;
+	uchar bytes[8];
+	bool success = (file.write(QByteArray(BundleHeaderSize, '\0')) == BundleHeaderSize);
+	int nEntries = 0;
+	QHash<QString,QString>::const_iterator it = media.constBegin();
+	for (int n=-1; (n<media.count()) && success; ++n)
+	{
+		QString name = (n == -1 ? QString(quizEntryName()) : it.key());
+		QByteArray entryData = (n == -1 ? quizData : data(it.value()));
+		if (n != -1)
+		{
+			if (!exists(it.value())) msg.print("Warning: Media file '%s' could not be read, and will be empty in the bundle.\n", qPrintable(it.value()));
+			++it;
+		}
+
+		QByteArray utf8Name = name.toUtf8();
+		qToLittleEndian<quint32>(utf8Name.size(), bytes);
+		index.append((const char*) bytes, 4);
+		index.append(utf8Name);
+		qToLittleEndian<qint64>(file.pos(), bytes);
+		index.append((const char*) bytes, 8);
+		qToLittleEndian<qint64>(entryData.size(), bytes);
+		index.append((const char*) bytes, 8);
+		index.append(QCryptographicHash::hash(entryData, QCryptographicHash::Md5));
+		++nEntries;
+
+		success = (file.write(entryData) == entryData.size());
+	}
+
+	// Write index, and fill in header
+	qint64 indexOffset = file.pos();
+	success = success && (file.write(index) == index.size());
+	QByteArray header(BundleMagic, 4);
+	quint32 headerValues[3] = { (quint32) version(), (quint32) nEntries, 0 };
+	for (int n=0; n<3; ++n)
+	{
+		qToLittleEndian<quint32>(headerValues[n], bytes);
+		header.append((const char*) bytes, 4);
+	}
+	qToLittleEndian<qint64>(indexOffset, bytes);
+	header.append((const char*) bytes, 8);
+	success = success && file.seek(0) && (file.write(header) == header.size());
+	success = success && file.flush();
+	file.close();
+
+	if (!success)
+	{
+		msg.print("Error: Failed to write bundle '%s'.\n", qPrintable(fileName));
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	// If we are replacing the open bundle it must be closed first, since a mapped file cannot be replaced on all platforms
+	bool reopen = map_ && (QFileInfo(fileName).absoluteFilePath() == QFileInfo(file_.fileName()).absoluteFilePath());
+	if (reopen) close();
+
+	// Replace the original file in one step - if this fails, the original is untouched and the new bundle is left in the temporary file
+	success = replaceFile(tempFileName, fileName);
+	if (!success) msg.print("Error: Failed to replace bundle '%s' - the new bundle has been left in '%s'.\n", qPrintable(fileName), qPrintable(tempFileName));
+
+	// Reopen whichever bundle is now on disk (entry names depend only on content, so are unchanged)
+	if (reopen && !open(fileName)) success = false;
+
+	return success;
+}
+
+// Extract specified bundled media file into a directory alongside the specified target file, returning the path of the copy
+QString MediaBundle::extract(QString fileName, QString targetFileName)
+{
+	if (!isBundlePath(fileName)) return fileName;
+
+	const MediaBundleEntry* bundleEntry = entry(fileName);
+	if (!bundleEntry)
+	{
+		msg.print("Warning: Bundled media file '%s' is not in the open bundle, and will not be found when '%s' is loaded.\n", qPrintable(fileName), qPrintable(targetFileName));
+		return fileName;
+	}
+
+	// Entry names depend only on content, so an existing copy of the right size is the one we want
+	QFileInfo targetInfo(targetFileName);
+	QDir targetDir(targetInfo.absolutePath());
+	QString directoryName = targetInfo.completeBaseName() + "_media";
+	QString extractedFileName = targetDir.absoluteFilePath(directoryName + "/" + QFileInfo(fileName.mid(fileName.indexOf(':')+1)).fileName());
+	QFileInfo extractedInfo(extractedFileName);
+	if (extractedInfo.exists() && (extractedInfo.size() == bundleEntry->size)) return extractedFileName;
+
+	QFile file(extractedFileName);
+	QByteArray entryData = data(fileName);
+	bool success = targetDir.mkpath(directoryName) && file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+	success = success && (file.write(entryData) == entryData.size());
+	file.close();
+	if (!success)
+	{
+		msg.print("Warning: Failed to extract bundled media file '%s' to '%s', so it will not be found when '%s' is loaded.\n", qPrintable(fileName), qPrintable(extractedFileName), qPrintable(targetFileName));
+		QFile::remove(extractedFileName);
+		return fileName;
+	}
+
+	return extractedFileName;
+}
+
+/*
+ * Media Bundle Stream
+ */
+
+// Constructor
+MediaBundleStream::MediaBundleStream(QString fileName, qint64 offset, qint64 size) : file_(fileName)
+{
+	offset_ = offset;
+	size_ = size;
+}
+
+// Destructor
+MediaBundleStream::~MediaBundleStream()
+{
+	close();
+}
+
+/*
+ * Data
+ */
+
+// Read data from entry
+qint64 MediaBundleStream::readData(char* data, qint64 maxSize)
+{
+	qint64 nBytes = qMin(maxSize, offset_ + size_ - file_.pos());
+	if (nBytes <= 0) return 0;
+	return file_.read(data, nBytes);
+}
+
+// Write data (not supported)
+qint64 MediaBundleStream::writeData(const char* data, qint64 maxSize)
+{
+	return -1;
+}
+
+// Open entry
+bool MediaBundleStream::open(OpenMode mode)
+{
+	if ((mode & QIODevice::WriteOnly) || (!file_.open(QIODevice::ReadOnly)) || (!file_.seek(offset_))) return false;
+	return QIODevice::open(mode);
+}
+
+// Close entry
+void MediaBundleStream::close()
+{
+	QIODevice::close();
+	file_.close();
+}
+
+// Return size of entry
+qint64 MediaBundleStream::size() const
+{
+	return size_;
+}
+
+// Seek to specified position in entry
+bool MediaBundleStream::seek(qint64 pos)
+{
+	if ((pos < 0) || (pos > size_) || (!file_.seek(offset_ + pos))) return false;
+	return QIODevice::seek(pos);
+}
+
+// Return whether the device is sequential
+bool MediaBundleStream::isSequential() const
+{
+	return false;
+}
@@ -0,0 +1,168 @@
+/*
+	*** Media Bundle
+	*** src/base/mediabundle.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIABUNDLE_H
+#define QUAPP_MEDIABUNDLE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+
+// Forward Declarations
+/* none */
+
+// Media Bundle Entry
+struct MediaBundleEntry
+{
+	// Offset of entry data in bundle
+	qint64 offset;
+	// Size of entry data
+	qint64 size;
+	// Content hash (MD5) of entry data
+	QByteArray hash;
+};
+
+/*!
+ * \brief Media Bundle
+ * \details A single file holding a quiz archive and all of the media it refers to. The file begins with a header (magic, version,
+ * number of entries, reserved, and the 64-bit offset of the index), followed by the data of each entry, stored as-is, and finally
+ * the index, which gives the name, offset, size, and MD5 content hash of each entry. Media are stored once per distinct content,
+ * under the name "media/<hash>.<suffix>", and the quiz refers to them by that name with a "bundle:" prefix.
+ *
+ * Opening a bundle reads only its index and maps the file - entry data is then read from the mapping as it is needed. One bundle
+ * is open at a time.
+ */
+class MediaBundle
+{
+	/*
+	 * Format
+	 */
+	public:
+	// Return current format version
+	static int version();
+	// Return standard file extension
+	static const char* extension();
+	// Return name of quiz archive entry
+	static const char* quizEntryName();
+	// Return whether the specified file is a media bundle
+	static bool isBundle(QString fileName);
+	// Return whether the specified media filename refers to an entry in a bundle
+	static bool isBundlePath(QString fileName);
+	// Return bundle path for entry with specified name
+	static QString bundlePath(QString entryName);
+
+
+	/*
+	 * Open Bundle
+	 */
+	private:
+	// Bundle file
+	static QFile file_;
+	// Mapped bundle data
+	static uchar* map_;
+	// Index of entries in bundle, keyed by name
+	static QHash<QString,MediaBundleEntry> entries_;
+
+	private:
+	// Return entry for specified media filename (or NULL if there is none)
+	static const MediaBundleEntry* entry(QString fileName);
+
+	public:
+	// Open (and map) specified bundle, closing any other
+	static bool open(QString fileName);
+	// Close current bundle
+	static void close();
+	// Return filename of current bundle
+	static QString fileName();
+	// Return offset and size of quiz archive entry in current bundle
+	static bool quizEntry(qint64& offset, qint64& size);
+
+
+	/*
+	 * Media Access
+	 */
+	public:
+	// Return whether the specified media file exists (in the current bundle, or on disk)
+	static bool exists(QString fileName);
+	// Return content of specified media file (read directly from the mapped bundle, without copying, if it is bundled)
+	static QByteArray data(QString fileName);
+	// Return stored content hash for specified media file, if it is bundled
+	static QByteArray contentHash(QString fileName);
+	// Return new (unopened) device from which the specified media file can be read
+	static QIODevice* device(QString fileName);
+
+
+	/*
+	 * Output
+	 */
+	public:
+	// Write bundle containing specified quiz archive data and media, given as source filenames keyed by entry name
+	static bool write(QString fileName, QByteArray quizData, const QHash<QString,QString>& media);
+	// Extract specified bundled media file into a directory alongside the specified target file, returning the path of the copy
+	static QString extract(QString fileName, QString targetFileName);
+};
+
+/*!
+ * \brief Media Bundle Stream
+ * \details Reads a single entry of a bundle through its own file handle, so that it can be streamed (e.g. for audio playback)
+ * independently of the bundle's mapping.
+ */
+class MediaBundleStream : public QIODevice
+{
+	public:
+	// Constructor / Destructor
+	MediaBundleStream(QString fileName, qint64 offset, qint64 size);
+	~MediaBundleStream();
+
+
+	/*
+	 * Data
+	 */
+	private:
+	// Bundle file
+	QFile file_;
+	// Offset of entry data in bundle
+	qint64 offset_;
+	// Size of entry data
+	qint64 size_;
+
+	protected:
+	// Read data from entry
+	qint64 readData(char* data, qint64 maxSize);
+	// Write data (not supported)
+	qint64 writeData(const char* data, qint64 maxSize);
+
+	public:
+	// Open entry
+	bool open(OpenMode mode);
+	// Close entry
+	void close();
+	// Return size of entry
+	qint64 size() const;
+	// Seek to specified position in entry
+	bool seek(qint64 pos);
+	// Return whether the device is sequential
+	bool isSequential() const;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+	*** Media Decode Job
+	*** src/base/mediadecodejob.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mediadecodejob.h"
+#include "base/mediabundle.h"
+#include "base/mediaregistry.h"
+#include "base/tracer.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QFile>
+
+// Constructor
+MediaDecodeJob::MediaDecodeJob(MediaImage* target, QString fileName, int targetSize, QString cacheDirectory) : QRunnable(), ListItem<MediaDecodeJob>()
+{
+	target_ = target;
+	fileName_ = fileName;
+	targetSize_ = targetSize;
+	cacheDirectory_ = cacheDirectory;
+	ok_ = false;
+	fromCache_ = false;
+	state_ = QueuedState;
+
+	// Job is deleted by the MediaRegistry once its result has been collected
+	setAutoDelete(false);
+}
+
+// Destructor
+MediaDecodeJob::~MediaDecodeJob()
+{
+}
+
+/*
+ * Job Data
+ */
+
+// Return target image for decoded data
+MediaImage* MediaDecodeJob::target()
+{
+	return target_;
+}
+
+// Return content key
+QByteArray MediaDecodeJob::key()
+{
+	return key_;
+}
+
+// Return decoded image
+QImage& MediaDecodeJob::image()
+{
+	return image_;
+}
+
+// Return whether image was decoded successfully
+bool MediaDecodeJob::ok()
+{
+	return ok_;
+}
+
+// Return whether reduced image was retrieved from the cache
+bool MediaDecodeJob::fromCache()
+{
+	return fromCache_;
+}
+
+/*
+ * Execution
+ */
+
+// Cancel job if it has yet to start, returning whether it was cancelled
+bool MediaDecodeJob::cancel()
+{
+	return state_.testAndSetOrdered(QueuedState, CancelledState);
+}
+
+// Return whether job was cancelled before it started
+bool MediaDecodeJob::cancelled()
+{
+	return (state_ == CancelledState);
+}
+
+// Read and decode image (called from worker thread)
+void MediaDecodeJob::run()
+{
+	TRACESPAN("MediaDecodeJob::run");
+
+	// A cancelled job is still handed back, so that the registry can release the reference it holds
+	if (!state_.testAndSetOrdered(QueuedState, RunningState))
+	{
+		MediaRegistry::jobCompleted(this);
+		return;
+	}
+
+	// Bundled files are read straight from the bundle's mapping
+	QByteArray data = MediaBundle::data(fileName_);
+	if (data.isEmpty())
+	{
+		MediaRegistry::jobCompleted(this);
+		return;
+	}
+
+	// We key images on their content, so identical files under different names can be shared (bundles store this already)
+	key_ = MediaBundle::contentHash(fileName_);
+	if (key_.isEmpty()) key_ = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+
+	// If a reduced image is wanted, a previous run may already have made it
+	QString cacheFileName;
+	if ((targetSize_ > 0) && (!cacheDirectory_.isEmpty()))
+	{
+		cacheFileName = QString("%1/%2-%3.png").arg(cacheDirectory_, QString(key_.toHex())).arg(targetSize_);
+		if (image_.load(cacheFileName, "PNG"))
+		{
+			ok_ = true;
+			fromCache_ = true;
+			MediaRegistry::jobCompleted(this);
+			return;
+		}
+	}
+
+	ok_ = image_.loadFromData(data);
+
+	// Reduce the image so that its smaller dimension matches the target size (images are never drawn larger than this)
+	if (ok_ && (targetSize_ > 0) && (qMin(image_.width(), image_.height()) > targetSize_))
+	{
+		if (image_.width() < image_.height()) image_ = image_.scaledToWidth(targetSize_, Qt::SmoothTransformation);
+		else image_ = image_.scaledToHeight(targetSize_, Qt::SmoothTransformation);
+
+		// Store the reduced image in the cache - write to a temporary file first, so other jobs never see a partial file
+		if (!cacheFileName.isEmpty())
+		{
+			QString tempFileName = cacheFileName + QString(".%1.tmp").arg(quintptr(this));
+			if ((!image_.save(tempFileName, "PNG")) || (!QFile::rename(tempFileName, cacheFileName))) QFile::remove(tempFileName);
+		}
+	}
+
+	// Hand the result back to the registry
+	MediaRegistry::jobCompleted(this);
+}
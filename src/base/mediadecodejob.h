@@ -0,0 +1,98 @@
+/*
+	*** Media Decode Job
+	*** src/base/mediadecodejob.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIADECODEJOB_H
+#define QUAPP_MEDIADECODEJOB_H
+
+#include "templates/list.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QRunnable>
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+// Forward Declarations
+class MediaImage;
+
+// Media Decode Job
+class MediaDecodeJob : public QRunnable, public ListItem<MediaDecodeJob>
+{
+	public:
+	// Constructor / Destructor
+	MediaDecodeJob(MediaImage* target, QString fileName, int targetSize, QString cacheDirectory);
+	~MediaDecodeJob();
+
+
+	/*
+	 * Job Data
+	 */
+	private:
+	// Target image for decoded data (not touched by the job itself)
+	MediaImage* target_;
+	// Filename to decode
+	QString fileName_;
+	// Size to which the smaller dimension of the image is reduced (zero for source resolution)
+	int targetSize_;
+	// Directory in which reduced images are cached (empty for no caching)
+	QString cacheDirectory_;
+	// Content key (hash of file data)
+	QByteArray key_;
+	// Decoded image
+	QImage image_;
+	// Whether image was decoded successfully
+	bool ok_;
+	// Whether reduced image was retrieved from the cache
+	bool fromCache_;
+
+	public:
+	// Return target image for decoded data
+	MediaImage* target();
+	// Return content key
+	QByteArray key();
+	// Return decoded image
+	QImage& image();
+	// Return whether image was decoded successfully
+	bool ok();
+	// Return whether reduced image was retrieved from the cache
+	bool fromCache();
+
+
+	/*
+	 * Execution
+	 */
+	public:
+	// Job States
+	enum JobState { QueuedState, RunningState, CancelledState };
+
+	private:
+	// Current state of job
+	QAtomicInt state_;
+
+	public:
+	// Cancel job if it has yet to start, returning whether it was cancelled
+	bool cancel();
+	// Return whether job was cancelled before it started
+	bool cancelled();
+	// Read and decode image (called from worker thread)
+	void run();
+};
+
+#endif
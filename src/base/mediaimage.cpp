@@ -0,0 +1,167 @@
+/*
+	*** Media Image
+	*** src/base/mediaimage.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mediaimage.h"
+#include "base/medialistener.h"
+
+// Constructor
+MediaImage::MediaImage() : ListItem<MediaImage>()
+{
+	pending_ = false;
+	ok_ = false;
+	refCount_ = 0;
+	lastUsed_ = 0;
+}
+
+// Destructor
+MediaImage::~MediaImage()
+{
+}
+
+/*
+ * Data
+ */
+
+// Set filename from which image is loaded
+void MediaImage::setFileName(QString fileName)
+{
+	fileName_ = fileName;
+}
+
+// Return filename from which image is loaded
+QString MediaImage::fileName()
+{
+	return fileName_;
+}
+
+// Set content key
+void MediaImage::setKey(QByteArray key)
+{
+	key_ = key;
+}
+
+// Return content key
+QByteArray MediaImage::key()
+{
+	return key_;
+}
+
+// Set decoded image
+void MediaImage::setImage(QImage image, bool ok)
+{
+	image_ = image;
+	ok_ = ok;
+}
+
+// Return decoded image
+QImage& MediaImage::image()
+{
+	return image_;
+}
+
+// Set whether image is waiting to be decoded
+void MediaImage::setPending(bool pending)
+{
+	pending_ = pending;
+}
+
+// Return whether image is waiting to be decoded
+bool MediaImage::pending()
+{
+	return pending_;
+}
+
+// Return whether image was decoded successfully
+bool MediaImage::ok()
+{
+	return ok_;
+}
+
+// Add reference to image
+void MediaImage::addReference()
+{
+	++refCount_;
+}
+
+// Remove reference from image, returning the number remaining
+int MediaImage::removeReference()
+{
+	if (refCount_ > 0) --refCount_;
+	return refCount_;
+}
+
+// Return number of references to image
+int MediaImage::refCount()
+{
+	return refCount_;
+}
+
+// Add listener to notify when image has been decoded
+void MediaImage::addListener(MediaListener* listener)
+{
+	if (listener) listeners_.addUnique(listener);
+}
+
+// Remove listener
+void MediaImage::removeListener(MediaListener* listener)
+{
+	if (listener && listeners_.contains(listener)) listeners_.remove(listener);
+}
+
+// Notify listeners that image has been decoded
+void MediaImage::notifyListeners()
+{
+	for (RefListItem<MediaListener,int>* ri = listeners_.first(); ri != NULL; ri = ri->next) ri->item->mediaImageLoaded(this);
+}
+
+/*
+ * Residency
+ */
+
+// Set usage stamp at which the image was last requested
+void MediaImage::setLastUsed(int stamp)
+{
+	lastUsed_ = stamp;
+}
+
+// Return usage stamp at which the image was last requested
+int MediaImage::lastUsed()
+{
+	return lastUsed_;
+}
+
+// Return whether decoded image data is currently held
+bool MediaImage::resident()
+{
+	return (!image_.isNull());
+}
+
+// Return size of decoded image data currently held
+qint64 MediaImage::nBytes()
+{
+	return image_.byteCount();
+}
+
+// Discard decoded image data (the image remains valid, and may be decoded again)
+void MediaImage::evict()
+{
+	image_ = QImage();
+}
@@ -0,0 +1,115 @@
+/*
+	*** Media Image
+	*** src/base/mediaimage.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIAIMAGE_H
+#define QUAPP_MEDIAIMAGE_H
+
+#include "templates/list.h"
+#include "templates/reflist.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+// Forward Declarations
+class MediaListener;
+
+// Media Image
+class MediaImage : public ListItem<MediaImage>
+{
+	public:
+	// Constructor / Destructor
+	MediaImage();
+	~MediaImage();
+
+
+	/*
+	 * Data
+	 */
+	private:
+	// Filename from which image is loaded
+	QString fileName_;
+	// Content key (hash of source file data)
+	QByteArray key_;
+	// Decoded image
+	QImage image_;
+	// Whether image is waiting to be decoded
+	bool pending_;
+	// Whether image was decoded successfully
+	bool ok_;
+	// Number of references to this image
+	int refCount_;
+	// Listeners to notify when image has been decoded
+	RefList<MediaListener,int> listeners_;
+
+	public:
+	// Set filename from which image is loaded
+	void setFileName(QString fileName);
+	// Return filename from which image is loaded
+	QString fileName();
+	// Set content key
+	void setKey(QByteArray key);
+	// Return content key
+	QByteArray key();
+	// Set decoded image
+	void setImage(QImage image, bool ok);
+	// Return decoded image
+	QImage& image();
+	// Set whether image is waiting to be decoded
+	void setPending(bool pending);
+	// Return whether image is waiting to be decoded
+	bool pending();
+	// Return whether image was decoded successfully
+	bool ok();
+	// Add reference to image
+	void addReference();
+	// Remove reference from image, returning the number remaining
+	int removeReference();
+	// Return number of references to image
+	int refCount();
+	// Add listener to notify when image has been decoded
+	void addListener(MediaListener* listener);
+	// Remove listener
+	void removeListener(MediaListener* listener);
+	// Notify listeners that image has been decoded
+	void notifyListeners();
+
+
+	/*
+	 * Residency
+	 */
+	private:
+	// Usage stamp at which the image was last requested
+	int lastUsed_;
+
+	public:
+	// Set usage stamp at which the image was last requested
+	void setLastUsed(int stamp);
+	// Return usage stamp at which the image was last requested
+	int lastUsed();
+	// Return whether decoded image data is currently held
+	bool resident();
+	// Return size of decoded image data currently held
+	qint64 nBytes();
+	// Discard decoded image data (the image remains valid, and may be decoded again)
+	void evict();
+};
+
+#endif
@@ -0,0 +1,38 @@
+/*
+	*** Media Listener
+	*** src/base/medialistener.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIALISTENER_H
+#define QUAPP_MEDIALISTENER_H
+
+// Forward Declarations
+class MediaImage;
+
+// Media Listener
+class MediaListener
+{
+	public:
+	// Destructor
+	virtual ~MediaListener() {};
+	// Notify that the specified image has finished loading
+	virtual void mediaImageLoaded(MediaImage* image) = 0;
+};
+
+#endif
@@ -0,0 +1,600 @@
+/*
+	*** Media Registry
+	*** src/base/mediaregistry.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mediaregistry.h"
+#include "base/mediabundle.h"
+#include "base/medialistener.h"
+#include "base/messenger.h"
+#include "base/tracer.h"
+#include "render/frameprofiler.h"
+#include <QtCore/QDir>
+#include <QtCore/QMetaObject>
+#include <QtCore/QThreadPool>
+
+// Static Members
+List<MediaImage> MediaRegistry::images_;
+QHash<QString,MediaImage*> MediaRegistry::imageHash_;
+QHash<QByteArray,MediaImage*> MediaRegistry::contentHash_;
+QImage MediaRegistry::nullImage_;
+QMutex MediaRegistry::jobMutex_;
+List<MediaDecodeJob> MediaRegistry::completedJobs_;
+QWaitCondition MediaRegistry::jobDone_;
+QHash<MediaImage*,MediaDecodeJob*> MediaRegistry::queuedJobs_;
+int MediaRegistry::nJobsQueued_ = 0;
+int MediaRegistry::nJobsProcessed_ = 0;
+QObject* MediaRegistry::notifier_ = NULL;
+qint64 MediaRegistry::imageBudget_ = 256*1024*1024;
+int MediaRegistry::usageStamp_ = 0;
+int MediaRegistry::nEvictions_ = 0;
+int MediaRegistry::targetSize_ = 0;
+QString MediaRegistry::cacheDirectory_;
+int MediaRegistry::nCacheHits_ = 0;
+int MediaRegistry::prefetchDepth_ = 4;
+RefList<MediaImage,int> MediaRegistry::prefetchWindow_;
+RefList<MediaImage,GLuint> MediaRegistry::prefetchTextures_;
+List<MediaTexture> MediaRegistry::textures_;
+QHash<qint64,MediaTexture*> MediaRegistry::textureHash_;
+
+/*
+ * Images
+ */
+
+// Remove image from content hash, promoting another image with the same content if possible
+void MediaRegistry::removeFromContentHash(MediaImage* image)
+{
+	if (contentHash_.value(image->key(), NULL) != image) return;
+
+	contentHash_.remove(image->key());
+	for (MediaImage* other = images_.first(); other != NULL; other = other->next)
+	{
+		if ((other == image) || (!other->ok()) || (other->key() != image->key())) continue;
+		contentHash_.insert(other->key(), other);
+		break;
+	}
+}
+
+// Share data from a resident image with identical content, returning whether this was possible
+bool MediaRegistry::shareResident(MediaImage* image)
+{
+	MediaImage* original = contentHash_.value(image->key(), NULL);
+	if ((!original) || (original == image) || (!original->resident())) return false;
+
+	image->setImage(original->image(), true);
+	return true;
+}
+
+// Return shared image for specified file (it is not decoded until it is prefetched or drawn)
+MediaImage* MediaRegistry::acquireImage(QString fileName, MediaListener* listener)
+{
+	// No file, no image
+	if (fileName.isEmpty()) return NULL;
+
+	// Do we already have this image?
+	MediaImage* image = imageHash_.value(fileName, NULL);
+	if (image)
+	{
+		image->addReference();
+		image->addListener(listener);
+		return image;
+	}
+
+	// Create new image - until it is first decoded, it is assumed to be good if its file exists
+	image = images_.add();
+	image->setFileName(fileName);
+	image->setImage(QImage(), MediaBundle::exists(fileName));
+	image->addReference();
+	image->addListener(listener);
+	imageHash_.insert(fileName, image);
+
+	return image;
+}
+
+// Release reference to shared image
+void MediaRegistry::releaseImage(MediaImage* image, MediaListener* listener)
+{
+	if (!image) return;
+
+	image->removeListener(listener);
+
+	// If there are still references to the image, nothing more to do
+	if (image->removeReference() > 0) return;
+
+	// Forget the image in the prefetch window (its texture, if any, is released on the next upload)
+	prefetchWindow_.remove(image);
+	for (RefListItem<MediaImage,GLuint>* ri = prefetchTextures_.first(); ri != NULL; ri = ri->next) if (ri->item == image) ri->item = NULL;
+
+	imageHash_.remove(image->fileName());
+	removeFromContentHash(image);
+	images_.remove(image);
+}
+
+// Return null image
+QImage& MediaRegistry::nullImage()
+{
+	return nullImage_;
+}
+
+// Return number of distinct images held
+int MediaRegistry::nImages()
+{
+	return images_.nItems();
+}
+
+// Return number of image bytes currently saved through sharing
+qint64 MediaRegistry::imageBytesSaved()
+{
+	// Every reference beyond the first would otherwise have held its own copy of the image, as would every image whose content duplicates another's
+	qint64 nBytes = 0;
+	int nCopies;
+	for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+	{
+		if (!image->ok()) continue;
+		nCopies = image->refCount() - 1;
+		if (contentHash_.value(image->key(), NULL) != image) ++nCopies;
+		nBytes += qint64(nCopies) * image->image().byteCount();
+	}
+	return nBytes;
+}
+
+/*
+ * Decoding
+ */
+
+// Set object to notify when a job completes
+void MediaRegistry::setNotifier(QObject* notifier)
+{
+	notifier_ = notifier;
+}
+
+// Store completed job (called from worker threads)
+void MediaRegistry::jobCompleted(MediaDecodeJob* job)
+{
+	jobMutex_.lock();
+	completedJobs_.own(job);
+	jobDone_.wakeAll();
+	jobMutex_.unlock();
+
+	if (notifier_) QMetaObject::invokeMethod(notifier_, "processCompleted", Qt::QueuedConnection);
+}
+
+// Collect completed jobs, updating images and notifying their listeners, and returning the number processed
+int MediaRegistry::processCompleted()
+{
+	// Grab all completed jobs
+	List<MediaDecodeJob> jobs;
+	jobMutex_.lock();
+	MediaDecodeJob* job;
+	while ((job = completedJobs_.first()) != NULL)
+	{
+		completedJobs_.disown(job);
+		jobs.own(job);
+	}
+	jobMutex_.unlock();
+
+	MediaImage* image, *original;
+	for (job = jobs.first(); job != NULL; job = job->next)
+	{
+		image = job->target();
+		if (queuedJobs_.value(image, NULL) == job) queuedJobs_.remove(image);
+
+		// A cancelled job was superseded by a decode on this thread, so only its reference needs releasing
+		if (job->cancelled())
+		{
+			releaseImage(image);
+			continue;
+		}
+
+		image->setKey(job->key());
+		image->setPending(false);
+		if (job->fromCache()) ++nCacheHits_;
+
+		// If we already have a resident image with identical content, share its data rather than keeping the new copy
+		original = contentHash_.value(job->key(), NULL);
+		if (original && (original != image) && original->resident()) image->setImage(original->image(), true);
+		else
+		{
+			image->setImage(job->image(), job->ok());
+			if (job->ok()) contentHash_.insert(job->key(), image);
+		}
+
+		image->notifyListeners();
+
+		// Release the reference held by the job
+		releaseImage(image);
+	}
+
+	nJobsProcessed_ += jobs.nItems();
+
+	enforceBudget();
+
+	return jobs.nItems();
+}
+
+// Wait until there is at least one completed job to collect
+void MediaRegistry::waitForCompleted()
+{
+	jobMutex_.lock();
+	if (completedJobs_.nItems() == 0) jobDone_.wait(&jobMutex_);
+	jobMutex_.unlock();
+}
+
+// Wait for all queued jobs to finish, and process them
+void MediaRegistry::waitForPending()
+{
+	TRACESPAN("MediaRegistry::waitForPending");
+
+	// Only our own jobs are waited for - anything else on the global pool (e.g. frame encoding or autosaves) is left to run
+	processCompleted();
+	while (busy())
+	{
+		waitForCompleted();
+		processCompleted();
+	}
+}
+
+// Queue decoding of every image which is not resident (e.g. to time decoding)
+void MediaRegistry::decodeAll()
+{
+	for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+	{
+		if (image->resident() || image->pending() || (!image->ok()) || shareResident(image)) continue;
+		queueDecode(image);
+	}
+}
+
+// Return number of jobs queued since the registry was last idle
+int MediaRegistry::nJobsQueued()
+{
+	return nJobsQueued_;
+}
+
+// Return number of jobs processed since the registry was last idle
+int MediaRegistry::nJobsProcessed()
+{
+	return nJobsProcessed_;
+}
+
+// Return whether there are jobs still waiting to be processed
+bool MediaRegistry::busy()
+{
+	return (nJobsQueued_ > nJobsProcessed_);
+}
+
+/*
+ * Residency
+ */
+
+// Queue decode job for specified image, optionally running it immediately in the calling thread
+void MediaRegistry::queueDecode(MediaImage* image, bool immediate)
+{
+	image->setPending(true);
+
+	// The job holds its own reference to the image, so it cannot disappear before the job has been processed
+	image->addReference();
+	if (!busy())
+	{
+		nJobsQueued_ = 0;
+		nJobsProcessed_ = 0;
+	}
+	++nJobsQueued_;
+
+	MediaDecodeJob* job = new MediaDecodeJob(image, image->fileName(), targetSize_, cacheDirectory_);
+	if (immediate) job->run();
+	else
+	{
+		queuedJobs_.insert(image, job);
+		QThreadPool::globalInstance()->start(job);
+	}
+}
+
+// Evict least-recently-used images until decoded data fits within the budget
+void MediaRegistry::enforceBudget()
+{
+	if (imageBudget_ <= 0) return;
+
+	MediaImage* oldest;
+	qint64 cacheKey;
+	while (residentBytes() > imageBudget_)
+	{
+		// Find least-recently-used image which may be evicted - images in the prefetch window, and the most recently requested image, must stay
+		oldest = NULL;
+		for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+		{
+			if ((!image->resident()) || (image->lastUsed() == usageStamp_) || prefetchWindow_.contains(image)) continue;
+			if ((!oldest) || (image->lastUsed() < oldest->lastUsed())) oldest = image;
+		}
+		if (!oldest) break;
+
+		// Evict it, along with any other evictable images sharing its data (otherwise no memory is actually freed)
+		cacheKey = oldest->image().cacheKey();
+		for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+		{
+			if ((!image->resident()) || (image->image().cacheKey() != cacheKey)) continue;
+			if ((image != oldest) && ((image->lastUsed() == usageStamp_) || prefetchWindow_.contains(image))) continue;
+			image->evict();
+			++nEvictions_;
+		}
+	}
+}
+
+// Set memory budget for decoded image data, in bytes (zero for unlimited)
+void MediaRegistry::setImageBudget(qint64 nBytes)
+{
+	imageBudget_ = nBytes;
+
+	enforceBudget();
+}
+
+// Return memory budget for decoded image data, in bytes
+qint64 MediaRegistry::imageBudget()
+{
+	return imageBudget_;
+}
+
+// Return size of decoded image data currently held
+qint64 MediaRegistry::residentBytes()
+{
+	// Images with identical content share their data, so count each distinct block once
+	QHash<qint64,bool> counted;
+	qint64 nBytes = 0;
+	for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+	{
+		if ((!image->resident()) || counted.contains(image->image().cacheKey())) continue;
+		counted.insert(image->image().cacheKey(), true);
+		nBytes += image->nBytes();
+	}
+	return nBytes;
+}
+
+// Return decoded data for specified image, decoding it now if it is not resident
+QImage& MediaRegistry::residentImage(MediaImage* image)
+{
+	image->setLastUsed(++usageStamp_);
+
+	// Images which failed to decode are not retried
+	if (image->resident() || (!image->ok())) return image->image();
+
+	// Not resident, so this is a prefetch miss - if its decode has started we wait for that alone, otherwise we decode it here and now
+	if (image->pending())
+	{
+		MediaDecodeJob* job = queuedJobs_.value(image, NULL);
+		if (job && job->cancel()) image->setPending(false);
+		else while (image->pending())
+		{
+			waitForCompleted();
+			processCompleted();
+		}
+	}
+	if ((!image->resident()) && image->ok() && (!shareResident(image)))
+	{
+		queueDecode(image, true);
+		processCompleted();
+	}
+
+	return image->image();
+}
+
+// Return number of images evicted since startup
+int MediaRegistry::nEvictions()
+{
+	return nEvictions_;
+}
+
+/*
+ * Display Sizing
+ */
+
+// Set target image size from the height of the display
+void MediaRegistry::setTargetSize(int displayHeight)
+{
+	// Round up to a multiple of 64 pixels, so that small changes in window size don't invalidate everything
+	int newSize = ((displayHeight + 63) / 64) * 64;
+	if (newSize == targetSize_) return;
+	int oldSize = targetSize_;
+	targetSize_ = newSize;
+
+	// Evict resident images which are now larger than necessary, or which were reduced further than we now want
+	int minSize;
+	for (MediaImage* image = images_.first(); image != NULL; image = image->next)
+	{
+		if (!image->resident()) continue;
+		minSize = qMin(image->image().width(), image->image().height());
+		if ((targetSize_ > 0) && (minSize > targetSize_)) image->evict();
+		else if ((oldSize > 0) && (minSize == oldSize) && ((targetSize_ == 0) || (targetSize_ > oldSize))) image->evict();
+		else continue;
+		++nEvictions_;
+	}
+}
+
+// Return size to which the smaller dimension of decoded images is reduced
+int MediaRegistry::targetSize()
+{
+	return targetSize_;
+}
+
+// Set directory in which reduced images are cached between runs
+bool MediaRegistry::setCacheDirectory(QString dirName)
+{
+	if ((!dirName.isEmpty()) && (!QDir().mkpath(dirName)))
+	{
+		msg.print("Failed to create media cache directory '%s' - reduced images will not be cached.\n", qPrintable(dirName));
+		cacheDirectory_.clear();
+		return false;
+	}
+
+	cacheDirectory_ = dirName;
+	return true;
+}
+
+// Return directory in which reduced images are cached between runs
+QString MediaRegistry::cacheDirectory()
+{
+	return cacheDirectory_;
+}
+
+/*
+ * Prefetch
+ */
+
+// Set number of upcoming parts of the running order whose media should be prefetched
+void MediaRegistry::setPrefetchDepth(int depth)
+{
+	prefetchDepth_ = depth;
+}
+
+// Return number of upcoming parts of the running order whose media should be prefetched
+int MediaRegistry::prefetchDepth()
+{
+	return prefetchDepth_;
+}
+
+// Begin new prefetch window, replacing the previous one
+void MediaRegistry::beginPrefetch()
+{
+	prefetchWindow_.clear();
+}
+
+// Add image to the prefetch window, queueing it for decoding if it is not resident
+void MediaRegistry::prefetchImage(MediaImage* image)
+{
+	if (!image) return;
+
+	image->setLastUsed(++usageStamp_);
+	prefetchWindow_.addUnique(image);
+
+	if (image->resident() || image->pending() || (!image->ok())) return;
+	if (shareResident(image)) return;
+
+	queueDecode(image);
+}
+
+// Upload textures for images in the prefetch window, and release those no longer in it (requires a current GL context)
+void MediaRegistry::uploadPrefetched()
+{
+	TRACESPAN("MediaRegistry::uploadPrefetched");
+
+	// Release textures for images which have left the window (primitives using them hold their own references)
+	RefListItem<MediaImage,GLuint>* ri = prefetchTextures_.first(), *next;
+	while (ri)
+	{
+		next = ri->next;
+		if ((!ri->item) || (!prefetchWindow_.contains(ri->item)))
+		{
+			releaseTexture(ri->data);
+			prefetchTextures_.remove(ri);
+		}
+		ri = next;
+	}
+
+	// Upload textures for resident images in the window which don't have one yet
+	for (RefListItem<MediaImage,int>* wi = prefetchWindow_.first(); wi != NULL; wi = wi->next)
+	{
+		if ((!wi->item->resident()) || prefetchTextures_.contains(wi->item)) continue;
+		prefetchTextures_.add(wi->item, acquireTexture(wi->item->image()));
+	}
+}
+
+/*
+ * Textures
+ */
+
+// Return shared texture object for specified image, uploading it if necessary (requires a current GL context)
+GLuint MediaRegistry::acquireTexture(const QImage& image)
+{
+	if (image.isNull()) return 0;
+
+	// Do we already have a texture for this image?
+	MediaTexture* texture = textureHash_.value(image.cacheKey(), NULL);
+	if (texture)
+	{
+		texture->addReference();
+		return texture->textureObject();
+	}
+
+	// Convert image to GL format (this also flips it vertically)
+	QImage glImage = QGLWidget::convertToGLFormat(image);
+
+	// Create and upload texture, generating mipmaps as we go
+	GLuint textureObject;
+	glGenTextures(1, &textureObject);
+	glBindTexture(GL_TEXTURE_2D, textureObject);
+	FrameProfiler::count(FrameProfiler::TextureBindCounter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, glImage.width(), glImage.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, glImage.bits());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	texture = textures_.add();
+	texture->set(image.cacheKey(), textureObject, glImage.byteCount());
+	texture->addReference();
+	textureHash_.insert(image.cacheKey(), texture);
+
+	return textureObject;
+}
+
+// Release reference to shared texture object (requires a current GL context)
+void MediaRegistry::releaseTexture(GLuint textureObject)
+{
+	if (textureObject == 0) return;
+
+	for (MediaTexture* texture = textures_.first(); texture != NULL; texture = texture->next)
+	{
+		if (texture->textureObject() != textureObject) continue;
+
+		// If there are still references to the texture, nothing more to do
+		if (texture->removeReference() > 0) return;
+
+		glDeleteTextures(1, &textureObject);
+		textureHash_.remove(texture->imageKey());
+		textures_.remove(texture);
+		return;
+	}
+
+	printf("Internal Error: Texture object %i is not known to MediaRegistry.\n", textureObject);
+}
+
+// Return number of distinct textures held
+int MediaRegistry::nTextures()
+{
+	return textures_.nItems();
+}
+
+// Return number of texture bytes currently saved through sharing
+qint64 MediaRegistry::textureBytesSaved()
+{
+	// Every reference beyond the first would otherwise have uploaded its own copy of the texture
+	qint64 nBytes = 0;
+	for (MediaTexture* texture = textures_.first(); texture != NULL; texture = texture->next) nBytes += qint64(texture->refCount()-1) * texture->nBytes();
+	return nBytes;
+}
+
+/*
+ * Statistics
+ */
+
+// Print summary of shared media
+void MediaRegistry::printStatistics()
+{
+	msg.print("Shared media: %i image(s) held, %lli bytes saved through sharing.\n", images_.nItems(), imageBytesSaved());
+	msg.print("Shared media: %i texture(s) held, %lli bytes saved through sharing.\n", textures_.nItems(), textureBytesSaved());
+	msg.print("Shared media: %lli of %lli bytes of image data resident, %i eviction(s), %i reduced image(s) read from cache.\n", residentBytes(), imageBudget_, nEvictions_, nCacheHits_);
+}
@@ -0,0 +1,218 @@
+/*
+	*** Media Registry
+	*** src/base/mediaregistry.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIAREGISTRY_H
+#define QUAPP_MEDIAREGISTRY_H
+
+#include "base/mediaimage.h"
+#include "base/mediatexture.h"
+#include "base/mediadecodejob.h"
+#include "templates/list.h"
+#include "templates/reflist.h"
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QString>
+
+// Forward Declarations
+class MediaListener;
+class QObject;
+
+// Media Registry
+class MediaRegistry
+{
+	/*
+	 * Images
+	 */
+	private:
+	// List of shared images
+	static List<MediaImage> images_;
+	// Hash of shared images, keyed by filename
+	static QHash<QString,MediaImage*> imageHash_;
+	// Hash of decoded images, keyed by content
+	static QHash<QByteArray,MediaImage*> contentHash_;
+	// Null image, returned when no image is available
+	static QImage nullImage_;
+
+	private:
+	// Remove image from content hash, promoting another image with the same content if possible
+	static void removeFromContentHash(MediaImage* image);
+	// Share data from a resident image with identical content, returning whether this was possible
+	static bool shareResident(MediaImage* image);
+
+	public:
+	// Return shared image for specified file (it is not decoded until it is prefetched or drawn)
+	static MediaImage* acquireImage(QString fileName, MediaListener* listener = NULL);
+	// Release reference to shared image
+	static void releaseImage(MediaImage* image, MediaListener* listener = NULL);
+	// Return null image
+	static QImage& nullImage();
+	// Return number of distinct images held
+	static int nImages();
+	// Return number of image bytes currently saved through sharing
+	static qint64 imageBytesSaved();
+
+
+	/*
+	 * Decoding
+	 */
+	private:
+	// Mutex protecting list of completed jobs
+	static QMutex jobMutex_;
+	// Completed decode jobs, waiting to be collected
+	static List<MediaDecodeJob> completedJobs_;
+	// Condition signalled whenever a job completes
+	static QWaitCondition jobDone_;
+	// Decode jobs queued on the thread pool and not yet collected, keyed by target image
+	static QHash<MediaImage*,MediaDecodeJob*> queuedJobs_;
+	// Number of jobs queued and processed since the registry was last idle
+	static int nJobsQueued_, nJobsProcessed_;
+	// Object to notify (via a queued call to its 'processCompleted' slot) when a job completes
+	static QObject* notifier_;
+
+	private:
+	// Wait until there is at least one completed job to collect
+	static void waitForCompleted();
+
+	public:
+	// Set object to notify when a job completes
+	static void setNotifier(QObject* notifier);
+	// Store completed job (called from worker threads)
+	static void jobCompleted(MediaDecodeJob* job);
+	// Collect completed jobs, updating images and notifying their listeners, and returning the number processed
+	static int processCompleted();
+	// Wait for all queued jobs to finish, and process them
+	static void waitForPending();
+	// Queue decoding of every image which is not resident (e.g. to time decoding)
+	static void decodeAll();
+	// Return number of jobs queued since the registry was last idle
+	static int nJobsQueued();
+	// Return number of jobs processed since the registry was last idle
+	static int nJobsProcessed();
+	// Return whether there are jobs still waiting to be processed
+	static bool busy();
+
+
+	/*
+	 * Residency
+	 */
+	private:
+	// Memory budget for decoded image data, in bytes (zero for unlimited)
+	static qint64 imageBudget_;
+	// Usage stamp counter
+	static int usageStamp_;
+	// Number of images evicted since startup
+	static int nEvictions_;
+
+	private:
+	// Queue decode job for specified image, optionally running it immediately in the calling thread
+	static void queueDecode(MediaImage* image, bool immediate = false);
+	// Evict least-recently-used images until decoded data fits within the budget
+	static void enforceBudget();
+
+	public:
+	// Set memory budget for decoded image data, in bytes (zero for unlimited)
+	static void setImageBudget(qint64 nBytes);
+	// Return memory budget for decoded image data, in bytes
+	static qint64 imageBudget();
+	// Return size of decoded image data currently held
+	static qint64 residentBytes();
+	// Return decoded data for specified image, decoding it now if it is not resident
+	static QImage& residentImage(MediaImage* image);
+	// Return number of images evicted since startup
+	static int nEvictions();
+
+
+	/*
+	 * Display Sizing
+	 */
+	private:
+	// Size to which the smaller dimension of decoded images is reduced (zero for source resolution)
+	static int targetSize_;
+	// Directory in which reduced images are cached between runs (empty for no caching)
+	static QString cacheDirectory_;
+	// Number of reduced images retrieved from the cache since startup
+	static int nCacheHits_;
+
+	public:
+	// Set target image size from the height of the display
+	static void setTargetSize(int displayHeight);
+	// Return size to which the smaller dimension of decoded images is reduced
+	static int targetSize();
+	// Set directory in which reduced images are cached between runs
+	static bool setCacheDirectory(QString dirName);
+	// Return directory in which reduced images are cached between runs
+	static QString cacheDirectory();
+
+
+	/*
+	 * Prefetch
+	 */
+	private:
+	// Number of upcoming parts of the running order whose media should be prefetched
+	static int prefetchDepth_;
+	// Images in the current prefetch window (protected from eviction)
+	static RefList<MediaImage,int> prefetchWindow_;
+	// Textures uploaded for images in the prefetch window
+	static RefList<MediaImage,GLuint> prefetchTextures_;
+
+	public:
+	// Set number of upcoming parts of the running order whose media should be prefetched
+	static void setPrefetchDepth(int depth);
+	// Return number of upcoming parts of the running order whose media should be prefetched
+	static int prefetchDepth();
+	// Begin new prefetch window, replacing the previous one
+	static void beginPrefetch();
+	// Add image to the prefetch window, queueing it for decoding if it is not resident
+	static void prefetchImage(MediaImage* image);
+	// Upload textures for images in the prefetch window, and release those no longer in it (requires a current GL context)
+	static void uploadPrefetched();
+
+
+	/*
+	 * Textures
+	 */
+	private:
+	// List of shared textures
+	static List<MediaTexture> textures_;
+	// Hash of shared textures, keyed by source image cache key
+	static QHash<qint64,MediaTexture*> textureHash_;
+
+	public:
+	// Return shared texture object for specified image, uploading it if necessary (requires a current GL context)
+	static GLuint acquireTexture(const QImage& image);
+	// Release reference to shared texture object (requires a current GL context)
+	static void releaseTexture(GLuint textureObject);
+	// Return number of distinct textures held
+	static int nTextures();
+	// Return number of texture bytes currently saved through sharing
+	static qint64 textureBytesSaved();
+
+
+	/*
+	 * Statistics
+	 */
+	public:
+	// Print summary of shared media
+	static void printStatistics();
+};
+
+#endif
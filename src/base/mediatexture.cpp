@@ -0,0 +1,85 @@
+/*
+	*** Media Texture
+	*** src/base/mediatexture.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/mediatexture.h"
+
+// Constructor
+MediaTexture::MediaTexture() : ListItem<MediaTexture>()
+{
+	imageKey_ = 0;
+	textureObject_ = 0;
+	nBytes_ = 0;
+	refCount_ = 0;
+}
+
+// Destructor
+MediaTexture::~MediaTexture()
+{
+}
+
+/*
+ * Data
+ */
+
+// Set texture data
+void MediaTexture::set(qint64 imageKey, GLuint textureObject, int nBytes)
+{
+	imageKey_ = imageKey;
+	textureObject_ = textureObject;
+	nBytes_ = nBytes;
+}
+
+// Return cache key of image from which texture was created
+qint64 MediaTexture::imageKey()
+{
+	return imageKey_;
+}
+
+// Return GL texture object
+GLuint MediaTexture::textureObject()
+{
+	return textureObject_;
+}
+
+// Return size of texture data (in bytes)
+int MediaTexture::nBytes()
+{
+	return nBytes_;
+}
+
+// Add reference to texture
+void MediaTexture::addReference()
+{
+	++refCount_;
+}
+
+// Remove reference from texture, returning the number remaining
+int MediaTexture::removeReference()
+{
+	if (refCount_ > 0) --refCount_;
+	return refCount_;
+}
+
+// Return number of references to texture
+int MediaTexture::refCount()
+{
+	return refCount_;
+}
@@ -0,0 +1,70 @@
+/*
+	*** Media Texture
+	*** src/base/mediatexture.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_MEDIATEXTURE_H
+#define QUAPP_MEDIATEXTURE_H
+
+#include "templates/list.h"
+#include <QtOpenGL/QGLWidget>
+
+// Forward Declarations
+/* none */
+
+// Media Texture
+class MediaTexture : public ListItem<MediaTexture>
+{
+	public:
+	// Constructor / Destructor
+	MediaTexture();
+	~MediaTexture();
+
+
+	/*
+	 * Data
+	 */
+	private:
+	// Cache key of image from which texture was created
+	qint64 imageKey_;
+	// GL texture object
+	GLuint textureObject_;
+	// Size of texture data (in bytes)
+	int nBytes_;
+	// Number of references to this texture
+	int refCount_;
+
+	public:
+	// Set texture data
+	void set(qint64 imageKey, GLuint textureObject, int nBytes);
+	// Return cache key of image from which texture was created
+	qint64 imageKey();
+	// Return GL texture object
+	GLuint textureObject();
+	// Return size of texture data (in bytes)
+	int nBytes();
+	// Add reference to texture
+	void addReference();
+	// Remove reference from texture, returning the number remaining
+	int removeReference();
+	// Return number of references to texture
+	int refCount();
+};
+
+#endif
@@ -47,7 +47,6 @@ Messenger::Messenger()
 {
 	// Private variables
 	outputTypes_= 0;
-	callLevel_ = 0;
 	quiet_ = false;
 	textBrowser_ = NULL;
 }
@@ -147,25 +146,3 @@ void Messenger::print(Messenger::OutputType ot, const char* fmt, ...) const
 	}
 	va_end(arguments);
 }
-
-// Function enter
-void Messenger::enter(const char* callname)
-{
-	if (!isOutputActive(Messenger::Calls)) return;
-	// Debug Messaging - Enter Function
-	printf("%2i ",callLevel_);
-	for (int n=0; n<callLevel_; n++) printf("--");
-	printf("Begin : %s...\n", callname);
-	callLevel_ ++;
-}
-
-// Function leave
-void Messenger::exit(const char* callname)
-{
-	if (!isOutputActive(Messenger::Calls)) return;
-	// Debug Messaging - Leave Function
-	callLevel_ --;
-	printf("%2i ", callLevel_);
-	for (int n=0; n<callLevel_; n++) printf("--");
-	printf("End   : %s.\n", callname);
-}
@@ -45,8 +45,6 @@ class Messenger
 	private:
 	// Bit-vector of active output levels
 	int outputTypes_;
-	// Call level, used to provide indent for enter/exit info
-	int callLevel_;
 	// Quiet mode
 	bool quiet_;
 
@@ -77,9 +75,6 @@ class Messenger
 	void print(const char*, ...) const;
 	// Print message in specific output level
 	void print(Messenger::OutputType, const char*, ...) const;
-	// Entrances / exits to / from subroutines
-	void enter(const char* callname);
-	void exit(const char* callname);
 };
 
 extern Messenger msg;
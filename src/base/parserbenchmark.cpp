@@ -0,0 +1,90 @@
+/*
+	*** Parser Benchmark
+	*** src/base/parserbenchmark.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/parserbenchmark.h"
+#include "base/lineparser.h"
+#include "base/mappedlineparser.h"
+#include "base/quiz.h"
+#include "base/quizgenerator.h"
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFileInfo>
+#include <stdio.h>
+
+// Time tokenising of a generated quiz with the specified number of questions through LineParser and MappedLineParser, and a full load, printing the results
+void ParserBenchmark::run(int nQuestions)
+{
+	// Generate quiz, split into rounds of (at most) 2000 questions, without images
+	QuizGenerator generator;
+	int nRounds = qMax(1, (nQuestions+1999) / 2000);
+	generator.setParameter("rounds", QString::number(nRounds));
+	generator.setParameter("questions", QString::number(qMax(1, nQuestions / nRounds)));
+	generator.setParameter("imagesize", "0");
+	QString fileName = QDir::temp().filePath("quapp-parser-benchmark.qap");
+	if (!generator.write(fileName, QString()))
+	{
+		printf("Error: Couldn't write benchmark quiz to '%s'.\n", qPrintable(fileName));
+		return;
+	}
+	printf("Parser benchmark - %i questions, %.1f MB\n", generator.nRounds()*generator.nQuestions(), QFileInfo(fileName).size() / (1024.0*1024.0));
+
+	// Tokenise through LineParser, matching keywords by comparison against each keyword set in turn
+	QElapsedTimer timer;
+	timer.start();
+	LineParser lineParser(fileName);
+	int nLines[2] = { 0, 0 }, nArgs[2] = { 0, 0 }, keywordSum[2] = { 0, 0 };
+	while (!lineParser.atEnd())
+	{
+		if (!lineParser.getArgs(LineParser::UseQuotes + LineParser::SkipBlanks)) break;
+		++nLines[0];
+		nArgs[0] += lineParser.nArgs();
+		keywordSum[0] += Quiz::mainKeyword(lineParser.argString(0)) + Quiz::questionSetBlockKeyword(lineParser.argString(0)) + Quiz::questionBlockKeyword(lineParser.argString(0)) + Quiz::segmentBlockKeyword(lineParser.argString(0));
+	}
+	lineParser.closeFiles();
+	qint64 lineTime = timer.nsecsElapsed();
+
+	// Tokenise through MappedLineParser, matching keywords through the keyword tables
+	timer.start();
+	MappedLineParser mappedParser(fileName);
+	while (mappedParser.getArgs())
+	{
+		++nLines[1];
+		nArgs[1] += mappedParser.nArgs();
+		const TextView& keyword = mappedParser.arg(0);
+		keywordSum[1] += Quiz::mainKeyword(keyword.data, keyword.length) + Quiz::questionSetBlockKeyword(keyword.data, keyword.length) + Quiz::questionBlockKeyword(keyword.data, keyword.length) + Quiz::segmentBlockKeyword(keyword.data, keyword.length);
+	}
+	mappedParser.closeFiles();
+	qint64 mappedTime = timer.nsecsElapsed();
+
+	// Full load
+	Quiz quiz;
+	timer.start();
+	bool loaded = quiz.load(fileName);
+	qint64 loadTime = timer.nsecsElapsed();
+
+	printf("  LineParser + linear keywords     : %10.2f ms  (%i lines, %i arguments)\n", lineTime*1.0e-6, nLines[0], nArgs[0]);
+	printf("  MappedLineParser + keyword table : %10.2f ms  (%i lines, %i arguments)\n", mappedTime*1.0e-6, nLines[1], nArgs[1]);
+	printf("  Speedup                          : %10.2fx\n", mappedTime > 0 ? double(lineTime)/mappedTime : 0.0);
+	printf("  Results match                    : %10s\n", ((nLines[0] == nLines[1]) && (nArgs[0] == nArgs[1]) && (keywordSum[0] == keywordSum[1])) ? "yes" : "NO");
+	printf("  Quiz::load                       : %10.2f ms  (%s)\n", loadTime*1.0e-6, loaded ? "ok" : "failed");
+
+	QFile::remove(fileName);
+}
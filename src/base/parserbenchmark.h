@@ -0,0 +1,36 @@
+/*
+	*** Parser Benchmark
+	*** src/base/parserbenchmark.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_PARSERBENCHMARK_H
+#define QUAPP_PARSERBENCHMARK_H
+
+// Forward Declarations
+/* none */
+
+// Parser Benchmark
+class ParserBenchmark
+{
+	public:
+	// Time tokenising of a generated quiz with the specified number of questions through LineParser and MappedLineParser, and a full load, printing the results
+	static void run(int nQuestions);
+};
+
+#endif
@@ -20,8 +20,9 @@
 */
 
 #include "base/question.h"
+#include "base/mediabundle.h"
+#include "base/mediaregistry.h"
 #include <QtCore/QString>
-#include <QtCore/QFile>
 
 // Constructor
 Question::Question() : ListItem<Question>()
@@ -30,11 +31,15 @@ Question::Question() : ListItem<Question>()
 	audioAnswerOK_ = false;
 	imageQuestionOK_ = false;
 	imageAnswerOK_ = false;
+	imageQuestion_ = NULL;
+	imageAnswer_ = NULL;
 }
 
 // Destructor
 Question::~Question()
 {
+	MediaRegistry::releaseImage(imageQuestion_, this);
+	MediaRegistry::releaseImage(imageAnswer_, this);
 }
 
 /*
@@ -69,7 +74,9 @@ QString Question::textAnswer()
 void Question::setImageQuestion(QString fileName)
 {
 	imageQuestionFileName_ = fileName;
-	imageQuestionOK_ = imageQuestion_.load(fileName);
+	MediaRegistry::releaseImage(imageQuestion_, this);
+	imageQuestion_ = MediaRegistry::acquireImage(fileName, this);
+	imageQuestionOK_ = (imageQuestion_ && imageQuestion_->ok());
 }
 
 // Return image question filename
@@ -87,14 +94,16 @@ bool Question::imageQuestionOK()
 // Return image question
 QImage& Question::imageQuestion()
 {
-	return imageQuestion_;
+	return (imageQuestion_ ? MediaRegistry::residentImage(imageQuestion_) : MediaRegistry::nullImage());
 }
 
 // Set image answer (from filename)
 void Question::setImageAnswer(QString fileName)
 {
 	imageAnswerFileName_ = fileName;
-	imageAnswerOK_ = imageAnswer_.load(fileName);
+	MediaRegistry::releaseImage(imageAnswer_, this);
+	imageAnswer_ = MediaRegistry::acquireImage(fileName, this);
+	imageAnswerOK_ = (imageAnswer_ && imageAnswer_->ok());
 }
 
 // Return image answer filename
@@ -112,14 +121,14 @@ bool Question::imageAnswerOK()
 // Return image answer
 QImage& Question::imageAnswer()
 {
-	return imageAnswer_;
+	return (imageAnswer_ ? MediaRegistry::residentImage(imageAnswer_) : MediaRegistry::nullImage());
 }
 
 // Set audio question (from filename)
 void Question::setAudioQuestion(QString fileName)
 {
 	audioQuestionFileName_ = fileName;
-	audioQuestionOK_ = QFile::exists(fileName);
+	audioQuestionOK_ = MediaBundle::exists(fileName);
 }
 
 // Return audio question filename
@@ -138,7 +147,7 @@ bool Question::audioQuestionOK()
 void Question::setAudioAnswer(QString fileName)
 {
 	audioAnswerFileName_ = fileName;
-	audioAnswerOK_ = QFile::exists(fileName);
+	audioAnswerOK_ = MediaBundle::exists(fileName);
 }
 
 // Return audio answer filename
@@ -152,3 +161,21 @@ bool Question::audioAnswerOK()
 {
 	return audioAnswerOK_;
 }
+
+// Prefetch question and/or answer images ahead of display
+void Question::prefetchMedia(bool questionMedia, bool answerMedia)
+{
+	if (questionMedia && imageQuestionOK_) MediaRegistry::prefetchImage(imageQuestion_);
+	if (answerMedia && imageAnswerOK_) MediaRegistry::prefetchImage(imageAnswer_);
+}
+
+/*
+ * Media Notification
+ */
+
+// Notify that the specified image has finished loading
+void Question::mediaImageLoaded(MediaImage* image)
+{
+	if (image == imageQuestion_) imageQuestionOK_ = image->ok();
+	if (image == imageAnswer_) imageAnswerOK_ = image->ok();
+}
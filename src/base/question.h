@@ -22,16 +22,17 @@
 #ifndef QUAPP_QUESTION_H
 #define QUAPP_QUESTION_H
 
+#include "base/medialistener.h"
 #include "templates/list.h"
 #include <QtCore/QString>
 #include <QtGui/QImage>
 #include <QtGui/QSound>
 
 // Forward Declarations
-/* none */
+class MediaImage;
 
 // Question
-class Question : public ListItem<Question>
+class Question : public ListItem<Question>, public MediaListener
 {
 	public:
 	// Constructor / Destructor
@@ -51,14 +52,14 @@ class Question : public ListItem<Question>
 	QString imageQuestionFileName_;
 	// Whether question image was loaded successfully
 	bool imageQuestionOK_;
-	// Question image
-	QImage imageQuestion_;
+	// Question image (shared)
+	MediaImage* imageQuestion_;
 	// Answer image filename
 	QString imageAnswerFileName_;
 	// Whether answer image was loaded successfully
 	bool imageAnswerOK_;
-	// Answer image
-	QImage imageAnswer_;
+	// Answer image (shared)
+	MediaImage* imageAnswer_;
 	// Question sound filename
 	QString audioQuestionFileName_;
 	// Whether question audio is OK (exists)
@@ -105,6 +106,16 @@ class Question : public ListItem<Question>
 	QString audioAnswerFileName();
 	// Return whether audio answer is OK (exists)
 	bool audioAnswerOK();
+	// Prefetch question and/or answer images ahead of display
+	void prefetchMedia(bool questionMedia, bool answerMedia);
+
+
+	/*
+	 * Media Notification
+	 */
+	public:
+	// Notify that the specified image has finished loading
+	void mediaImageLoaded(MediaImage* image);
 };
 
 #endif
@@ -21,17 +21,23 @@
 
 #include "base/questionset.h"
 #include "base/messenger.h"
+#include "base/quizarchive.h"
+#include "base/tracer.h"
 #include <QtCore/QString>
 
 // Constructor
 QuestionSet::QuestionSet()
 {
 	name_ = "New QuestionSet";
+	archive_ = NULL;
+	archiveFirst_ = 0;
+	archiveCount_ = 0;
 }
 
 // Destructor
 QuestionSet::~QuestionSet()
 {
+	setArchiveSource(NULL, 0, 0);
 }
 
 /*
@@ -53,6 +59,8 @@ QString QuestionSet::name()
 // Add question
 Question* QuestionSet::addQuestion()
 {
+	materialise();
+
 	Question* newItem = questions_.add();
 
 	return newItem;
@@ -61,41 +69,99 @@ Question* QuestionSet::addQuestion()
 // Remove question
 void QuestionSet::removeQuestion(Question* item)
 {
+	materialise();
 	questions_.remove(item);
 }
 
 // Return number of questions
 int QuestionSet::nQuestions()
 {
+	materialise();
 	return questions_.nItems();
 }
 
 // Return questions
 Question* QuestionSet::questions()
 {
+	materialise();
 	return questions_.first();
 }
 
 // Return specified question
 Question* QuestionSet::question(int index)
 {
+	materialise();
 	return questions_[index];
 }
 
 // Return index of specified question
 int QuestionSet::indexOf(Question* item)
 {
+	materialise();
 	return questions_.indexOf(item);
 }
 
 // Move specified question up in list (towards head)
 void QuestionSet::moveQuestionUp(Question* item)
 {
+	materialise();
 	questions_.shiftUp(item);
 }
 
 // Move specified question down in list (towards tail)
 void QuestionSet::moveQuestionDown(Question* item)
 {
+	materialise();
 	questions_.shiftDown(item);
 }
+
+/*
+ * Archive Source
+ */
+
+// Set archive from which questions will be read when first needed
+void QuestionSet::setArchiveSource(QuizArchive* archive, int first, int count)
+{
+	if (archive) archive->addReference();
+	if (archive_ && (archive_->removeReference() == 0)) delete archive_;
+	archive_ = archive;
+	archiveFirst_ = first;
+	archiveCount_ = count;
+}
+
+// Return whether questions are still to be read from archive
+bool QuestionSet::pending()
+{
+	return (archive_ != NULL);
+}
+
+// Return archive from which questions are still to be read (if any)
+QuizArchive* QuestionSet::archiveSource()
+{
+	return archive_;
+}
+
+// Return index of first question in archive
+int QuestionSet::archiveFirst()
+{
+	return archiveFirst_;
+}
+
+// Return number of questions in archive
+int QuestionSet::archiveCount()
+{
+	return archiveCount_;
+}
+
+// Read questions from archive now, if they have not been already
+void QuestionSet::materialise()
+{
+	if (!archive_) return;
+
+	TRACESPAN("QuestionSet::materialise");
+
+	for (int n=0; n<archiveCount_; ++n) archive_->readQuestion(archiveFirst_+n, questions_.add());
+
+	// Release archive
+	setArchiveSource(NULL, 0, 0);
+}
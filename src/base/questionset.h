@@ -28,6 +28,7 @@
 
 // Forward Declarations
 class Quiz;
+class QuizArchive;
 
 // QuestionSet
 class QuestionSet : public ListItem<QuestionSet>
@@ -68,6 +69,32 @@ class QuestionSet : public ListItem<QuestionSet>
 	void moveQuestionUp(Question* item);
 	// Move specified question set item down in list (towards tail)
 	void moveQuestionDown(Question* item);
+
+
+	/*
+	 * Archive Source
+	 */
+	private:
+	// Archive from which questions are still to be read (if any)
+	QuizArchive* archive_;
+	// Index of first question in archive
+	int archiveFirst_;
+	// Number of questions in archive
+	int archiveCount_;
+
+	public:
+	// Set archive from which questions will be read when first needed
+	void setArchiveSource(QuizArchive* archive, int first, int count);
+	// Return whether questions are still to be read from archive
+	bool pending();
+	// Return archive from which questions are still to be read (if any)
+	QuizArchive* archiveSource();
+	// Return index of first question in archive
+	int archiveFirst();
+	// Return number of questions in archive
+	int archiveCount();
+	// Read questions from archive now, if they have not been already
+	void materialise();
 };
 
 #endif
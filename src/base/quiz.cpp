@@ -20,6 +20,7 @@
 */
 
 #include "base/quiz.h"
+#include "base/mediaregistry.h"
 #include "base/messenger.h"
 #include <QtCore/QString>
 
@@ -40,6 +41,7 @@ void Quiz::clear()
 {
 	segments_.clear();
 	teams_.clear();
+	questionSets_.clear();
 }
 
 /*
@@ -185,6 +187,22 @@ Segment* Quiz::currentSegment()
 	return currentSegment_;
 }
 
+// Prefetch media for the upcoming parts of the running order
+void Quiz::prefetchMedia()
+{
+	// Start a new window - anything not in it may now be evicted
+	MediaRegistry::beginPrefetch();
+	if (!currentSegment_) return;
+
+	int nParts = MediaRegistry::prefetchDepth();
+	currentSegment_->prefetchMedia(nParts, false);
+	for (Segment* segment = currentSegment_->next; (segment != NULL) && (nParts > 0); segment = segment->next)
+	{
+		if (segment->nonVisual()) continue;
+		segment->prefetchMedia(nParts, true);
+	}
+}
+
 /*
  * Teams
  */
@@ -29,7 +29,8 @@
 #include <QtCore/QString>
 
 // Forward Declarations
-class LineParser;
+class MappedLineParser;
+class QuizArchiveWriter;
 
 // Quiz
 class Quiz
@@ -114,6 +115,8 @@ class Quiz
 	void setCurrentSegment(Segment* segment);
 	// Return current segment
 	Segment* currentSegment();
+	// Prefetch media for the upcoming parts of the running order
+	void prefetchMedia();
 
 
 	/*
@@ -167,11 +170,13 @@ class Quiz
 		nSegmentKeywords
 	};
 	// Convert text string to SegmentBlockKeyword
-	SegmentBlockKeyword segmentBlockKeyword(QString s);
+	static SegmentBlockKeyword segmentBlockKeyword(QString s);
+	// Convert text (of specified length) to SegmentBlockKeyword
+	static SegmentBlockKeyword segmentBlockKeyword(const char* text, int length);
 	// Convert SegmentBlockKeyword to text string
-	const char* segmentBlockKeyword(SegmentBlockKeyword kwd);
+	static const char* segmentBlockKeyword(SegmentBlockKeyword kwd);
 	// Return minimum number of expected arguments
-	int segmentBlockKeywordNArguments(SegmentBlockKeyword kwd);
+	static int segmentBlockKeywordNArguments(SegmentBlockKeyword kwd);
 
 	// QuestionBlockKeyword Enum
 	enum QuestionBlockKeyword
@@ -186,11 +191,13 @@ class Quiz
 		nQuestionKeywords
 	};
 	// Convert text string to SegmentBlockKeyword
-	QuestionBlockKeyword questionBlockKeyword(QString s);
+	static QuestionBlockKeyword questionBlockKeyword(QString s);
+	// Convert text (of specified length) to QuestionBlockKeyword
+	static QuestionBlockKeyword questionBlockKeyword(const char* text, int length);
 	// Convert QuestionBlockKeyword to text string
-	const char* questionBlockKeyword(QuestionBlockKeyword kwd);
+	static const char* questionBlockKeyword(QuestionBlockKeyword kwd);
 	// Return minimum number of expected arguments
-	int questionBlockKeywordNArguments(QuestionBlockKeyword kwd);
+	static int questionBlockKeywordNArguments(QuestionBlockKeyword kwd);
 
 	// QuestionSetBlockKeyword Enum
 	enum QuestionSetBlockKeyword
@@ -200,11 +207,13 @@ class Quiz
 		nQuestionSetKeywords
 	};
 	// Convert text string to QuestionSetBlockKeyword
-	QuestionSetBlockKeyword questionSetBlockKeyword(QString s);
+	static QuestionSetBlockKeyword questionSetBlockKeyword(QString s);
+	// Convert text (of specified length) to QuestionSetBlockKeyword
+	static QuestionSetBlockKeyword questionSetBlockKeyword(const char* text, int length);
 	// Convert QuestionSetBlockKeyword to text string
-	const char* questionSetBlockKeyword(QuestionSetBlockKeyword kwd);
+	static const char* questionSetBlockKeyword(QuestionSetBlockKeyword kwd);
 	// Return minimum number of expected arguments
-	int questionSetBlockKeywordNArguments(QuestionSetBlockKeyword kwd);
+	static int questionSetBlockKeywordNArguments(QuestionSetBlockKeyword kwd);
 
 	// Main Keywords Enum
 	enum MainKeyword
@@ -216,24 +225,38 @@ class Quiz
 		nMainKeywords
 	};
 	// Convert text string to MainKeyword
-	MainKeyword mainKeyword(QString s);
+	static MainKeyword mainKeyword(QString s);
+	// Convert text (of specified length) to MainKeyword
+	static MainKeyword mainKeyword(const char* text, int length);
 	// Convert MainKeyword to text string
-	const char* mainKeyword(MainKeyword kwd);
+	static const char* mainKeyword(MainKeyword kwd);
 	// Return minimum number of expected arguments
-	int mainKeywordNArguments(MainKeyword kwd);
+	static int mainKeywordNArguments(MainKeyword kwd);
 
 	private:
 	// Read QuestionSetBlock keywords
-	bool readQuestionSetBlock(LineParser& parser, QuestionSet* questionSetItem);
+	bool readQuestionSetBlock(MappedLineParser& parser, QuestionSet* questionSetItem);
 	// Read QuestionBlock keywords
-	bool readQuestionBlock(LineParser& parser, Question* questionItem);
+	bool readQuestionBlock(MappedLineParser& parser, Question* questionItem);
 	// Read SegmentBlock keywords
-	bool readSegmentBlock(LineParser& parser, Segment* segment);
+	bool readSegmentBlock(MappedLineParser& parser, Segment* segment);
+	// Load from archive file, or part of one (question sets are read when first needed)
+	bool loadArchive(QString fileName, qint64 offset, qint64 size);
+	// Add quiz to archive writer
+	void writeArchive(QuizArchiveWriter& writer);
+	// Save to archive file
+	bool saveArchive(QString fileName);
+	// Load from bundle file
+	bool loadBundle(QString fileName);
+	// Save to bundle file
+	bool saveBundle(QString fileName);
+	// Read any question sets still held in an archive
+	void materialiseQuestionSets();
 
 	public:
-	// Load from file
+	// Load from file (text, archive, or bundle)
 	bool load(QString fileName);
-	// Save to file
+	// Save to file (as an archive or bundle if the filename has the corresponding extension)
 	bool save(QString fileName);
 };
 
@@ -20,9 +20,15 @@
 */
 
 #include "base/quiz.h"
-#include "base/lineparser.h"
+#include "base/keywordtable.h"
+#include "base/mappedlineparser.h"
+#include "base/mediabundle.h"
 #include "base/messenger.h"
+#include "base/quizarchive.h"
+#include "base/quizsnapshot.h"
 #include "base/session.h"
+#include "base/tracer.h"
+#include <QtCore/QFileInfo>
 
 /*
  * I/O
@@ -41,6 +47,15 @@ Quiz::SegmentBlockKeyword Quiz::segmentBlockKeyword(QString s)
 	return nSegmentKeywords;
 }
 
+// Segment Block Keyword Table
+KeywordTable SegmentBlockKeywordTable(SegmentBlockKeywords, Quiz::nSegmentKeywords);
+
+// Convert text (of specified length) to SegmentBlockKeyword
+Quiz::SegmentBlockKeyword Quiz::segmentBlockKeyword(const char* text, int length)
+{
+	return (Quiz::SegmentBlockKeyword) SegmentBlockKeywordTable.find(text, length);
+}
+
 // Convert SegmentBlockKeyword to text string
 const char* Quiz::segmentBlockKeyword(Quiz::SegmentBlockKeyword kwd)
 {
@@ -66,6 +81,15 @@ Quiz::QuestionBlockKeyword Quiz::questionBlockKeyword(QString s)
 	return nQuestionKeywords;
 }
 
+// Question Block Keyword Table
+KeywordTable QuestionBlockKeywordTable(QuestionBlockKeywords, Quiz::nQuestionKeywords);
+
+// Convert text (of specified length) to QuestionBlockKeyword
+Quiz::QuestionBlockKeyword Quiz::questionBlockKeyword(const char* text, int length)
+{
+	return (Quiz::QuestionBlockKeyword) QuestionBlockKeywordTable.find(text, length);
+}
+
 // Convert QuestionBlockKeyword to text string
 const char* Quiz::questionBlockKeyword(Quiz::QuestionBlockKeyword kwd)
 {
@@ -91,6 +115,15 @@ Quiz::QuestionSetBlockKeyword Quiz::questionSetBlockKeyword(QString s)
 	return nQuestionSetKeywords;
 }
 
+// Question Set Block Keyword Table
+KeywordTable QuestionSetBlockKeywordTable(QuestionSetBlockKeywords, Quiz::nQuestionSetKeywords);
+
+// Convert text (of specified length) to QuestionSetBlockKeyword
+Quiz::QuestionSetBlockKeyword Quiz::questionSetBlockKeyword(const char* text, int length)
+{
+	return (Quiz::QuestionSetBlockKeyword) QuestionSetBlockKeywordTable.find(text, length);
+}
+
 // Convert QuestionSetBlockKeyword to text string
 const char* Quiz::questionSetBlockKeyword(Quiz::QuestionSetBlockKeyword kwd)
 {
@@ -116,6 +149,15 @@ Quiz::MainKeyword Quiz::mainKeyword(QString s)
 	return nMainKeywords;
 }
 
+// Main Block Keyword Table
+KeywordTable MainBlockKeywordTable(MainBlockKeywords, Quiz::nMainKeywords);
+
+// Convert text (of specified length) to MainKeyword
+Quiz::MainKeyword Quiz::mainKeyword(const char* text, int length)
+{
+	return (Quiz::MainKeyword) MainBlockKeywordTable.find(text, length);
+}
+
 // Convert MainKeyword to text string
 const char* Quiz::mainKeyword(Quiz::MainKeyword kwd)
 {
@@ -129,17 +171,14 @@ int Quiz::mainKeywordNArguments(Quiz::MainKeyword kwd)
 }
 
 // Read QuestionSet keywords
-bool Quiz::readQuestionSetBlock(LineParser& parser, QuestionSet* questionSet)
+bool Quiz::readQuestionSetBlock(MappedLineParser& parser, QuestionSet* questionSet)
 {
 	Quiz::QuestionSetBlockKeyword setKwd;
 	Question* question;
-	while (!parser.atEnd())
+	while (parser.getArgs())
 	{
-		// Get line from file
-		parser.getArgs(LineParser::UseQuotes + LineParser::SkipBlanks);
-
 		// Get keyword and check number of arguments provided
-		setKwd = Quiz::questionSetBlockKeyword(parser.argString(0));
+		setKwd = Quiz::questionSetBlockKeyword(parser.arg(0).data, parser.arg(0).length);
 		if ((setKwd != Quiz::nQuestionSetKeywords) && (Quiz::questionSetBlockKeywordNArguments(setKwd) > (parser.nArgs()-1)))
 		{
 			msg.print("Error : QuestionSet keyword '%s' requires %i arguments, but only %i have been provided.\n", Quiz::questionSetBlockKeyword(setKwd), Quiz::questionSetBlockKeywordNArguments(setKwd), parser.nArgs()-1);
@@ -158,7 +197,7 @@ bool Quiz::readQuestionSetBlock(LineParser& parser, QuestionSet* questionSet)
 				break;
 			// Unrecognised Keyword
 			default:
-				msg.print("Warning: Unrecognised QuestionSet keyword: %s\n", parser.argChar(0));
+				msg.print("Warning: Unrecognised QuestionSet keyword: %s\n", qPrintable(parser.argString(0)));
 				break;
 		}
 	}
@@ -167,16 +206,13 @@ bool Quiz::readQuestionSetBlock(LineParser& parser, QuestionSet* questionSet)
 }
 
 // Read QuestionBlock keywords
-bool Quiz::readQuestionBlock(LineParser& parser, Question* question)
+bool Quiz::readQuestionBlock(MappedLineParser& parser, Question* question)
 {
 	Quiz::QuestionBlockKeyword itemKwd;
-	while (!parser.atEnd())
+	while (parser.getArgs())
 	{
-		// Get line from file
-		parser.getArgs(LineParser::UseQuotes + LineParser::SkipBlanks);
-
 		// Get keyword and check number of arguments provided
-		itemKwd = Quiz::questionBlockKeyword(parser.argString(0));
+		itemKwd = Quiz::questionBlockKeyword(parser.arg(0).data, parser.arg(0).length);
 		if ((itemKwd != Quiz::nQuestionKeywords) && (Quiz::questionBlockKeywordNArguments(itemKwd) > (parser.nArgs()-1)))
 		{
 			msg.print("Error : Question keyword '%s' requires %i arguments, but only %i have been provided.\n", Quiz::questionBlockKeyword(itemKwd), Quiz::questionBlockKeywordNArguments(itemKwd), parser.nArgs()-1);
@@ -214,7 +250,7 @@ bool Quiz::readQuestionBlock(LineParser& parser, Question* question)
 				break;
 			// Unrecognised Keyword
 			default:
-				msg.print("Warning: Unrecognised Question keyword: %s\n", parser.argChar(0));
+				msg.print("Warning: Unrecognised Question keyword: %s\n", qPrintable(parser.argString(0)));
 				break;
 		}
 	}
@@ -223,18 +259,15 @@ bool Quiz::readQuestionBlock(LineParser& parser, Question* question)
 }
 
 // Read SegmentBlock keywords
-bool Quiz::readSegmentBlock(LineParser& parser, Segment* segment)
+bool Quiz::readSegmentBlock(MappedLineParser& parser, Segment* segment)
 {
 	Segment::SegmentType segmentType;
 	Team* t;
 	QuestionSet* set;
-	while (!parser.atEnd())
+	while (parser.getArgs())
 	{
-		// Get line from file
-		parser.getArgs(LineParser::UseQuotes + LineParser::SkipBlanks);
-
 		// Get keyword and check number of arguments provided
-		Quiz::SegmentBlockKeyword segmentKwd = Quiz::segmentBlockKeyword(parser.argString(0));
+		Quiz::SegmentBlockKeyword segmentKwd = Quiz::segmentBlockKeyword(parser.arg(0).data, parser.arg(0).length);
 		if ((segmentKwd != Quiz::nSegmentKeywords) && (Quiz::segmentBlockKeywordNArguments(segmentKwd) > (parser.nArgs()-1)))
 		{
 			msg.print("Error : Segment keyword '%s' requires %i arguments, but only %i have been provided.\n", Quiz::segmentBlockKeyword(segmentKwd), Quiz::segmentBlockKeywordNArguments(segmentKwd), parser.nArgs()-1);
@@ -263,7 +296,7 @@ bool Quiz::readSegmentBlock(LineParser& parser, Segment* segment)
 				set = questionSet(parser.argString(1));
 				if (!set)
 				{
-					msg.print("Couldn't find question set '%s' specified in segment '%s'.\n", parser.argChar(1), qPrintable(segment->name()));
+					msg.print("Couldn't find question set '%s' specified in segment '%s'.\n", qPrintable(parser.argString(1)), qPrintable(segment->name()));
 				}
 				else segment->setQuestionSource(set);
 				break;
@@ -271,7 +304,7 @@ bool Quiz::readSegmentBlock(LineParser& parser, Segment* segment)
 			case (Quiz::ScoreKeyword):
 				t = team(parser.argString(1));
 				if (t) segment->setScore(t, parser.argd(2));
-				else msg.print("Warning: Unrecognised team name '%s' found in score.\n", parser.argChar(1));
+				else msg.print("Warning: Unrecognised team name '%s' found in score.\n", qPrintable(parser.argString(1)));
 				break;
 			// Subtext
 			case (Quiz::SubTextKeyword):
@@ -286,14 +319,14 @@ bool Quiz::readSegmentBlock(LineParser& parser, Segment* segment)
 				segmentType = Segment::segmentType(parser.argString(1));
 				if (segmentType == Segment::nSegmentTypes)
 				{
-					msg.print("Warning: Unrecognised segment type '%s'. Defaulting to '%s'.\n", parser.argChar(1), Segment::segmentType(Segment::TitleSegment));
+					msg.print("Warning: Unrecognised segment type '%s'. Defaulting to '%s'.\n", qPrintable(parser.argString(1)), Segment::segmentType(Segment::TitleSegment));
 					segmentType = Segment::TitleSegment;
 				}
 				segment->setType(segmentType);
 				break;
 			// Unrecognised Keyword
 			default:
-				msg.print("Warning: Unrecognised segment keyword: %s\n", parser.argChar(0));
+				msg.print("Warning: Unrecognised segment keyword: %s\n", qPrintable(parser.argString(0)));
 				break;
 		}
 	}
@@ -304,7 +337,12 @@ bool Quiz::readSegmentBlock(LineParser& parser, Segment* segment)
 // Load from file specified
 bool Quiz::load(QString fileName)
 {
-	LineParser parser(fileName);
+	TRACESPAN("Quiz::load");
+
+	if (QuizArchive::isArchive(fileName)) return loadArchive(fileName, 0, -1);
+	if (MediaBundle::isBundle(fileName)) return loadBundle(fileName);
+
+	MappedLineParser parser(fileName);
 
 	if (!parser.ready()) return false;
 
@@ -312,16 +350,14 @@ bool Quiz::load(QString fileName)
 
 	// Read line from file and decide what to do with it
 	Quiz::MainKeyword kwd;
-	bool success;
+	bool success = true;
 	Team* team;
 	Segment* segment;
 	QuestionSet* set;
-	while (!parser.atEnd())
+	while (parser.getArgs())
 	{
-		parser.getArgs(LineParser::UseQuotes + LineParser::SkipBlanks);
-
 		// We expect a block keyword in this loop...
-		kwd = Quiz::mainKeyword(parser.argString(0));
+		kwd = Quiz::mainKeyword(parser.arg(0).data, parser.arg(0).length);
 		switch (kwd)
 		{
 			// QuestionSet
@@ -340,7 +376,7 @@ bool Quiz::load(QString fileName)
 			case (Quiz::TeamKeyword):
 				if (segments_.nItems() != 0)
 				{
-					msg.print("Warning: Teams must be specified before any segments are defined. Will ignore '%s'...\n", parser.argChar(1));
+					msg.print("Warning: Teams must be specified before any segments are defined. Will ignore '%s'...\n", qPrintable(parser.argString(1)));
 					break;
 				}
 				team = addTeam(parser.argString(1));
@@ -350,7 +386,7 @@ bool Quiz::load(QString fileName)
 				title_ = parser.argString(1);
 				break;
 			default:
-				msg.print("Warning: Unrecognised keyword: %s\n", parser.argChar(0));
+				msg.print("Warning: Unrecognised keyword: %s\n", qPrintable(parser.argString(0)));
 				break;
 		}
 
@@ -374,50 +410,196 @@ bool Quiz::load(QString fileName)
 // Save quiz to file
 bool Quiz::save(QString fileName)
 {
-	LineParser parser(fileName, true);
+	TRACESPAN("Quiz::save");
 
-	if (!parser.ready()) return false;
+	if (QFileInfo(fileName).suffix() == QuizArchive::extension()) return saveArchive(fileName);
+	if (QFileInfo(fileName).suffix() == MediaBundle::extension()) return saveBundle(fileName);
 
-	// Write main keywords
-	parser.writeLineF("%s  '%s'\n", Quiz::mainKeyword(Quiz::TitleKeyword), qPrintable(title_));
+	// Media in an open bundle must be extracted, since the file we write will not be able to find them once the bundle is closed
+	bool extract = !MediaBundle::fileName().isEmpty();
+	if (extract) materialiseQuestionSets();
 
-	// Write teams
-	for (Team* team = teams_.first(); team != NULL; team = team->next) parser.writeLineF("%s  '%s'\n", Quiz::mainKeyword(Quiz::TeamKeyword), qPrintable(team->name()));
+	// Take a snapshot of the quiz and write it out - the file is replaced atomically, so this is safe even if the snapshot is reading from it
+	QuizSnapshot snapshot(*this);
+	if (extract) snapshot.extractBundledMedia(fileName);
+	return snapshot.write(fileName);
+}
 
-	// Write question sets
-	for (QuestionSet* set = questionSets_.first(); set != NULL; set = set->next)
+// Load from archive file, or part of one (question sets are read when first needed)
+bool Quiz::loadArchive(QString fileName, qint64 offset, qint64 size)
+{
+	QuizArchive* archive = new QuizArchive;
+	if (!archive->open(fileName, offset, size))
+	{
+		delete archive;
+		return false;
+	}
+
+	clear();
+
+	if (archive->nRecords(QuizArchive::QuizSection) > 0) title_ = archive->string(archive->value(QuizArchive::QuizSection, 0, 0));
+
+	// Teams
+	QVector<Team*> teams(archive->nRecords(QuizArchive::TeamSection));
+	for (int n=0; n<teams.count(); ++n) teams[n] = addTeam(archive->string(archive->value(QuizArchive::TeamSection, n, 0)));
+
+	// Question sets - we note only where their questions are for now
+	bool success = true;
+	int nQuestions = archive->nRecords(QuizArchive::QuestionSection);
+	QVector<QuestionSet*> sets(archive->nRecords(QuizArchive::QuestionSetSection));
+	for (int n=0; n<sets.count(); ++n)
 	{
-		parser.writeLineF("%s  '%s'\n", Quiz::mainKeyword(Quiz::QuestionSetKeyword), qPrintable(set->name()));
-		for (Question* question = set->questions(); question != NULL; question = question->next)
+		sets[n] = questionSets_.add();
+		sets[n]->setName(archive->string(archive->value(QuizArchive::QuestionSetSection, n, 0)));
+		quint32 first = archive->value(QuizArchive::QuestionSetSection, n, 1), count = archive->value(QuizArchive::QuestionSetSection, n, 2);
+		if ((first > (quint32) nQuestions) || (count > nQuestions - first))
 		{
-			parser.writeLineF("  %s\n", Quiz::questionSetBlockKeyword(Quiz::QuestionKeyword));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::TextQuestionKeyword), qPrintable(question->textQuestion()));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::TextAnswerKeyword), qPrintable(question->textAnswer()));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::AudioQuestionKeyword), qPrintable(question->audioQuestionFileName()));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::AudioAnswerKeyword), qPrintable(question->audioAnswerFileName()));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::ImageQuestionKeyword), qPrintable(question->imageQuestionFileName()));
-			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::ImageAnswerKeyword), qPrintable(question->imageAnswerFileName()));
-			parser.writeLineF("  %s\n", Quiz::questionBlockKeyword(Quiz::EndQuestionKeyword));
+			msg.print("Error : Questions for set '%s' lie outside the archive's question table.\n", qPrintable(sets[n]->name()));
+			success = false;
+			break;
 		}
-		parser.writeLineF("%s\n", Quiz::questionSetBlockKeyword(Quiz::EndQuestionSetKeyword));
+		if (count > 0) sets[n]->setArchiveSource(archive, first, count);
 	}
 
-	// Write segments
-	for (Segment* segment = segments_.first(); segment != NULL; segment = segment->next) 
+	// Segments
+	int nScores = archive->nRecords(QuizArchive::ScoreSection);
+	for (int n=0; (n<archive->nRecords(QuizArchive::SegmentSection)) && success; ++n)
 	{
-		parser.writeLineF("%s\n", Quiz::mainKeyword(Quiz::SegmentKeyword));
-		parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::ImageKeyword), qPrintable(segment->imageFileName()));
-		parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::NameKeyword), qPrintable(segment->name()));
-		if (segment->nonVisual()) parser.writeLineF("  %s\n", Quiz::segmentBlockKeyword(Quiz::NonVisualKeyword));
-		parser.writeLineF("  %s  %s\n", Quiz::segmentBlockKeyword(Quiz::TypeKeyword), Segment::segmentType(segment->type()));
-		if (segment->questionSource()) parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::QuestionSourceKeyword), qPrintable(segment->questionSource()->name()));
-		for (RefListItem<Team,double>* ri = segment->scores(); ri != NULL; ri = ri->next) parser.writeLineF("  %s  '%s' %f\n", Quiz::segmentBlockKeyword(Quiz::ScoreKeyword), qPrintable(ri->item->name()), ri->data);
-		parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::SubTextKeyword), qPrintable(segment->subText()));
-		parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::TitleTextKeyword), qPrintable(segment->titleText()));
-		parser.writeLineF("%s\n", Quiz::segmentBlockKeyword(Quiz::EndSegmentKeyword));
+		Segment* segment = segments_.add(*this);
+		segment->updateScores(teams_);
+		segment->setName(archive->string(archive->value(QuizArchive::SegmentSection, n, 0)));
+		quint32 type = archive->value(QuizArchive::SegmentSection, n, 1);
+		if (type >= Segment::nSegmentTypes)
+		{
+			msg.print("Warning: Unrecognised segment type %i. Defaulting to '%s'.\n", type, Segment::segmentType(Segment::TitleSegment));
+			type = Segment::TitleSegment;
+		}
+		segment->setType((Segment::SegmentType) type);
+		segment->setNonVisual(archive->value(QuizArchive::SegmentSection, n, 2) & 1);
+		quint32 setIndex = archive->value(QuizArchive::SegmentSection, n, 3);
+		if ((setIndex > 0) && (setIndex <= (quint32) sets.count())) segment->setQuestionSource(sets[setIndex-1]);
+		segment->setImage(archive->mediaFileName(archive->value(QuizArchive::SegmentSection, n, 4)));
+		segment->setSubText(archive->string(archive->value(QuizArchive::SegmentSection, n, 5)));
+		segment->setTitleText(archive->string(archive->value(QuizArchive::SegmentSection, n, 6)));
+		quint32 first = archive->value(QuizArchive::SegmentSection, n, 7), count = archive->value(QuizArchive::SegmentSection, n, 8);
+		if ((first > (quint32) nScores) || (count > nScores - first))
+		{
+			msg.print("Error : Scores for segment '%s' lie outside the archive's score table.\n", qPrintable(segment->name()));
+			success = false;
+			break;
+		}
+		for (quint32 i=first; i<first+count; ++i)
+		{
+			quint32 teamIndex = archive->value(QuizArchive::ScoreSection, i, 0);
+			if (teamIndex < (quint32) teams.count()) segment->setScore(teams[teamIndex], archive->doubleValue(QuizArchive::ScoreSection, i, 1));
+			else msg.print("Warning: Unrecognised team index %i found in score.\n", teamIndex);
+		}
 	}
 
-	parser.closeFiles();
+	// If no question sets need the archive, we can close it now
+	if (archive->refCount() == 0) delete archive;
+
+	if (!success) return false;
+
+	Session::setInputFile(fileName);
+	Session::setAsNotModified();
+	updateTeamScoresAndRanks();
 
 	return true;
 }
+
+// Add quiz to archive writer
+void Quiz::writeArchive(QuizArchiveWriter& writer)
+{
+	// Question sets still held in an archive must be read before we (potentially) overwrite it
+	materialiseQuestionSets();
+
+	writer.addValue(QuizArchive::QuizSection, writer.addString(title_));
+
+	// Teams
+	QHash<Team*,int> teamIndices;
+	for (Team* team = teams_.first(); team != NULL; team = team->next)
+	{
+		teamIndices.insert(team, teamIndices.count());
+		writer.addValue(QuizArchive::TeamSection, writer.addString(team->name()));
+	}
+
+	// Question sets
+	QHash<QuestionSet*,int> setIndices;
+	for (QuestionSet* set = questionSets_.first(); set != NULL; set = set->next)
+	{
+		setIndices.insert(set, setIndices.count());
+		writer.addValue(QuizArchive::QuestionSetSection, writer.addString(set->name()));
+		writer.addValue(QuizArchive::QuestionSetSection, writer.nRecords(QuizArchive::QuestionSection));
+		writer.addValue(QuizArchive::QuestionSetSection, set->nQuestions());
+		for (Question* question = set->questions(); question != NULL; question = question->next) writer.addQuestion(question);
+	}
+
+	// Segments
+	for (Segment* segment = segments_.first(); segment != NULL; segment = segment->next)
+	{
+		writer.addValue(QuizArchive::SegmentSection, writer.addString(segment->name()));
+		writer.addValue(QuizArchive::SegmentSection, segment->type());
+		writer.addValue(QuizArchive::SegmentSection, segment->nonVisual() ? 1 : 0);
+		writer.addValue(QuizArchive::SegmentSection, segment->questionSource() ? setIndices.value(segment->questionSource())+1 : 0);
+		writer.addValue(QuizArchive::SegmentSection, writer.addMedia(segment->imageFileName()));
+		writer.addValue(QuizArchive::SegmentSection, writer.addString(segment->subText()));
+		writer.addValue(QuizArchive::SegmentSection, writer.addString(segment->titleText()));
+		writer.addValue(QuizArchive::SegmentSection, writer.nRecords(QuizArchive::ScoreSection));
+		int nScores = 0;
+		for (RefListItem<Team,double>* ri = segment->scores(); ri != NULL; ri = ri->next)
+		{
+			writer.addValue(QuizArchive::ScoreSection, teamIndices.value(ri->item));
+			writer.addDouble(QuizArchive::ScoreSection, ri->data);
+			++nScores;
+		}
+		writer.addValue(QuizArchive::SegmentSection, nScores);
+	}
+}
+
+// Save to archive file
+bool Quiz::saveArchive(QString fileName)
+{
+	QuizArchiveWriter writer;
+	writer.setExtractTarget(fileName);
+	writeArchive(writer);
+
+	return writer.write(fileName);
+}
+
+// Load from bundle file
+bool Quiz::loadBundle(QString fileName)
+{
+	// Release media from the current quiz before its bundle (if any) is closed
+	clear();
+
+	qint64 offset, size;
+	if (!MediaBundle::open(fileName)) return false;
+	if (!MediaBundle::quizEntry(offset, size))
+	{
+		msg.print("Error: Bundle '%s' contains no quiz.\n", qPrintable(fileName));
+		MediaBundle::close();
+		return false;
+	}
+
+	return loadArchive(fileName, offset, size);
+}
+
+// Save to bundle file
+bool Quiz::saveBundle(QString fileName)
+{
+	QuizArchiveWriter writer;
+	writer.setBundleMedia(true);
+	writeArchive(writer);
+
+	QByteArray quizData = writer.data();
+	if (quizData.isEmpty()) return false;
+
+	return MediaBundle::write(fileName, quizData, writer.bundledMedia());
+}
+
+// Read any question sets still held in an archive
+void Quiz::materialiseQuestionSets()
+{
+	for (QuestionSet* set = questionSets_.first(); set != NULL; set = set->next) set->materialise();
+}
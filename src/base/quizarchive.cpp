@@ -0,0 +1,580 @@
+/*
+	*** Quiz Archive
+	*** src/base/quizarchive.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/quizarchive.h"
+#include "base/mediabundle.h"
+#include "base/messenger.h"
+#include "base/question.h"
+#include "base/sysfunc.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QFileInfo>
+#include <QtCore/qendian.h>
+#include <string.h>
+
+// Archive Magic
+const char ArchiveMagic[] = { 'Q', 'A', 'P', 'B' };
+
+// Maximum number of content hashes held in cache
+const int MaxFileHashes = 1024;
+
+// Size of archive header (magic, version, number of sections, reserved)
+const int ArchiveHeaderSize = 16;
+
+// Size of section table entry (type, number of records, offset, size)
+const int ArchiveSectionEntrySize = 16;
+
+// Number of fields in each record of each section
+int ArchiveSectionNFields[] = { 1, 0, 7, 1, 3, 6, 9, 3 };
+
+// Read little-endian value from data
+static inline quint32 readValue(const uchar* data)
+{
+	return qFromLittleEndian<quint32>(data);
+}
+
+// Constructor
+QuizArchive::QuizArchive()
+{
+	map_ = NULL;
+	for (int n=0; n<nSections; ++n)
+	{
+		sections_[n] = NULL;
+		nRecords_[n] = 0;
+	}
+	stringOffsets_ = NULL;
+	stringData_ = NULL;
+	nStrings_ = 0;
+}
+
+// Destructor
+QuizArchive::~QuizArchive()
+{
+	if (map_) file_.unmap(map_);
+	file_.close();
+}
+
+/*
+ * Format
+ */
+
+// Return number of 32-bit fields in each record of the specified section
+int QuizArchive::nFields(QuizArchive::Section section)
+{
+	return ArchiveSectionNFields[section];
+}
+
+// Return current format version
+int QuizArchive::version()
+{
+	return 1;
+}
+
+// Return standard file extension
+const char* QuizArchive::extension()
+{
+	return "qab";
+}
+
+// Return whether the specified file is a quiz archive
+bool QuizArchive::isArchive(QString fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) return false;
+	char magic[4];
+	return ((file.read(magic, 4) == 4) && (memcmp(magic, ArchiveMagic, 4) == 0));
+}
+
+/*
+ * Content Hashes
+ */
+
+// Static Members
+QHash<QString,QByteArray> QuizArchive::fileHashes_;
+QList<QString> QuizArchive::fileHashOrder_;
+QMutex QuizArchive::fileHashMutex_;
+
+// Return MD5 content hash of specified media file (or sixteen zero bytes if it does not exist)
+QByteArray QuizArchive::fileHash(QString fileName)
+{
+	// Bundled files have their hash stored
+	if (MediaBundle::isBundlePath(fileName))
+	{
+		QByteArray hash = MediaBundle::contentHash(fileName);
+		if (!hash.isEmpty()) return hash;
+		return (MediaBundle::exists(fileName) ? QCryptographicHash::hash(MediaBundle::data(fileName), QCryptographicHash::Md5) : QByteArray(16, '\0'));
+	}
+
+	// Other files are hashed once for each version of the file
+	QFileInfo fileInfo(fileName);
+	if (!fileInfo.exists()) return QByteArray(16, '\0');
+	QString hashKey = QString("%1|%2|%3").arg(fileInfo.absoluteFilePath()).arg(fileInfo.lastModified().toTime_t()).arg(fileInfo.size());
+	QMutexLocker locker(&fileHashMutex_);
+	if (fileHashes_.contains(hashKey)) return fileHashes_.value(hashKey);
+	locker.unlock();
+
+	QByteArray hash = QCryptographicHash::hash(MediaBundle::data(fileName), QCryptographicHash::Md5);
+
+	// Discard the oldest hashes once the cache is full
+	locker.relock();
+	if (!fileHashes_.contains(hashKey))
+	{
+		while (fileHashOrder_.count() >= MaxFileHashes) fileHashes_.remove(fileHashOrder_.takeFirst());
+		fileHashes_.insert(hashKey, hash);
+		fileHashOrder_.append(hashKey);
+	}
+	return hash;
+}
+
+/*
+ * Source
+ */
+
+// Open (and map) specified file, or part of it, checking its structure
+bool QuizArchive::open(QString fileName, qint64 offset, qint64 size)
+{
+	file_.setFileName(fileName);
+	mediaFileNames_.clear();
+	if (!file_.open(QIODevice::ReadOnly))
+	{
+		msg.print("Error: Couldn't open file '%s' for reading.\n", qPrintable(fileName));
+		return false;
+	}
+
+	// Map the file if we can, or read it in one go if we can't
+	if ((size < 0) || (offset + size > file_.size())) size = qMax(file_.size() - offset, qint64(0));
+	const uchar* data;
+	if (size > 0) map_ = file_.map(offset, size);
+	if (map_) data = map_;
+	else
+	{
+		if (file_.seek(offset)) contents_ = file_.read(size);
+		data = (const uchar*) contents_.constData();
+		size = contents_.size();
+	}
+
+	// Check header
+	if ((size < ArchiveHeaderSize) || (memcmp(data, ArchiveMagic, 4) != 0))
+	{
+		msg.print("Error: File '%s' is not a quiz archive.\n", qPrintable(fileName));
+		return false;
+	}
+	int fileVersion = readValue(data+4);
+	if (fileVersion > version())
+	{
+		msg.print("Error: Quiz archive '%s' is version %i, but only versions up to %i are understood.\n", qPrintable(fileName), fileVersion, version());
+		return false;
+	}
+	quint32 nTableEntries = readValue(data+8);
+	if (nTableEntries > (size - ArchiveHeaderSize) / ArchiveSectionEntrySize)
+	{
+		msg.print("Error: Quiz archive '%s' has a damaged section table.\n", qPrintable(fileName));
+		return false;
+	}
+
+	// Read section table, checking that each section lies within the file and is large enough for its records
+	const uchar* entry = data + ArchiveHeaderSize;
+	for (quint32 n=0; n<nTableEntries; ++n, entry += ArchiveSectionEntrySize)
+	{
+		quint32 type = readValue(entry), nRecords = readValue(entry+4), offset = readValue(entry+8), sectionSize = readValue(entry+12);
+		if ((offset > size) || (sectionSize > size - offset))
+		{
+			msg.print("Error: Section %i of quiz archive '%s' lies outside the file.\n", n, qPrintable(fileName));
+			return false;
+		}
+		if (type >= nSections) continue;
+		Section section = (Section) type;
+		if ((nFields(section) > 0) && (nRecords > sectionSize / (nFields(section)*4)))
+		{
+			msg.print("Error: Section %i of quiz archive '%s' is too small for its records.\n", n, qPrintable(fileName));
+			return false;
+		}
+		sections_[section] = data + offset;
+		nRecords_[section] = nRecords;
+
+		// The string table must have an offset for the end of each string, in order, and within the section
+		if (section == StringSection)
+		{
+			if ((sectionSize < 4) || (nRecords != readValue(data+offset)) || ((quint64(nRecords)+2)*4 > sectionSize))
+			{
+				msg.print("Error: Quiz archive '%s' has a damaged string table.\n", qPrintable(fileName));
+				return false;
+			}
+			nStrings_ = nRecords;
+			stringOffsets_ = data + offset + 4;
+			stringData_ = stringOffsets_ + (nStrings_+1)*4;
+			quint32 dataSize = sectionSize - (nStrings_+2)*4, last = 0, current;
+			for (int i=0; i<=nStrings_; ++i)
+			{
+				current = readValue(stringOffsets_ + i*4);
+				if ((current < last) || (current > dataSize))
+				{
+					msg.print("Error: Quiz archive '%s' has a damaged string table.\n", qPrintable(fileName));
+					return false;
+				}
+				last = current;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Add reference to archive
+void QuizArchive::addReference()
+{
+	refCount_.ref();
+}
+
+// Remove reference from archive, returning the number remaining
+int QuizArchive::removeReference()
+{
+	return refCount_.fetchAndAddOrdered(-1) - 1;
+}
+
+// Return number of references to archive
+int QuizArchive::refCount()
+{
+	return refCount_;
+}
+
+/*
+ * Records
+ */
+
+// Return number of records in specified section
+int QuizArchive::nRecords(QuizArchive::Section section)
+{
+	return nRecords_[section];
+}
+
+// Return integer field from record in specified section
+quint32 QuizArchive::value(QuizArchive::Section section, int record, int field)
+{
+	return readValue(sections_[section] + (record*nFields(section) + field)*4);
+}
+
+// Return double (occupying two fields) from record in specified section
+double QuizArchive::doubleValue(QuizArchive::Section section, int record, int field)
+{
+	quint64 bits = qFromLittleEndian<quint64>(sections_[section] + (record*nFields(section) + field)*4);
+	double result;
+	memcpy(&result, &bits, sizeof(double));
+	return result;
+}
+
+// Return string with specified index
+QString QuizArchive::string(quint32 index)
+{
+	if (index >= (quint32) nStrings_) return QString();
+	quint32 start = readValue(stringOffsets_ + index*4);
+	return QString::fromUtf8((const char*) stringData_ + start, readValue(stringOffsets_ + index*4 + 4) - start);
+}
+
+// Return content hash of media with specified reference
+QByteArray QuizArchive::mediaHash(quint32 reference)
+{
+	if ((reference == 0) || (reference > (quint32) nRecords_[MediaSection])) return QByteArray();
+	QByteArray hash(16, '\0');
+	for (int n=0; n<4; ++n) qToLittleEndian<quint32>(value(MediaSection, reference-1, n+3), (uchar*) hash.data() + n*4);
+	return hash;
+}
+
+// Return filename of media with specified reference, resolved by its content hash
+QString QuizArchive::mediaFileName(quint32 reference)
+{
+	if ((reference == 0) || (reference > (quint32) nRecords_[MediaSection])) return QString();
+
+	// Media are resolved once, since checking a file against its hash may mean reading it
+	QMutexLocker locker(&mediaMutex_);
+	if (mediaFileNames_.contains(reference)) return mediaFileNames_.value(reference);
+	locker.unlock();
+
+	QString fileName = resolveMediaFileName(reference);
+
+	locker.relock();
+	mediaFileNames_.insert(reference, fileName);
+	return fileName;
+}
+
+// Return text of field in specified question record (media references are returned as filenames)
+QString QuizArchive::questionField(int index, int field)
+{
+	return (field < 2 ? string(value(QuestionSection, index, field)) : mediaFileName(value(QuestionSection, index, field)));
+}
+
+// Read specified question record into question
+void QuizArchive::readQuestion(int index, Question* question)
+{
+	question->setTextQuestion(questionField(index, 0));
+	question->setTextAnswer(questionField(index, 1));
+	question->setAudioQuestion(questionField(index, 2));
+	question->setAudioAnswer(questionField(index, 3));
+	question->setImageQuestion(questionField(index, 4));
+	question->setImageAnswer(questionField(index, 5));
+}
+
+/*
+ * Media Resolution
+ */
+
+// Resolve filename of media with specified reference from its content hash
+QString QuizArchive::resolveMediaFileName(quint32 reference)
+{
+	QString fileName = string(value(MediaSection, reference-1, 0));
+	QByteArray hash = mediaHash(reference);
+
+	// A zero hash means the file didn't exist when the archive was written, so there is nothing to resolve by
+	if (hash == QByteArray(16, '\0')) return fileName;
+
+	// Prefer the copy of the content held in the open bundle, whatever the file was called when it was added
+	QString bundleName = MediaBundle::bundlePath(QString("media/%1.%2").arg(QString(hash.toHex()), QFileInfo(fileName).suffix().toLower()));
+	if (MediaBundle::exists(bundleName)) return bundleName;
+
+	// Otherwise check that the named file still has the content it was referenced with
+	if (!MediaBundle::exists(fileName)) msg.print("Warning: Media file '%s' could not be found.\n", qPrintable(fileName));
+	else
+	{
+		quint64 size = quint64(value(MediaSection, reference-1, 1)) | (quint64(value(MediaSection, reference-1, 2)) << 32);
+		qint64 currentSize = MediaBundle::isBundlePath(fileName) ? MediaBundle::data(fileName).size() : QFileInfo(fileName).size();
+		if ((quint64(currentSize) != size) || (fileHash(fileName) != hash)) msg.print("Warning: Media file '%s' has changed since the quiz was saved.\n", qPrintable(fileName));
+	}
+	return fileName;
+}
+
+/*
+ * Quiz Archive Writer
+ */
+
+// Constructor
+QuizArchiveWriter::QuizArchiveWriter()
+{
+	for (int n=0; n<QuizArchive::nSections; ++n) nRecords_[n] = 0;
+	bundleMedia_ = false;
+
+	// String zero is always the empty string
+	stringOffsets_.append(0);
+	addString(QString());
+}
+
+// Destructor
+QuizArchiveWriter::~QuizArchiveWriter()
+{
+}
+
+/*
+ * Sections
+ */
+
+// Add value to current record in specified section (starting a new record if the last is complete)
+void QuizArchiveWriter::addValue(QuizArchive::Section section, quint32 value)
+{
+	if ((sections_[section].size() / 4) % QuizArchive::nFields(section) == 0) ++nRecords_[section];
+	uchar bytes[4];
+	qToLittleEndian<quint32>(value, bytes);
+	sections_[section].append((const char*) bytes, 4);
+}
+
+// Add double (occupying two fields) to current record in specified section
+void QuizArchiveWriter::addDouble(QuizArchive::Section section, double value)
+{
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(double));
+	addValue(section, quint32(bits & 0xffffffff));
+	addValue(section, quint32(bits >> 32));
+}
+
+// Return number of records in specified section
+int QuizArchiveWriter::nRecords(QuizArchive::Section section)
+{
+	return nRecords_[section];
+}
+
+/*
+ * Strings and Media
+ */
+
+// Add string to table (if it is not there already) and return its index
+quint32 QuizArchiveWriter::addString(QString text)
+{
+	if (stringIndices_.contains(text)) return stringIndices_.value(text);
+
+	quint32 index = stringOffsets_.size() - 1;
+	stringData_.append(text.toUtf8());
+	stringOffsets_.append(stringData_.size());
+	stringIndices_.insert(text, index);
+	return index;
+}
+
+// Add media file to table (if it is not there already) and return its reference
+quint32 QuizArchiveWriter::addMedia(QString fileName)
+{
+	if (fileName.isEmpty()) return 0;
+	if (mediaIndices_.contains(fileName)) return mediaIndices_.value(fileName);
+	QString sourceFileName = fileName;
+
+	// Bundled media will not be found once the bundle is closed, so unless we are writing a bundle they must be extracted
+	if (!bundleMedia_ && !extractTarget_.isEmpty()) fileName = MediaBundle::extract(fileName, extractTarget_);
+
+	// Hash file contents, unless we already have done so for this version of the file (bundled files have their hash stored)
+	QFileInfo fileInfo(fileName);
+	bool bundled = MediaBundle::isBundlePath(fileName);
+	qint64 size = bundled ? MediaBundle::data(fileName).size() : (fileInfo.exists() ? fileInfo.size() : 0);
+	QByteArray hash = QuizArchive::fileHash(fileName);
+
+	// When bundling, files which exist are stored once per distinct content, and referred to by their path in the bundle
+	if (bundleMedia_ && MediaBundle::exists(fileName))
+	{
+		QString suffix = bundled ? QFileInfo(fileName.mid(fileName.indexOf(':')+1)).suffix() : fileInfo.suffix();
+		QString entryName = QString("media/%1.%2").arg(QString(hash.toHex()), suffix.toLower());
+		bundledMedia_.insert(entryName, fileName);
+		fileName = MediaBundle::bundlePath(entryName);
+	}
+
+	addValue(QuizArchive::MediaSection, addString(fileName));
+	addValue(QuizArchive::MediaSection, quint32(size & 0xffffffff));
+	addValue(QuizArchive::MediaSection, quint32(quint64(size) >> 32));
+	for (int n=0; n<4; ++n) addValue(QuizArchive::MediaSection, qFromLittleEndian<quint32>((const uchar*) hash.constData() + n*4));
+
+	quint32 reference = nRecords_[QuizArchive::MediaSection];
+	mediaIndices_.insert(sourceFileName, reference);
+	return reference;
+}
+
+// Add question record
+void QuizArchiveWriter::addQuestion(Question* question)
+{
+	addValue(QuizArchive::QuestionSection, addString(question->textQuestion()));
+	addValue(QuizArchive::QuestionSection, addString(question->textAnswer()));
+	addValue(QuizArchive::QuestionSection, addMedia(question->audioQuestionFileName()));
+	addValue(QuizArchive::QuestionSection, addMedia(question->audioAnswerFileName()));
+	addValue(QuizArchive::QuestionSection, addMedia(question->imageQuestionFileName()));
+	addValue(QuizArchive::QuestionSection, addMedia(question->imageAnswerFileName()));
+}
+
+// Set whether media files are to be stored in a bundle (and referred to by their bundle paths)
+void QuizArchiveWriter::setBundleMedia(bool b)
+{
+	bundleMedia_ = b;
+}
+
+// Return source filenames of bundled media, keyed by entry name
+const QHash<QString,QString>& QuizArchiveWriter::bundledMedia()
+{
+	return bundledMedia_;
+}
+
+// Set file alongside which bundled media are extracted (and referred to by their extracted paths), when not storing them in a bundle
+void QuizArchiveWriter::setExtractTarget(QString fileName)
+{
+	extractTarget_ = fileName;
+}
+
+/*
+ * Output
+ */
+
+// Return assembled archive data
+QByteArray QuizArchiveWriter::data()
+{
+	// Assemble string table
+	QByteArray& strings = sections_[QuizArchive::StringSection];
+	strings.clear();
+	nRecords_[QuizArchive::StringSection] = stringOffsets_.size() - 1;
+	uchar bytes[4];
+	qToLittleEndian<quint32>(stringOffsets_.size() - 1, bytes);
+	strings.append((const char*) bytes, 4);
+	for (int n=0; n<stringOffsets_.size(); ++n)
+	{
+		qToLittleEndian<quint32>(stringOffsets_.at(n), bytes);
+		strings.append((const char*) bytes, 4);
+	}
+	strings.append(stringData_);
+
+	// Assemble header and section table, placing each section on an eight-byte boundary
+	QByteArray header;
+	header.append(ArchiveMagic, 4);
+	quint32 headerValues[3] = { (quint32) QuizArchive::version(), (quint32) QuizArchive::nSections, 0 };
+	for (int n=0; n<3; ++n)
+	{
+		qToLittleEndian<quint32>(headerValues[n], bytes);
+		header.append((const char*) bytes, 4);
+	}
+	quint64 offset = ArchiveHeaderSize + QuizArchive::nSections*ArchiveSectionEntrySize;
+	for (int n=0; n<QuizArchive::nSections; ++n)
+	{
+		offset = (offset + 7) & ~quint64(7);
+		quint32 entryValues[4] = { (quint32) n, (quint32) nRecords_[n], (quint32) offset, (quint32) sections_[n].size() };
+		for (int i=0; i<4; ++i)
+		{
+			qToLittleEndian<quint32>(entryValues[i], bytes);
+			header.append((const char*) bytes, 4);
+		}
+		offset += sections_[n].size();
+	}
+	if (offset > 0xffffffff)
+	{
+		msg.print("Error: Quiz is too large to be written as an archive.\n");
+		return QByteArray();
+	}
+
+	// Append sections
+	QByteArray result = header;
+	for (int n=0; n<QuizArchive::nSections; ++n)
+	{
+		result.append(QByteArray((8 - (result.size() & 7)) & 7, '\0'));
+		result.append(sections_[n]);
+	}
+
+	return result;
+}
+
+// Write archive to specified file
+bool QuizArchiveWriter::write(QString fileName)
+{
+	QByteArray archive = data();
+	if (archive.isEmpty()) return false;
+
+	// Write to a temporary file alongside the target, and make sure it has reached the disk, so that a failed save leaves the original intact
+	QString tempFileName = fileName + ".tmp";
+	QFile file(tempFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		msg.print("Error: Couldn't open file '%s' for writing.\n", qPrintable(tempFileName));
+		return false;
+	}
+	bool success = (file.write(archive) == archive.size()) && syncFile(file);
+	file.close();
+	if (!success)
+	{
+		msg.print("Error: Failed to write quiz archive '%s'.\n", qPrintable(tempFileName));
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	// Replace the original in one step - an archive which is still mapped keeps its old contents until it is closed
+	if (!replaceFile(tempFileName, fileName))
+	{
+		msg.print("Error: Failed to replace quiz archive '%s' - the new archive has been left in '%s'.\n", qPrintable(fileName), qPrintable(tempFileName));
+		return false;
+	}
+
+	return true;
+}
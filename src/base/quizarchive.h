@@ -0,0 +1,240 @@
+/*
+	*** Quiz Archive
+	*** src/base/quizarchive.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_QUIZARCHIVE_H
+#define QUAPP_QUIZARCHIVE_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Forward Declarations
+class Question;
+
+/*!
+ * \brief Quiz Archive
+ * \details Binary representation of a quiz, memory-mapped when opened. The file begins with a header (magic, version, number of sections)
+ * and a table giving the type, record count, offset and size of each section. All values are little-endian, and records are made
+ * from 32-bit fields (doubles occupy two). Text is held once in the string section, which begins with a table of offsets into its
+ * UTF-8 data, and is referred to everywhere else by index (zero is always the empty string). Media files are listed once each in the
+ * media section along with their size and MD5 content hash, and are referred to by index plus one (zero meaning none). On loading, media
+ * are resolved by their hash - the copy of the content in the open bundle is preferred, and otherwise the named file is checked against it.
+ * Sections with types not known to this version are skipped.
+ */
+class QuizArchive
+{
+	public:
+	// Constructor / Destructor
+	QuizArchive();
+	~QuizArchive();
+
+
+	/*
+	 * Format
+	 */
+	public:
+	// Section Types
+	enum Section
+	{
+		QuizSection,		/**< Quiz definition - title */
+		StringSection,		/**< String table */
+		MediaSection,		/**< Media references - filename, size (two fields), content hash (four fields) */
+		TeamSection,		/**< Teams - name */
+		QuestionSetSection,	/**< Question sets - name, index of first question, number of questions */
+		QuestionSection,	/**< Questions - question text, answer text, question audio, answer audio, question image, answer image */
+		SegmentSection,		/**< Segments - name, type, flags, question set (plus one), image, subtext, title text, index of first score, number of scores */
+		ScoreSection,		/**< Segment scores - team, value (two fields) */
+		nSections
+	};
+	// Return number of 32-bit fields in each record of the specified section
+	static int nFields(Section section);
+	// Return current format version
+	static int version();
+	// Return standard file extension
+	static const char* extension();
+	// Return whether the specified file is a quiz archive
+	static bool isArchive(QString fileName);
+
+
+	/*
+	 * Content Hashes
+	 */
+	private:
+	// Content hashes of media files, keyed by filename, modification time, and size
+	static QHash<QString,QByteArray> fileHashes_;
+	// Order in which content hashes were added to cache
+	static QList<QString> fileHashOrder_;
+	// Mutex for content hash cache
+	static QMutex fileHashMutex_;
+
+	public:
+	// Return MD5 content hash of specified media file (or sixteen zero bytes if it does not exist)
+	static QByteArray fileHash(QString fileName);
+
+
+	/*
+	 * Source
+	 */
+	private:
+	// Source file
+	QFile file_;
+	// Mapped file data (if the file could be mapped)
+	uchar* map_;
+	// File contents (if the file could not be mapped)
+	QByteArray contents_;
+	// Section data
+	const uchar* sections_[nSections];
+	// Number of records in each section
+	int nRecords_[nSections];
+	// String offsets, and start of string data
+	const uchar* stringOffsets_, *stringData_;
+	// Number of strings in string table
+	int nStrings_;
+	// Number of references to archive (which may be held by snapshots being written on other threads)
+	QAtomicInt refCount_;
+
+	public:
+	// Open (and map) specified file, or part of it, checking its structure
+	bool open(QString fileName, qint64 offset = 0, qint64 size = -1);
+	// Add reference to archive
+	void addReference();
+	// Remove reference from archive, returning the number remaining
+	int removeReference();
+	// Return number of references to archive
+	int refCount();
+
+
+	/*
+	 * Records
+	 */
+	public:
+	// Return number of records in specified section
+	int nRecords(Section section);
+	// Return integer field from record in specified section
+	quint32 value(Section section, int record, int field);
+	// Return double (occupying two fields) from record in specified section
+	double doubleValue(Section section, int record, int field);
+	// Return string with specified index
+	QString string(quint32 index);
+	// Return content hash of media with specified reference
+	QByteArray mediaHash(quint32 reference);
+	// Return filename of media with specified reference, resolved by its content hash
+	QString mediaFileName(quint32 reference);
+	// Return text of field in specified question record (media references are returned as filenames)
+	QString questionField(int index, int field);
+	// Read specified question record into question
+	void readQuestion(int index, Question* question);
+
+
+	/*
+	 * Media Resolution
+	 */
+	private:
+	// Resolved filenames of media, keyed by reference
+	QHash<quint32,QString> mediaFileNames_;
+	// Mutex for resolved filenames
+	QMutex mediaMutex_;
+
+	private:
+	// Resolve filename of media with specified reference from its content hash
+	QString resolveMediaFileName(quint32 reference);
+};
+
+/*!
+ * \brief Quiz Archive Writer
+ * \details Assembles the sections of a QuizArchive in memory, pooling strings and media references, and writes them out in one go.
+ */
+class QuizArchiveWriter
+{
+	public:
+	// Constructor / Destructor
+	QuizArchiveWriter();
+	~QuizArchiveWriter();
+
+
+	/*
+	 * Sections
+	 */
+	private:
+	// Section data
+	QByteArray sections_[QuizArchive::nSections];
+	// Number of records in each section
+	int nRecords_[QuizArchive::nSections];
+
+	public:
+	// Add value to current record in specified section (starting a new record if the last is complete)
+	void addValue(QuizArchive::Section section, quint32 value);
+	// Add double (occupying two fields) to current record in specified section
+	void addDouble(QuizArchive::Section section, double value);
+	// Return number of records in specified section
+	int nRecords(QuizArchive::Section section);
+
+
+	/*
+	 * Strings and Media
+	 */
+	private:
+	// String indices, keyed by string
+	QHash<QString,quint32> stringIndices_;
+	// String offsets
+	QVector<quint32> stringOffsets_;
+	// String data
+	QByteArray stringData_;
+	// Media indices, keyed by filename
+	QHash<QString,quint32> mediaIndices_;
+	// Whether media files are to be stored in a bundle
+	bool bundleMedia_;
+	// Source filenames of bundled media, keyed by entry name
+	QHash<QString,QString> bundledMedia_;
+	// File alongside which bundled media are extracted, when not storing them in a bundle
+	QString extractTarget_;
+
+	public:
+	// Add string to table (if it is not there already) and return its index
+	quint32 addString(QString text);
+	// Add media file to table (if it is not there already) and return its reference
+	quint32 addMedia(QString fileName);
+	// Add question record
+	void addQuestion(Question* question);
+	// Set whether media files are to be stored in a bundle (and referred to by their bundle paths)
+	void setBundleMedia(bool b);
+	// Return source filenames of bundled media, keyed by entry name
+	const QHash<QString,QString>& bundledMedia();
+	// Set file alongside which bundled media are extracted (and referred to by their extracted paths), when not storing them in a bundle
+	void setExtractTarget(QString fileName);
+
+
+	/*
+	 * Output
+	 */
+	public:
+	// Return assembled archive data
+	QByteArray data();
+	// Write archive to specified file
+	bool write(QString fileName);
+};
+
+#endif
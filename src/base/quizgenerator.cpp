@@ -0,0 +1,237 @@
+/*
+	*** Synthetic Quiz Generator
+	*** src/base/quizgenerator.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/quizgenerator.h"
+#include "base/lineparser.h"
+#include "base/messenger.h"
+#include "base/quiz.h"
+#include "base/segment.h"
+#include "math/mathfunc.h"
+#include <QtCore/QDir>
+#include <QtGui/QImage>
+#include <stdlib.h>
+
+// Word pool used for generated text
+const char* GeneratorWords[] = { "which", "famous", "scientist", "river", "capital", "painted", "century", "element", "orbit", "composer", "island", "ancient", "invented", "novel", "mountain", "symphony", "empire", "bridge", "language", "planet", "desert", "festival", "treaty", "voyage" };
+const int nGeneratorWords = sizeof(GeneratorWords) / sizeof(GeneratorWords[0]);
+
+// Constructor
+QuizGenerator::QuizGenerator()
+{
+	nTeams_ = 8;
+	nRounds_ = 6;
+	nQuestions_ = 20;
+	imageSize_ = 512;
+	markupDensity_ = 0.2;
+	seed_ = 1;
+}
+
+// Destructor
+QuizGenerator::~QuizGenerator()
+{
+}
+
+/*
+ * Parameters
+ */
+
+// Set named parameter, returning false if the name is not recognised
+bool QuizGenerator::setParameter(QString name, QString value)
+{
+	if (name == "teams") nTeams_ = qMax(1, value.toInt());
+	else if (name == "rounds") nRounds_ = qMax(1, value.toInt());
+	else if (name == "questions") nQuestions_ = qMax(1, value.toInt());
+	else if (name == "imagesize") imageSize_ = qMax(0, value.toInt());
+	else if (name == "markup") markupDensity_ = qBound(0.0, value.toDouble(), 1.0);
+	else if (name == "seed") seed_ = value.toInt();
+	else return false;
+
+	return true;
+}
+
+// Return number of teams
+int QuizGenerator::nTeams()
+{
+	return nTeams_;
+}
+
+// Return number of rounds
+int QuizGenerator::nRounds()
+{
+	return nRounds_;
+}
+
+// Return number of questions per round
+int QuizGenerator::nQuestions()
+{
+	return nQuestions_;
+}
+
+// Return width of generated images
+int QuizGenerator::imageSize()
+{
+	return imageSize_;
+}
+
+// Return fraction of words carrying markup
+double QuizGenerator::markupDensity()
+{
+	return markupDensity_;
+}
+
+// Return random seed
+int QuizGenerator::seed()
+{
+	return seed_;
+}
+
+// Return number of segments that will be generated
+int QuizGenerator::nSegments()
+{
+	// Title segment, plus question, answer, and score segments for each round
+	return 1 + nRounds_*3;
+}
+
+/*
+ * Generation
+ */
+
+// Return random text of the specified number of words, with markup applied
+QString QuizGenerator::randomText(int nWords)
+{
+	QString text;
+	for (int n=0; n<nWords; ++n)
+	{
+		if (n > 0) text += " ";
+		QString word = GeneratorWords[QuappMath::randomi(nGeneratorWords)];
+		if (QuappMath::random() < markupDensity_)
+		{
+			// Cycle between the available markup types
+			switch (QuappMath::randomi(3))
+			{
+				case (0):
+					word = "\\b{" + word + "}";
+					break;
+				case (1):
+					word = "\\it{" + word + "}";
+					break;
+				default:
+					word = word + "\\sup{" + QString::number(n+1) + "}";
+					break;
+			}
+		}
+		text += word;
+	}
+
+	return text;
+}
+
+// Create synthetic image with the specified index
+bool QuizGenerator::createImage(QString fileName, int index)
+{
+	int width = imageSize_, height = (imageSize_*3) / 4;
+	QImage image(width, height, QImage::Format_RGB32);
+
+	// Fill with a gradient whose colour depends on the index, so that each image compresses differently
+	for (int y=0; y<height; ++y)
+	{
+		uint* line = (uint*) image.scanLine(y);
+		for (int x=0; x<width; ++x)
+		{
+			int r = (x*255) / width, g = (y*255) / height, b = (index*37 + x + y) % 256;
+			line[x] = 0xff000000 | (r << 16) | (g << 8) | b;
+		}
+	}
+
+	return image.save(fileName, "PNG");
+}
+
+// Write quiz to specified file, placing generated images in the media directory
+bool QuizGenerator::write(QString fileName, QString mediaDirectory)
+{
+	if ((imageSize_ > 0) && (!QDir().mkpath(mediaDirectory)))
+	{
+		msg.print("Error: Couldn't create media directory '%s'.\n", qPrintable(mediaDirectory));
+		return false;
+	}
+
+	LineParser parser(fileName, true);
+	if (!parser.ready()) return false;
+
+	srand(seed_);
+
+	// Title and teams
+	parser.writeLineF("%s  'Synthetic Quiz'\n", Quiz::mainKeyword(Quiz::TitleKeyword));
+	for (int n=0; n<nTeams_; ++n) parser.writeLineF("%s  'Team %i'\n", Quiz::mainKeyword(Quiz::TeamKeyword), n+1);
+
+	// Question sets, one per round
+	int imageIndex = 0;
+	for (int round=0; round<nRounds_; ++round)
+	{
+		parser.writeLineF("%s  'Round %i'\n", Quiz::mainKeyword(Quiz::QuestionSetKeyword), round+1);
+		for (int n=0; n<nQuestions_; ++n)
+		{
+			parser.writeLineF("  %s\n", Quiz::questionSetBlockKeyword(Quiz::QuestionKeyword));
+			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::TextQuestionKeyword), qPrintable(randomText(8 + QuappMath::randomi(8))));
+			parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::TextAnswerKeyword), qPrintable(randomText(1 + QuappMath::randomi(3))));
+			if (imageSize_ > 0)
+			{
+				QString imageFile = QDir(mediaDirectory).absoluteFilePath(QString("image%1.png").arg(imageIndex, 4, 10, QChar('0')));
+				if (!createImage(imageFile, imageIndex)) msg.print("Warning: Failed to write synthetic image '%s'.\n", qPrintable(imageFile));
+				++imageIndex;
+				parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::ImageQuestionKeyword), qPrintable(imageFile));
+
+				// Alternate questions reuse their image in the answer, so both answer layouts are exercised
+				if (n%2 == 0) parser.writeLineF("    %s  '%s'\n", Quiz::questionBlockKeyword(Quiz::ImageAnswerKeyword), qPrintable(imageFile));
+			}
+			parser.writeLineF("  %s\n", Quiz::questionBlockKeyword(Quiz::EndQuestionKeyword));
+		}
+		parser.writeLineF("%s\n", Quiz::questionSetBlockKeyword(Quiz::EndQuestionSetKeyword));
+	}
+
+	// Title segment
+	parser.writeLineF("%s\n", Quiz::mainKeyword(Quiz::SegmentKeyword));
+	parser.writeLineF("  %s  'Welcome'\n", Quiz::segmentBlockKeyword(Quiz::NameKeyword));
+	parser.writeLineF("  %s  %s\n", Quiz::segmentBlockKeyword(Quiz::TypeKeyword), Segment::segmentType(Segment::TitleSegment));
+	parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::TitleTextKeyword), qPrintable(randomText(3)));
+	parser.writeLineF("  %s  '%s'\n", Quiz::segmentBlockKeyword(Quiz::SubTextKeyword), qPrintable(randomText(6)));
+	parser.writeLineF("%s\n", Quiz::segmentBlockKeyword(Quiz::EndSegmentKeyword));
+
+	// Question, answer, and score segments for each round
+	for (int round=0; round<nRounds_; ++round)
+	{
+		const Segment::SegmentType types[3] = { Segment::QuestionSegment, Segment::AnswerSegment, Segment::ScoreSegment };
+		for (int n=0; n<3; ++n)
+		{
+			parser.writeLineF("%s\n", Quiz::mainKeyword(Quiz::SegmentKeyword));
+			parser.writeLineF("  %s  'Round %i %s'\n", Quiz::segmentBlockKeyword(Quiz::NameKeyword), round+1, Segment::segmentType(types[n]));
+			parser.writeLineF("  %s  %s\n", Quiz::segmentBlockKeyword(Quiz::TypeKeyword), Segment::segmentType(types[n]));
+			if (types[n] == Segment::ScoreSegment) for (int team=0; team<nTeams_; ++team) parser.writeLineF("  %s  'Team %i' %f\n", Quiz::segmentBlockKeyword(Quiz::ScoreKeyword), team+1, double(QuappMath::randomi(nQuestions_+1)));
+			else parser.writeLineF("  %s  'Round %i'\n", Quiz::segmentBlockKeyword(Quiz::QuestionSourceKeyword), round+1);
+			parser.writeLineF("  %s  'Round %i'\n", Quiz::segmentBlockKeyword(Quiz::TitleTextKeyword), round+1);
+			parser.writeLineF("%s\n", Quiz::segmentBlockKeyword(Quiz::EndSegmentKeyword));
+		}
+	}
+
+	parser.closeFiles();
+
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+	*** Synthetic Quiz Generator
+	*** src/base/quizgenerator.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_QUIZGENERATOR_H
+#define QUAPP_QUIZGENERATOR_H
+
+#include <QtCore/QString>
+
+// Forward Declarations
+class LineParser;
+
+// Synthetic Quiz Generator
+class QuizGenerator
+{
+	public:
+	// Constructor / Destructor
+	QuizGenerator();
+	~QuizGenerator();
+
+
+	/*
+	 * Parameters
+	 */
+	private:
+	// Number of teams
+	int nTeams_;
+	// Number of rounds (each a question, answer, and score segment)
+	int nRounds_;
+	// Number of questions per round
+	int nQuestions_;
+	// Width of generated images (zero for no images)
+	int imageSize_;
+	// Fraction of words carrying markup
+	double markupDensity_;
+	// Random seed
+	int seed_;
+
+	public:
+	// Set named parameter, returning false if the name is not recognised
+	bool setParameter(QString name, QString value);
+	// Return number of teams
+	int nTeams();
+	// Return number of rounds
+	int nRounds();
+	// Return number of questions per round
+	int nQuestions();
+	// Return width of generated images
+	int imageSize();
+	// Return fraction of words carrying markup
+	double markupDensity();
+	// Return random seed
+	int seed();
+	// Return number of segments that will be generated
+	int nSegments();
+
+
+	/*
+	 * Generation
+	 */
+	private:
+	// Return random text of the specified number of words, with markup applied
+	QString randomText(int nWords);
+	// Create synthetic image with the specified index
+	bool createImage(QString fileName, int index);
+
+	public:
+	// Write quiz to specified file, placing generated images in the media directory
+	bool write(QString fileName, QString mediaDirectory);
+};
+
+#endif
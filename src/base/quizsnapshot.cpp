@@ -0,0 +1,316 @@
+/*
+	*** Quiz Snapshot
+	*** src/base/quizsnapshot.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/quizsnapshot.h"
+#include "base/mediabundle.h"
+#include "base/messenger.h"
+#include "base/quiz.h"
+#include "base/quizarchive.h"
+#include "base/sysfunc.h"
+#include "base/tracer.h"
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+
+// Static Members
+int QuizSnapshot::lastSerial_ = 0;
+QMutex QuizSnapshot::writeMutex_;
+QHash<QString,int> QuizSnapshot::writtenSerials_;
+
+// Size at which buffered output is written to the device
+const int SnapshotBufferSize = 65536;
+
+// Append keyword line to buffer
+static void appendKeyword(QByteArray& buffer, const char* indent, const char* keyword)
+{
+	buffer.append(indent).append(keyword).append('\n');
+}
+
+// Append keyword line with quoted argument to buffer
+static void appendQuoted(QByteArray& buffer, const char* indent, const char* keyword, const QString& text)
+{
+	buffer.append(indent).append(keyword).append("  '").append(text.toUtf8()).append("'\n");
+}
+
+// Write buffer contents to device, and empty the buffer
+static bool flushBuffer(QByteArray& buffer, QIODevice& device)
+{
+	bool success = (device.write(buffer) == buffer.size());
+	buffer.resize(0);
+	return success;
+}
+
+// Constructors
+QuizSnapshot::QuizSnapshot()
+{
+	serial_ = 0;
+}
+
+QuizSnapshot::QuizSnapshot(Quiz& quiz)
+{
+	TRACESPAN("QuizSnapshot::QuizSnapshot");
+
+	// Snapshots are only ever taken on the GUI thread, so the serial needs no protection
+	serial_ = ++lastSerial_;
+
+	title_ = quiz.title();
+	for (Team* team = quiz.teams(); team != NULL; team = team->next) teams_ << team->name();
+
+	// Question sets - those still held in an archive are left there, and read from it when the snapshot is written
+	for (QuestionSet* set = quiz.questionSets(); set != NULL; set = set->next)
+	{
+		setNames_ << set->name();
+		setArchives_.append(set->archiveSource());
+		if (set->pending())
+		{
+			setFirsts_.append(set->archiveFirst());
+			setSizes_.append(set->archiveCount());
+			continue;
+		}
+		setFirsts_.append(questions_.count() / 6);
+		setSizes_.append(set->nQuestions());
+		for (Question* question = set->questions(); question != NULL; question = question->next)
+		{
+			questions_.append(question->textQuestion());
+			questions_.append(question->textAnswer());
+			questions_.append(question->audioQuestionFileName());
+			questions_.append(question->audioAnswerFileName());
+			questions_.append(question->imageQuestionFileName());
+			questions_.append(question->imageAnswerFileName());
+		}
+	}
+
+	// Segments
+	segments_.resize(quiz.nSegments());
+	int index = 0;
+	for (Segment* segment = quiz.segments(); segment != NULL; segment = segment->next, ++index)
+	{
+		SegmentSnapshot& snapshot = segments_[index];
+		snapshot.name = segment->name();
+		snapshot.type = segment->type();
+		snapshot.nonVisual = segment->nonVisual();
+		snapshot.imageFileName = segment->imageFileName();
+		snapshot.hasQuestionSource = (segment->questionSource() != NULL);
+		if (snapshot.hasQuestionSource) snapshot.questionSource = segment->questionSource()->name();
+		for (RefListItem<Team,double>* ri = segment->scores(); ri != NULL; ri = ri->next)
+		{
+			snapshot.scoreTeams << ri->item->name();
+			snapshot.scores.append(ri->data);
+		}
+		snapshot.subText = segment->subText();
+		snapshot.titleText = segment->titleText();
+	}
+
+	addArchiveReferences();
+}
+
+QuizSnapshot::QuizSnapshot(const QuizSnapshot& source)
+{
+	(*this) = source;
+}
+
+// Destructor
+QuizSnapshot::~QuizSnapshot()
+{
+	removeArchiveReferences();
+}
+
+// Assignment operator
+QuizSnapshot& QuizSnapshot::operator=(const QuizSnapshot& source)
+{
+	if (this == &source) return *this;
+
+	removeArchiveReferences();
+
+	serial_ = source.serial_;
+	title_ = source.title_;
+	teams_ = source.teams_;
+	setNames_ = source.setNames_;
+	setSizes_ = source.setSizes_;
+	setArchives_ = source.setArchives_;
+	setFirsts_ = source.setFirsts_;
+	questions_ = source.questions_;
+	segments_ = source.segments_;
+	extractTarget_ = source.extractTarget_;
+
+	addArchiveReferences();
+
+	return *this;
+}
+
+/*
+ * Data
+ */
+
+// Add references to archives held
+void QuizSnapshot::addArchiveReferences()
+{
+	for (int n=0; n<setArchives_.count(); ++n) if (setArchives_.at(n)) setArchives_.at(n)->addReference();
+}
+
+// Remove references to archives held, deleting any no longer needed
+void QuizSnapshot::removeArchiveReferences()
+{
+	for (int n=0; n<setArchives_.count(); ++n) if (setArchives_.at(n) && (setArchives_.at(n)->removeReference() == 0)) delete setArchives_.at(n);
+	setArchives_.clear();
+}
+
+// Return serial number of snapshot (zero for an empty snapshot)
+int QuizSnapshot::serial() const
+{
+	return serial_;
+}
+
+// Return whether snapshot holds the same data as that specified
+bool QuizSnapshot::matches(const QuizSnapshot& other) const
+{
+	// Strings which are still shared with the quiz compare by pointer, so this is cheap for an unchanged quiz
+	if ((title_ != other.title_) || (teams_ != other.teams_) || (setNames_ != other.setNames_) || (setSizes_ != other.setSizes_)) return false;
+	if ((setArchives_ != other.setArchives_) || (setFirsts_ != other.setFirsts_) || (questions_ != other.questions_)) return false;
+	if (segments_.count() != other.segments_.count()) return false;
+	for (int n=0; n<segments_.count(); ++n)
+	{
+		const SegmentSnapshot& a = segments_.at(n), &b = other.segments_.at(n);
+		if ((a.name != b.name) || (a.type != b.type) || (a.nonVisual != b.nonVisual) || (a.imageFileName != b.imageFileName)) return false;
+		if ((a.hasQuestionSource != b.hasQuestionSource) || (a.questionSource != b.questionSource)) return false;
+		if ((a.scoreTeams != b.scoreTeams) || (a.scores != b.scores) || (a.subText != b.subText) || (a.titleText != b.titleText)) return false;
+	}
+	return true;
+}
+
+// Extract bundled media into a directory alongside the specified file, and refer to the extracted copies instead
+void QuizSnapshot::extractBundledMedia(QString targetFileName)
+{
+	// Only questions already copied into the snapshot are changed - those of sets still held in an archive are extracted as they are written
+	extractTarget_ = targetFileName;
+	for (int n=0; n<questions_.count(); ++n) if ((n%6) >= 2) questions_[n] = MediaBundle::extract(questions_[n], targetFileName);
+	for (int n=0; n<segments_.count(); ++n) segments_[n].imageFileName = MediaBundle::extract(segments_[n].imageFileName, targetFileName);
+}
+
+/*
+ * Output
+ */
+
+// Write snapshot in text format to specified device
+bool QuizSnapshot::write(QIODevice& device) const
+{
+	TRACESPAN("QuizSnapshot::write");
+
+	// Lines are assembled in a buffer, which is written to the device whenever it fills
+	QByteArray buffer;
+	buffer.reserve(SnapshotBufferSize*2);
+	bool success = true;
+
+	// Main keywords
+	appendQuoted(buffer, "", Quiz::mainKeyword(Quiz::TitleKeyword), title_);
+
+	// Teams
+	for (int n=0; n<teams_.count(); ++n) appendQuoted(buffer, "", Quiz::mainKeyword(Quiz::TeamKeyword), teams_.at(n));
+
+	// Question sets
+	QString fields[6];
+	for (int n=0; n<setNames_.count(); ++n)
+	{
+		appendQuoted(buffer, "", Quiz::mainKeyword(Quiz::QuestionSetKeyword), setNames_.at(n));
+		for (int i=setFirsts_.at(n); i<setFirsts_.at(n)+setSizes_.at(n); ++i)
+		{
+			for (int field=0; field<6; ++field) fields[field] = (setArchives_.at(n) ? setArchives_.at(n)->questionField(i, field) : questions_.at(i*6+field));
+			if (setArchives_.at(n) && !extractTarget_.isEmpty()) for (int field=2; field<6; ++field) fields[field] = MediaBundle::extract(fields[field], extractTarget_);
+			appendKeyword(buffer, "  ", Quiz::questionSetBlockKeyword(Quiz::QuestionKeyword));
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::TextQuestionKeyword), fields[0]);
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::TextAnswerKeyword), fields[1]);
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::AudioQuestionKeyword), fields[2]);
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::AudioAnswerKeyword), fields[3]);
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::ImageQuestionKeyword), fields[4]);
+			appendQuoted(buffer, "    ", Quiz::questionBlockKeyword(Quiz::ImageAnswerKeyword), fields[5]);
+			appendKeyword(buffer, "  ", Quiz::questionBlockKeyword(Quiz::EndQuestionKeyword));
+			if (buffer.size() >= SnapshotBufferSize) success = success && flushBuffer(buffer, device);
+		}
+		appendKeyword(buffer, "", Quiz::questionSetBlockKeyword(Quiz::EndQuestionSetKeyword));
+	}
+
+	// Segments
+	for (int n=0; n<segments_.count(); ++n)
+	{
+		const SegmentSnapshot& segment = segments_.at(n);
+		appendKeyword(buffer, "", Quiz::mainKeyword(Quiz::SegmentKeyword));
+		appendQuoted(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::ImageKeyword), segment.imageFileName);
+		appendQuoted(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::NameKeyword), segment.name);
+		if (segment.nonVisual) appendKeyword(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::NonVisualKeyword));
+		buffer.append("  ").append(Quiz::segmentBlockKeyword(Quiz::TypeKeyword)).append("  ").append(Segment::segmentType((Segment::SegmentType) segment.type)).append('\n');
+		if (segment.hasQuestionSource) appendQuoted(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::QuestionSourceKeyword), segment.questionSource);
+		for (int i=0; i<segment.scores.count(); ++i)
+		{
+			buffer.append("  ").append(Quiz::segmentBlockKeyword(Quiz::ScoreKeyword)).append("  '").append(segment.scoreTeams.at(i).toUtf8()).append("' ");
+			buffer.append(QByteArray::number(segment.scores.at(i), 'f', 6)).append('\n');
+		}
+		appendQuoted(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::SubTextKeyword), segment.subText);
+		appendQuoted(buffer, "  ", Quiz::segmentBlockKeyword(Quiz::TitleTextKeyword), segment.titleText);
+		appendKeyword(buffer, "", Quiz::segmentBlockKeyword(Quiz::EndSegmentKeyword));
+		if (buffer.size() >= SnapshotBufferSize) success = success && flushBuffer(buffer, device);
+	}
+
+	return success && flushBuffer(buffer, device);
+}
+
+// Write snapshot in text format to specified file, replacing it atomically (unless a newer snapshot has already been written there)
+bool QuizSnapshot::write(QString fileName) const
+{
+	// Write to a temporary file alongside the target, and make sure it has reached the disk
+	QString tempFileName = QString("%1.%2.tmp").arg(fileName).arg(serial_);
+	QFile file(tempFileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		msg.print("Error: Couldn't open file '%s' for writing.\n", qPrintable(tempFileName));
+		return false;
+	}
+	bool success = write(file) && syncFile(file);
+	file.close();
+	if (!success)
+	{
+		msg.print("Error: Failed to write file '%s'.\n", qPrintable(tempFileName));
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	// Replace the target, unless a more recent snapshot got there first
+	QMutexLocker locker(&writeMutex_);
+	if (writtenSerials_.value(fileName, 0) > serial_)
+	{
+		QFile::remove(tempFileName);
+		return true;
+	}
+	if (!replaceFile(tempFileName, fileName))
+	{
+		msg.print("Error: Failed to replace file '%s'.\n", qPrintable(fileName));
+		QFile::remove(tempFileName);
+		return false;
+	}
+	writtenSerials_.insert(fileName, serial_);
+
+	return true;
+}
+
+// Return serial number of last snapshot written to specified file (zero if there is none)
+int QuizSnapshot::writtenSerial(QString fileName)
+{
+	QMutexLocker locker(&writeMutex_);
+	return writtenSerials_.value(fileName, 0);
+}
@@ -0,0 +1,140 @@
+/*
+	*** Quiz Snapshot
+	*** src/base/quizsnapshot.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_QUIZSNAPSHOT_H
+#define QUAPP_QUIZSNAPSHOT_H
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+// Forward Declarations
+class QIODevice;
+class Quiz;
+class QuizArchive;
+
+// Segment Snapshot
+struct SegmentSnapshot
+{
+	// Segment name
+	QString name;
+	// Segment type
+	int type;
+	// Whether segment is non-visual
+	bool nonVisual;
+	// Image filename
+	QString imageFileName;
+	// Name of source question set (if there is one)
+	QString questionSource;
+	// Whether there is a source question set
+	bool hasQuestionSource;
+	// Team names for scores
+	QStringList scoreTeams;
+	// Score values
+	QVector<double> scores;
+	// Subtext
+	QString subText;
+	// Title text
+	QString titleText;
+};
+
+/*!
+ * \brief Quiz Snapshot
+ * \details A copy of everything in a Quiz that is saved to file. Since QString data is implicitly shared, taking a snapshot copies
+ * only references to the text, which is then private to the snapshot as soon as the original is changed. A snapshot may therefore
+ * be taken cheaply on the GUI thread and written out from any other. Question sets which are still held in an archive are not read
+ * when the snapshot is taken - the snapshot keeps a reference to the archive instead, and reads them as it is written.
+ */
+class QuizSnapshot
+{
+	public:
+	// Constructors / Destructor
+	QuizSnapshot();
+	QuizSnapshot(Quiz& quiz);
+	QuizSnapshot(const QuizSnapshot& source);
+	~QuizSnapshot();
+	// Assignment operator
+	QuizSnapshot& operator=(const QuizSnapshot& source);
+
+
+	/*
+	 * Data
+	 */
+	private:
+	// Serial number of snapshot (zero for an empty snapshot)
+	int serial_;
+	// Quiz title
+	QString title_;
+	// Team names
+	QStringList teams_;
+	// Question set names
+	QStringList setNames_;
+	// Number of questions in each set
+	QVector<int> setSizes_;
+	// Archive holding the questions of each set, if they are yet to be read from it (otherwise NULL)
+	QVector<QuizArchive*> setArchives_;
+	// Index of first question of each set (in its archive, if it has one)
+	QVector<int> setFirsts_;
+	// Question data (question text, answer text, question audio, answer audio, question image, answer image, for each question)
+	QVector<QString> questions_;
+	// Segments
+	QVector<SegmentSnapshot> segments_;
+	// File alongside which bundled media are extracted (if any)
+	QString extractTarget_;
+	// Last serial number issued
+	static int lastSerial_;
+
+	private:
+	// Add references to archives held
+	void addArchiveReferences();
+	// Remove references to archives held, deleting any no longer needed
+	void removeArchiveReferences();
+
+	public:
+	// Return serial number of snapshot (zero for an empty snapshot)
+	int serial() const;
+	// Return whether snapshot holds the same data as that specified
+	bool matches(const QuizSnapshot& other) const;
+	// Extract bundled media into a directory alongside the specified file, and refer to the extracted copies instead
+	void extractBundledMedia(QString targetFileName);
+
+
+	/*
+	 * Output
+	 */
+	private:
+	// Mutex protecting list of written serial numbers
+	static QMutex writeMutex_;
+	// Serial numbers of last snapshots written, keyed by filename
+	static QHash<QString,int> writtenSerials_;
+
+	public:
+	// Write snapshot in text format to specified device
+	bool write(QIODevice& device) const;
+	// Write snapshot in text format to specified file, replacing it atomically (unless a newer snapshot has already been written there)
+	bool write(QString fileName) const;
+	// Return serial number of last snapshot written to specified file (zero if there is none)
+	static int writtenSerial(QString fileName);
+};
+
+#endif
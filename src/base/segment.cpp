@@ -22,8 +22,11 @@
 #include "base/segment.h"
 #include "base/team.h"
 #include "base/messenger.h"
+#include "base/mediaregistry.h"
+#include "base/tracer.h"
 #include "render/displayobject.h"
 #include "render/fontinstance.h"
+#include "render/scenecompiler.h"
 #include "gui/quapp.h"
 #include "templates/reflist.h"
 #include <QtCore/QString>
@@ -50,6 +53,7 @@ Segment::Segment(Quiz& parent) : parent_(parent)
 	name_ = "New Segment";
 	titleText_ = "New Segment";
 	imageOK_ = false;
+	image_ = NULL;
 	type_ = Segment::TitleSegment;
 	currentQuestion_ = NULL;
 	questionSource_ = NULL;
@@ -64,6 +68,7 @@ Segment::Segment(Quiz& parent) : parent_(parent)
 // Destructor
 Segment::~Segment()
 {
+	MediaRegistry::releaseImage(image_, this);
 }
 
 /*
@@ -110,7 +115,9 @@ QString Segment::subText()
 void Segment::setImage(QString fileName)
 {
 	imageFileName_ = fileName;
-	imageOK_ = image_.load(fileName);
+	MediaRegistry::releaseImage(image_, this);
+	image_ = MediaRegistry::acquireImage(fileName, this);
+	imageOK_ = (image_ && image_->ok());
 }
 
 // Return image filename
@@ -128,7 +135,7 @@ bool Segment::imageOK()
 // Return image
 QImage& Segment::image()
 {
-	return image_;
+	return (image_ ? MediaRegistry::residentImage(image_) : MediaRegistry::nullImage());
 }
 
 // Set segment type
@@ -257,9 +264,58 @@ RefListItem<Team,double>* Segment::scores()
  * Segment Run
  */
 
+// Return text line showing question
+QString Segment::questionLineText(Question* question)
+{
+	return QString::number(questionSource_->indexOf(question) + 1) + ". " + question->textQuestion();
+}
+
+// Return text line showing answer
+QString Segment::answerLineText(Question* question)
+{
+	return "    " + question->textAnswer();
+}
+
+// Return caption for image question
+QString Segment::imageQuestionText(Question* question)
+{
+	if (imageQuestionDisplayIndex_) return "("+QString::number(questionSource_->indexOf(question)+1)+")";
+	return question->textQuestion();
+}
+
+// Register text for all parts of the segment with the SceneCompiler
+void Segment::compile(QuappWindow& quapp)
+{
+	// Title text (text sizes must match those set on the DisplayObjects by QuappWindow and begin() / showNextPart())
+	TextPrimitive::TextAnchor titleAnchor = (type_ == Segment::TitleSegment ? TextPrimitive::CentralAnchor : TextPrimitive::TopLeftAnchor);
+	SceneCompiler::addText(titleText_, titleAnchor, quapp.titleTextHeight());
+	if (type_ == Segment::TitleSegment) SceneCompiler::addText(subText_, TextPrimitive::CentralAnchor, quapp.titleTextHeight());
+
+	// Score text depends on the scores at the time the segment is shown, so cannot be compiled in advance
+	if ((type_ != Segment::QuestionSegment) && (type_ != Segment::AnswerSegment)) return;
+	if (!questionSource_) return;
+
+	double captionSize = quapp.bodyTextHeight()*bodyTextSizeModifier_;
+	for (Question* question = questionSource_->questions(); question != NULL; question = question->next)
+	{
+		if (type_ == Segment::QuestionSegment)
+		{
+			if (question->imageQuestionOK()) SceneCompiler::addText(imageQuestionText(question), TextPrimitive::TopMiddleAnchor, captionSize);
+		}
+		else if (question->imageAnswerOK()) SceneCompiler::addText(question->textAnswer(), TextPrimitive::TopMiddleAnchor, captionSize);
+		else
+		{
+			SceneCompiler::addText(questionLineText(question), TextPrimitive::TopLeftAnchor, quapp.bodyTextHeight());
+			SceneCompiler::addText(answerLineText(question), TextPrimitive::TopLeftAnchor, quapp.bodyTextHeight());
+		}
+	}
+}
+
 // Begin segment
 void Segment::begin(QuappWindow& quapp)
 {
+	TRACESPAN("Segment::begin");
+
 	DisplayObject* object;
 	Primitive* primitive;
 	QColor colourA, colourB;
@@ -276,32 +332,32 @@ void Segment::begin(QuappWindow& quapp)
 				// Create object for image
 				object = quapp.addForeGroundObject();
 				primitive = object->primitive().addPrimitive(6, 0, GL_TRIANGLES, false, true);
-				primitive->setTextureImage(image_);
-				double imageAspect = double(image_.width()) / double(image_.height());
+				primitive->setTextureImage(image());
+				double imageAspect = double(image().width()) / double(image().height());
 				primitive->rectangle(0.0, 0.0, 0.0, 0.8*imageAspect, 0.8, true);
 				colourA.setRgbF(1.0, 1.0, 1.0, 0.0);
 				colourB.setRgbF(1.0, 1.0, 1.0, 1.0);
 				object->setPosition(0.0, 0.0, -0.5);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 			}
 
 			// Add text
 			object = quapp.addTitleObject();
 			object->setPosition(0.0, 0.6*quapp.titleLineHeight(), 0.0);
-			object->textPrimitive().set(titleText_, TextPrimitive::CentralAnchor);
+			SceneCompiler::setText(object->textPrimitive(), titleText_, TextPrimitive::CentralAnchor);
 			colourA = Qt::black;
 			colourA.setAlphaF(0.0);
 			colourB = Qt::black;
-			object->addTransform()->setColourTransform(colourA, colourB, 0.01);
+			object->addTransform().setColourTransform(colourA, colourB, 2.5);
 			object->initialiseTransforms();
 			if (!subText_.isEmpty())
 			{
 				object = quapp.addTitleObject();
 				object->setPosition(0.0, -0.6*quapp.titleLineHeight(), 0.0);
-				object->textPrimitive().set(subText_, TextPrimitive::CentralAnchor);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.01);
+				SceneCompiler::setText(object->textPrimitive(), subText_, TextPrimitive::CentralAnchor);
+				object->addTransform().setColourTransform(colourA, colourB, 2.5);
 				object->initialiseTransforms();
 			}
 			break;
@@ -319,11 +375,11 @@ void Segment::begin(QuappWindow& quapp)
 			object->initialiseTransforms();
 			// Add title object
 			object = quapp.addTitleObject();
-			object->textPrimitive().set(titleText_, TextPrimitive::TopLeftAnchor);
+			SceneCompiler::setText(object->textPrimitive(), titleText_, TextPrimitive::TopLeftAnchor);
 			colourA = Qt::black;
 			colourA.setAlphaF(0.0);
 			colourB = Qt::black;
-			object->addTransform()->setColourTransform(colourA, colourB, 0.01);
+			object->addTransform().setColourTransform(colourA, colourB, 2.5);
 
 			// Get some lines for text display, and add on the text to display (all objects will be hidden to start with)
 			displayLines_ = quapp.addForeGroundTextLines();
@@ -384,11 +440,11 @@ void Segment::begin(QuappWindow& quapp)
 			object->initialiseTransforms();
 			// Add title object
 			object = quapp.addTitleObject();
-			object->textPrimitive().set(titleText_, TextPrimitive::TopLeftAnchor);
+			SceneCompiler::setText(object->textPrimitive(), titleText_, TextPrimitive::TopLeftAnchor);
 			colourA = Qt::black;
 			colourA.setAlphaF(0.0);
 			colourB = Qt::black;
-			object->addTransform()->setColourTransform(colourA, colourB, 0.01);
+			object->addTransform().setColourTransform(colourA, colourB, 2.5);
 
 			// Do we have an image to display?
 			if (imageOK_)
@@ -396,14 +452,14 @@ void Segment::begin(QuappWindow& quapp)
 				// Create object for image
 				object = quapp.addForeGroundObject();
 				primitive = object->primitive().addPrimitive(6, 0, GL_TRIANGLES, false, true);
-				primitive->setTextureImage(image_);
-				double imageAspect = double(image_.width()) / double(image_.height());
+				primitive->setTextureImage(image());
+				double imageAspect = double(image().width()) / double(image().height());
 				primitive->rectangle(0.0, 0.0, 0.0, 0.8*imageAspect, 0.8, true);
 				colourA.setRgbF(1.0, 1.0, 1.0, 0.0);
 				colourB.setRgbF(1.0, 1.0, 1.0, 1.0);
 				object->setPosition(0.0, 0.0, -0.01);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 			}
 			break;
@@ -416,6 +472,8 @@ void Segment::begin(QuappWindow& quapp)
 // Create objects to show next part
 bool Segment::showNextPart(QuappWindow& quapp)
 {
+	TRACESPAN("Segment::showNextPart");
+
 	// Exactly what we do here depends on the segment type...
 	DisplayObject* object;
 	Primitive* primitive;
@@ -444,8 +502,8 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				colourA.setRgbF(1.0, 1.0, 1.0, 0.0);
 				colourB.setRgbF(1.0, 1.0, 1.0, 1.0);
 				object->setPosition(0.0, 0.0, -0.5);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 
 				// Create object for text
@@ -454,10 +512,10 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				colourB.setRgbF(0.0, 0.0, 0.0, 1.0);
 				text = currentQuestion_->textAnswer();
 				object->setTextSize(quapp.bodyTextHeight()*bodyTextSizeModifier_);
-				object->textPrimitive().set(text, TextPrimitive::TopMiddleAnchor);
+				SceneCompiler::setText(object->textPrimitive(), text, TextPrimitive::TopMiddleAnchor);
 				object->setPosition(0.0, -0.31, -0.5);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 			}
 			else
@@ -467,12 +525,12 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				{
 					pos = object->position();
 					pos.z += 5.0;
-					object->addTransform()->setTranslationTransform(object->position(), pos, 0.05, 0.5);
-					object->addTransform()->setRotationTransform(1, 0.0, -90.0, 0.05);
+					object->addTransform().setTranslationTransform(object->position(), pos, 0.5, 0.5);
+					object->addTransform().setRotationTransform(1, 0.0, -90.0, 0.5);
 					colourA = object->colour();
 					colourB = colourA;
 					colourB.setAlphaF(0.0);
-					object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+					object->addTransform().setColourTransform(colourA, colourB, 0.5);
 					object->setDeleteAfterTransform();
 				}
 
@@ -492,9 +550,9 @@ bool Segment::showNextPart(QuappWindow& quapp)
 					// If this is a question, make sure we have at least one more object (for the answer)...
 					if (question && (ri->next == NULL)) break;
 					// Set text
-					if (question) text = QString::number(questionSource_->indexOf(currentQuestion_) + 1) + ". " + currentQuestion_->textQuestion();
-					else text = "    " + currentQuestion_->textAnswer();
-					object->textPrimitive().set(text, TextPrimitive::TopLeftAnchor);
+					if (question) text = questionLineText(currentQuestion_);
+					else text = answerLineText(currentQuestion_);
+					SceneCompiler::setText(object->textPrimitive(), text, TextPrimitive::TopLeftAnchor);
 					if (!question) object->adjustPosition(0.0, fgMargin*0.5, 0.0);
 					textWidth = object->textPrimitive().textWidth() * object->textSize();
 					if (textWidth > maxTextWidth) maxTextWidth = textWidth;
@@ -514,8 +572,8 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				for (ri = lines.first(); ri != NULL; ri = ri->next)
 				{
 					if (delta > 0) ri->item->adjustPosition(delta, 0.0, 0.0);
-					ri->item->addTransform()->setColourTransform(colourA, colourB, 0.01);
-					ri->item->addTransform()->setTranslationTransform(Vec3<double>(aspectRatio-delta,0.0,0.0), Vec3<double>(), 0.02);
+					ri->item->addTransform().setColourTransform(colourA, colourB, 2.5);
+					ri->item->addTransform().setTranslationTransform(Vec3<double>(aspectRatio-delta,0.0,0.0), Vec3<double>(), 1.25);
 					ri->item->setTransformContinueAt(0.2);
 					ri->item->initialiseTransforms();
 				}
@@ -526,11 +584,11 @@ bool Segment::showNextPart(QuappWindow& quapp)
 			// Transition out any previous objects
 			for (object = quapp.foregroundObjects().first(); object != NULL; object = object->next)
 			{
-				object->addTransform()->setRotationTransform(1, 0.0, -90.0, 0.05);
+				object->addTransform().setRotationTransform(1, 0.0, -90.0, 0.5);
 				colourA = object->colour();
 				colourB = colourA;
 				colourB.setAlphaF(0.0);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->setDeleteAfterTransform();
 			}
 			if (!questionSource_) break;
@@ -547,8 +605,8 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				colourA.setRgbF(1.0, 1.0, 1.0, 0.0);
 				colourB.setRgbF(1.0, 1.0, 1.0, 1.0);
 				object->setPosition(0.0, 0.0, -0.5);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 
 				// Create object for text
@@ -556,14 +614,13 @@ bool Segment::showNextPart(QuappWindow& quapp)
 				colourA.setRgbF(0.0, 0.0, 0.0, 0.0);
 				colourB.setRgbF(0.0, 0.0, 0.0, 1.0);
 
-				if (imageQuestionDisplayIndex_) text = "("+QString::number(questionSource_->indexOf(currentQuestion_)+1)+")";
-				else text = currentQuestion_->textQuestion();
+				text = imageQuestionText(currentQuestion_);
 
 				object->setTextSize(quapp.bodyTextHeight()*bodyTextSizeModifier_);
-				object->textPrimitive().set(text, TextPrimitive::TopMiddleAnchor);
+				SceneCompiler::setText(object->textPrimitive(), text, TextPrimitive::TopMiddleAnchor);
 				object->setPosition(0.4, -0.31, -0.5);
-				object->addTransform()->setRotationTransform(1, 90.0, 0.0, 0.05);
-				object->addTransform()->setColourTransform(colourA, colourB, 0.05);
+				object->addTransform().setRotationTransform(1, 90.0, 0.0, 0.5);
+				object->addTransform().setColourTransform(colourA, colourB, 0.5);
 				object->initialiseTransforms();
 			}
 
@@ -590,8 +647,8 @@ bool Segment::showNextPart(QuappWindow& quapp)
 					return false;
 				}
 				
-				object->addTransform()->setColourTransform(colourA, colourB, 0.01);
-				object->addTransform()->setTranslationTransform(Vec3<double>(0.0,0.0,0.0), Vec3<double>(-1.0,0.0,0.0), 0.02);
+				object->addTransform().setColourTransform(colourA, colourB, 2.5);
+				object->addTransform().setTranslationTransform(Vec3<double>(0.0,0.0,0.0), Vec3<double>(-1.0,0.0,0.0), 1.25);
 				object->setTransformContinueAt(0.2);
 				object->initialiseTransforms();
 
@@ -626,3 +683,35 @@ bool Segment::hasNextPart()
 	}
 	return false;
 }
+
+// Prefetch media for upcoming parts of the segment, decreasing the supplied number of parts remaining
+void Segment::prefetchMedia(int& nParts, bool fromStart)
+{
+	// Segment image is shown as soon as the segment begins
+	if (fromStart)
+	{
+		if (imageOK_) MediaRegistry::prefetchImage(image_);
+		--nParts;
+	}
+
+	if ((type_ != Segment::QuestionSegment) && (type_ != Segment::AnswerSegment)) return;
+	if (!questionSource_) return;
+
+	Question* question = (fromStart ? questionSource_->questions() : currentQuestion_);
+	while (question && (nParts > 0))
+	{
+		question->prefetchMedia(type_ == Segment::QuestionSegment, type_ == Segment::AnswerSegment);
+		question = question->next;
+		--nParts;
+	}
+}
+
+/*
+ * Media Notification
+ */
+
+// Notify that the specified image has finished loading
+void Segment::mediaImageLoaded(MediaImage* image)
+{
+	if (image == image_) imageOK_ = image->ok();
+}
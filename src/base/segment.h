@@ -23,18 +23,20 @@
 #define QUAPP_SEGMENT_H
 
 #include "base/questionset.h"
+#include "base/medialistener.h"
 #include "templates/list.h"
 #include "templates/reflist.h"
 #include "render/displayobject.h"
 #include <QtCore/QString>
 
 // Forward Declarations
+class MediaImage;
 class QuappWindow;
 class Quiz;
 class Team;
 
 // Segment
-class Segment : public ListItem<Segment>
+class Segment : public ListItem<Segment>, public MediaListener
 {
 	public:
 	// Constructor / Destructor
@@ -68,8 +70,8 @@ class Segment : public ListItem<Segment>
 	QString subText_;
 	// Image filename  for the segment (if relevant)
 	QString imageFileName_;
-	// Image for segment (if relevant)
-	QImage image_;
+	// Image for segment (if relevant, shared)
+	MediaImage* image_;
 	// Whether image was loaded successfully
 	bool imageOK_;
 	// Segment type
@@ -169,13 +171,33 @@ class Segment : public ListItem<Segment>
 	// Next display line to use
 	RefListItem<DisplayObject,int>* displayLine_;
 
+	private:
+	// Return text line showing question
+	QString questionLineText(Question* question);
+	// Return text line showing answer
+	QString answerLineText(Question* question);
+	// Return caption for image question
+	QString imageQuestionText(Question* question);
+
 	public:
+	// Register text for all parts of the segment with the SceneCompiler
+	void compile(QuappWindow& quapp);
 	// Begin segment, creating title object
 	void begin(QuappWindow& quapp);
 	// Create objects to show part of segment
 	bool showNextPart(QuappWindow& quapp);
 	// Return whether there is another part after this one
 	bool hasNextPart();
+	// Prefetch media for upcoming parts of the segment, decreasing the supplied number of parts remaining
+	void prefetchMedia(int& nParts, bool fromStart);
+
+
+	/*
+	 * Media Notification
+	 */
+	public:
+	// Notify that the specified image has finished loading
+	void mediaImageLoaded(MediaImage* image);
 };
 
 #endif
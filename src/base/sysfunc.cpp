@@ -23,7 +23,16 @@
 #include <fstream>
 #include <iostream>
 #include <string.h>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <stdio.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -322,3 +331,24 @@ void enumPrintValid(int nitems, const char* *list)
 // 	}
 // 	else return FALSE;
 // }
+
+// Replace target file with source file, atomically where the platform allows
+bool replaceFile(QString source, QString target)
+{
+#ifdef _WIN32
+	return (MoveFileExW((LPCWSTR) QDir::toNativeSeparators(source).utf16(), (LPCWSTR) QDir::toNativeSeparators(target).utf16(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+	return (rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0);
+#endif
+}
+
+// Flush specified open file, and make sure its contents have reached the disk
+bool syncFile(QFile& file)
+{
+	if (!file.flush()) return false;
+#ifdef _WIN32
+	return (_commit(file.handle()) == 0);
+#else
+	return (fsync(file.handle()) == 0);
+#endif
+}
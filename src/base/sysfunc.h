@@ -24,8 +24,16 @@
 
 #include <QtCore/QString>
 
+// Forward Declarations
+class QFile;
+
 // Enum search and print
 int enumSearch(QString name, int nitems, const char* *list, QString query, bool reportError = 1);
 void enumPrintValid(int nitems, const char* *list);
 
+// Replace target file with source file, atomically where the platform allows
+bool replaceFile(QString source, QString target);
+// Flush specified open file, and make sure its contents have reached the disk
+bool syncFile(QFile& file);
+
 #endif
@@ -0,0 +1,201 @@
+/*
+	*** Tracing Spans
+	*** src/base/tracer.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/tracer.h"
+#include "base/lineparser.h"
+#include "base/messenger.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+
+/*
+ * Trace Buffer
+ */
+
+// Constructor
+TraceBuffer::TraceBuffer() : ListItem<TraceBuffer>()
+{
+	events_ = new TraceEvent[capacity_];
+	nEvents_ = 0;
+	nDropped_ = 0;
+	threadId_ = 0;
+}
+
+// Destructor
+TraceBuffer::~TraceBuffer()
+{
+	delete[] events_;
+}
+
+// Set thread identifier and name
+void TraceBuffer::setThread(int id, QString name)
+{
+	threadId_ = id;
+	threadName_ = name;
+}
+
+// Return thread identifier
+int TraceBuffer::threadId()
+{
+	return threadId_;
+}
+
+// Return thread name
+QString TraceBuffer::threadName()
+{
+	return threadName_;
+}
+
+// Record event (called only from the owning thread)
+void TraceBuffer::record(const char* name, qint64 start, qint64 end)
+{
+	int n = nEvents_;
+	if (n == capacity_)
+	{
+		++nDropped_;
+		return;
+	}
+
+	events_[n].name = name;
+	events_[n].start = start;
+	events_[n].duration = end - start;
+
+	// Publish the event only once it is complete
+	nEvents_.fetchAndStoreRelease(n+1);
+}
+
+// Return number of published events
+int TraceBuffer::nEvents()
+{
+	return nEvents_.fetchAndAddAcquire(0);
+}
+
+// Return nth event
+const TraceEvent& TraceBuffer::event(int n)
+{
+	return events_[n];
+}
+
+// Return number of events dropped
+int TraceBuffer::nDropped()
+{
+	return nDropped_;
+}
+
+// Discard all events
+void TraceBuffer::clear()
+{
+	nEvents_.fetchAndStoreRelease(0);
+	nDropped_ = 0;
+}
+
+/*
+ * Tracer
+ */
+
+// Thread-local reference to a thread's buffer (the buffer itself belongs to the Tracer, since it must outlive its thread)
+class TraceBufferReference
+{
+	public:
+	// Referenced buffer
+	TraceBuffer* buffer;
+};
+
+// Static Members
+bool Tracer::enabled_ = false;
+QElapsedTimer Tracer::clock_;
+List<TraceBuffer> Tracer::buffers_;
+QMutex Tracer::mutex_;
+static QThreadStorage<TraceBufferReference*> threadBufferReference;
+
+// Enable or disable recording, returning false if spans were not compiled in
+bool Tracer::setEnabled(bool enabled)
+{
+#ifdef QUAPPTRACE
+	if (enabled && (!clock_.isValid())) clock_.start();
+	enabled_ = enabled;
+	return true;
+#else
+	if (enabled) msg.print("Warning: Tracing spans are not available in this build (configure with --enable-trace).\n");
+	return false;
+#endif
+}
+
+// Return buffer for calling thread, creating it if necessary
+TraceBuffer* Tracer::threadBuffer()
+{
+	if (threadBufferReference.hasLocalData()) return threadBufferReference.localData()->buffer;
+
+	QMutexLocker locker(&mutex_);
+	TraceBuffer* buffer = buffers_.add();
+	QThread* thread = QThread::currentThread();
+	bool mainThread = (QCoreApplication::instance() && (thread == QCoreApplication::instance()->thread()));
+	buffer->setThread(buffers_.nItems(), mainThread ? QString("Main") : QString("Worker %1").arg(buffers_.nItems()));
+
+	TraceBufferReference* reference = new TraceBufferReference;
+	reference->buffer = buffer;
+	threadBufferReference.setLocalData(reference);
+
+	return buffer;
+}
+
+// Record completed span
+void Tracer::record(const char* name, qint64 start, qint64 end)
+{
+	threadBuffer()->record(name, start, end);
+}
+
+// Export recorded events to the specified file as Chrome trace-event JSON
+bool Tracer::exportTrace(QString fileName)
+{
+	LineParser parser(fileName, true);
+	if (!parser.ready())
+	{
+		msg.print("Error: Couldn't open file '%s' for trace export.\n", qPrintable(fileName));
+		return false;
+	}
+
+	QMutexLocker locker(&mutex_);
+
+	// Thread names are written as metadata events, followed by complete ('X') events with times in microseconds
+	int nEvents = 0, nDropped = 0;
+	parser.writeLineF("{\n  \"traceEvents\": [\n");
+	parser.writeLineF("    { \"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": { \"name\": \"Quapp\" } }");
+	for (TraceBuffer* buffer = buffers_.first(); buffer != NULL; buffer = buffer->next)
+	{
+		parser.writeLineF(",\n    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %i, \"args\": { \"name\": \"%s\" } }", buffer->threadId(), qPrintable(buffer->threadName()));
+		int n = buffer->nEvents();
+		for (int i=0; i<n; ++i)
+		{
+			const TraceEvent& event = buffer->event(i);
+			parser.writeLineF(",\n    { \"name\": \"%s\", \"cat\": \"quapp\", \"ph\": \"X\", \"pid\": 1, \"tid\": %i, \"ts\": %.3f, \"dur\": %.3f }", event.name, buffer->threadId(), event.start*1.0e-3, event.duration*1.0e-3);
+		}
+		nEvents += n;
+		nDropped += buffer->nDropped();
+	}
+	parser.writeLineF("\n  ],\n  \"displayTimeUnit\": \"ms\"\n}\n");
+	parser.closeFiles();
+
+	msg.print("Exported %i trace event(s) from %i thread(s) to '%s'.\n", nEvents, buffers_.nItems(), qPrintable(fileName));
+	if (nDropped > 0) msg.print("Warning: %i event(s) were dropped because trace buffers were full.\n", nDropped);
+
+	return true;
+}
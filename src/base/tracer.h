@@ -0,0 +1,183 @@
+/*
+	*** Tracing Spans
+	*** src/base/tracer.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_TRACER_H
+#define QUAPP_TRACER_H
+
+#include "templates/list.h"
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+// Forward Declarations
+/* none */
+
+/*
+ * Span Macro
+ * -- Spans are only compiled in when QUAPPTRACE is defined (configure with --enable-trace), and only recorded when the Tracer is enabled
+ */
+#ifdef QUAPPTRACE
+#define QUAPP_TRACE_JOIN2(a,b) a##b
+#define QUAPP_TRACE_JOIN(a,b) QUAPP_TRACE_JOIN2(a,b)
+#define TRACESPAN(name) TraceSpan QUAPP_TRACE_JOIN(traceSpan_,__LINE__)(name)
+#else
+#define TRACESPAN(name)
+#endif
+
+// Trace Event
+struct TraceEvent
+{
+	// Span name (must be a string literal)
+	const char* name;
+	// Start time (in ns since tracing was enabled)
+	qint64 start;
+	// Duration (in ns)
+	qint64 duration;
+};
+
+/*!
+ * \brief Trace Buffer
+ * \details Fixed-size store of events recorded by a single thread. Only the owning thread ever writes events, publishing each one
+ * by advancing the event count, so recording takes no locks and the buffer can be read safely from another thread at any time.
+ */
+class TraceBuffer : public ListItem<TraceBuffer>
+{
+	public:
+	// Constructor / Destructor
+	TraceBuffer();
+	~TraceBuffer();
+	// Maximum number of events held by each buffer
+	static const int capacity_ = 65536;
+
+
+	/*
+	 * Events
+	 */
+	private:
+	// Recorded events
+	TraceEvent* events_;
+	// Number of events published
+	QAtomicInt nEvents_;
+	// Number of events dropped because the buffer was full
+	int nDropped_;
+	// Thread identifier used in trace output
+	int threadId_;
+	// Thread name used in trace output
+	QString threadName_;
+
+	public:
+	// Set thread identifier and name
+	void setThread(int id, QString name);
+	// Return thread identifier
+	int threadId();
+	// Return thread name
+	QString threadName();
+	// Record event (called only from the owning thread)
+	void record(const char* name, qint64 start, qint64 end);
+	// Return number of published events
+	int nEvents();
+	// Return nth event
+	const TraceEvent& event(int n);
+	// Return number of events dropped
+	int nDropped();
+	// Discard all events
+	void clear();
+};
+
+// Tracer
+class Tracer
+{
+	/*
+	 * Control
+	 */
+	private:
+	// Whether spans are currently recorded
+	static bool enabled_;
+	// Timer from which all event times are derived
+	static QElapsedTimer clock_;
+
+	public:
+	// Enable or disable recording, returning false if spans were not compiled in
+	static bool setEnabled(bool enabled);
+	// Return whether spans are currently recorded
+	static bool enabled()
+	{
+		return enabled_;
+	}
+	// Return current time (in ns since tracing was enabled)
+	static qint64 now()
+	{
+		return clock_.nsecsElapsed();
+	}
+
+
+	/*
+	 * Buffers
+	 */
+	private:
+	// List of buffers, one per thread which has recorded an event
+	static List<TraceBuffer> buffers_;
+	// Mutex protecting the buffer list (only taken when a thread records its first event)
+	static QMutex mutex_;
+
+	private:
+	// Return buffer for calling thread, creating it if necessary
+	static TraceBuffer* threadBuffer();
+
+	public:
+	// Record completed span
+	static void record(const char* name, qint64 start, qint64 end);
+	// Export recorded events to the specified file as Chrome trace-event JSON
+	static bool exportTrace(QString fileName);
+};
+
+/*!
+ * \brief Trace Span
+ * \details Records the time between its construction and destruction as a single event, if the Tracer is enabled. Use through
+ * the TRACESPAN macro, so that spans disappear entirely from builds without tracing.
+ */
+class TraceSpan
+{
+	public:
+	// Constructor / Destructor
+	TraceSpan(const char* name)
+	{
+		if (Tracer::enabled())
+		{
+			name_ = name;
+			start_ = Tracer::now();
+		}
+		else name_ = NULL;
+	}
+	~TraceSpan()
+	{
+		if (name_) Tracer::record(name_, start_, Tracer::now());
+	}
+
+	private:
+	// Span name
+	const char* name_;
+	// Start time (in ns)
+	qint64 start_;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+	*** Media Loader
+	*** src/gui/medialoader_funcs.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/medialoader.uih"
+#include "base/mediaregistry.h"
+
+// Constructor
+MediaLoader::MediaLoader(QObject* parent) : QObject(parent)
+{
+	MediaRegistry::setNotifier(this);
+}
+
+// Destructor
+MediaLoader::~MediaLoader()
+{
+	MediaRegistry::setNotifier(NULL);
+}
+
+/*
+ * Completion
+ */
+
+// Collect completed decode jobs from the MediaRegistry (invoked from worker threads via a queued call)
+void MediaLoader::processCompleted()
+{
+	// Several queued calls may arrive for jobs that were all collected by the first
+	if (MediaRegistry::processCompleted() == 0) return;
+
+	emit progress(MediaRegistry::nJobsProcessed(), MediaRegistry::nJobsQueued());
+
+	if (!MediaRegistry::busy()) emit finished();
+}
@@ -24,9 +24,14 @@
 
 #include "gui/display.h"
 #include "gui/ui_quapp.h"
+#include "gui/medialoader.uih"
+#include "render/discfield.h"
 #include "base/quiz.h"
+#include "base/quizsnapshot.h"
 #include "base/lineparser.h"
 #include <QtCore/QDir>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
 
 // Forward Declarations
@@ -86,6 +91,8 @@ class QuappWindow : public QMainWindow
 	void on_actionDisplayRunFromStart_triggered(bool checked);
 	void on_actionDisplayRunFromSegment_triggered(bool checked);
 	void on_actionDisplayToggleFullscreen_triggered(bool checked);
+	void on_actionDisplayShowProfiler_triggered(bool checked);
+	void on_actionDisplayExportProfile_triggered(bool checked);
 
 
 	/*
@@ -173,6 +180,8 @@ class QuappWindow : public QMainWindow
 	private:
 	// Return current Team
 	Team* currentTeam();
+	// Compile the running order from the specified segment onwards
+	void compileRunningOrder(Segment* firstSegment);
 
 	private slots:
 	// Teams / Scores
@@ -212,8 +221,6 @@ class QuappWindow : public QMainWindow
 	List<DisplayObject> foregroundObjects_;
 	// Persistent foreground objects (e.g. headers, titles etc.)
 	List<DisplayObject> persistentForegroundObjects_;
-	// Object timer
-	QTimer objectTimer_;
 	// Fractional margin to use for foreground objects
 	double foregroundMargin_;
 	// Height of title line
@@ -228,18 +235,22 @@ class QuappWindow : public QMainWindow
 	double bodyTextHeight_;
 	// Scale modifier for aspect ratio (to adjust odd ratios on screen)
 	double aspectModifier_;
+	// Duration of transition of outgoing scene when moving between segments
+	static const double segmentTransitionDuration_;
 	
-	protected slots:
-	// Update objects
-	void updateObjects();
+	public:
+	// Update objects to the current animation time, returning whether anything is still animating
+	bool updateObjects();
 
 	private:
 	// Calculate text heights
 	void calculateTextHeights();
 	// Apply transition to all objects in list
-	void applyExitTransform(List<DisplayObject>& objects, QuappWindow::ExitTransformType transformType, double speed, double stallCoordinate = 0.0);
+	void applyExitTransform(List<DisplayObject>& objects, QuappWindow::ExitTransformType transformType, double duration, double stallCoordinate = 0.0);
 	// Apply entrance transition to specific object (using current position as destination)
-	void applyEntranceTransform(DisplayObject* object, QuappWindow::EntranceTransformType transformType, double speed, double stallCoordinate = 0.0);
+	void applyEntranceTransform(DisplayObject* object, QuappWindow::EntranceTransformType transformType, double duration, double stallCoordinate = 0.0);
+	// Transition out all persistent and foreground objects, ready for the next segment
+	void transitionForegroundOut();
 
 	public:
 	// Background objects
@@ -304,26 +315,113 @@ class QuappWindow : public QMainWindow
 	private:
 	// Current background type
 	BackgroundType backgroundType_;
+	// Animated disc field
+	DiscField backgroundDiscs_;
+	// Number of discs in field
+	int nBackgroundDiscs_;
 
 	public:
 	// Initialise background
 	void initialiseBackground(BackgroundType type);
-	// Update background
-	void updateBackground();
+	// Update background, returning whether anything changed
+	bool updateBackground();
+	// Set number of discs in background field
+	void setNBackgroundDiscs(int nDiscs);
+	// Return background disc field
+	DiscField& backgroundDiscs();
+
+
+	/*
+	 * Media
+	 */
+	private:
+	// Receiver for completed background media decodes
+	MediaLoader mediaLoader_;
+
+	private slots:
+	// Media decoding progress
+	void mediaLoadProgress(int nCompleted, int nTotal);
+	// All queued media has been decoded
+	void mediaLoadFinished();
 
 
 	/*
 	 * Audio
 	 */
 	private:
-	// Current audio file being played back
-	QFile currentAudioStream_;
+	// Current audio stream being played back
+	QIODevice* currentAudioStream_;
 	// Current audio output instance
 	QAudioOutput* audioOutput_;
 
 	public:
 	// Play specified audio file
 		bool playAudio(QString filename);
+
+
+	/*
+	 * Autosave
+	 */
+	private:
+	// Timer triggering autosaves
+	QTimer autosaveTimer_;
+	// Semaphore marking an autosave in progress
+	QSemaphore autosaveSlot_;
+	// Snapshot of quiz as last loaded, saved, or successfully autosaved
+	QuizSnapshot lastAutosave_;
+	// Snapshot being written by the autosave in progress (if any), and the file it is being written to
+	QuizSnapshot pendingAutosave_;
+	QString pendingAutosaveFile_;
+	// Thread pool running autosaves (separate from the global pool, so that waiting on that never waits on an autosave)
+	QThreadPool autosavePool_;
+
+	public:
+	// Set interval between autosaves (in seconds, zero to disable)
+	void setAutosaveInterval(int seconds);
+	// Return filename to which autosaves are written
+	QString autosaveFileName();
+	// Take current state of quiz as saved, so that it is not autosaved until changed
+	void resetAutosave();
+	// Wait for any autosave in progress to finish (which must be done before the quiz is loaded or saved, since the autosave may be reading the open bundle)
+	void waitForAutosave();
+
+	private slots:
+	// Write snapshot of quiz in the background, if it has changed since it was last saved
+	void autosave();
+
+
+	/*
+	 * Run Rendering
+	 */
+	private:
+	// Whether a run is currently being rendered offscreen
+	bool renderingRun_;
+	// Time for which each step is held after its animations have finished, when rendering a run
+	static const double renderHoldTime_;
+	// Maximum time spent on each step, when rendering a run
+	static const double renderMaxStepTime_;
+
+	private:
+	// Return whether any foreground object (or the snapshot of an outgoing scene) is still animating
+	bool foregroundAnimating();
+	// Begin rendered run from the first visual segment, at time zero
+	bool startRenderedRun();
+	// Move rendered run on to the next item in the segment, or the next segment if there is no next item
+	void advanceRenderedRun();
+	// Finish rendered run
+	void finishRenderedRun();
+
+	public:
+	// Render complete run offscreen, writing numbered PNG frames to the specified directory
+	bool renderRun(QString outputDirectory, int fps, int width, int height);
+
+
+	/*
+	 * Benchmarking
+	 */
+	public:
+	// Run render benchmark on a synthetic quiz, as described by the supplied specification
+	bool benchmark(QString spec);
 };
 
 #endif
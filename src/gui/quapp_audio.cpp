@@ -20,25 +20,28 @@
 */
 
 #include "gui/quapp.h"
+#include "base/mediabundle.h"
 #include <QtMultimedia/QAudioOutput>
 
 // Play specified audio file
 bool QuappWindow::playAudio(QString filename)
 {
+	// No audio is wanted when rendering a run to images
+	if (renderingRun_) return true;
+
 	// Make sure current audio is stopped
 	audioOutput_->stop();
-	if (currentAudioStream_.isOpen()) currentAudioStream_.close();
+	if (currentAudioStream_) delete currentAudioStream_;
 
-	// Set new stream
-	currentAudioStream_.setFileName(filename);
-	currentAudioStream_.open(QIODevice::ReadOnly);
-	if (!currentAudioStream_.isOpen())
+	// Set new stream (audio in a bundle is streamed from the bundle file)
+	currentAudioStream_ = MediaBundle::device(filename);
+	if ((!currentAudioStream_) || (!currentAudioStream_->open(QIODevice::ReadOnly)))
 	{
 		printf("Error opening audio file.\n");
 		return false;
 	}
 
-	audioOutput_->start(&currentAudioStream_);
+	audioOutput_->start(currentAudioStream_);
 
 	return true;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+	*** QuappWindow Autosave
+	*** src/gui/quapp_autosave.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/quapp.h"
+#include "base/autosavejob.h"
+#include "base/mediabundle.h"
+#include "base/session.h"
+#include <QtCore/QFileInfo>
+
+// Set interval between autosaves (in seconds, zero to disable)
+void QuappWindow::setAutosaveInterval(int seconds)
+{
+	if (seconds > 0) autosaveTimer_.start(seconds*1000);
+	else autosaveTimer_.stop();
+}
+
+// Return filename to which autosaves are written
+QString QuappWindow::autosaveFileName()
+{
+	// Autosaves are written in text format - over the input file if it is a text file, or alongside it if not
+	QString inputFile = Session::inputFile();
+	if (inputFile.isEmpty())
+	{
+		QDir().mkpath(QDir::homePath() + "/.quapp");
+		return QDir::homePath() + "/.quapp/autosave.qap";
+	}
+	else if (QFileInfo(inputFile).suffix() == "qap") return inputFile;
+	else return inputFile + ".autosave.qap";
+}
+
+// Take current state of quiz as saved, so that it is not autosaved until changed
+void QuappWindow::resetAutosave()
+{
+	lastAutosave_ = QuizSnapshot(quiz_);
+
+	// Any autosave still in progress is older than this, so must not replace it when it finishes
+	pendingAutosave_ = QuizSnapshot();
+}
+
+// Wait for any autosave in progress to finish (which must be done before the quiz is loaded or saved, since the autosave may be reading the open bundle)
+void QuappWindow::waitForAutosave()
+{
+	autosaveSlot_.acquire();
+	autosaveSlot_.release();
+}
+
+// Write snapshot of quiz in the background, if it has changed since it was last saved
+void QuappWindow::autosave()
+{
+	// Never wait for a previous autosave - we'll catch up next time
+	if (!autosaveSlot_.tryAcquire()) return;
+
+	// The previous autosave has finished - if it reached the disk, it is now the last autosave (otherwise the quiz is still unsaved)
+	if (pendingAutosave_.serial() != 0)
+	{
+		if (QuizSnapshot::writtenSerial(pendingAutosaveFile_) >= pendingAutosave_.serial()) lastAutosave_ = pendingAutosave_;
+		pendingAutosave_ = QuizSnapshot();
+	}
+
+	// Strings in an unchanged quiz are still shared with the last snapshot, so comparison is cheap
+	QuizSnapshot snapshot(quiz_);
+	if (snapshot.matches(lastAutosave_))
+	{
+		autosaveSlot_.release();
+		return;
+	}
+	pendingAutosave_ = snapshot;
+	pendingAutosaveFile_ = autosaveFileName();
+
+	autosavePool_.start(new AutosaveJob(snapshot, pendingAutosaveFile_, !MediaBundle::fileName().isEmpty(), &autosaveSlot_));
+}
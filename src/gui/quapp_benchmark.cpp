@@ -0,0 +1,168 @@
+/*
+	*** Main Window - Render Benchmark
+	*** src/gui/quapp_benchmark.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/quapp.h"
+#include "base/lineparser.h"
+#include "base/mediaregistry.h"
+#include "base/messenger.h"
+#include "base/quizgenerator.h"
+#include "render/animationclock.h"
+#include "render/primitive.h"
+#include "render/textfragment.h"
+#include "templates/objectpool.h"
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <algorithm>
+
+// Return value at the specified fraction through the sorted list of values
+static double percentile(const QVector<double>& sortedValues, double fraction)
+{
+	if (sortedValues.count() == 0) return 0.0;
+	int index = qMin(sortedValues.count()-1, int(fraction*sortedValues.count()));
+	return sortedValues.at(index);
+}
+
+// Run render benchmark on a synthetic quiz, as described by the supplied specification
+bool QuappWindow::benchmark(QString spec)
+{
+	// Parse specification - a comma-separated list of name=value pairs, passed either to us or to the generator
+	QuizGenerator generator;
+	int nFrames = 600, stepFrames = 30, width = 1280, height = 720;
+	QString outputFile;
+	QStringList items = spec.split(",", QString::SkipEmptyParts);
+	foreach(QString item, items)
+	{
+		if (item == "-") continue;
+		QString name = item.section('=', 0, 0).trimmed().toLower(), value = item.section('=', 1).trimmed();
+		if (name == "frames") nFrames = qMax(1, value.toInt());
+		else if (name == "step") stepFrames = qMax(1, value.toInt());
+		else if (name == "width") width = qMax(1, value.toInt());
+		else if (name == "height") height = qMax(1, value.toInt());
+		else if (name == "output") outputFile = value;
+		else if (!generator.setParameter(name, value))
+		{
+			msg.print("Error: Unrecognised benchmark parameter '%s'.\n", qPrintable(name));
+			return false;
+		}
+	}
+
+	// Generate the synthetic quiz
+	QDir dir(QDir::temp().filePath("quapp-benchmark"));
+	if (!dir.mkpath("."))
+	{
+		msg.print("Error: Couldn't create benchmark directory '%s'.\n", qPrintable(dir.path()));
+		return false;
+	}
+	QString quizFile = dir.filePath("synthetic.qap");
+	QElapsedTimer timer;
+	timer.start();
+	if (!generator.write(quizFile, dir.filePath("media"))) return false;
+	double generateTime = timer.nsecsElapsed() / 1.0e6;
+
+	// Load it, and time decoding of all its media
+	waitForAutosave();
+	timer.restart();
+	if (!quiz_.load(quizFile)) return false;
+	double loadTime = timer.nsecsElapsed() / 1.0e6;
+	timer.restart();
+	MediaRegistry::decodeAll();
+	MediaRegistry::waitForPending();
+	double decodeTime = timer.nsecsElapsed() / 1.0e6;
+
+	Viewer* viewer = displayWindow_.ui.MainView;
+	if (!viewer->beginOffScreen(width, height)) return false;
+	if (!startRenderedRun())
+	{
+		QImage image;
+		viewer->endOffScreen(image);
+		return false;
+	}
+
+	int displayObjectAllocations = ObjectPool<DisplayObject>::nAllocations();
+	int textFragmentAllocations = ObjectPool<TextFragment>::nAllocations();
+	int primitiveAllocations = ObjectPool<Primitive>::nAllocations();
+
+	// Render fixed number of frames at 60 fps, advancing the run at regular intervals and starting again if it ends
+	// -- No readback is performed, so the timings reflect scene update and drawing only
+	QVector<double> frameTimes(nFrames);
+	QImage image;
+	double time = 0.0;
+	int nDrawCalls = 0, maxDrawCalls = 0, nRestarts = 0;
+	for (int frame = 0; frame < nFrames; ++frame)
+	{
+		timer.restart();
+		Primitive::resetDrawCalls();
+
+		if ((frame > 0) && (frame%stepFrames == 0))
+		{
+			if (quiz_.currentSegment()) advanceRenderedRun();
+			else
+			{
+				startRenderedRun();
+				time = 0.0;
+				++nRestarts;
+			}
+			quiz_.prefetchMedia();
+		}
+
+		AnimationClock::setFrameTime(time);
+		updateObjects();
+		viewer->renderOffScreen(image, false);
+
+		frameTimes[frame] = timer.nsecsElapsed() / 1.0e6;
+		nDrawCalls += Primitive::nDrawCalls();
+		maxDrawCalls = qMax(maxDrawCalls, Primitive::nDrawCalls());
+		time += 1.0 / 60.0;
+	}
+
+	viewer->endOffScreen(image);
+	finishRenderedRun();
+
+	// Calculate frame time statistics
+	double totalTime = 0.0;
+	for (int n=0; n<nFrames; ++n) totalTime += frameTimes.at(n);
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	// Assemble results
+	QString json = "{\n";
+	json += QString("  \"quiz\": { \"teams\": %1, \"rounds\": %2, \"questions\": %3, \"imageSize\": %4, \"markupDensity\": %5, \"seed\": %6, \"segments\": %7 },\n").arg(generator.nTeams()).arg(generator.nRounds()).arg(generator.nQuestions()).arg(generator.imageSize()).arg(generator.markupDensity()).arg(generator.seed()).arg(generator.nSegments());
+	json += QString("  \"loadTimeMs\": { \"generate\": %1, \"parse\": %2, \"decode\": %3 },\n").arg(generateTime, 0, 'f', 3).arg(loadTime, 0, 'f', 3).arg(decodeTime, 0, 'f', 3);
+	json += QString("  \"render\": { \"width\": %1, \"height\": %2, \"frames\": %3, \"stepFrames\": %4, \"restarts\": %5 },\n").arg(width).arg(height).arg(nFrames).arg(stepFrames).arg(nRestarts);
+	json += QString("  \"frameTimeMs\": { \"mean\": %1, \"p50\": %2, \"p90\": %3, \"p99\": %4, \"max\": %5 },\n").arg(totalTime / nFrames, 0, 'f', 3).arg(percentile(frameTimes, 0.5), 0, 'f', 3).arg(percentile(frameTimes, 0.9), 0, 'f', 3).arg(percentile(frameTimes, 0.99), 0, 'f', 3).arg(frameTimes.at(nFrames-1), 0, 'f', 3);
+	json += QString("  \"drawCalls\": { \"mean\": %1, \"max\": %2 },\n").arg(double(nDrawCalls) / nFrames, 0, 'f', 1).arg(maxDrawCalls);
+	json += QString("  \"allocations\": {\n");
+	json += QString("    \"DisplayObject\": { \"count\": %1, \"peakLive\": %2 },\n").arg(ObjectPool<DisplayObject>::nAllocations() - displayObjectAllocations).arg(ObjectPool<DisplayObject>::nPeakLive());
+	json += QString("    \"TextFragment\": { \"count\": %1, \"peakLive\": %2 },\n").arg(ObjectPool<TextFragment>::nAllocations() - textFragmentAllocations).arg(ObjectPool<TextFragment>::nPeakLive());
+	json += QString("    \"Primitive\": { \"count\": %1, \"peakLive\": %2 }\n").arg(ObjectPool<Primitive>::nAllocations() - primitiveAllocations).arg(ObjectPool<Primitive>::nPeakLive());
+	json += "  }\n}\n";
+
+	// Write to file if one was specified, otherwise to stdout
+	if (outputFile.isEmpty()) printf("%s", qPrintable(json));
+	else
+	{
+		LineParser parser(outputFile, true);
+		if (!parser.ready()) return false;
+		parser.writeLine(json);
+		parser.closeFiles();
+	}
+
+	return true;
+}
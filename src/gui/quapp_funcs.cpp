@@ -21,6 +21,7 @@
 
 #include "gui/quapp.h"
 #include "render/fontinstance.h"
+#include "base/mediaregistry.h"
 #include "base/session.h"
 #include "templates/variantpointer.h"
 #include "version.h"
@@ -28,7 +29,7 @@
 #include <QtMultimedia/QAudioOutput>
 
 // Constructor
-QuappWindow::QuappWindow(QMainWindow *parent) : QMainWindow(parent), displayWindow_(*this)
+QuappWindow::QuappWindow(QMainWindow *parent) : QMainWindow(parent), displayWindow_(*this), autosaveSlot_(1)
 {
 	// Initialise the icon resource
 	Q_INIT_RESOURCE(icons);
@@ -52,6 +53,8 @@ QuappWindow::QuappWindow(QMainWindow *parent) : QMainWindow(parent), displayWind
 
 	// Set variable defaults
 	aspectModifier_ = 1.0;
+	nBackgroundDiscs_ = 200;
+	renderingRun_ = false;
 
 printf("Lkjlkjlkl\n");
 foreach(const QAudioDeviceInfo &deviceInfo, QAudioDeviceInfo::availableDevices(QAudio::AudioOutput))
@@ -74,20 +77,29 @@ foreach(const QAudioDeviceInfo &deviceInfo, QAudioDeviceInfo::availableDevices(Q
 		format = info.nearestFormat(format);
 	}
 	audioOutput_ = new QAudioOutput(format, this);
+	currentAudioStream_ = NULL;
 // 	connect(audio, SIGNAL(stateChanged(QAudio::State)), this, SLOT(handleStateChanged(QAudio::State)));
 
-	startNewSession();
+	// Set location for cached (reduced) media
+	MediaRegistry::setCacheDirectory(QDir::homePath() + "/.quapp/mediacache");
+
+	// Connect media loader signals
+	QObject::connect(&mediaLoader_, SIGNAL(progress(int,int)), this, SLOT(mediaLoadProgress(int,int)));
+	QObject::connect(&mediaLoader_, SIGNAL(finished()), this, SLOT(mediaLoadFinished()));
+
+	// Autosave every minute by default, one at a time
+	autosavePool_.setMaxThreadCount(1);
+	QObject::connect(&autosaveTimer_, SIGNAL(timeout()), this, SLOT(autosave()));
+	setAutosaveInterval(60);
 
-	// Setup and start timer
-	QObject::connect(&objectTimer_, SIGNAL(timeout()), this, SLOT(updateObjects()));
-	objectTimer_.setInterval(25);
-	objectTimer_.setSingleShot(true);
-	objectTimer_.start();
+	startNewSession();
 }
 
 // Destructor
 QuappWindow::~QuappWindow()
 {
+	waitForAutosave();
+	if (currentAudioStream_) delete currentAudioStream_;
 }
 
 /*
@@ -142,4 +154,8 @@ void QuappWindow::startNewSession()
 
 	// Initialise background
 	initialiseBackground(QuappWindow::TestBackground);
+
+	// A new session has no file, and nothing worth autosaving yet
+	Session::setInputFile(QString());
+	resetAutosave();
 }
@@ -0,0 +1,42 @@
+/*
+	*** Media Functions
+	*** src/gui/quapp_media.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/quapp.h"
+#include "base/mediaregistry.h"
+
+// Media decoding progress
+void QuappWindow::mediaLoadProgress(int nCompleted, int nTotal)
+{
+	statusBar()->showMessage(QString("Loading media (%1 of %2)...").arg(nCompleted).arg(nTotal));
+}
+
+// All queued media has been decoded
+void QuappWindow::mediaLoadFinished()
+{
+	statusBar()->clearMessage();
+
+	MediaRegistry::printStatistics();
+
+	// Refresh editor controls, since image validity may have changed
+	if (refreshing_) return;
+	updateQuestions(currentQuestion());
+	updateSegments(currentSegment(), false);
+}
@@ -20,7 +20,10 @@
 */
 
 #include "gui/quapp.h"
+#include "base/mediabundle.h"
+#include "base/quizarchive.h"
 #include "base/session.h"
+#include "render/frameprofiler.h"
 #include <QtGui/QFileDialog>
 #include <QtGui/QMessageBox>
 #include <QtGui/QInputDialog>
@@ -59,16 +62,18 @@ void QuappWindow::on_actionFileOpen_triggered(bool checked)
 		}
 	}
 
-	QString fileName = QFileDialog::getOpenFileName(this, "Choose file to load", inputFileDirectory_.absolutePath(), "Quapp files (*.qap);;All files (*.*)");
+	QString fileName = QFileDialog::getOpenFileName(this, "Choose file to load", inputFileDirectory_.absolutePath(), "Quapp files (*.qap *.qab *.qapz);;All files (*.*)");
 	if (fileName.isEmpty()) return;
 	inputFileDirectory_ = fileName;
 
 	// Load input file
+	waitForAutosave();
 	if (!quiz_.load(fileName))
 	{
 		QMessageBox::information(this, "Failed to load session", "Failed to load the session, so reverting to the default.\n");
 		startNewSession();
 	}
+	else resetAutosave();
 
 	// Update the GUI
 	updateSegments();
@@ -80,30 +85,40 @@ void QuappWindow::on_actionFileSave_triggered(bool checked)
 	// Has an input filename already been chosen?
 	if (Session::inputFile().isEmpty())
 	{
-		QString fileName = QFileDialog::getSaveFileName(this, "Choose save file name", inputFileDirectory_.absolutePath(), "Quapp files (*.qap);;All files (*.*)");
+		QString fileName = QFileDialog::getSaveFileName(this, "Choose save file name", inputFileDirectory_.absolutePath(), "Quapp files (*.qap);;Quapp archives (*.qab);;Quapp bundles (*.qapz);;All files (*.*)");
 		if (fileName.isEmpty()) return;
 
 		// Make sure the file has the right extension
 		QFileInfo fileInfo(fileName);
-		if (fileInfo.suffix() != "qap") fileName += ".qap";
+		if ((fileInfo.suffix() != "qap") && (fileInfo.suffix() != QuizArchive::extension()) && (fileInfo.suffix() != MediaBundle::extension())) fileName += ".qap";
 		Session::setInputFile(fileName);
 	}
 
-	if (quiz_.save(Session::inputFile())) Session::setAsNotModified();
+	waitForAutosave();
+	if (quiz_.save(Session::inputFile()))
+	{
+		Session::setAsNotModified();
+		resetAutosave();
+	}
 }
 
 void QuappWindow::on_actionFileSaveAs_triggered(bool checked)
 {
 	// Get a filename from the user
-	QString fileName = QFileDialog::getSaveFileName(this, "Choose save file name", inputFileDirectory_.absolutePath(), "Quapp files (*.qap);;All files (*.*)");
+	QString fileName = QFileDialog::getSaveFileName(this, "Choose save file name", inputFileDirectory_.absolutePath(), "Quapp files (*.qap);;Quapp archives (*.qab);;Quapp bundles (*.qapz);;All files (*.*)");
 	if (fileName.isEmpty()) return;
 
 	// Make sure the file has the right extension
 	QFileInfo fileInfo(fileName);
-	if (fileInfo.suffix() != "qap") fileName += ".qap";
+	if ((fileInfo.suffix() != "qap") && (fileInfo.suffix() != QuizArchive::extension()) && (fileInfo.suffix() != MediaBundle::extension())) fileName += ".qap";
 	Session::setInputFile(fileName);
 
-	if (quiz_.save(Session::inputFile())) Session::setAsNotModified();
+	waitForAutosave();
+	if (quiz_.save(Session::inputFile()))
+	{
+		Session::setAsNotModified();
+		resetAutosave();
+	}
 }
 
 void QuappWindow::on_actionDisplayShow_triggered(bool checked)
@@ -125,4 +140,18 @@ void QuappWindow::on_actionDisplayToggleFullscreen_triggered(bool checked)
 {
 	if (displayWindow_.isFullScreen()) displayWindow_.showNormal();
 	else displayWindow_.showFullScreen();
-}
\ No newline at end of file
+}
+
+void QuappWindow::on_actionDisplayShowProfiler_triggered(bool checked)
+{
+	FrameProfiler::setOverlay(checked);
+	displayWindow_.ui.MainView->update();
+}
+
+void QuappWindow::on_actionDisplayExportProfile_triggered(bool checked)
+{
+	QString fileName = QFileDialog::getSaveFileName(this, "Choose frame profile file name", inputFileDirectory_.absolutePath(), "CSV files (*.csv);;JSON files (*.json);;All files (*.*)");
+	if (fileName.isEmpty()) return;
+
+	if (!FrameProfiler::exportFrames(fileName)) QMessageBox::warning(this, "Export Failed", "Failed to export the frame profile.\n");
+}
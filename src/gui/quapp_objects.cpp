@@ -21,54 +21,96 @@
 
 #include "gui/quapp.h"
 #include "base/messenger.h"
+#include "base/tracer.h"
 #include "render/fontinstance.h"
+#include "render/animationstore.h"
+#include "render/animationclock.h"
+#include "render/frameprofiler.h"
+#include "render/snapshottransition.h"
 
-// Update objects
-void QuappWindow::updateObjects()
+// Static Members
+const double QuappWindow::segmentTransitionDuration_ = 0.5;
+
+// Update objects to the current animation time, returning whether anything is still animating
+bool QuappWindow::updateObjects()
 {
-	DisplayObject* object;
-	int nChanged = 0;
-	RefList<DisplayObject,bool> toDelete;
-	RefListItem<DisplayObject,bool>* refObject;
+	TRACESPAN("QuappWindow::updateObjects");
+
+	DisplayObject* object, *nextObject;
+	int nAnimating = 0, nDeleted = 0;
+	bool held;
 
-	// Background objects
+	FrameProfiler::startTimer(FrameProfiler::UpdateObjectsTimer);
+
+	// Hold any objects which follow one that is stalling
+	held = false;
 	for (object = backgroundObjects_.first(); object != NULL; object = object->next)
 	{
-		if (object->updateDynamic()) ++nChanged;
-		if (object->toBeDeleted()) toDelete.add(object);
-		if (object->stall()) break;
+		object->setHeld(held);
+		if (object->stall()) held = true;
+	}
+	held = false;
+	for (object = foregroundObjects_.first(); object != NULL; object = object->next)
+	{
+		object->setHeld(held);
+		if (object->stall()) held = true;
+	}
+	held = false;
+	for (object = persistentForegroundObjects_.first(); object != NULL; object = object->next)
+	{
+		object->setHeld(held);
+		if (object->stall()) held = true;
+	}
+
+	// Progress all other objects in one go
+	AnimationStore::update(AnimationClock::frameTime());
+
+	// Background objects (finished objects are removed as we go, returning them to the pool)
+	for (object = backgroundObjects_.first(); object != NULL; object = nextObject)
+	{
+		nextObject = object->next;
+		if (object->isTransforming()) ++nAnimating;
+		if (object->toBeDeleted())
+		{
+			backgroundObjects_.remove(object);
+			++nDeleted;
+		}
 	}
-	for (refObject = toDelete.first(); refObject != NULL; refObject = refObject->next) backgroundObjects_.remove(refObject->item);
-	toDelete.clear();
 
 	// Foreground objects
-	for (object = foregroundObjects_.first(); object != NULL; object = object->next)
+	for (object = foregroundObjects_.first(); object != NULL; object = nextObject)
 	{
-		if (object->updateDynamic()) ++nChanged;
-		if (object->toBeDeleted()) toDelete.add(object);
-		if (object->stall()) break;
+		nextObject = object->next;
+		if (object->isTransforming()) ++nAnimating;
+		if (object->toBeDeleted())
+		{
+			foregroundObjects_.remove(object);
+			++nDeleted;
+		}
 	}
-	for (refObject = toDelete.first(); refObject != NULL; refObject = refObject->next) foregroundObjects_.remove(refObject->item);
-	toDelete.clear();
 
 	// Persistent foreground objects
-	for (object = persistentForegroundObjects_.first(); object != NULL; object = object->next)
+	for (object = persistentForegroundObjects_.first(); object != NULL; object = nextObject)
 	{
-		if (object->updateDynamic()) ++nChanged;
-		if (object->toBeDeleted()) toDelete.add(object);
-		if (object->stall()) break;
+		nextObject = object->next;
+		if (object->isTransforming()) ++nAnimating;
+		if (object->toBeDeleted())
+		{
+			persistentForegroundObjects_.remove(object);
+			++nDeleted;
+		}
 	}
-	for (refObject = toDelete.first(); refObject != NULL; refObject = refObject->next) persistentForegroundObjects_.remove(refObject->item);
-	toDelete.clear();
 
-	// Update background
-	updateBackground();
+	FrameProfiler::count(FrameProfiler::TransformingCounter, nAnimating);
+	FrameProfiler::count(FrameProfiler::DeletedCounter, nDeleted);
+	FrameProfiler::stopTimer(FrameProfiler::UpdateObjectsTimer);
 
-	// Update display if necessary
-	if (nChanged > 0) displayWindow_.ui.MainView->postRedisplay();
+	// Update background
+	FrameProfiler::startTimer(FrameProfiler::UpdateBackgroundTimer);
+	if (updateBackground()) ++nAnimating;
+	FrameProfiler::stopTimer(FrameProfiler::UpdateBackgroundTimer);
 
-	// Restart timer...
-	objectTimer_.start();
+	return (nAnimating > 0);
 }
 
 // Calculate text heights
@@ -80,7 +122,7 @@ void QuappWindow::calculateTextHeights()
 }
 
 // Apply transition to all objects in list
-void QuappWindow::applyExitTransform(List<DisplayObject>& objects, QuappWindow::ExitTransformType transformType, double speed, double stallCoordinate)
+void QuappWindow::applyExitTransform(List<DisplayObject>& objects, QuappWindow::ExitTransformType transformType, double duration, double stallCoordinate)
 {
 	QColor colour;
 	switch (transformType)
@@ -90,7 +132,7 @@ void QuappWindow::applyExitTransform(List<DisplayObject>& objects, QuappWindow::
 			{
 				colour = object->colour();
 				colour.setAlphaF(0.0);
-				object->addTransform()->setColourTransform(object->colour(), colour, speed);
+				object->addTransform().setColourTransform(object->colour(), colour, duration);
 				object->setTransformContinueAt(stallCoordinate);
 				object->setDeleteAfterTransform();
 			}
@@ -102,7 +144,7 @@ void QuappWindow::applyExitTransform(List<DisplayObject>& objects, QuappWindow::
 }
 
 // Apply entrance transform to specified object
-void QuappWindow::applyEntranceTransform(DisplayObject* object, QuappWindow::EntranceTransformType transformType, double speed, double stallCoordinate)
+void QuappWindow::applyEntranceTransform(DisplayObject* object, QuappWindow::EntranceTransformType transformType, double duration, double stallCoordinate)
 {
 	QColor colourA, colourB;
 	switch (transformType)
@@ -111,7 +153,7 @@ void QuappWindow::applyEntranceTransform(DisplayObject* object, QuappWindow::Ent
 			colourB = object->colour();
 			colourA = colourB;
 			colourA.setAlphaF(0.0);
-			object->addTransform()->setColourTransform(colourA, colourB, speed);
+			object->addTransform().setColourTransform(colourA, colourB, duration);
 			object->setTransformContinueAt(stallCoordinate);
 			break;
 		default:
@@ -120,6 +162,22 @@ void QuappWindow::applyEntranceTransform(DisplayObject* object, QuappWindow::Ent
 	}
 }
 
+// Transition out all persistent and foreground objects, ready for the next segment
+void QuappWindow::transitionForegroundOut()
+{
+	// Capture the outgoing scene and animate that alone, so that its objects can be freed now rather than drawn until they have faded
+	if (displayWindow_.ui.MainView->beginTransition(SnapshotTransition::defaultType(), segmentTransitionDuration_))
+	{
+		foregroundObjects_.clear();
+		persistentForegroundObjects_.clear();
+		return;
+	}
+
+	// Snapshots are not possible, so fade out each object in turn
+	applyExitTransform(foregroundObjects_, QuappWindow::FadeOutTransform, 0.05, 0.999);
+	applyExitTransform(persistentForegroundObjects_, QuappWindow::FadeOutTransform, 0.5, 0.999);
+}
+
 // Background objects
 List<DisplayObject>& QuappWindow::backgroundObjects()
 {
@@ -192,13 +250,13 @@ double QuappWindow::displayAspectRatio()
 // Return width of display
 double QuappWindow::displayWidth()
 {
-	return double(displayWindow_.ui.MainView->width());
+	return double(displayWindow_.ui.MainView->contextWidth());
 }
 
 // Return height of display
 double QuappWindow::displayHeight()
 {
-	return double(displayWindow_.ui.MainView->height());
+	return double(displayWindow_.ui.MainView->contextHeight());
 }
 
 
@@ -0,0 +1,187 @@
+/*
+	*** Main Window - Run Rendering
+	*** src/gui/quapp_render.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "gui/quapp.h"
+#include "base/mediaregistry.h"
+#include "base/messenger.h"
+#include "base/tracer.h"
+#include "render/animationclock.h"
+#include "render/framewritejob.h"
+#include <QtCore/QDir>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+// Static Members
+const double QuappWindow::renderHoldTime_ = 2.0;
+const double QuappWindow::renderMaxStepTime_ = 60.0;
+
+// Return whether any foreground object (or the snapshot of an outgoing scene) is still animating
+bool QuappWindow::foregroundAnimating()
+{
+	for (DisplayObject* object = foregroundObjects_.first(); object != NULL; object = object->next) if (object->isTransforming()) return true;
+	for (DisplayObject* object = persistentForegroundObjects_.first(); object != NULL; object = object->next) if (object->isTransforming()) return true;
+	return displayWindow_.ui.MainView->transitionActive();
+}
+
+// Begin rendered run from the first visual segment, at time zero
+bool QuappWindow::startRenderedRun()
+{
+	Segment* segment = quiz_.segments();
+	while (segment && segment->nonVisual()) segment = segment->next;
+	if (!segment)
+	{
+		msg.print("Error: Quiz has no segments to render.\n");
+		return false;
+	}
+
+	renderingRun_ = true;
+	AnimationClock::setFrameTime(0.0);
+	initialiseBackground(backgroundType_);
+	foregroundObjects_.clear();
+	persistentForegroundObjects_.clear();
+	quiz_.setCurrentSegment(segment);
+	compileRunningOrder(segment);
+	segment->begin(*this);
+
+	return true;
+}
+
+// Move rendered run on to the next item in the segment, or the next segment if there is no next item
+void QuappWindow::advanceRenderedRun()
+{
+	Segment* segment = quiz_.currentSegment();
+	if (!segment) return;
+
+	if (segment->hasNextPart())
+	{
+		segment->showNextPart(*this);
+		return;
+	}
+
+	// Set all existing foreground and title objects to transition out, and begin the next segment (if there is one)
+	segment = segment->next;
+	while (segment && segment->nonVisual()) segment = segment->next;
+	quiz_.setCurrentSegment(segment);
+
+	transitionForegroundOut();
+
+	if (segment) segment->begin(*this);
+}
+
+// Finish rendered run
+void QuappWindow::finishRenderedRun()
+{
+	renderingRun_ = false;
+	quiz_.setCurrentSegment(NULL);
+}
+
+// Render complete run offscreen, writing numbered PNG frames to the specified directory
+bool QuappWindow::renderRun(QString outputDirectory, int fps, int width, int height)
+{
+	TRACESPAN("QuappWindow::renderRun");
+
+	// Check arguments
+	if ((fps < 1) || (width < 1) || (height < 1))
+	{
+		msg.print("Error: Invalid frame rate (%i) or size (%ix%i) for rendered run.\n", fps, width, height);
+		return false;
+	}
+	QDir dir(outputDirectory);
+	if (!dir.mkpath("."))
+	{
+		msg.print("Error: Couldn't create output directory '%s'.\n", qPrintable(outputDirectory));
+		return false;
+	}
+
+	Viewer* viewer = displayWindow_.ui.MainView;
+	if (!viewer->beginOffScreen(width, height)) return false;
+
+	// Start from an empty scene at time zero - the clock is only ever set from here on, so the run is independent of real time
+	double time = 0.0, frameInterval = 1.0 / fps;
+	if (!startRenderedRun())
+	{
+		QImage image;
+		viewer->endOffScreen(image);
+		return false;
+	}
+
+	// Limit the number of frames waiting to be encoded, so that memory use stays bounded if encoding is the bottleneck
+	int nQueueSlots = 2*QThread::idealThreadCount();
+	QSemaphore queueSlots(nQueueSlots);
+	QThreadPool* threadPool = QThreadPool::globalInstance();
+
+	QImage image;
+	int nFrames = 0, nSteps = 0;
+	double stepStart, settledTime;
+	bool finished = false;
+	while (!finished)
+	{
+		// Decode all media needed by this step before drawing it
+		quiz_.prefetchMedia();
+		MediaRegistry::waitForPending();
+		++nSteps;
+
+		// Render frames until the foreground has settled and been held for a short while
+		finished = (quiz_.currentSegment() == NULL);
+		stepStart = time;
+		settledTime = -1.0;
+		while ((time - stepStart) < renderMaxStepTime_)
+		{
+			AnimationClock::setFrameTime(time);
+			updateObjects();
+			if (foregroundAnimating()) settledTime = -1.0;
+			else if (settledTime < 0.0) settledTime = time;
+			if ((settledTime >= 0.0) && ((time - settledTime) >= (finished ? 0.0 : renderHoldTime_))) break;
+
+			// Frames come back from the viewer one behind the frame just drawn, so that readback overlaps drawing
+			if (viewer->renderOffScreen(image))
+			{
+				queueSlots.acquire();
+				threadPool->start(new FrameWriteJob(image, dir.filePath(QString("frame%1.png").arg(nFrames, 6, 10, QChar('0'))), &queueSlots));
+				++nFrames;
+			}
+
+			time += frameInterval;
+		}
+
+		// Move on to next item in segment, or next segment if there is no next item
+		// -- When the last segment is done, everything fades out and one last step is rendered
+		if (finished) break;
+		advanceRenderedRun();
+	}
+
+	// Collect the final frame, and wait for all frames to be written
+	if (viewer->endOffScreen(image))
+	{
+		queueSlots.acquire();
+		threadPool->start(new FrameWriteJob(image, dir.filePath(QString("frame%1.png").arg(nFrames, 6, 10, QChar('0'))), &queueSlots));
+		++nFrames;
+	}
+	queueSlots.acquire(nQueueSlots);
+	queueSlots.release(nQueueSlots);
+
+	finishRenderedRun();
+
+	msg.print("Rendered %i step(s) as %i frame(s) (%.1f seconds at %i fps) to '%s'.\n", nSteps, nFrames, nFrames*frameInterval, fps, qPrintable(outputDirectory));
+
+	return true;
+}
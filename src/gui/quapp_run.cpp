@@ -21,6 +21,7 @@
 
 #include "gui/quapp.h"
 #include "base/session.h"
+#include "render/scenecompiler.h"
 #include "templates/variantpointer.h"
 #include <QtGui/QFileDialog>
 #include <QtGui/QMessageBox>
@@ -105,6 +106,18 @@ void QuappWindow::on_TeamRemoveButton_clicked(bool checked)
  * Control
  */
 
+// Compile the running order from the specified segment onwards
+void QuappWindow::compileRunningOrder(Segment* firstSegment)
+{
+	SceneCompiler::clear();
+	for (Segment* segment = firstSegment; segment != NULL; segment = segment->next)
+	{
+		if (segment->nonVisual()) continue;
+		segment->compile(*this);
+	}
+	SceneCompiler::start();
+}
+
 void QuappWindow::on_RunFromStartButton_clicked(bool checked)
 {
 	// Clear all foreground primitives
@@ -114,12 +127,18 @@ void QuappWindow::on_RunFromStartButton_clicked(bool checked)
 	// Get first segment
 	quiz_.setCurrentSegment(quiz_.segments());
 
+	// Lay out text for the whole running order in the background
+	compileRunningOrder(quiz_.segments());
+
 	// Run from this segment
 	if (quiz_.currentSegment())
 	{
 		quiz_.currentSegment()->begin(*this);
 	}
 
+	// Prefetch media for upcoming items
+	quiz_.prefetchMedia();
+
 	// Update display
 	updateRunControls();
 	displayWindow_.ui.MainView->postRedisplay();
@@ -136,9 +155,15 @@ void QuappWindow::on_RunFromSegmentButton_clicked(bool checked)
 	quiz_.setCurrentSegment(segment);
 	if (!segment) return;
 
+	// Lay out text for the remaining running order in the background
+	compileRunningOrder(segment);
+
 	// Run from this segment
 	quiz_.currentSegment()->begin(*this);
 
+	// Prefetch media for upcoming items
+	quiz_.prefetchMedia();
+
 	// Update GUI and display
 	updateRunControls();
 	displayWindow_.ui.MainView->postRedisplay();
@@ -160,12 +185,14 @@ void QuappWindow::on_NextSegmentButton_clicked(bool checked)
 	quiz_.setCurrentSegment(nextSegment);
 
 	// Set all existing foreground and title objects to transition out
-	applyExitTransform(foregroundObjects_, QuappWindow::FadeOutTransform, 0.5, 0.999);
-	applyExitTransform(persistentForegroundObjects_, QuappWindow::FadeOutTransform, 0.05, 0.999);
+	transitionForegroundOut();
 
 	// Begin next segment
 	quiz_.currentSegment()->begin(*this);
 
+	// Prefetch media for upcoming items
+	quiz_.prefetchMedia();
+
 	// Update GUI and display
 	updateRunControls();
 	displayWindow_.ui.MainView->postRedisplay();
@@ -184,6 +211,9 @@ void QuappWindow::on_NextItemButton_clicked(bool checked)
 
 	currentSegment->showNextPart(*this);
 
+	// Prefetch media for upcoming items
+	quiz_.prefetchMedia();
+
 	// Update GUI and display
 	updateRunControls();
 	displayWindow_.ui.MainView->postRedisplay();
@@ -192,6 +222,8 @@ void QuappWindow::on_NextItemButton_clicked(bool checked)
 void QuappWindow::on_EndButton_clicked(bool checked)
 {
 	quiz_.setCurrentSegment(NULL);
+	quiz_.prefetchMedia();
+	SceneCompiler::clear();
 
 	updateRunControls();
 }
@@ -206,6 +238,8 @@ void QuappWindow::on_NextAnythingButton_clicked(bool checked)
 	else if (currentSegment->next) on_NextSegmentButton_clicked(false);
 	else quiz_.setCurrentSegment(NULL);
 
+	quiz_.prefetchMedia();
+
 	updateRunControls();
 }
 
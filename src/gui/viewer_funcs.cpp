@@ -26,8 +26,13 @@
 #endif
 #include "gui/viewer.uih"
 #include "gui/quapp.h"
+#include "base/mediaregistry.h"
 #include "base/messenger.h"
+#include "base/tracer.h"
 #include "render/fontinstance.h"
+#include "render/animationclock.h"
+#include "render/frameprofiler.h"
+#include "render/shaderrenderer.h"
 #ifndef __APPLE__
 #include "render/glextensions.h"
 #endif
@@ -49,6 +54,11 @@ Viewer::Viewer(QWidget *parent) : QGLWidget(parent)
 	valid_ = false;
 	drawing_ = false;
 	renderingOffScreen_ = false;
+	frameBuffer_ = NULL;
+	packBuffers_[0] = 0;
+	packBuffers_[1] = 0;
+	packIndex_ = 0;
+	framePacked_ = false;
 
 	// Prevent QPainter from autofilling widget background
 	setAutoFillBackground(false);
@@ -57,6 +67,16 @@ Viewer::Viewer(QWidget *parent) : QGLWidget(parent)
 // Destructor
 Viewer::~Viewer()
 {
+	// Free arena buffers while our context still exists
+	if (valid_)
+	{
+		makeCurrent();
+		vertexArena_.clear();
+		drawQueue_.clearBuffers();
+		layerCache_.clear();
+		transition_.clear();
+		ShaderRenderer::clear();
+	}
 }
 
 // Set QuappWindow pointer
@@ -73,7 +93,7 @@ void Viewer::setQuapp(QuappWindow* ptr)
 void Viewer::initializeGL()
 {
 	// Initialize GL
-	msg.enter("Viewer::initializeGL");
+	TRACESPAN("Viewer::initializeGL");
 	valid_ = true;
 
 	// Create a GLExtensions object to probe features and give when pushing instances etc.
@@ -86,31 +106,75 @@ void Viewer::initializeGL()
 		PrimitiveInstance::setGlobalInstanceType(PrimitiveInstance::ListInstance);
 	}
 
-	msg.exit("Viewer::initializeGL");
+	// Vertex arena uses the same extensions
+	vertexArena_.setExtensions(extensions);
+
+	// Draw primitives through the shader program if possible - it relies on vertex array objects, recording layouts within the arena's buffers
+	if (ShaderRenderer::enabled())
+	{
+		if ((PrimitiveInstance::globalInstanceType() != PrimitiveInstance::VBOInstance) || (!extensions->hasVertexArrays())) printf("Vertex array objects are not available, so reverting to fixed-function rendering.\n");
+		else if (ShaderRenderer::initialise()) msg.print(Messenger::Verbose, "Primitives will be drawn through shader program.\n");
+	}
+
+	// Light and material properties are held by the context, so need only be set once
+	setupLighting();
 }
 
 void Viewer::paintGL()
 {
-	msg.enter("Viewer::paintGL");
+	TRACESPAN("Viewer::paintGL");
 
 	// Do nothing if the canvas is not valid, or we are still drawing from last time, or the Quapp pointer has not been set
-	if ((!valid_) || drawing_ || (!quapp_))
-	{
-		msg.exit("Viewer::paintGL");
-		return;
-	}
+	if ((!valid_) || drawing_ || (!quapp_)) return;
 
 	// Set the drawing flag so we don't have any rendering clashes
 	drawing_ = true;
 
-	// Grab topmost GLExtensions pointer
-	GLExtensions* extensions = extensionsStack_.last();
+	// Bring all objects up to date at a single animation time for this frame
+	bool animating = false;
+	if (!renderingOffScreen_)
+	{
+		AnimationClock::advance();
+		animating = quapp_->updateObjects() || transition_.isActive();
+	}
+
+	FrameProfiler::startTimer(FrameProfiler::PaintTimer);
 
 	// Setup basic GL stuff
 	setupGL();
 
-	// Set viewport to be entire window
-	glViewport(0, 0, width(), height());
+	// Upload textures for any media prefetched since the last redraw
+	if (!renderingOffScreen_) MediaRegistry::uploadPrefetched();
+
+	// Create instances for new objects, uploading all their data in one go before we start drawing
+	updateInstances();
+
+	// Draw scene over the entire window
+	renderScene(width(), height());
+
+	FrameProfiler::stopTimer(FrameProfiler::PaintTimer);
+	FrameProfiler::endFrame();
+
+	// Draw profiler summary on top, if requested (not included in the frame's timings)
+	if (FrameProfiler::overlay()) drawProfilerOverlay();
+
+	// Set the rendering flag to false
+	drawing_ = false;
+
+	// Keep redrawing while anything is animating - buffer swaps are synced to the display, so this runs at its refresh rate
+	if (animating) update();
+
+	// If we were rendering offscreen, delete the topmost GLExtensions object here (primitives will have already been popped)
+	if (renderingOffScreen_) extensionsStack_.removeLast();
+}
+
+// Draw scene to the current target (window or framebuffer object)
+void Viewer::renderScene(int targetWidth, int targetHeight)
+{
+	TRACESPAN("Viewer::renderScene");
+
+	// Set viewport to be entire target
+	glViewport(0, 0, targetWidth, targetHeight);
 
 	// Set colour mode
 	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
@@ -131,6 +195,31 @@ void Viewer::paintGL()
 	glEnable(GL_LIGHTING);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
+	/*
+	 * Gather Draw Items
+	 */
+
+	// Objects in all layers are queued and sorted together, so that those sharing state may be drawn in as few batches as possible
+	// Those which would not be seen are culled against the projections the layers will be drawn with
+	GLfloat projection[16];
+	ShaderRenderer::orthographicMatrix(projection, 0.0, aspectRatio_, 0.0, 1.0, -1.0, 2000.0);
+	drawQueue_.setProjection(DrawQueue::BackgroundLayer, projection);
+	ShaderRenderer::frustumMatrix(projection, -0.5*aspectRatio_, 0.5*aspectRatio_, -0.5, 0.5, 1.0, 100.0);
+	drawQueue_.setProjection(DrawQueue::PersistentLayer, projection);
+	drawQueue_.setProjection(DrawQueue::ForegroundLayer, projection);
+	drawQueue_.clear();
+	for (DisplayObject* object = quapp_->backgroundObjects().first(); object != NULL; object = object->next) object->queue(drawQueue_, DrawQueue::BackgroundLayer, aspectRatio_);
+	for (DisplayObject* object = quapp_->persistentForegroundObjects().first(); object != NULL; object = object->next) object->queue(drawQueue_, DrawQueue::PersistentLayer, aspectRatio_);
+	for (DisplayObject* object = quapp_->foregroundObjects().first(); object != NULL; object = object->next) object->queue(drawQueue_, DrawQueue::ForegroundLayer, aspectRatio_);
+
+	// The persistent and foreground layers share a depth buffer, so are cached together - while nothing in them changes they are drawn from the cache
+	const int cachedLayers = DrawQueue::PersistentLayerFlag | DrawQueue::ForegroundLayerFlag;
+	bool cacheLayers = layerCache_.available(extensionsStack_.last()) && drawQueue_.cacheable(cachedLayers);
+	quint64 signature = drawQueue_.signature(cachedLayers);
+	bool signatureStable = layerCache_.stable(signature);
+	bool layersCached = cacheLayers && layerCache_.matches(signature, targetWidth, targetHeight);
+	drawQueue_.prepare(extensionsStack_.last(), layersCached ? cachedLayers : 0);
+
 	/*
 	 * Draw Background Objects
 	 */
@@ -139,24 +228,64 @@ void Viewer::paintGL()
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	glOrtho(0.0, aspectRatio_, 0.0, 1.0, -1.0, 2000.0);
+	ShaderRenderer::setOrthographic(0.0, aspectRatio_, 0.0, 1.0, -1.0, 2000.0);
 
 	// -- Switch to modelview matrix and draw background objects
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
-	for (DisplayObject* object = quapp_->backgroundObjects().first(); object != NULL; object = object->next)
+	FrameProfiler::startTimer(FrameProfiler::PaintBackgroundTimer);
+	ShaderRenderer::bind();
+	drawQueue_.submit(DrawQueue::BackgroundLayer);
+	ShaderRenderer::release();
+	// -- Animated disc field
+	quapp_->backgroundDiscs().sendToGL(context(), extensionsStack_.last(), aspectRatio_);
+	FrameProfiler::stopTimer(FrameProfiler::PaintBackgroundTimer);
+
+	// -- Outgoing scene, if it is still transitioning out
+	if (transition_.isActive())
 	{
-		if (object->primitive().nInstances() == 0) object->primitive().pushInstance(context(), extensions, this);
-		object->sendToGL(aspectRatio_);
+		FrameProfiler::startTimer(FrameProfiler::PaintForegroundTimer);
+		transition_.draw(aspectRatio_);
+		FrameProfiler::stopTimer(FrameProfiler::PaintForegroundTimer);
 	}
 
 	/*
 	 * Draw Foreground
 	 */
 
+	// -- Unchanged since last frame, so composite the cached layers
+	if (layersCached)
+	{
+		FrameProfiler::startTimer(FrameProfiler::PaintForegroundTimer);
+		layerCache_.composite();
+		FrameProfiler::stopTimer(FrameProfiler::PaintForegroundTimer);
+		FrameProfiler::count(FrameProfiler::CachedLayerCounter, 2);
+		return;
+	}
+
+	// -- Redraw layers into the cache if they may be cached (and were unchanged since last frame, so are likely to stay so), compositing them afterwards
+	bool redrawCache = cacheLayers && signatureStable && layerCache_.begin(extensionsStack_.last(), targetWidth, targetHeight);
+	drawForegroundLayers();
+	if (redrawCache)
+	{
+		layerCache_.end(signature);
+		// Releasing the cache's framebuffer returns to the window's, so rebind ours if we are rendering offscreen
+		if (renderingOffScreen_) frameBuffer_->bind();
+		FrameProfiler::startTimer(FrameProfiler::PaintForegroundTimer);
+		layerCache_.composite();
+		FrameProfiler::stopTimer(FrameProfiler::PaintForegroundTimer);
+		FrameProfiler::count(FrameProfiler::CacheRedrawCounter);
+	}
+}
+
+// Draw prepared persistent and foreground layers to the current target
+void Viewer::drawForegroundLayers()
+{
 	// -- Set projection matrix
 	glMatrixMode(GL_PROJECTION);
         glLoadIdentity();
 	glFrustum(-0.5*aspectRatio_, 0.5*aspectRatio_, -0.5, 0.5, 1.0, 100.0);
+	ShaderRenderer::setFrustum(-0.5*aspectRatio_, 0.5*aspectRatio_, -0.5, 0.5, 1.0, 100.0);
 
 	// -- Switch to modelview matrix and draw background objects
         glMatrixMode(GL_MODELVIEW);
@@ -164,26 +293,51 @@ void Viewer::paintGL()
 	glClear(GL_DEPTH_BUFFER_BIT);
 
 	// -- Persistent foreground objects
-	for (DisplayObject* object = quapp_->persistentForegroundObjects().first(); object != NULL; object = object->next)
-	{
-		if (object->primitive().nInstances() == 0) object->primitive().pushInstance(context(), extensions, this);
-		object->sendToGL(aspectRatio_);
-	}
+	ShaderRenderer::bind();
+	FrameProfiler::startTimer(FrameProfiler::PaintPersistentTimer);
+	drawQueue_.submit(DrawQueue::PersistentLayer);
+	FrameProfiler::stopTimer(FrameProfiler::PaintPersistentTimer);
 
 	// -- Other foreground objects
-	for (DisplayObject* object = quapp_->foregroundObjects().first(); object != NULL; object = object->next)
-	{
-		if (object->primitive().nInstances() == 0) object->primitive().pushInstance(context(), extensions, this);
-		object->sendToGL(aspectRatio_);
-	}
+	FrameProfiler::startTimer(FrameProfiler::PaintForegroundTimer);
+	drawQueue_.submit(DrawQueue::ForegroundLayer);
+	FrameProfiler::stopTimer(FrameProfiler::PaintForegroundTimer);
+	ShaderRenderer::release();
+}
 
-	// Set the rendering flag to false
-	drawing_ = false;
+// Draw frame profiler summary over the top of the scene
+void Viewer::drawProfilerOverlay()
+{
+	QStringList lines = FrameProfiler::summary();
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_TEXTURE_2D);
+	glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
+	QFont font;
+	font.setPixelSize(14);
+	for (int n=0; n<lines.count(); ++n) renderText(10, 20 + n*18, lines.at(n), font);
+	glEnable(GL_DEPTH_TEST);
+}
 
-	// If we were rendering offscreen, delete the topmost GLExtensions object here (primitives will have already been popped)
-	if (renderingOffScreen_) extensionsStack_.removeLast();
-	
-	msg.exit("Viewer::paintGL");
+// Create instances for any new or changed objects, and upload their data
+void Viewer::updateInstances()
+{
+	TRACESPAN("Viewer::updateInstances");
+
+	GLExtensions* extensions = extensionsStack_.last();
+
+	// Vertex array objects of primitives deleted since the last frame can be deleted now that the context is current
+	ShaderRenderer::deleteReleasedVertexArrays(extensions);
+
+	// Glyphs added to the atlas since the last frame are uploaded before any text using them is pushed
+	FontInstance::uploadAtlas();
+
+	for (DisplayObject* object = quapp_->backgroundObjects().first(); object != NULL; object = object->next) object->updateInstances(context(), extensions, &vertexArena_);
+	for (DisplayObject* object = quapp_->persistentForegroundObjects().first(); object != NULL; object = object->next) object->updateInstances(context(), extensions, &vertexArena_);
+	for (DisplayObject* object = quapp_->foregroundObjects().first(); object != NULL; object = object->next) object->updateInstances(context(), extensions, &vertexArena_);
+
+	vertexArena_.flushUploads();
 }
 
 // Resize function
@@ -196,20 +350,18 @@ void Viewer::resizeGL(int newwidth, int newheight)
 
 	// Adjust aspect ratio by modified
 	if (quapp_) aspectRatio_ *= quapp_->aspectModifier();
+
+	// Images are never drawn taller than the display, so there is no point in decoding them any larger
+	if (!renderingOffScreen_) MediaRegistry::setTargetSize(contextHeight_);
 }
 
 // Setup basic GL properties (called each time before renderScene())
 void Viewer::setupGL()
 {
-	msg.enter("Viewer::setupGL");
+	TRACESPAN("Viewer::setupGL");
 
 	// Define colours etc.
 	GLfloat backgroundColour[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	GLfloat spotlightAmbient[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-	GLfloat spotlightDiffuse[4] = { 0.8f, 0.8f, 0.8f, 1.0f };
-	GLfloat spotlightSpecular[4] = { 0.7f, 0.7f, 0.7f, 1.0f };
-	GLfloat spotlightPosition[4] = { 0.0f, 0.0f, -10.0f, 0.0f };
-	GLfloat specularColour[4] = { 0.9f, 0.9f, 0.9f, 1.0f };
 
 	// Clear (background) colour
 	glClearColor(backgroundColour[0], backgroundColour[1], backgroundColour[2], backgroundColour[3]);
@@ -226,19 +378,8 @@ void Viewer::setupGL()
 	// Auto-normalise surface normals
 	glEnable(GL_NORMALIZE);	
 
-	// Set up the light model
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	// Enable lighting (the light model itself is set once, in setupLighting())
 	glEnable(GL_LIGHTING);
-	glLightfv(GL_LIGHT0, GL_AMBIENT, spotlightAmbient);
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, spotlightDiffuse);
-	glLightfv(GL_LIGHT0, GL_SPECULAR, spotlightSpecular);
-	glLightfv(GL_LIGHT0, GL_POSITION, spotlightPosition);
-	glEnable(GL_LIGHT0);
-
-	// Set specular reflection colour
-	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specularColour);
-	glMateriali(GL_FRONT_AND_BACK, GL_SHININESS, 127);
 
 	// Configure antialiasing
 	glDisable(GL_MULTISAMPLE);
@@ -262,8 +403,30 @@ void Viewer::setupGL()
 // 	glEnable(GL_CULL_FACE);
 
 	glEnable(GL_TEXTURE_2D);
+}
+
+// Setup light and material properties (once for the context)
+void Viewer::setupLighting()
+{
+	// Define colours etc.
+	GLfloat spotlightAmbient[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLfloat spotlightDiffuse[4] = { 0.8f, 0.8f, 0.8f, 1.0f };
+	GLfloat spotlightSpecular[4] = { 0.7f, 0.7f, 0.7f, 1.0f };
+	GLfloat spotlightPosition[4] = { 0.0f, 0.0f, -10.0f, 0.0f };
+	GLfloat specularColour[4] = { 0.9f, 0.9f, 0.9f, 1.0f };
 
-	msg.exit("Viewer::setupGL");
+	// Set up the light model
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glLightfv(GL_LIGHT0, GL_AMBIENT, spotlightAmbient);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, spotlightDiffuse);
+	glLightfv(GL_LIGHT0, GL_SPECULAR, spotlightSpecular);
+	glLightfv(GL_LIGHT0, GL_POSITION, spotlightPosition);
+	glEnable(GL_LIGHT0);
+
+	// Set specular reflection colour
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specularColour);
+	glMateriali(GL_FRONT_AND_BACK, GL_SHININESS, 127);
 }
 
 /*
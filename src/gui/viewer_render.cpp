@@ -0,0 +1,226 @@
+/*
+	*** Viewer - Offscreen Rendering
+	*** src/gui/viewer_render.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// On OSX must include glextensions.h before any other file since (or OSX doesn't see PROC typedefs) since gl.h and gl3.h clash
+// However, on normal unix systems it must be included *after* viewer.uih, otherwise Qt throws lots of errors.
+#ifdef __APPLE__
+#include "render/glextensions.h"
+#endif
+#include "gui/viewer.uih"
+#include "gui/quapp.h"
+#include "base/mediaregistry.h"
+#include "base/messenger.h"
+#include "render/frameprofiler.h"
+#include "render/shaderrenderer.h"
+#include <QtOpenGL/QGLFramebufferObject>
+#include <QtGui/QImage>
+#include <string.h>
+#ifndef __APPLE__
+#include "render/glextensions.h"
+#endif
+
+// Copy frame from specified pixel buffer into supplied image
+void Viewer::unpackFrame(int index, QImage& image)
+{
+	GLExtensions* extensions = extensionsStack_.last();
+	image = QImage(contextWidth_, contextHeight_, QImage::Format_ARGB32);
+
+	extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers_[index]);
+	const uchar* pixels = (const uchar*) extensions->glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (pixels)
+	{
+		// GL rows run from the bottom of the image upwards
+		int rowBytes = contextWidth_*4;
+		for (int y=0; y<contextHeight_; ++y) memcpy(image.scanLine(contextHeight_-y-1), pixels+y*rowBytes, rowBytes);
+		extensions->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else msg.print("Failed to map pixel buffer - frame will be blank.\n");
+	extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Begin rendering offscreen at the specified size
+bool Viewer::beginOffScreen(int width, int height)
+{
+	// Make sure our context has been initialised, even if the widget has never been shown
+	makeCurrent();
+	if (!valid_) glInit();
+	if (!QGLFramebufferObject::hasOpenGLFramebufferObjects())
+	{
+		msg.print("Error: Framebuffer objects are not supported by this context, so cannot render offscreen.\n");
+		return false;
+	}
+
+	frameBuffer_ = new QGLFramebufferObject(width, height, QGLFramebufferObject::Depth);
+	if (!frameBuffer_->isValid())
+	{
+		msg.print("Error: Failed to create %ix%i framebuffer object.\n", width, height);
+		delete frameBuffer_;
+		frameBuffer_ = NULL;
+		return false;
+	}
+
+	// Take on the size of the framebuffer, so that objects are laid out for it rather than for the widget
+	// Our drawing flag is kept set for the duration, so that any update() of the widget does not disturb the framebuffer
+	renderingOffScreen_ = true;
+	drawing_ = true;
+	resizeGL(width, height);
+	MediaRegistry::setTargetSize(height);
+
+	// Create pixel buffers for readback
+	GLExtensions* extensions = extensionsStack_.last();
+	if (extensions->hasPixelBuffers())
+	{
+		extensions->glGenBuffers(2, packBuffers_);
+		for (int n=0; n<2; ++n)
+		{
+			extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers_[n]);
+			extensions->glBufferData(GL_PIXEL_PACK_BUFFER, width*height*4, NULL, GL_STREAM_READ);
+		}
+		extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	else msg.print("Pixel buffer objects are not available, so frames will be read back synchronously.\n");
+	packIndex_ = 0;
+	framePacked_ = false;
+
+	return true;
+}
+
+// Render frame offscreen, returning in the supplied image the frame before it (or this frame if readback is synchronous)
+bool Viewer::renderOffScreen(QImage& image, bool readBack)
+{
+	if (!frameBuffer_) return false;
+
+	frameBuffer_->bind();
+
+	FrameProfiler::startTimer(FrameProfiler::PaintTimer);
+	setupGL();
+	MediaRegistry::uploadPrefetched();
+	updateInstances();
+	renderScene(contextWidth_, contextHeight_);
+	FrameProfiler::stopTimer(FrameProfiler::PaintTimer);
+	FrameProfiler::endFrame();
+
+	// If the frame is not wanted, just wait for it to be finished (so that callers timing frames see the full cost)
+	if (!readBack)
+	{
+		glFinish();
+		frameBuffer_->release();
+		return false;
+	}
+
+	// Read back pixels - GL_BGRA matches the byte order of QImage::Format_ARGB32 on little-endian machines
+	bool result = false;
+	if (packBuffers_[0] != 0)
+	{
+		// Start an asynchronous read of this frame into the current buffer, then collect the previous frame from the other
+		GLExtensions* extensions = extensionsStack_.last();
+		extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffers_[packIndex_]);
+		glReadPixels(0, 0, contextWidth_, contextHeight_, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+		extensions->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		packIndex_ = 1 - packIndex_;
+		if (framePacked_)
+		{
+			unpackFrame(packIndex_, image);
+			result = true;
+		}
+		framePacked_ = true;
+	}
+	else
+	{
+		image = QImage(contextWidth_, contextHeight_, QImage::Format_ARGB32);
+		glReadPixels(0, 0, contextWidth_, contextHeight_, GL_BGRA, GL_UNSIGNED_BYTE, image.bits());
+		image = image.mirrored();
+		result = true;
+	}
+
+	frameBuffer_->release();
+
+	return result;
+}
+
+// Finish rendering offscreen, returning any outstanding frame in the supplied image
+bool Viewer::endOffScreen(QImage& image)
+{
+	if (!frameBuffer_) return false;
+
+	// The last frame rendered is in the buffer before the current one
+	bool result = false;
+	if (framePacked_)
+	{
+		unpackFrame(1 - packIndex_, image);
+		result = true;
+	}
+	framePacked_ = false;
+
+	if (packBuffers_[0] != 0) extensionsStack_.last()->glDeleteBuffers(2, packBuffers_);
+	packBuffers_[0] = 0;
+	packBuffers_[1] = 0;
+
+	delete frameBuffer_;
+	frameBuffer_ = NULL;
+
+	// Return to the size of the widget
+	renderingOffScreen_ = false;
+	drawing_ = false;
+	resizeGL(width(), height());
+
+	return result;
+}
+
+// Capture persistent and foreground layers as they stand, and begin transition of the snapshot
+bool Viewer::beginTransition(SnapshotTransition::TransitionType type, double duration)
+{
+	if ((!valid_) || (!quapp_)) return false;
+
+	makeCurrent();
+	GLExtensions* extensions = extensionsStack_.last();
+	if (!SnapshotTransition::supported(extensions)) return false;
+
+	// Objects added since the last frame may not have instances yet
+	setupGL();
+	updateInstances();
+
+	// Queue only the layers being captured
+	drawQueue_.clear();
+	for (DisplayObject* object = quapp_->persistentForegroundObjects().first(); object != NULL; object = object->next) object->queue(drawQueue_, DrawQueue::PersistentLayer, aspectRatio_);
+	for (DisplayObject* object = quapp_->foregroundObjects().first(); object != NULL; object = object->next) object->queue(drawQueue_, DrawQueue::ForegroundLayer, aspectRatio_);
+	drawQueue_.prepare(extensions);
+
+	// Set remaining state as renderScene() would
+	glViewport(0, 0, contextWidth_, contextHeight_);
+	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+	glEnable(GL_COLOR_MATERIAL);
+	glEnable(GL_MULTISAMPLE);
+	if (!transition_.beginCapture(extensions, contextWidth_, contextHeight_)) return false;
+	drawForegroundLayers();
+	transition_.endCapture();
+
+	transition_.start(type, duration);
+
+	return true;
+}
+
+// Return whether a transition is in progress
+bool Viewer::transitionActive()
+{
+	return transition_.isActive();
+}
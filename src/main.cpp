@@ -21,7 +21,17 @@
 
 #include "version.h"
 #include "gui/quapp.h"
+#include "base/mediaregistry.h"
 #include "base/messenger.h"
+#include "base/parserbenchmark.h"
+#include "base/tracer.h"
+#include "render/animationbenchmark.h"
+#include "render/frameprofiler.h"
+#include "render/layercache.h"
+#include "render/scenecompiler.h"
+#include "render/shaderrenderer.h"
+#include "render/snapshottransition.h"
+#include "templates/objectpool.h"
 
 int main(int argc, char *argv[])
 {	
@@ -35,14 +45,19 @@ int main(int argc, char *argv[])
 	QGL::setPreferredPaintEngine(QPaintEngine::OpenGL);
 	#endif
 
-	/* Tweak the default QGLFormat */
-	QGLFormat::defaultFormat().setSampleBuffers(true);
+	/* Tweak the default QGLFormat - buffer swaps are synced to the display, since animations are evaluated once per frame */
+	QGLFormat format = QGLFormat::defaultFormat();
+	format.setSampleBuffers(true);
+	format.setSwapInterval(1);
+	QGLFormat::setDefaultFormat(format);
 
 	/* Create the main window */
 	QuappWindow mainWindow;
 
 	/* Do we have CLI options? */
 	bool fileLoaded = false;
+	QString renderDirectory, benchmarkSpec, traceFile, convertFile;
+	int renderFps = 30, renderWidth = 1920, renderHeight = 1080;
 	if (argc > 1)
 	{
 		int n = 1;
@@ -62,11 +77,119 @@ int main(int argc, char *argv[])
 			// Command-line switch
 			switch (argv[n][1])
 			{
+				case ('a'):
+					if (n < argc-1)
+					{
+						AnimationBenchmark::run(atoi(argv[++n]));
+						return 0;
+					}
+					else missingArg = true;
+					break;
+				case ('b'):
+					if (n < argc-1) benchmarkSpec = argv[++n];
+					else missingArg = true;
+					break;
+				case ('c'):
+					if (n < argc-1) convertFile = argv[++n];
+					else missingArg = true;
+					break;
+				case ('d'):
+					if (n < argc-1) mainWindow.setNBackgroundDiscs(atoi(argv[++n]));
+					else missingArg = true;
+					break;
+				case ('e'):
+					if (n < argc-1)
+					{
+						SnapshotTransition::TransitionType tt = SnapshotTransition::transitionType(argv[++n]);
+						if (tt == SnapshotTransition::nTransitionTypes)
+						{
+							msg.print("Error: Unrecognised transition type '%s' (expected fade, slide or rotate).\n", argv[n]);
+							return 1;
+						}
+						SnapshotTransition::setDefaultType(tt);
+					}
+					else missingArg = true;
+					break;
+				case ('f'):
+					if (n < argc-1) renderFps = atoi(argv[++n]);
+					else missingArg = true;
+					break;
+				case ('g'):
+					ShaderRenderer::setEnabled(false);
+					break;
 				case ('h'):
 					printf("Quapp revision %s, %s\n\nAvailable CLI options are:\n\n", QUAPPREVISION, QUAPPDATE);
+					printf("\t-a <n>\t\tTime animation of n objects through per-object and batched paths, and exit\n");
+					printf("\t-b <spec>\tRun render benchmark on a synthetic quiz, print results as JSON, and exit\n");
+					printf("\t\t\t<spec> is a comma-separated list of name=value pairs (or '-' for defaults) from:\n");
+					printf("\t\t\t  teams, rounds, questions, imagesize, markup, seed, frames, step, width, height, output\n");
+					printf("\t-c <file>\tSave the loaded quiz to <file> (as an archive if it ends .qab, or a bundle with all media if it ends .qapz), and exit\n");
+					printf("\t-d <n>\t\tSet number of discs in animated background (default 200)\n");
+					printf("\t-e <type>\tSet transition of outgoing scene between segments - fade, slide or rotate (default %s)\n", SnapshotTransition::transitionType(SnapshotTransition::defaultType()));
+					printf("\t-f <fps>\tSet frame rate for rendered run (default 30)\n");
+					printf("\t-g\t\tDraw through the fixed-function pipeline, rather than shader programs\n");
 					printf("\t-h\t\tShow this help\n");
+					printf("\t-l\t\tDraw every layer every frame, rather than caching those which are unchanged\n");
+					printf("\t-m <MB>\t\tSet memory budget for decoded images (0 for unlimited, default %lli)\n", MediaRegistry::imageBudget()/(1024*1024));
+					printf("\t-n <n>\t\tSet number of frames kept by the frame profiler (0 to disable, default %i)\n", FrameProfiler::historyLength());
+					printf("\t-p <n>\t\tSet number of upcoming items whose media is prefetched (default %i)\n", MediaRegistry::prefetchDepth());
+					printf("\t-q <n>\t\tTime tokenising and loading of a generated quiz of n questions (e.g. 200000), and exit\n");
+					printf("\t-r <dir>\tRender the whole run of the loaded quiz offscreen to numbered PNG frames in <dir>, and exit\n");
+					printf("\t-s <WxH>\tSet frame size for rendered run (default 1920x1080)\n");
+					printf("\t-t <file>\tRecord tracing spans and write them to <file> as Chrome trace-event JSON on exit\n");
+					printf("\t-w <s>\t\tSet interval between background autosaves in seconds (0 to disable, default 60)\n");
 					return 1;
 					break;
+				case ('l'):
+					LayerCache::setEnabled(false);
+					break;
+				case ('m'):
+					if (n < argc-1) MediaRegistry::setImageBudget(qint64(atoi(argv[++n]))*1024*1024);
+					else missingArg = true;
+					break;
+				case ('n'):
+					if (n < argc-1) FrameProfiler::setHistoryLength(atoi(argv[++n]));
+					else missingArg = true;
+					break;
+				case ('p'):
+					if (n < argc-1) MediaRegistry::setPrefetchDepth(atoi(argv[++n]));
+					else missingArg = true;
+					break;
+				case ('q'):
+					if (n < argc-1)
+					{
+						ParserBenchmark::run(atoi(argv[++n]));
+						return 0;
+					}
+					else missingArg = true;
+					break;
+				case ('r'):
+					if (n < argc-1) renderDirectory = argv[++n];
+					else missingArg = true;
+					break;
+				case ('s'):
+					if (n < argc-1)
+					{
+						if (sscanf(argv[++n], "%ix%i", &renderWidth, &renderHeight) != 2)
+						{
+							msg.print("Error: Frame size must be given as WxH (e.g. 1920x1080).\n");
+							return 1;
+						}
+					}
+					else missingArg = true;
+					break;
+				case ('t'):
+					if (n < argc-1)
+					{
+						traceFile = argv[++n];
+						if (!Tracer::setEnabled(true)) traceFile = QString();
+					}
+					else missingArg = true;
+					break;
+				case ('w'):
+					if (n < argc-1) mainWindow.setAutosaveInterval(atoi(argv[++n]));
+					else missingArg = true;
+					break;
 				default:
 					msg.print("Unrecognised command-line switch '%s'.\n", argv[n]);
 					msg.print("Run with -h to see available switches.\n");
@@ -86,16 +209,56 @@ int main(int argc, char *argv[])
 	}
 
 	/* Update main window */
+	mainWindow.resetAutosave();
 	mainWindow.updateQuestionSets();
 	mainWindow.updateQuestions();
 	mainWindow.updateSegments();
 	mainWindow.updateRunData();
 	mainWindow.updateRunControls();
 	
-	/* Show the main window */
-	mainWindow.show();
+	/* Run the benchmark, convert the quiz, or render the run offscreen if requested, or show the main window and enter Qt's main events loop */
+	int result;
+	if (!benchmarkSpec.isEmpty()) result = (mainWindow.benchmark(benchmarkSpec) ? 0 : 1);
+	else if (!convertFile.isEmpty())
+	{
+		if (!fileLoaded)
+		{
+			msg.print("Error: A quiz file must be given in order to convert it.\n");
+			return 1;
+		}
+		result = (mainWindow.quiz().save(convertFile) ? 0 : 1);
+	}
+	else if (!renderDirectory.isEmpty())
+	{
+		if (!fileLoaded)
+		{
+			msg.print("Error: A quiz file must be given in order to render a run.\n");
+			return 1;
+		}
+		result = (mainWindow.renderRun(renderDirectory, renderFps, renderWidth, renderHeight) ? 0 : 1);
+	}
+	else
+	{
+		mainWindow.show();
+		result = app.exec();
+	}
+
+	/* Stop any text compilation still in progress */
+	SceneCompiler::printStatistics();
+	SceneCompiler::clear();
+
+	/* Write trace, if one was recorded */
+	if (!traceFile.isEmpty())
+	{
+		Tracer::setEnabled(false);
+		Tracer::exportTrace(traceFile);
+	}
+
+	/* Report object pool usage */
+	ObjectPool<DisplayObject>::printStatistics("DisplayObject");
+	ObjectPool<TextFragment>::printStatistics("TextFragment");
+	ObjectPool<Primitive>::printStatistics("Primitive");
 
-	/* Enter Qt's main events loop */
-	return app.exec();
+	return result;
 }
 
@@ -36,20 +36,33 @@ Cuboid::Cuboid()
 // Update extreme coordinates with supplied vector
 void Cuboid::updateExtremes(Vec3<double> v)
 {
+	// Each axis is checked independently, since a coordinate may extend the cuboid along several at once
 	if (!minimaSet_) minima_ = v;
-	else if (v.x < minima_.x) minima_.x = v.x;
-	else if (v.y < minima_.y) minima_.y = v.y;
-	else if (v.z < minima_.z) minima_.z = v.z;
+	else
+	{
+		if (v.x < minima_.x) minima_.x = v.x;
+		if (v.y < minima_.y) minima_.y = v.y;
+		if (v.z < minima_.z) minima_.z = v.z;
+	}
 
 	if (!maximaSet_) maxima_ = v;
-	else if (v.x > maxima_.x) maxima_.x = v.x;
-	else if (v.y > maxima_.y) maxima_.y = v.y;
-	else if (v.z > maxima_.z) maxima_.z = v.z;
+	else
+	{
+		if (v.x > maxima_.x) maxima_.x = v.x;
+		if (v.y > maxima_.y) maxima_.y = v.y;
+		if (v.z > maxima_.z) maxima_.z = v.z;
+	}
 
 	minimaSet_ = true;
 	maximaSet_ = true;
 }
 
+// Return whether the cuboid has been given any coordinates
+bool Cuboid::isSet() const
+{
+	return minimaSet_ && maximaSet_;
+}
+
 /*
  * Functions
  */
@@ -79,3 +92,38 @@ bool Cuboid::isPointWithinProjection(int x, int y, Matrix viewMatrix, Matrix pro
 // 	rectArea = QuappMath::triangleArea(a.) + 
 	return false;
 }
+
+// Return whether cuboid lies entirely outside the view volume, once transformed by the supplied (column-major) modelview and projection matrices
+bool Cuboid::isOutsideView(const GLfloat* modelView, const GLfloat* projection) const
+{
+	// Combined transformation to clip space
+	GLfloat m[16];
+	for (int col=0; col<4; ++col)
+	{
+		for (int row=0; row<4; ++row) m[col*4+row] = projection[row]*modelView[col*4] + projection[4+row]*modelView[col*4+1] + projection[8+row]*modelView[col*4+2] + projection[12+row]*modelView[col*4+3];
+	}
+
+	// Transform each corner to clip space, noting which of the six clip planes it lies beyond
+	// The cuboid is outside the view only if all corners lie beyond the same plane, so this errs on the side of visibility
+	int outsideAll = 63, outside;
+	GLfloat x, y, z, clip[4];
+	for (int corner=0; corner<8; ++corner)
+	{
+		x = (corner&1 ? maxima_.x : minima_.x);
+		y = (corner&2 ? maxima_.y : minima_.y);
+		z = (corner&4 ? maxima_.z : minima_.z);
+		for (int n=0; n<4; ++n) clip[n] = m[n]*x + m[4+n]*y + m[8+n]*z + m[12+n];
+
+		outside = 0;
+		if (clip[0] < -clip[3]) outside |= 1;
+		if (clip[0] > clip[3]) outside |= 2;
+		if (clip[1] < -clip[3]) outside |= 4;
+		if (clip[1] > clip[3]) outside |= 8;
+		if (clip[2] < -clip[3]) outside |= 16;
+		if (clip[2] > clip[3]) outside |= 32;
+		outsideAll &= outside;
+		if (outsideAll == 0) return false;
+	}
+
+	return true;
+}
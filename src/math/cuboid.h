@@ -44,6 +44,8 @@ class Cuboid
 	public:
 	// Update extreme coordinates with supplied vector
 	void updateExtremes(Vec3<double> v);
+	// Return whether the cuboid has been given any coordinates
+	bool isSet() const;
 
 
 	/*
@@ -56,6 +58,8 @@ class Cuboid
 	Vec3<double> maxima() const;
 	// Return whether 2D coordinates are within projection of cuboid
 	bool isPointWithinProjection(int x, int y, Matrix viewMatrix, Matrix projectionMatrix, const GLuint* viewPort);
+	// Return whether cuboid lies entirely outside the view volume, once transformed by the supplied (column-major) modelview and projection matrices
+	bool isOutsideView(const GLfloat* modelView, const GLfloat* projection) const;
 };
 
 #endif
@@ -0,0 +1,157 @@
+/*
+	*** Animation Benchmark
+	*** src/render/animationbenchmark.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/animationbenchmark.h"
+#include "render/animationstore.h"
+#include "render/animationclock.h"
+#include "render/transform.h"
+#include "math/mathfunc.h"
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QVector>
+#include <math.h>
+#include <stdio.h>
+
+// Reference Object (as evaluated by DisplayObject before AnimationStore)
+class ReferenceObject : public ListItem<ReferenceObject>
+{
+	public:
+	// Position of object
+	Vec3<double> position;
+	// Transformation matrix for object
+	Matrix transformationMatrix;
+	// Colour of object
+	QColor colour;
+	// List of transforms
+	List<Transform> transforms;
+	// Overall transform coordinate
+	double transformCoordinate;
+	// Whether object is currently transforming
+	bool isTransforming;
+
+	public:
+	// Update dynamic properties
+	void updateDynamic()
+	{
+		if (!isTransforming) return;
+
+		transformationMatrix.setIdentity();
+		transformationMatrix.addTranslation(position);
+
+		bool continueTransform = true;
+		transformCoordinate = 0.0;
+		for (Transform* transform = transforms.first(); transform != NULL; transform = transform->next)
+		{
+			if (continueTransform) continueTransform = transform->applyTransform(transformationMatrix, colour);
+			transformCoordinate += transform->coordinate();
+		}
+		transformCoordinate /= transforms.nItems();
+
+		if (transformCoordinate > 0.9999) isTransforming = false;
+	}
+};
+
+// Time per-object (Transform list) and batched (AnimationStore) evaluation of the specified number of objects, printing the results
+void AnimationBenchmark::run(int nObjects, int nFrames)
+{
+	printf("Animation benchmark - %i objects, %i frames\n", nObjects, nFrames);
+
+	// Create identical sets of objects, each with a translation, rotation, scaling, and colour transform (as a typical text line)
+	// Every other object is first rotated in, as image answers are, so that it goes through a rotation, translation, and rotation
+	List<ReferenceObject> referenceObjects;
+	QVector<int> handles(nObjects);
+	Vec3<double> position, origin, destination;
+	QColor colourA, colourB;
+	double duration;
+	for (int n=0; n<nObjects; ++n)
+	{
+		ReferenceObject* object = referenceObjects.add();
+		object->isTransforming = true;
+		handles[n] = AnimationStore::createObject();
+
+		position.set(QuappMath::random(), QuappMath::random(), 0.0);
+		object->position = position;
+		AnimationStore::setPosition(handles[n], position);
+
+		if (n%2 == 1)
+		{
+			duration = 4.0 + 4.0*QuappMath::random();
+			object->transforms.add()->setRotationTransform(1, 90.0, 0.0, duration, 0.5);
+			AnimationStore::addRotation(handles[n], 1, 90.0, 0.0, duration, 0.5);
+		}
+
+		origin.set(QuappMath::random(), QuappMath::random(), 0.0);
+		destination.set(QuappMath::random(), QuappMath::random(), 0.0);
+		duration = 4.0 + 4.0*QuappMath::random();
+		object->transforms.add()->setTranslationTransform(origin, destination, duration);
+		AnimationStore::addTranslation(handles[n], origin, destination, duration);
+
+		duration = 4.0 + 4.0*QuappMath::random();
+		object->transforms.add()->setRotationTransform(1, 90.0, 0.0, duration);
+		AnimationStore::addRotation(handles[n], 1, 90.0, 0.0, duration);
+
+		duration = 4.0 + 4.0*QuappMath::random();
+		object->transforms.add()->setScaleTransform(Vec3<double>(0.5, 0.5, 0.5), Vec3<double>(1.0, 1.0, 1.0), duration);
+		AnimationStore::addScaling(handles[n], Vec3<double>(0.5, 0.5, 0.5), Vec3<double>(1.0, 1.0, 1.0), duration);
+
+		colourA.setRgbF(QuappMath::random(), QuappMath::random(), QuappMath::random(), 0.0);
+		colourB = colourA;
+		colourB.setAlphaF(1.0);
+		duration = 4.0 + 4.0*QuappMath::random();
+		object->transforms.add()->setColourTransform(colourA, colourB, duration);
+		AnimationStore::addColour(handles[n], colourA, colourB, duration);
+	}
+
+	// Step both sets through the same frame times (at 60 Hz)
+	QElapsedTimer timer;
+	qint64 referenceTime = 0, batchedTime = 0;
+	for (int frame=0; frame<nFrames; ++frame)
+	{
+		AnimationClock::setFrameTime(frame / 60.0);
+
+		timer.start();
+		for (ReferenceObject* object = referenceObjects.first(); object != NULL; object = object->next) object->updateDynamic();
+		referenceTime += timer.nsecsElapsed();
+
+		timer.start();
+		AnimationStore::update(frame / 60.0);
+		batchedTime += timer.nsecsElapsed();
+	}
+
+	// Check that both produced the same result
+	double maxMatrixDelta = 0.0, maxColourDelta = 0.0;
+	int n = 0;
+	for (ReferenceObject* object = referenceObjects.first(); object != NULL; object = object->next, ++n)
+	{
+		const float* matrix = AnimationStore::matrix(handles[n]);
+		for (int m=0; m<16; ++m) maxMatrixDelta = qMax(maxMatrixDelta, fabs(object->transformationMatrix[m] - matrix[m]));
+		const float* colour = AnimationStore::colourData(handles[n]);
+		maxColourDelta = qMax(maxColourDelta, fabs(object->colour.redF() - colour[0]));
+		maxColourDelta = qMax(maxColourDelta, fabs(object->colour.greenF() - colour[1]));
+		maxColourDelta = qMax(maxColourDelta, fabs(object->colour.blueF() - colour[2]));
+		maxColourDelta = qMax(maxColourDelta, fabs(object->colour.alphaF() - colour[3]));
+		AnimationStore::releaseObject(handles[n]);
+	}
+
+	printf("  Per-object (List<Transform>) : %10.4f ms/frame  %8.2f ns/object\n", referenceTime*1.0e-6/nFrames, double(referenceTime)/(double(nFrames)*nObjects));
+	printf("  Batched (AnimationStore)     : %10.4f ms/frame  %8.2f ns/object\n", batchedTime*1.0e-6/nFrames, double(batchedTime)/(double(nFrames)*nObjects));
+	printf("  Speedup                      : %10.2fx\n", batchedTime > 0 ? double(referenceTime)/batchedTime : 0.0);
+	printf("  Maximum difference           : %10.3e (matrix)  %10.3e (colour)\n", maxMatrixDelta, maxColourDelta);
+}
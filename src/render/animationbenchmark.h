@@ -0,0 +1,36 @@
+/*
+	*** Animation Benchmark
+	*** src/render/animationbenchmark.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_ANIMATIONBENCHMARK_H
+#define QUAPP_ANIMATIONBENCHMARK_H
+
+// Forward Declarations
+/* none */
+
+// Animation Benchmark
+class AnimationBenchmark
+{
+	public:
+	// Time per-object (Transform list) and batched (AnimationStore) evaluation of the specified number of objects, printing the results
+	static void run(int nObjects, int nFrames = 600);
+};
+
+#endif
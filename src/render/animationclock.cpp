@@ -0,0 +1,53 @@
+/*
+	*** Animation Clock
+	*** src/render/animationclock.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/animationclock.h"
+
+// Static Members
+QElapsedTimer AnimationClock::timer_;
+double AnimationClock::frameTime_ = 0.0;
+
+/*
+ * Time
+ */
+
+// Sample the clock for a new frame, returning the frame time (in seconds)
+double AnimationClock::advance()
+{
+	if (!timer_.isValid()) timer_.start();
+
+	// Every object animated in this frame sees the same time, however long the frame takes to process
+	frameTime_ = timer_.nsecsElapsed() * 1.0e-9;
+
+	return frameTime_;
+}
+
+// Return time (in seconds) sampled for the current frame
+double AnimationClock::frameTime()
+{
+	return frameTime_;
+}
+
+// Set frame time explicitly (for evaluating animations away from the display)
+void AnimationClock::setFrameTime(double time)
+{
+	frameTime_ = time;
+}
@@ -0,0 +1,51 @@
+/*
+	*** Animation Clock
+	*** src/render/animationclock.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_ANIMATIONCLOCK_H
+#define QUAPP_ANIMATIONCLOCK_H
+
+#include <QtCore/QElapsedTimer>
+
+// Forward Declarations
+/* none */
+
+// Animation Clock
+class AnimationClock
+{
+	/*
+	 * Time
+	 */
+	private:
+	// Monotonic timer from which all animation times are derived
+	static QElapsedTimer timer_;
+	// Time (in seconds) sampled for the current frame
+	static double frameTime_;
+
+	public:
+	// Sample the clock for a new frame, returning the frame time (in seconds)
+	static double advance();
+	// Return time (in seconds) sampled for the current frame
+	static double frameTime();
+	// Set frame time explicitly (for evaluating animations away from the display)
+	static void setFrameTime(double time);
+};
+
+#endif
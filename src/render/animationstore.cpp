@@ -0,0 +1,647 @@
+/*
+	*** Animation Store
+	*** src/render/animationstore.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/animationstore.h"
+#include "math/constants.h"
+#include <QtCore/QVarLengthArray>
+#include <math.h>
+
+// Static Members
+QVector<bool> AnimationStore::objectUsed_;
+QVector<int> AnimationStore::freeObjects_;
+QVector<float> AnimationStore::position_;
+QVector<float> AnimationStore::matrix_;
+QVector<float> AnimationStore::colour_;
+QVector<float> AnimationStore::coordinate_;
+QVector<int> AnimationStore::nTracks_;
+QVector<int> AnimationStore::lastTrack_;
+QVector<bool> AnimationStore::transforming_;
+QVector<bool> AnimationStore::held_;
+QVector<bool> AnimationStore::active_;
+QVector<bool> AnimationStore::rotateFirst_;
+QVector<bool> AnimationStore::sequential_;
+QVector<float> AnimationStore::translation_;
+QVector<float> AnimationStore::rotation_;
+QVector<float> AnimationStore::scaling_;
+QVector<int> AnimationStore::colourSequence_;
+int AnimationStore::trackSequence_ = 0;
+QVector<int> AnimationStore::trackObject_[AnimationStore::nTrackTypes];
+QVector<int> AnimationStore::freeTracks_[AnimationStore::nTrackTypes];
+QVector<int> AnimationStore::trackSequenceNumber_[AnimationStore::nTrackTypes];
+QVector<int> AnimationStore::trackPrevious_[AnimationStore::nTrackTypes];
+QVector<double> AnimationStore::trackStart_[AnimationStore::nTrackTypes];
+QVector<float> AnimationStore::trackDuration_[AnimationStore::nTrackTypes];
+QVector<float> AnimationStore::trackContinueAt_[AnimationStore::nTrackTypes];
+QVector<float> AnimationStore::trackCoordinate_[AnimationStore::nTrackTypes];
+QVector<float> AnimationStore::trackOrigin_[AnimationStore::nTrackTypes];
+QVector<float> AnimationStore::trackDestination_[AnimationStore::nTrackTypes];
+QVector<int> AnimationStore::rotationAxis_;
+
+/*
+ * Objects
+ */
+
+// Create new object, returning its handle
+int AnimationStore::createObject()
+{
+	int object;
+	if (freeObjects_.size() > 0)
+	{
+		object = freeObjects_.last();
+		freeObjects_.removeLast();
+	}
+	else
+	{
+		object = objectUsed_.size();
+		objectUsed_.resize(object+1);
+		position_.resize((object+1)*3);
+		matrix_.resize((object+1)*16);
+		colour_.resize((object+1)*4);
+		coordinate_.resize(object+1);
+		nTracks_.resize(object+1);
+		lastTrack_.resize(object+1);
+		transforming_.resize(object+1);
+		held_.resize(object+1);
+		active_.resize(object+1);
+		rotateFirst_.resize(object+1);
+		sequential_.resize(object+1);
+		translation_.resize((object+1)*3);
+		rotation_.resize((object+1)*3);
+		scaling_.resize((object+1)*3);
+		colourSequence_.resize(object+1);
+	}
+
+	// Initialise object data
+	objectUsed_[object] = true;
+	for (int n=0; n<3; ++n) position_[object*3+n] = 0.0;
+	for (int n=0; n<16; ++n) matrix_[object*16+n] = (n%5 == 0 ? 1.0 : 0.0);
+	for (int n=0; n<4; ++n) colour_[object*4+n] = 1.0;
+	coordinate_[object] = 0.0;
+	nTracks_[object] = 0;
+	lastTrack_[object] = -1;
+	transforming_[object] = false;
+	held_[object] = false;
+	active_[object] = false;
+	rotateFirst_[object] = false;
+	sequential_[object] = false;
+	resetAccumulation(object);
+
+	return object;
+}
+
+// Release object and all of its tracks
+void AnimationStore::releaseObject(int object)
+{
+	clearTracks(object);
+	objectUsed_[object] = false;
+	freeObjects_.append(object);
+}
+
+// Set base position of object
+void AnimationStore::setPosition(int object, Vec3<double> position)
+{
+	position_[object*3] = position.x;
+	position_[object*3+1] = position.y;
+	position_[object*3+2] = position.z;
+}
+
+// Return base position of object
+Vec3<double> AnimationStore::position(int object)
+{
+	return Vec3<double>(position_[object*3], position_[object*3+1], position_[object*3+2]);
+}
+
+// Set colour of object
+void AnimationStore::setColour(int object, QColor colour)
+{
+	colour_[object*4] = colour.redF();
+	colour_[object*4+1] = colour.greenF();
+	colour_[object*4+2] = colour.blueF();
+	colour_[object*4+3] = colour.alphaF();
+}
+
+// Return colour of object
+QColor AnimationStore::colour(int object)
+{
+	QColor colour;
+	colour.setRgbF(colour_[object*4], colour_[object*4+1], colour_[object*4+2], colour_[object*4+3]);
+	return colour;
+}
+
+// Return colour of object (r, g, b, a)
+const float* AnimationStore::colourData(int object)
+{
+	return &colour_.constData()[object*4];
+}
+
+// Return transformation matrix of object
+const float* AnimationStore::matrix(int object)
+{
+	return &matrix_.constData()[object*16];
+}
+
+// Return overall transform coordinate of object
+double AnimationStore::coordinate(int object)
+{
+	return coordinate_[object];
+}
+
+// Return whether object is transforming
+bool AnimationStore::isTransforming(int object)
+{
+	return transforming_[object];
+}
+
+// Set whether object is held (not progressed) in the next update
+void AnimationStore::setHeld(int object, bool held)
+{
+	held_[object] = held;
+}
+
+// Return number of object slots in use
+int AnimationStore::nObjects()
+{
+	return objectUsed_.size() - freeObjects_.size();
+}
+
+/*
+ * Tracks
+ */
+
+// Encode track handle
+int AnimationStore::encodeTrack(int type, int index)
+{
+	return index*nTrackTypes + type;
+}
+
+// Create new track of specified type for object, returning its index
+int AnimationStore::createTrack(int object, TrackType type, double duration, double continueAt)
+{
+	int index;
+	if (freeTracks_[type].size() > 0)
+	{
+		index = freeTracks_[type].last();
+		freeTracks_[type].removeLast();
+	}
+	else
+	{
+		index = trackObject_[type].size();
+		trackObject_[type].resize(index+1);
+		trackSequenceNumber_[type].resize(index+1);
+		trackPrevious_[type].resize(index+1);
+		trackStart_[type].resize(index+1);
+		trackDuration_[type].resize(index+1);
+		trackContinueAt_[type].resize(index+1);
+		trackCoordinate_[type].resize(index+1);
+		trackOrigin_[type].resize((index+1)*4);
+		trackDestination_[type].resize((index+1)*4);
+		if (type == AnimationStore::RotateTrack) rotationAxis_.resize(index+1);
+	}
+
+	// Link track to the end of the object's sequence
+	trackObject_[type][index] = object;
+	trackSequenceNumber_[type][index] = trackSequence_++;
+	trackPrevious_[type][index] = lastTrack_[object];
+	trackStart_[type][index] = -1.0;
+	trackDuration_[type][index] = duration;
+	trackContinueAt_[type][index] = continueAt;
+	trackCoordinate_[type][index] = 0.0;
+	for (int n=0; n<4; ++n) trackOrigin_[type][index*4+n] = trackDestination_[type][index*4+n] = 0.0;
+
+	lastTrack_[object] = encodeTrack(type, index);
+	++nTracks_[object];
+	transforming_[object] = true;
+	coordinate_[object] = 0.0;
+
+	return index;
+}
+
+// Release track
+void AnimationStore::releaseTrack(int type, int index)
+{
+	trackObject_[type][index] = -1;
+	freeTracks_[type].append(index);
+}
+
+// Return whether the track preceding the specified one (if any) permits it to start
+bool AnimationStore::canStart(int previous)
+{
+	if (previous < 0) return true;
+	int type = previous%nTrackTypes, index = previous/nTrackTypes;
+	return ((trackStart_[type][index] >= 0.0) && (trackCoordinate_[type][index] > trackContinueAt_[type][index]));
+}
+
+// Apply value of track at its current coordinate to accumulated object data
+void AnimationStore::applyTrack(int type, int index)
+{
+	int object = trackObject_[type][index];
+	float c = trackCoordinate_[type][index];
+	const float* origin = &trackOrigin_[type].constData()[index*4];
+	const float* destination = &trackDestination_[type].constData()[index*4];
+	switch (type)
+	{
+		case (AnimationStore::TranslateTrack):
+			translation_[object*3] += origin[0] + (destination[0]-origin[0])*c;
+			translation_[object*3+1] += origin[1] + (destination[1]-origin[1])*c;
+			translation_[object*3+2] -= origin[2] + (destination[2]-origin[2])*c;
+			break;
+		case (AnimationStore::RotateTrack):
+			rotation_[object*3+rotationAxis_[index]] += origin[0] + (destination[0]-origin[0])*c;
+			break;
+		case (AnimationStore::ScaleTrack):
+			for (int n=0; n<3; ++n) scaling_[object*3+n] *= origin[n] + (destination[n]-origin[n])*c;
+			break;
+		case (AnimationStore::ColourTrack):
+			if (trackSequenceNumber_[type][index] < colourSequence_[object]) break;
+			for (int n=0; n<4; ++n) colour_[object*4+n] = qBound(0.0f, origin[n] + (destination[n]-origin[n])*c, 1.0f);
+			colourSequence_[object] = trackSequenceNumber_[type][index];
+			break;
+	}
+}
+
+// Determine how the translations and rotations of object may be composed
+void AnimationStore::classifyOrder(int object)
+{
+	// Summed rotations are applied about x, then y, then z, and all either before or after the summed translation. Anything
+	// else (e.g. rotate, translate, rotate) has to be composed one track at a time. Tracks are linked from last to first.
+	int nChanges = 0, laterType = -1, laterAxis = 2;
+	bool outOfOrder = false;
+	for (int track = lastTrack_[object]; track != -1; track = trackPrevious_[track%nTrackTypes][track/nTrackTypes])
+	{
+		int type = track%nTrackTypes, index = track/nTrackTypes;
+		if ((type != AnimationStore::TranslateTrack) && (type != AnimationStore::RotateTrack)) continue;
+		if ((laterType != -1) && (type != laterType)) ++nChanges;
+		if (type == AnimationStore::RotateTrack)
+		{
+			if (rotationAxis_[index] > laterAxis) outOfOrder = true;
+			laterAxis = rotationAxis_[index];
+		}
+		laterType = type;
+	}
+
+	// The last type found is that of the first track
+	rotateFirst_[object] = (laterType == AnimationStore::RotateTrack);
+	sequential_[object] = (nChanges > 1) || outOfOrder;
+}
+
+// Compose transformation matrix of object from its accumulated data
+void AnimationStore::compose(int object)
+{
+	if (sequential_[object])
+	{
+		composeSequential(object);
+		return;
+	}
+
+	const float* position = &position_.constData()[object*3];
+	const float* translation = &translation_.constData()[object*3];
+	const float* rotation = &rotation_.constData()[object*3];
+	const float* scaling = &scaling_.constData()[object*3];
+	float* matrix = &matrix_.data()[object*16];
+
+	// Rotation (applied about x, then y, then z, with the same sense as Matrix::applyRotation*)
+	float cx = 1.0, sx = 0.0, cy = 1.0, sy = 0.0, cz = 1.0, sz = 0.0;
+	if (rotation[0] != 0.0)
+	{
+		cx = cosf(rotation[0]/DEGRAD);
+		sx = sinf(rotation[0]/DEGRAD);
+	}
+	if (rotation[1] != 0.0)
+	{
+		cy = cosf(rotation[1]/DEGRAD);
+		sy = sinf(rotation[1]/DEGRAD);
+	}
+	if (rotation[2] != 0.0)
+	{
+		cz = cosf(rotation[2]/DEGRAD);
+		sz = sinf(rotation[2]/DEGRAD);
+	}
+	float r[9] = { cz*cy, cz*sy*sx + sz*cx, sz*sx - cz*sy*cx,
+			-sz*cy, cz*cx - sz*sy*sx, sz*sy*cx + cz*sx,
+			sy, -cy*sx, cy*cx };
+
+	// Translation is rotated along with the position unless the rotation came first
+	float v[3];
+	if (rotateFirst_[object]) for (int n=0; n<3; ++n) v[n] = r[n*3]*position[0] + r[n*3+1]*position[1] + r[n*3+2]*position[2] + translation[n];
+	else for (int n=0; n<3; ++n) v[n] = r[n*3]*(position[0]+translation[0]) + r[n*3+1]*(position[1]+translation[1]) + r[n*3+2]*(position[2]+translation[2]);
+
+	// Scaling is applied to the object's own axes
+	for (int col=0; col<3; ++col)
+	{
+		for (int row=0; row<3; ++row) matrix[col*4+row] = r[row*3+col]*scaling[col];
+		matrix[col*4+3] = 0.0;
+	}
+	matrix[12] = v[0];
+	matrix[13] = v[1];
+	matrix[14] = v[2];
+	matrix[15] = 1.0;
+}
+
+// Compose transformation matrix of object by applying its translations and rotations in the order they were added
+void AnimationStore::composeSequential(int object)
+{
+	// Tracks are linked from last to first, so gather them up before applying them in order
+	QVarLengthArray<int,16> tracks;
+	for (int track = lastTrack_[object]; track != -1; track = trackPrevious_[track%nTrackTypes][track/nTrackTypes]) tracks.append(track);
+
+	// Each rotation is applied to everything before it, with the same sense as Matrix::applyRotation*
+	float r[9] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 }, v[3], row[6], angle, c, s;
+	for (int n=0; n<3; ++n) v[n] = position_[object*3+n];
+	for (int n=tracks.size()-1; n>=0; --n)
+	{
+		int type = tracks[n]%nTrackTypes, index = tracks[n]/nTrackTypes;
+		const float* origin = &trackOrigin_[type].constData()[index*4];
+		const float* destination = &trackDestination_[type].constData()[index*4];
+		float coordinate = trackCoordinate_[type][index];
+		if (type == AnimationStore::TranslateTrack)
+		{
+			v[0] += origin[0] + (destination[0]-origin[0])*coordinate;
+			v[1] += origin[1] + (destination[1]-origin[1])*coordinate;
+			v[2] -= origin[2] + (destination[2]-origin[2])*coordinate;
+		}
+		else if (type == AnimationStore::RotateTrack)
+		{
+			angle = (origin[0] + (destination[0]-origin[0])*coordinate) / DEGRAD;
+			c = cosf(angle);
+			s = sinf(angle);
+
+			// Rows affected by rotation about x are (y, z), about y are (z, x), and about z are (x, y)
+			int a = (rotationAxis_[index]+1)%3, b = (rotationAxis_[index]+2)%3;
+			for (int m=0; m<3; ++m)
+			{
+				row[m] = c*r[a*3+m] + s*r[b*3+m];
+				row[m+3] = c*r[b*3+m] - s*r[a*3+m];
+			}
+			for (int m=0; m<3; ++m)
+			{
+				r[a*3+m] = row[m];
+				r[b*3+m] = row[m+3];
+			}
+			float va = c*v[a] + s*v[b], vb = c*v[b] - s*v[a];
+			v[a] = va;
+			v[b] = vb;
+		}
+
+		// Later tracks have not started until this one has passed its continuation point
+		if (coordinate <= trackContinueAt_[type][index]) break;
+	}
+
+	// Scaling is applied to the object's own axes
+	const float* scaling = &scaling_.constData()[object*3];
+	float* matrix = &matrix_.data()[object*16];
+	for (int col=0; col<3; ++col)
+	{
+		for (int row=0; row<3; ++row) matrix[col*4+row] = r[row*3+col]*scaling[col];
+		matrix[col*4+3] = 0.0;
+	}
+	matrix[12] = v[0];
+	matrix[13] = v[1];
+	matrix[14] = v[2];
+	matrix[15] = 1.0;
+}
+
+// Reset accumulated data of object
+void AnimationStore::resetAccumulation(int object)
+{
+	for (int n=0; n<3; ++n)
+	{
+		translation_[object*3+n] = 0.0;
+		rotation_[object*3+n] = 0.0;
+		scaling_[object*3+n] = 1.0;
+	}
+	colourSequence_[object] = -1;
+}
+
+// Add translation track to object
+void AnimationStore::addTranslation(int object, Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
+{
+	int index = createTrack(object, AnimationStore::TranslateTrack, duration, continueAt);
+	float* o = &trackOrigin_[AnimationStore::TranslateTrack].data()[index*4];
+	float* d = &trackDestination_[AnimationStore::TranslateTrack].data()[index*4];
+	o[0] = origin.x;
+	o[1] = origin.y;
+	o[2] = origin.z;
+	d[0] = destination.x;
+	d[1] = destination.y;
+	d[2] = destination.z;
+	classifyOrder(object);
+}
+
+// Add rotation track to object
+void AnimationStore::addRotation(int object, int axis, double origin, double destination, double duration, double continueAt)
+{
+	int index = createTrack(object, AnimationStore::RotateTrack, duration, continueAt);
+	rotationAxis_[index] = (axis < 0 ? 0 : (axis > 2 ? 2 : axis));
+	trackOrigin_[AnimationStore::RotateTrack][index*4] = origin;
+	trackDestination_[AnimationStore::RotateTrack][index*4] = destination;
+	classifyOrder(object);
+}
+
+// Add scaling track to object
+void AnimationStore::addScaling(int object, Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
+{
+	int index = createTrack(object, AnimationStore::ScaleTrack, duration, continueAt);
+	float* o = &trackOrigin_[AnimationStore::ScaleTrack].data()[index*4];
+	float* d = &trackDestination_[AnimationStore::ScaleTrack].data()[index*4];
+	o[0] = origin.x;
+	o[1] = origin.y;
+	o[2] = origin.z;
+	d[0] = destination.x;
+	d[1] = destination.y;
+	d[2] = destination.z;
+}
+
+// Add colour track to object
+void AnimationStore::addColour(int object, QColor origin, QColor destination, double duration, double continueAt)
+{
+	int index = createTrack(object, AnimationStore::ColourTrack, duration, continueAt);
+	float* o = &trackOrigin_[AnimationStore::ColourTrack].data()[index*4];
+	float* d = &trackDestination_[AnimationStore::ColourTrack].data()[index*4];
+	o[0] = origin.redF();
+	o[1] = origin.greenF();
+	o[2] = origin.blueF();
+	o[3] = origin.alphaF();
+	d[0] = destination.redF();
+	d[1] = destination.greenF();
+	d[2] = destination.blueF();
+	d[3] = destination.alphaF();
+}
+
+// Clear all tracks of object
+void AnimationStore::clearTracks(int object)
+{
+	int track = lastTrack_[object], previous;
+	while (track != -1)
+	{
+		previous = trackPrevious_[track%nTrackTypes][track/nTrackTypes];
+		releaseTrack(track%nTrackTypes, track/nTrackTypes);
+		track = previous;
+	}
+
+	nTracks_[object] = 0;
+	lastTrack_[object] = -1;
+	coordinate_[object] = 0.0;
+	transforming_[object] = false;
+	rotateFirst_[object] = false;
+	sequential_[object] = false;
+}
+
+// Return number of tracks in use
+int AnimationStore::nTracks()
+{
+	int nTracks = 0;
+	for (int type=0; type<nTrackTypes; ++type) nTracks += trackObject_[type].size() - freeTracks_[type].size();
+	return nTracks;
+}
+
+/*
+ * Evaluation
+ */
+
+// Set object matrix and colour from its tracks at their current coordinates, without progressing them
+void AnimationStore::initialise(int object)
+{
+	// Tracks are linked from last to first, so gather them up before applying them in order
+	QVector<int> tracks;
+	for (int track = lastTrack_[object]; track != -1; track = trackPrevious_[track%nTrackTypes][track/nTrackTypes]) tracks.append(track);
+
+	resetAccumulation(object);
+	for (int n=tracks.size()-1; n>=0; --n)
+	{
+		int type = tracks[n]%nTrackTypes, index = tracks[n]/nTrackTypes;
+		applyTrack(type, index);
+		if (trackCoordinate_[type][index] <= trackContinueAt_[type][index]) break;
+	}
+	compose(object);
+}
+
+// Progress all (non-held) objects to the specified animation time
+void AnimationStore::update(double time)
+{
+	int nObjects = objectUsed_.size();
+	bool* active = active_.data();
+	const bool* used = objectUsed_.constData(), *transforming = transforming_.constData(), *held = held_.constData();
+	float* coordinate = coordinate_.data();
+
+	// Determine which objects are to be progressed, and reset their accumulated data
+	float* translation = translation_.data(), *rotation = rotation_.data(), *scaling = scaling_.data();
+	int* colourSequence = colourSequence_.data();
+	for (int n=0; n<nObjects; ++n)
+	{
+		active[n] = used[n] && transforming[n] && (!held[n]);
+		if (!active[n]) continue;
+		coordinate[n] = 0.0;
+		translation[n*3] = translation[n*3+1] = translation[n*3+2] = 0.0;
+		rotation[n*3] = rotation[n*3+1] = rotation[n*3+2] = 0.0;
+		scaling[n*3] = scaling[n*3+1] = scaling[n*3+2] = 1.0;
+		colourSequence[n] = -1;
+	}
+
+	// Advance track coordinates, starting any tracks whose predecessors have reached their continuation point
+	for (int type=0; type<nTrackTypes; ++type)
+	{
+		int nTracks = trackObject_[type].size();
+		const int* object = trackObject_[type].constData(), *previous = trackPrevious_[type].constData();
+		const float* duration = trackDuration_[type].constData();
+		double* start = trackStart_[type].data();
+		float* trackCoordinate = trackCoordinate_[type].data();
+		for (int n=0; n<nTracks; ++n)
+		{
+			if ((object[n] == -1) || (!active[object[n]])) continue;
+			if (start[n] < 0.0)
+			{
+				if (!canStart(previous[n])) continue;
+				start[n] = time;
+			}
+			trackCoordinate[n] = (duration[n] > 0.0 ? qMin(float((time - start[n]) / duration[n]), 1.0f) : 1.0f);
+			coordinate[object[n]] += trackCoordinate[n];
+		}
+	}
+
+	// Accumulate translations
+	int nTracks = trackObject_[AnimationStore::TranslateTrack].size();
+	const int* object = trackObject_[AnimationStore::TranslateTrack].constData();
+	const double* start = trackStart_[AnimationStore::TranslateTrack].constData();
+	const float* trackCoordinate = trackCoordinate_[AnimationStore::TranslateTrack].constData();
+	const float* origin = trackOrigin_[AnimationStore::TranslateTrack].constData(), *destination = trackDestination_[AnimationStore::TranslateTrack].constData();
+	for (int n=0; n<nTracks; ++n)
+	{
+		if ((object[n] == -1) || (!active[object[n]]) || (start[n] < 0.0)) continue;
+		translation[object[n]*3] += origin[n*4] + (destination[n*4]-origin[n*4])*trackCoordinate[n];
+		translation[object[n]*3+1] += origin[n*4+1] + (destination[n*4+1]-origin[n*4+1])*trackCoordinate[n];
+		translation[object[n]*3+2] -= origin[n*4+2] + (destination[n*4+2]-origin[n*4+2])*trackCoordinate[n];
+	}
+
+	// Accumulate rotations
+	nTracks = trackObject_[AnimationStore::RotateTrack].size();
+	object = trackObject_[AnimationStore::RotateTrack].constData();
+	start = trackStart_[AnimationStore::RotateTrack].constData();
+	trackCoordinate = trackCoordinate_[AnimationStore::RotateTrack].constData();
+	origin = trackOrigin_[AnimationStore::RotateTrack].constData();
+	destination = trackDestination_[AnimationStore::RotateTrack].constData();
+	const int* axis = rotationAxis_.constData();
+	for (int n=0; n<nTracks; ++n)
+	{
+		if ((object[n] == -1) || (!active[object[n]]) || (start[n] < 0.0)) continue;
+		rotation[object[n]*3+axis[n]] += origin[n*4] + (destination[n*4]-origin[n*4])*trackCoordinate[n];
+	}
+
+	// Accumulate scalings
+	nTracks = trackObject_[AnimationStore::ScaleTrack].size();
+	object = trackObject_[AnimationStore::ScaleTrack].constData();
+	start = trackStart_[AnimationStore::ScaleTrack].constData();
+	trackCoordinate = trackCoordinate_[AnimationStore::ScaleTrack].constData();
+	origin = trackOrigin_[AnimationStore::ScaleTrack].constData();
+	destination = trackDestination_[AnimationStore::ScaleTrack].constData();
+	for (int n=0; n<nTracks; ++n)
+	{
+		if ((object[n] == -1) || (!active[object[n]]) || (start[n] < 0.0)) continue;
+		scaling[object[n]*3] *= origin[n*4] + (destination[n*4]-origin[n*4])*trackCoordinate[n];
+		scaling[object[n]*3+1] *= origin[n*4+1] + (destination[n*4+1]-origin[n*4+1])*trackCoordinate[n];
+		scaling[object[n]*3+2] *= origin[n*4+2] + (destination[n*4+2]-origin[n*4+2])*trackCoordinate[n];
+	}
+
+	// Set colours - the most recently added colour track which has started takes precedence
+	nTracks = trackObject_[AnimationStore::ColourTrack].size();
+	object = trackObject_[AnimationStore::ColourTrack].constData();
+	start = trackStart_[AnimationStore::ColourTrack].constData();
+	trackCoordinate = trackCoordinate_[AnimationStore::ColourTrack].constData();
+	origin = trackOrigin_[AnimationStore::ColourTrack].constData();
+	destination = trackDestination_[AnimationStore::ColourTrack].constData();
+	const int* sequence = trackSequenceNumber_[AnimationStore::ColourTrack].constData();
+	float* colour = colour_.data();
+	for (int n=0; n<nTracks; ++n)
+	{
+		if ((object[n] == -1) || (!active[object[n]]) || (start[n] < 0.0) || (sequence[n] < colourSequence[object[n]])) continue;
+		for (int m=0; m<4; ++m) colour[object[n]*4+m] = qBound(0.0f, origin[n*4+m] + (destination[n*4+m]-origin[n*4+m])*trackCoordinate[n], 1.0f);
+		colourSequence[object[n]] = sequence[n];
+	}
+
+	// Compose matrices, and check for finished objects
+	const int* nObjectTracks = nTracks_.constData();
+	for (int n=0; n<nObjects; ++n)
+	{
+		if (!active[n]) continue;
+		compose(n);
+		coordinate[n] /= nObjectTracks[n];
+		if (coordinate[n] > 0.9999) transforming_[n] = false;
+	}
+}
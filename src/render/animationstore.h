@@ -0,0 +1,174 @@
+/*
+	*** Animation Store
+	*** src/render/animationstore.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_ANIMATIONSTORE_H
+#define QUAPP_ANIMATIONSTORE_H
+
+#include <QtCore/QVector>
+#include <QtGui/QColor>
+#include "templates/vector3.h"
+
+// Forward Declarations
+/* none */
+
+// Animation Store
+class AnimationStore
+{
+	public:
+	// Track type enum
+	enum TrackType { TranslateTrack, RotateTrack, ScaleTrack, ColourTrack, nTrackTypes };
+
+
+	/*
+	 * Objects
+	 */
+	private:
+	// Whether each object slot is in use
+	static QVector<bool> objectUsed_;
+	// Unused object slots
+	static QVector<int> freeObjects_;
+	// Base position of each object (x, y, z)
+	static QVector<float> position_;
+	// Current transformation matrix of each object (column-major, 16 per object)
+	static QVector<float> matrix_;
+	// Current colour of each object (r, g, b, a)
+	static QVector<float> colour_;
+	// Overall transform coordinate of each object
+	static QVector<float> coordinate_;
+	// Number of tracks belonging to each object
+	static QVector<int> nTracks_;
+	// Last track added to each object (encoded, or -1 for none)
+	static QVector<int> lastTrack_;
+	// Whether each object is transforming
+	static QVector<bool> transforming_;
+	// Whether each object is held (not progressed) in the next update
+	static QVector<bool> held_;
+	// Whether each object is being progressed in the current update
+	static QVector<bool> active_;
+	// Whether rotations are applied before translations for each object
+	static QVector<bool> rotateFirst_;
+	// Whether translations and rotations of each object must be composed one by one, in the order they were added
+	static QVector<bool> sequential_;
+	// Accumulated translation, rotation (about x, y, and z), and scaling of each object in the current update
+	static QVector<float> translation_, rotation_, scaling_;
+	// Sequence number of the track which last set the colour of each object in the current update
+	static QVector<int> colourSequence_;
+
+	public:
+	// Create new object, returning its handle
+	static int createObject();
+	// Release object and all of its tracks
+	static void releaseObject(int object);
+	// Set base position of object
+	static void setPosition(int object, Vec3<double> position);
+	// Return base position of object
+	static Vec3<double> position(int object);
+	// Set colour of object
+	static void setColour(int object, QColor colour);
+	// Return colour of object
+	static QColor colour(int object);
+	// Return colour of object (r, g, b, a)
+	static const float* colourData(int object);
+	// Return transformation matrix of object
+	static const float* matrix(int object);
+	// Return overall transform coordinate of object
+	static double coordinate(int object);
+	// Return whether object is transforming
+	static bool isTransforming(int object);
+	// Set whether object is held (not progressed) in the next update
+	static void setHeld(int object, bool held);
+	// Return number of object slots in use
+	static int nObjects();
+
+
+	/*
+	 * Tracks
+	 */
+	private:
+	// Sequence number to assign to next track
+	static int trackSequence_;
+	// Object to which each track belongs (or -1 if unused)
+	static QVector<int> trackObject_[nTrackTypes];
+	// Unused track slots
+	static QVector<int> freeTracks_[nTrackTypes];
+	// Sequence number of each track (order of creation)
+	static QVector<int> trackSequenceNumber_[nTrackTypes];
+	// Previous track (encoded) belonging to same object, or -1 for none
+	static QVector<int> trackPrevious_[nTrackTypes];
+	// Animation time at which each track started (or -1.0 if not yet started)
+	static QVector<double> trackStart_[nTrackTypes];
+	// Duration of each track (in seconds)
+	static QVector<float> trackDuration_[nTrackTypes];
+	// Coordinate of each track at which subsequent tracks of the same object start
+	static QVector<float> trackContinueAt_[nTrackTypes];
+	// Current coordinate of each track
+	static QVector<float> trackCoordinate_[nTrackTypes];
+	// Origin and destination values of each track (four per track)
+	static QVector<float> trackOrigin_[nTrackTypes], trackDestination_[nTrackTypes];
+	// Axis of each rotation track
+	static QVector<int> rotationAxis_;
+
+	private:
+	// Encode track handle
+	static int encodeTrack(int type, int index);
+	// Create new track of specified type for object, returning its index
+	static int createTrack(int object, TrackType type, double duration, double continueAt);
+	// Release track
+	static void releaseTrack(int type, int index);
+	// Return whether the track preceding the specified one (if any) permits it to start
+	static bool canStart(int previous);
+	// Apply value of track at its current coordinate to accumulated object data
+	static void applyTrack(int type, int index);
+	// Determine how the translations and rotations of object may be composed
+	static void classifyOrder(int object);
+	// Compose transformation matrix of object from its accumulated data
+	static void compose(int object);
+	// Compose transformation matrix of object by applying its translations and rotations in the order they were added
+	static void composeSequential(int object);
+	// Reset accumulated data of object
+	static void resetAccumulation(int object);
+
+	public:
+	// Add translation track to object
+	static void addTranslation(int object, Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
+	// Add rotation track to object
+	static void addRotation(int object, int axis, double origin, double destination, double duration, double continueAt = 0.0);
+	// Add scaling track to object
+	static void addScaling(int object, Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
+	// Add colour track to object
+	static void addColour(int object, QColor origin, QColor destination, double duration, double continueAt = 0.0);
+	// Clear all tracks of object
+	static void clearTracks(int object);
+	// Return number of tracks in use
+	static int nTracks();
+
+
+	/*
+	 * Evaluation
+	 */
+	public:
+	// Set object matrix and colour from its tracks at their current coordinates, without progressing them
+	static void initialise(int object);
+	// Progress all (non-held) objects to the specified animation time
+	static void update(double time);
+};
+
+#endif
@@ -0,0 +1,63 @@
+/*
+	*** Animation Track Handle
+	*** src/render/animationtrack.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/animationtrack.h"
+#include "render/animationstore.h"
+
+// Constructor
+AnimationTrack::AnimationTrack(int object)
+{
+	object_ = object;
+}
+
+/*
+ * Definition
+ */
+
+// Set translation transform
+void AnimationTrack::setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
+{
+	AnimationStore::addTranslation(object_, origin, destination, duration, continueAt);
+}
+
+// Set translation transform (no dynamics)
+void AnimationTrack::setTranslationTransform(Vec3<double> coordinates)
+{
+	AnimationStore::addTranslation(object_, coordinates, coordinates, 0.0, -1.0);
+}
+
+// Set colour transform
+void AnimationTrack::setColourTransform(QColor origin, QColor dest, double duration, double continueAt)
+{
+	AnimationStore::addColour(object_, origin, dest, duration, continueAt);
+}
+
+// Set scale transform
+void AnimationTrack::setScaleTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
+{
+	AnimationStore::addScaling(object_, origin, destination, duration, continueAt);
+}
+
+// Set rotation transform
+void AnimationTrack::setRotationTransform(int axis, double origin, double destination, double duration, double continueAt)
+{
+	AnimationStore::addRotation(object_, axis, origin, destination, duration, continueAt);
+}
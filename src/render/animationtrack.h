@@ -0,0 +1,59 @@
+/*
+	*** Animation Track Handle
+	*** src/render/animationtrack.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_ANIMATIONTRACK_H
+#define QUAPP_ANIMATIONTRACK_H
+
+#include "templates/vector3.h"
+#include <QtGui/QColor>
+
+// Forward Declarations
+/* none */
+
+// Animation Track Handle
+class AnimationTrack
+{
+	public:
+	// Constructor
+	AnimationTrack(int object);
+
+
+	/*
+	 * Definition
+	 */
+	private:
+	// Object (in AnimationStore) to which the track will be added
+	int object_;
+
+	public:
+	// Set translation transform
+	void setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
+	// Set translation transform (no dynamics)
+	void setTranslationTransform(Vec3<double> coordinates);
+	// Set colour transform
+	void setColourTransform(QColor origin, QColor dest, double duration, double continueAt = 0.0);
+	// Add scale transform
+	void setScaleTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
+	// Add rotation transform
+	void setRotationTransform(int axis, double origin, double dest, double duration, double continueAt = 0.0);
+};
+
+#endif
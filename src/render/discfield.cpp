@@ -0,0 +1,334 @@
+/*
+	*** Animated Disc Field
+	*** src/render/discfield.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/discfield.h"
+#include "render/glextensions.h"
+#include "render/animationclock.h"
+#include "render/frameprofiler.h"
+#include "render/primitive.h"
+#include "math/mathfunc.h"
+#include <QtOpenGL/QGLShaderProgram>
+#include <math.h>
+#include <stdio.h>
+
+// Vertex shader for instanced path
+// Discs lie face-on to the scene light, so only the ambient terms contribute (as in the fixed-function path)
+static const char* discVertexShader =
+	"#version 120\n"
+	"attribute vec2 vertex;\n"
+	"attribute vec4 instancePosition;\n"
+	"attribute vec4 instanceColour;\n"
+	"uniform float aspectRatio;\n"
+	"varying vec4 colour;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 position = vec4(instancePosition.x*aspectRatio + vertex.x*instancePosition.w, instancePosition.y + vertex.y*instancePosition.w, instancePosition.z, 1.0);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * position;\n"
+	"	colour = vec4(min(instanceColour.rgb * (gl_LightSource[0].ambient.rgb + gl_LightModel.ambient.rgb), 1.0), instanceColour.a);\n"
+	"}\n";
+
+// Fragment shader for instanced path
+static const char* discFragmentShader =
+	"#version 120\n"
+	"varying vec4 colour;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = colour;\n"
+	"}\n";
+
+// Constructor
+DiscField::DiscField()
+{
+	nDiscs_ = 0;
+	instanceDataChanged_ = false;
+	glContext_ = NULL;
+	instanced_ = false;
+	meshBuffer_ = 0;
+	instanceBuffer_ = 0;
+	program_ = NULL;
+
+	// Create unit disc mesh
+	unitDisc_.resize(nSegments_*6);
+	GLfloat* mesh = unitDisc_.data();
+	double delta = 2.0*M_PI / nSegments_;
+	for (int n=0; n<nSegments_; ++n)
+	{
+		*mesh++ = 0.0;
+		*mesh++ = 0.0;
+		*mesh++ = cos(n*delta);
+		*mesh++ = sin(n*delta);
+		*mesh++ = cos((n+1)*delta);
+		*mesh++ = sin((n+1)*delta);
+	}
+}
+
+// Destructor
+DiscField::~DiscField()
+{
+	// GL objects belong to the context, and are released along with it
+	if (program_) delete program_;
+}
+
+/*
+ * Discs
+ */
+
+// Set new random start / end points, colour, and durations for specified disc, starting at the time given
+void DiscField::respawn(int index, double time)
+{
+	float r = radius_[index];
+
+	// Start at a random point on screen, and head for a random point just off one of the edges
+	startX_[index] = QuappMath::random();
+	startY_[index] = QuappMath::random();
+	if (QuappMath::random() < 0.5)
+	{
+		endX_[index] = QuappMath::random() < 0.5 ? -r : 1.0+r;
+		endY_[index] = QuappMath::random()*(1.0+2.0*r) - r;
+	}
+	else
+	{
+		endX_[index] = QuappMath::random()*(1.0+2.0*r) - r;
+		endY_[index] = QuappMath::random() < 0.5 ? -r : 1.0+r;
+	}
+
+	// Mostly grey, with the occasional random colour
+	if (QuappMath::random() > 0.9)
+	{
+		red_[index] = QuappMath::random();
+		green_[index] = QuappMath::random();
+		blue_[index] = QuappMath::random();
+	}
+	else red_[index] = green_[index] = blue_[index] = QuappMath::random();
+
+	// Set transition durations
+	float dx = endX_[index] - startX_[index], dy = endY_[index] - startY_[index];
+	startTime_[index] = time;
+	moveDuration_[index] = 1.0 / (sqrt(dx*dx + dy*dy)*0.04 + QuappMath::random()*0.08);
+	fadeDuration_[index] = 1.0 / (0.4 + 0.8*QuappMath::random());
+	growDuration_[index] = 2.5;
+}
+
+// Initialise field with specified number of discs
+void DiscField::initialise(int nDiscs)
+{
+	nDiscs_ = nDiscs;
+	radius_.resize(nDiscs_);
+	depth_.resize(nDiscs_);
+	startX_.resize(nDiscs_);
+	startY_.resize(nDiscs_);
+	endX_.resize(nDiscs_);
+	endY_.resize(nDiscs_);
+	red_.resize(nDiscs_);
+	green_.resize(nDiscs_);
+	blue_.resize(nDiscs_);
+	startTime_.resize(nDiscs_);
+	moveDuration_.resize(nDiscs_);
+	fadeDuration_.resize(nDiscs_);
+	growDuration_.resize(nDiscs_);
+	instanceData_.resize(nDiscs_*8);
+	instanceData_.fill(0.0);
+
+	// Discs are spread evenly over the same depth range regardless of their number, later discs nearer the viewer
+	float depthDelta = (nDiscs_ > 0 ? 2.0 / nDiscs_ : 0.0);
+	for (int n=0; n<nDiscs_; ++n)
+	{
+		radius_[n] = 0.1*QuappMath::random();
+		depth_[n] = 10.0 - n*depthDelta;
+		respawn(n, AnimationClock::frameTime());
+	}
+
+	instanceDataChanged_ = true;
+}
+
+// Return number of discs in field
+int DiscField::nDiscs()
+{
+	return nDiscs_;
+}
+
+// Update all discs to the specified animation time, returning whether anything changed
+bool DiscField::update(double time)
+{
+	if (nDiscs_ == 0) return false;
+
+	double* startTime = startTime_.data();
+	const float* moveDuration = moveDuration_.constData(), *fadeDuration = fadeDuration_.constData(), *growDuration = growDuration_.constData();
+	GLfloat* data = instanceData_.data();
+	float moveCoordinate, fadeCoordinate, growCoordinate, elapsed;
+	for (int n=0; n<nDiscs_; ++n)
+	{
+		// Once all transitions are complete, send the disc off again from somewhere new
+		elapsed = time - startTime[n];
+		if ((elapsed >= moveDuration[n]) && (elapsed >= fadeDuration[n]) && (elapsed >= growDuration[n]))
+		{
+			respawn(n, time);
+			elapsed = 0.0;
+		}
+
+		// Get transition coordinates, each stopping at 1.0
+		moveCoordinate = qMin(elapsed / moveDuration[n], 1.0f);
+		fadeCoordinate = qMin(elapsed / fadeDuration[n], 1.0f);
+		growCoordinate = qMin(elapsed / growDuration[n], 1.0f);
+
+		// Store instance data
+		GLfloat* instance = &data[n*8];
+		instance[0] = startX_[n] + (endX_[n] - startX_[n])*moveCoordinate;
+		instance[1] = startY_[n] + (endY_[n] - startY_[n])*moveCoordinate;
+		instance[2] = -depth_[n] - 1.0;
+		instance[3] = radius_[n]*growCoordinate;
+		instance[4] = red_[n];
+		instance[5] = green_[n];
+		instance[6] = blue_[n];
+		instance[7] = 0.15*fadeCoordinate;
+	}
+
+	instanceDataChanged_ = true;
+
+	return true;
+}
+
+/*
+ * Rendering
+ */
+
+// Create GL objects for the current context
+void DiscField::initialiseGL(const QGLContext* context, GLExtensions* extensions)
+{
+	glContext_ = context;
+	instanced_ = false;
+	if (!extensions->hasVBO() || !extensions->hasInstancing()) return;
+
+	// Compile and link shader program
+	program_ = new QGLShaderProgram;
+	bool success = program_->addShaderFromSourceCode(QGLShader::Vertex, discVertexShader);
+	if (success) success = program_->addShaderFromSourceCode(QGLShader::Fragment, discFragmentShader);
+	if (success)
+	{
+		program_->bindAttributeLocation("vertex", 0);
+		program_->bindAttributeLocation("instancePosition", 1);
+		program_->bindAttributeLocation("instanceColour", 2);
+		success = program_->link();
+	}
+	if (!success)
+	{
+		printf("Failed to create disc field shader program - falling back to batched drawing.\n%s\n", qPrintable(program_->log()));
+		delete program_;
+		program_ = NULL;
+		return;
+	}
+
+	// Create buffer objects for the mesh and instance data
+	extensions->glGenBuffers(1, &meshBuffer_);
+	extensions->glBindBuffer(GL_ARRAY_BUFFER, meshBuffer_);
+	extensions->glBufferData(GL_ARRAY_BUFFER, unitDisc_.size()*sizeof(GLfloat), unitDisc_.constData(), GL_STATIC_DRAW);
+	extensions->glGenBuffers(1, &instanceBuffer_);
+	extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	instanceDataChanged_ = true;
+
+	instanced_ = true;
+}
+
+// Draw field with a single instanced call
+void DiscField::sendInstanced(GLExtensions* extensions, double aspectRatio)
+{
+	program_->bind();
+	program_->setUniformValue("aspectRatio", (GLfloat) aspectRatio);
+
+	// Unit disc mesh
+	extensions->glBindBuffer(GL_ARRAY_BUFFER, meshBuffer_);
+	program_->enableAttributeArray(0);
+	program_->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+
+	// Per-disc data - reallocate the store each time it changes, so the driver need not wait on the previous frame
+	extensions->glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+	if (instanceDataChanged_)
+	{
+		extensions->glBufferData(GL_ARRAY_BUFFER, instanceData_.size()*sizeof(GLfloat), instanceData_.constData(), GL_STREAM_DRAW);
+		FrameProfiler::count(FrameProfiler::BufferUploadCounter);
+		instanceDataChanged_ = false;
+	}
+	program_->enableAttributeArray(1);
+	program_->setAttributeBuffer(1, GL_FLOAT, 0, 4, 8*sizeof(GLfloat));
+	extensions->glVertexAttribDivisor(1, 1);
+	program_->enableAttributeArray(2);
+	program_->setAttributeBuffer(2, GL_FLOAT, 4*sizeof(GLfloat), 4, 8*sizeof(GLfloat));
+	extensions->glVertexAttribDivisor(2, 1);
+
+	extensions->glDrawArraysInstanced(GL_TRIANGLES, 0, nSegments_*3, nDiscs_);
+	Primitive::countDrawCalls(1, nSegments_*3*nDiscs_);
+
+	// Restore state
+	extensions->glVertexAttribDivisor(1, 0);
+	extensions->glVertexAttribDivisor(2, 0);
+	program_->disableAttributeArray(0);
+	program_->disableAttributeArray(1);
+	program_->disableAttributeArray(2);
+	extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	program_->release();
+}
+
+// Draw field as a single batched vertex array
+void DiscField::sendBatched(double aspectRatio)
+{
+	int nVertices = nSegments_*3;
+	batchData_.resize(nDiscs_*nVertices*10);
+	GLfloat* vertex = batchData_.data();
+	const GLfloat* instance = instanceData_.constData();
+	for (int n=0; n<nDiscs_; ++n, instance += 8)
+	{
+		GLfloat x = instance[0]*aspectRatio, y = instance[1], size = instance[3];
+		const GLfloat* mesh = unitDisc_.constData();
+		for (int m=0; m<nVertices; ++m, mesh += 2)
+		{
+			*vertex++ = instance[4];
+			*vertex++ = instance[5];
+			*vertex++ = instance[6];
+			*vertex++ = instance[7];
+			*vertex++ = 0.0;
+			*vertex++ = 0.0;
+			*vertex++ = 1.0;
+			*vertex++ = x + mesh[0]*size;
+			*vertex++ = y + mesh[1]*size;
+			*vertex++ = instance[2];
+		}
+	}
+
+	glInterleavedArrays(GL_C4F_N3F_V3F, 0, batchData_.constData());
+	glDrawArrays(GL_TRIANGLES, 0, nDiscs_*nVertices);
+	Primitive::countDrawCalls(1, nDiscs_*nVertices);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Draw field
+void DiscField::sendToGL(const QGLContext* context, GLExtensions* extensions, double aspectRatio)
+{
+	if (nDiscs_ == 0) return;
+
+	if (glContext_ == NULL) initialiseGL(context, extensions);
+
+	// GL objects only exist in the context they were created in (offscreen renders use the batched path)
+	glLoadIdentity();
+	if (instanced_ && (context == glContext_)) sendInstanced(extensions, aspectRatio);
+	else sendBatched(aspectRatio);
+}
@@ -0,0 +1,120 @@
+/*
+	*** Animated Disc Field
+	*** src/render/discfield.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_DISCFIELD_H
+#define QUAPP_DISCFIELD_H
+
+#ifndef __APPLE__
+#include <GL/gl.h>
+#else
+#include <OpenGL/gl3.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include "glext.h"
+#endif
+#include <QtCore/QVector>
+
+// Forward Declarations
+class GLExtensions;
+class QGLContext;
+class QGLShaderProgram;
+
+// Animated Disc Field
+class DiscField
+{
+	public:
+	// Constructor / Destructor
+	DiscField();
+	~DiscField();
+
+
+	/*
+	 * Discs
+	 */
+	private:
+	// Number of discs in field
+	int nDiscs_;
+	// Radius of each disc
+	QVector<float> radius_;
+	// Depth of each disc
+	QVector<float> depth_;
+	// Start and end coordinates of each disc
+	QVector<float> startX_, startY_, endX_, endY_;
+	// Colour of each disc
+	QVector<float> red_, green_, blue_;
+	// Animation time at which each disc was (re)started
+	QVector<double> startTime_;
+	// Durations (in seconds) of movement, fade, and growth transitions
+	QVector<float> moveDuration_, fadeDuration_, growDuration_;
+
+	private:
+	// Set new random start / end points, colour, and durations for specified disc, starting at the time given
+	void respawn(int index, double time);
+
+	public:
+	// Initialise field with specified number of discs
+	void initialise(int nDiscs);
+	// Return number of discs in field
+	int nDiscs();
+	// Update all discs to the specified animation time, returning whether anything changed
+	bool update(double time);
+
+
+	/*
+	 * Rendering
+	 */
+	private:
+	// Number of segments in unit disc mesh
+	static const int nSegments_ = 36;
+	// Unit disc mesh (xy pairs, as triangles)
+	QVector<GLfloat> unitDisc_;
+	// Per-disc instance data (x, y, z, size, r, g, b, a)
+	QVector<GLfloat> instanceData_;
+	// Whether instance data has changed since it was last uploaded
+	bool instanceDataChanged_;
+	// Context in which GL objects were created (if any)
+	const QGLContext* glContext_;
+	// Whether the instanced path is available
+	bool instanced_;
+	// Buffer object containing unit disc mesh
+	GLuint meshBuffer_;
+	// Buffer object containing per-disc instance data
+	GLuint instanceBuffer_;
+	// Shader program for instanced path
+	QGLShaderProgram* program_;
+	// Vertex data for batched (non-instanced) path (C4F_N3F_V3F)
+	QVector<GLfloat> batchData_;
+
+	private:
+	// Create GL objects for the current context
+	void initialiseGL(const QGLContext* context, GLExtensions* extensions);
+	// Draw field with a single instanced call
+	void sendInstanced(GLExtensions* extensions, double aspectRatio);
+	// Draw field as a single batched vertex array
+	void sendBatched(double aspectRatio);
+
+	public:
+	// Draw field
+	void sendToGL(const QGLContext* context, GLExtensions* extensions, double aspectRatio);
+};
+
+#endif
@@ -20,7 +20,11 @@
 */
 
 #include "render/displayobject.h"
+#include "templates/objectpool.h"
+#include "render/animationstore.h"
+#include "render/shaderrenderer.h"
 #include <QtOpenGL/QGLWidget>
+#include <string.h>
 
 // Static members
 QColor DisplayObject::defaultColour_(1,1,1,1);
@@ -28,17 +32,31 @@ QColor DisplayObject::defaultColour_(1,1,1,1);
 // Constructor
 DisplayObject::DisplayObject() : ListItem<DisplayObject>()
 {
+	// Definition
+	animation_ = AnimationStore::createObject();
+	AnimationStore::setColour(animation_, defaultColour_);
+
 	// Dynamic Properties
-	colour_ = defaultColour_;
-	transformCoordinate_ = 0.0;
 	transformContinueAt_ = -1.0;
-	isTransforming_ = false;
 	deleteAfterTransform_ = false;
 }
 
 // Destructor
 DisplayObject::~DisplayObject()
 {
+	AnimationStore::releaseObject(animation_);
+}
+
+// Allocate storage from object pool
+void* DisplayObject::operator new(size_t size)
+{
+	return ObjectPool<DisplayObject>::allocate(size);
+}
+
+// Return storage to object pool
+void DisplayObject::operator delete(void* object, size_t size)
+{
+	ObjectPool<DisplayObject>::release(object, size);
 }
 
 /*
@@ -48,25 +66,25 @@ DisplayObject::~DisplayObject()
 // Set position
 void DisplayObject::setPosition(double x, double y, double z)
 {
-	position_.set(x, y, z);
+	AnimationStore::setPosition(animation_, Vec3<double>(x, y, z));
 }
 
 // Set position
 void DisplayObject::setPosition(Vec3<double> position)
 {
-	position_ = position;
+	AnimationStore::setPosition(animation_, position);
 }
 
 // Adjust position
 void DisplayObject::adjustPosition(double dx, double dy, double dz)
 {
-	position_.add(dx, dy, dz);
+	AnimationStore::setPosition(animation_, AnimationStore::position(animation_) + Vec3<double>(dx, dy, dz));
 }
 
 // Return position
 Vec3<double> DisplayObject::position()
 {
-	return position_;
+	return AnimationStore::position(animation_);
 }
 
 // Set text size
@@ -100,19 +118,21 @@ TextPrimitive& DisplayObject::textPrimitive()
 // Set colour
 void DisplayObject::setColour(QColor colour)
 {
-	colour_ = colour;
+	AnimationStore::setColour(animation_, colour);
 }
 
 // Set colour
 void DisplayObject::setColour(double r, double g, double b, double a)
 {
-	colour_.setRgbF(r, g, b, a);
+	QColor colour;
+	colour.setRgbF(r, g, b, a);
+	AnimationStore::setColour(animation_, colour);
 }
 
 // Return colour
 QColor DisplayObject::colour()
 {
-	return colour_;
+	return AnimationStore::colour(animation_);
 }
 
 // Set primitive data used to generate it (size, radius etc.)
@@ -127,23 +147,42 @@ Vec3<double> DisplayObject::data()
 	return data_;
 }
 
+// Push instances of primitives, if they do not exist or are out of date
+void DisplayObject::updateInstances(const QGLContext* context, GLExtensions* extensions, VertexArena* arena)
+{
+	if (primitive_.nInstances() == 0) primitive_.pushInstance(context, extensions, arena);
+	textPrimitive_.updateInstance(context, extensions, arena);
+}
+
 // Send primitive to GL
 void DisplayObject::sendToGL(double aspectRatio) const
 {
-	// Reset matrix
-	glLoadIdentity();
+	// Get transformation
+	GLfloat matrix[16];
+	memcpy(matrix, AnimationStore::matrix(animation_), 16*sizeof(GLfloat));
+	matrix[12] *= aspectRatio;
 
-	// Set colour
-	GLfloat colour[4] =  { colour_.redF(), colour_.greenF(), colour_.blueF(), colour_.alphaF() };
-	glColor4fv(colour);
+	if (ShaderRenderer::active())
+	{
+		// Translate to perspective 'zero' plane (premultiplying by the translation), and pass matrix and colour to the program
+		for (int n=0; n<4; ++n) matrix[n*4+2] -= matrix[n*4+3];
+		ShaderRenderer::setModelView(matrix);
+		ShaderRenderer::setColour(AnimationStore::colourData(animation_));
+	}
+	else
+	{
+		// Reset matrix
+		glLoadIdentity();
 
-	// Translate to perspective 'zero' plane
-	glTranslated(0.0, 0.0, -1.0);
+		// Set colour
+		glColor4fv(AnimationStore::colourData(animation_));
 
-	// Apply transformation
-	Matrix matrix = transformationMatrix_;
-	matrix[12] *= aspectRatio;
-	glMultMatrixd(matrix.matrix());
+		// Translate to perspective 'zero' plane
+		glTranslated(0.0, 0.0, -1.0);
+
+		// Apply transformation
+		glMultMatrixf(matrix);
+	}
 
 	// Send text to GL
 	textPrimitive_.sendToGL();
@@ -152,42 +191,45 @@ void DisplayObject::sendToGL(double aspectRatio) const
 	primitive_.sendToGL();
 }
 
+// Add primitives to draw queue
+void DisplayObject::queue(DrawQueue& drawQueue, DrawQueue::Layer layer, double aspectRatio) const
+{
+	// Get transformation, translated to perspective 'zero' plane (premultiplying by the translation)
+	GLfloat matrix[16];
+	memcpy(matrix, AnimationStore::matrix(animation_), 16*sizeof(GLfloat));
+	matrix[12] *= aspectRatio;
+	for (int n=0; n<4; ++n) matrix[n*4+2] -= matrix[n*4+3];
+
+	// Text is added first, so that it is drawn before the primitive at the same depth and state (as in sendToGL())
+	textPrimitive_.queue(drawQueue, layer, matrix, AnimationStore::colourData(animation_));
+	primitive_.queue(drawQueue, layer, matrix, AnimationStore::colourData(animation_));
+
+	// Layers containing animating objects will have to be redrawn next frame anyway, so are not worth caching
+	if (AnimationStore::isTransforming(animation_)) drawQueue.setUncacheable(layer);
+}
+
 /*
  * Dynamic Properties
  */
 
 // Add new transform
-Transform* DisplayObject::addTransform()
+AnimationTrack DisplayObject::addTransform()
 {
-	isTransforming_ = true;
-	transformCoordinate_ = 0.0;
-	return transforms_.add();
+	return AnimationTrack(animation_);
 }
 
 // Initialise transforms
 void DisplayObject::initialiseTransforms()
 {
-	// Loop over defined transforms and set initial colour and transform
-	transformationMatrix_.setIdentity();
-
-	// Apply position to transformation matrix
-	transformationMatrix_.setTranslation(position_);
-	
-	bool continueTransform = true;
-	for (Transform* transform = transforms_.first(); transform != NULL; transform = transform->next)
-	{
-		if (continueTransform) continueTransform = transform->applyTransform(transformationMatrix_, colour_, false);
-	}
+	AnimationStore::initialise(animation_);
 }
 
 // Clear all existing transforms
 void DisplayObject::clearTransforms()
 {
-	transforms_.clear();
+	AnimationStore::clearTracks(animation_);
 
-	transformCoordinate_ = 0.0;
 	transformContinueAt_ = -1.0;
-	isTransforming_ = false;
 }
 
 // Set transform coordinate at which next object should start/continue transforming
@@ -199,13 +241,19 @@ void DisplayObject::setTransformContinueAt(double continueAt)
 // Return whether object is transforming
 bool DisplayObject::isTransforming()
 {
-	return isTransforming_;
+	return AnimationStore::isTransforming(animation_);
 }
 
 // Return whether update of the next object should be stalled
 bool DisplayObject::stall()
 {
-	return (transformCoordinate_ < transformContinueAt_);
+	return (AnimationStore::coordinate(animation_) < transformContinueAt_);
+}
+
+// Set whether object is held (not progressed) in the next update
+void DisplayObject::setHeld(bool held)
+{
+	AnimationStore::setHeld(animation_, held);
 }
 
 // Set object to be deleted after it has finished transforming
@@ -217,31 +265,5 @@ void DisplayObject::setDeleteAfterTransform()
 // Return whether this object should be deleted
 bool DisplayObject::toBeDeleted()
 {
-	return (deleteAfterTransform_ && (transformCoordinate_ > 0.9999));
-}
-
-// Update dynamic properties
-bool DisplayObject::updateDynamic()
-{
-	// If we have finished transforming, no need to do anything else
-	if (!isTransforming_) return false;
-
-	// Reset transformation matrix, and apply initial position
-	transformationMatrix_.setIdentity();
-	transformationMatrix_.addTranslation(position_);
-
-	// Loop over transforms
-	bool continueTransform = true;
-	transformCoordinate_ = 0.0;
-	for (Transform* transform = transforms_.first(); transform != NULL; transform = transform->next)
-	{
-		if (continueTransform) continueTransform = transform->applyTransform(transformationMatrix_, colour_);
-		transformCoordinate_ += transform->coordinate();
-	}
-	transformCoordinate_ /= transforms_.nItems();
-
-	// Have we finished transforming?
-	if (transformCoordinate_ > 0.9999) isTransforming_ = false;
-
-	return (transformCoordinate_ > transformContinueAt_);
+	return (deleteAfterTransform_ && (AnimationStore::coordinate(animation_) > 0.9999));
 }
@@ -24,13 +24,15 @@
 
 #include "render/primitivelist.h"
 #include "render/textprimitive.h"
-#include "render/transform.h"
+#include "render/animationtrack.h"
 #include <QtCore/QString>
 #include <QtGui/QImage>
 #include <QtGui/QColor>
 
 // Forward Declarations
-class QGLWidget;
+class GLExtensions;
+class QGLContext;
+class VertexArena;
 
 // Drawing Object
 class DisplayObject : public ListItem<DisplayObject>
@@ -39,16 +41,18 @@ class DisplayObject : public ListItem<DisplayObject>
 	// Constructor / Destructor
 	DisplayObject();
 	~DisplayObject();
+	// Allocate storage from object pool
+	static void* operator new(size_t size);
+	// Return storage to object pool
+	static void operator delete(void* object, size_t size);
 
 
 	/*
 	 * Definition
 	 */
 	private:
-	// Position of object
-	Vec3<double> position_;
-	// Transformation matrix for object
-	Matrix transformationMatrix_;
+	// Handle of object in AnimationStore (holding position, matrix, colour, and transforms)
+	int animation_;
 
 	public:
 	// Set position
@@ -75,8 +79,6 @@ class DisplayObject : public ListItem<DisplayObject>
 	TextPrimitive textPrimitive_;
 	// Default colour for primitives
 	static QColor defaultColour_;
-	// Colour for primitive
-	QColor colour_;
 	// Primitive data used to generate it (size, radius etc.)
 	Vec3<double> data_;
 
@@ -95,28 +97,26 @@ class DisplayObject : public ListItem<DisplayObject>
 	void setData(Vec3<double> v);
 	// Return primitive data used to generate it (size, radius etc.)
 	Vec3<double> data();
+	// Push instances of primitives, if they do not exist or are out of date
+	void updateInstances(const QGLContext* context, GLExtensions* extensions, VertexArena* arena);
 	// Send primitive to GL
 	void sendToGL(double aspectRatio) const;
+	// Add primitives to draw queue
+	void queue(DrawQueue& drawQueue, DrawQueue::Layer layer, double aspectRatio) const;
 
 
 	/*
 	 * Dynamic Properties
 	 */
 	private:
-	// List of transforms
-	List<Transform> transforms_;
-	// Overall transform coordinate
-	double transformCoordinate_;
 	// Overall transform coordinate at which next object should start/continue transforming
 	double transformContinueAt_;
-	// Whether object is currently transforming
-	bool isTransforming_;
 	// Whether to delete object once transform has finished
 	bool deleteAfterTransform_;
 	
 	public:
 	// Add new transform
-	Transform* addTransform();
+	AnimationTrack addTransform();
 	// Initialise transforms
 	void initialiseTransforms();
 	// Clear all existing transforms
@@ -127,12 +127,12 @@ class DisplayObject : public ListItem<DisplayObject>
 	bool isTransforming();
 	// Return whether update of the next object should be stalled
 	bool stall();
+	// Set whether object is held (not progressed) in the next update
+	void setHeld(bool held);
 	// Set object to be deleted after it has finished transforming
 	void setDeleteAfterTransform();
 	// Return whether this object should be deleted
 	bool toBeDeleted();
-	// Update dynamic properties, returning if anything was changed
-	bool updateDynamic();
 };
 
 #endif
@@ -0,0 +1,517 @@
+/*
+	*** Draw Queue
+	*** src/render/drawqueue.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/drawqueue.h"
+#include "render/frameprofiler.h"
+#include "render/glextensions.h"
+#include "render/primitive.h"
+#include "render/shaderrenderer.h"
+#include "render/textprimitive.h"
+#include "math/cuboid.h"
+#include <string.h>
+
+// Sort key layout (most significant first) - layer (2 bits), depth (32), program (1), texture (16), blend (1), type (2), streamed (1)
+#define KEY_LAYER_SHIFT 62
+#define KEY_DEPTH_SHIFT 30
+#define KEY_PROGRAM_SHIFT 29
+#define KEY_TEXTURE_SHIFT 13
+#define KEY_BLEND_SHIFT 12
+#define KEY_TYPE_SHIFT 10
+#define KEY_STREAMED_SHIFT 9
+
+// Number of floats per stream vertex
+#define STREAM_VERTEX_SIZE 12
+
+// FNV-1a parameters used for layer signatures
+#define SIGNATURE_OFFSET 14695981039346656037ULL
+#define SIGNATURE_PRIME 1099511628211ULL
+
+// Static Members
+int DrawQueue::maxStreamVertices_ = 4096;
+
+// Constructor
+DrawQueue::DrawQueue()
+{
+	nItems_ = 0;
+	nBatches_ = 0;
+	nStreamVertices_ = 0;
+	extensions_ = NULL;
+	streamBuffer_ = 0;
+	for (int n=0; n<nLayers; ++n) projectionSet_[n] = false;
+	clear();
+}
+
+// Destructor
+DrawQueue::~DrawQueue()
+{
+}
+
+/*
+ * Items
+ */
+
+// Add new item to queue, returning it and its sort entry
+DrawQueue::DrawItem* DrawQueue::addItem(DrawQueue::Layer layer, const GLfloat* matrix, const GLfloat* colour, DrawQueue::SortEntry*& entry)
+{
+	// Storage only ever grows, so that items are not reallocated every frame
+	if (nItems_ == items_.count())
+	{
+		items_.resize(qMax(64, nItems_*2));
+		sortEntries_.resize(items_.count());
+	}
+	DrawItem* item = &items_[nItems_];
+	memcpy(item->matrix, matrix, 16*sizeof(GLfloat));
+	memcpy(item->colour, colour, 4*sizeof(GLfloat));
+	item->primitive = NULL;
+	item->text = NULL;
+	item->texture = 0;
+	item->nStreamVertices = 0;
+
+	// Depth is the eye-space z of the item's origin, mapped to an unsigned integer which sorts in the same order (back to front)
+	quint32 depth;
+	memcpy(&depth, &item->matrix[14], sizeof(quint32));
+	depth = (depth & 0x80000000u) ? ~depth : (depth | 0x80000000u);
+
+	entry = &sortEntries_[nItems_];
+	entry->key = (quint64(layer) << KEY_LAYER_SHIFT) | (quint64(depth) << KEY_DEPTH_SHIFT);
+	entry->index = nItems_;
+
+	++nItems_;
+
+	// Matrix and colour are all that is needed of the item's state - primitives add their own data
+	sign(layer, &layer, sizeof(Layer));
+	sign(layer, item->matrix, 16*sizeof(GLfloat));
+	sign(layer, item->colour, 4*sizeof(GLfloat));
+
+	return item;
+}
+
+// Fold data into signature of specified layer
+void DrawQueue::sign(DrawQueue::Layer layer, const void* data, int nBytes)
+{
+	// Data are folded in a word at a time, which is plenty for spotting changes between frames
+	quint64 signature = layerSignatures_[layer];
+	const unsigned char* bytes = (const unsigned char*) data;
+	quint32 word;
+	for (int n=0; n+4 <= nBytes; n += 4)
+	{
+		memcpy(&word, bytes+n, 4);
+		signature = (signature ^ word) * SIGNATURE_PRIME;
+	}
+	for (int n=nBytes & ~3; n<nBytes; ++n) signature = (signature ^ bytes[n]) * SIGNATURE_PRIME;
+	layerSignatures_[layer] = signature;
+}
+
+// Return key for specified state (excluding depth)
+quint64 DrawQueue::stateKey(DrawQueue::Layer layer, DrawQueue::Program program, GLuint texture, DrawQueue::BlendMode blend, GLenum type, bool streamed)
+{
+	// Textures are numbered in the order they are first seen in the frame
+	int textureIndex = 0;
+	if (texture != 0)
+	{
+		if (textureIndices_.contains(texture)) textureIndex = textureIndices_.value(texture);
+		else
+		{
+			textureIndex = textureIndices_.count() + 1;
+			textureIndices_.insert(texture, textureIndex);
+		}
+	}
+
+	quint64 typeIndex = (type == GL_TRIANGLES ? 0 : (type == GL_LINES ? 1 : (type == GL_POINTS ? 2 : 3)));
+
+	return (quint64(layer) << KEY_LAYER_SHIFT) | (quint64(program) << KEY_PROGRAM_SHIFT) | (quint64(textureIndex & 0xffff) << KEY_TEXTURE_SHIFT) | (quint64(blend) << KEY_BLEND_SHIFT) | (typeIndex << KEY_TYPE_SHIFT) | (quint64(streamed) << KEY_STREAMED_SHIFT);
+}
+
+// Sort entries by key
+void DrawQueue::sortEntries()
+{
+	if (sortScratch_.count() < nItems_) sortScratch_.resize(sortEntries_.count());
+
+	// Least-significant digit radix sort on bytes of the key - this is stable, so items with equal keys keep the order they were added in
+	int count[256];
+	SortEntry* source = sortEntries_.data(), *target = sortScratch_.data();
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		memset(count, 0, 256*sizeof(int));
+		for (int n=0; n<nItems_; ++n) ++count[(source[n].key >> shift) & 0xff];
+
+		// If every entry has the same digit, this pass would not change the order
+		if (count[(source[0].key >> shift) & 0xff] == nItems_) continue;
+
+		int total = 0, digitCount;
+		for (int digit=0; digit<256; ++digit)
+		{
+			digitCount = count[digit];
+			count[digit] = total;
+			total += digitCount;
+		}
+		for (int n=0; n<nItems_; ++n) target[count[(source[n].key >> shift) & 0xff]++] = source[n];
+		qSwap(source, target);
+	}
+
+	if (source != sortEntries_.data()) memcpy(sortEntries_.data(), source, nItems_*sizeof(SortEntry));
+}
+
+// Clear queue, ready for a new frame
+void DrawQueue::clear()
+{
+	nItems_ = 0;
+	nBatches_ = 0;
+	nStreamVertices_ = 0;
+	textureIndices_.clear();
+	for (int n=0; n<nLayers; ++n)
+	{
+		layerSignatures_[n] = SIGNATURE_OFFSET;
+		layerCacheable_[n] = true;
+		nCulled_[n] = 0;
+	}
+}
+
+// Add primitive to queue
+void DrawQueue::addPrimitive(DrawQueue::Layer layer, const Primitive* primitive, const GLfloat* matrix, const GLfloat* colour, DrawQueue::BlendMode blend)
+{
+	if (primitive->nDefinedVertices() == 0) return;
+
+	// Per-vertex colours take precedence over that of the object, so such primitives remain visible whatever its alpha
+	if (culled(layer, colour, !primitive->hasColourData(), &primitive->bounds(), matrix)) return;
+
+	SortEntry* entry;
+	DrawItem* item = addItem(layer, matrix, colour, entry);
+	item->primitive = primitive;
+	item->texture = primitive->textureObject();
+
+	// Only independent primitive types can be merged, and larger primitives are better drawn from their own buffers
+	GLenum type = primitive->type();
+	int nVertices = (primitive->hasIndices() ? primitive->nDefinedIndices() : primitive->nDefinedVertices());
+	if (((type == GL_TRIANGLES) || (type == GL_LINES) || (type == GL_POINTS)) && (nVertices <= maxStreamVertices_)) item->nStreamVertices = nVertices;
+
+	entry->key |= stateKey(layer, DrawQueue::PrimitiveProgram, item->texture, blend, type, item->nStreamVertices > 0);
+
+	// Primitive revisions are unique, so changes to (or replacement of) vertex data always change the signature
+	unsigned int state[5] = { primitive->revision(), (unsigned int) primitive->nDefinedVertices(), (unsigned int) primitive->nDefinedIndices(), item->texture, (unsigned int) blend };
+	sign(layer, state, 5*sizeof(unsigned int));
+}
+
+// Add text to be drawn through the fixed-function pipeline
+void DrawQueue::addText(DrawQueue::Layer layer, const TextPrimitive* text, const GLfloat* matrix, const GLfloat* colour)
+{
+	// FTGL text is positioned fragment by fragment as it is drawn, so only its opacity can be tested
+	if (culled(layer, colour, true, NULL, matrix)) return;
+
+	SortEntry* entry;
+	DrawItem* item = addItem(layer, matrix, colour, entry);
+	item->text = text;
+
+	entry->key |= stateKey(layer, DrawQueue::FixedFunctionProgram, 0, DrawQueue::AlphaBlend, GL_TRIANGLES, false);
+
+	// The contents of FTGL text are not part of the signature, so the layer cannot be cached
+	layerCacheable_[layer] = false;
+}
+
+// Return number of items in queue
+int DrawQueue::nItems()
+{
+	return nItems_;
+}
+
+// Flag that the specified layer should not be cached this frame
+void DrawQueue::setUncacheable(DrawQueue::Layer layer)
+{
+	layerCacheable_[layer] = false;
+}
+
+// Return whether the specified layers may be cached
+bool DrawQueue::cacheable(int layerFlags)
+{
+	for (int n=0; n<nLayers; ++n) if ((layerFlags & (1 << n)) && (!layerCacheable_[n])) return false;
+	return true;
+}
+
+// Return combined signature of the contents of the specified layers
+quint64 DrawQueue::signature(int layerFlags)
+{
+	quint64 result = SIGNATURE_OFFSET;
+	for (int n=0; n<nLayers; ++n) if (layerFlags & (1 << n)) result = (result ^ layerSignatures_[n]) * SIGNATURE_PRIME;
+	return result;
+}
+
+/*
+ * Culling
+ */
+
+// Return whether item with the specified colour (if used), bounds (if known) and modelview matrix would not be seen
+bool DrawQueue::culled(DrawQueue::Layer layer, const GLfloat* colour, bool colourUsed, const Cuboid* bounds, const GLfloat* matrix)
+{
+	bool result = false;
+	if (colourUsed && (colour[3] <= 0.0f)) result = true;
+	else if (bounds && projectionSet_[layer] && bounds->isSet() && bounds->isOutsideView(matrix, projections_[layer])) result = true;
+
+	if (result) ++nCulled_[layer];
+	return result;
+}
+
+// Set projection against which items in specified layer are culled
+void DrawQueue::setProjection(DrawQueue::Layer layer, const GLfloat* projection)
+{
+	memcpy(projections_[layer], projection, 16*sizeof(GLfloat));
+	projectionSet_[layer] = true;
+}
+
+// Return number of items culled in specified layer in the current frame
+int DrawQueue::nCulled(DrawQueue::Layer layer)
+{
+	return nCulled_[layer];
+}
+
+/*
+ * Batches
+ */
+
+// Write item's vertices, transformed and coloured, to the stream at the specified vertex
+void DrawQueue::writeVertices(const DrawQueue::DrawItem& item, int firstVertex)
+{
+	const Primitive* primitive = item.primitive;
+	const GLfloat* data = primitive->vertexData();
+	const GLuint* indices = (primitive->hasIndices() ? primitive->indexData() : NULL);
+	int dataPerVertex = primitive->dataPerVertex();
+	bool colourData = primitive->hasColourData(), textureData = primitive->hasTextureCoordinateData();
+	const GLfloat* m = item.matrix;
+
+	GLfloat* target = stream_.data() + firstVertex*STREAM_VERTEX_SIZE;
+	for (int n=0; n<item.nStreamVertices; ++n, target += STREAM_VERTEX_SIZE)
+	{
+		const GLfloat* source = data + (indices ? indices[n] : n)*dataPerVertex;
+
+		// Texture coordinate
+		if (textureData)
+		{
+			target[0] = source[0];
+			target[1] = source[1];
+			source += 2;
+		}
+		else target[0] = target[1] = 0.0f;
+
+		// Colour - per-vertex colour takes precedence over that of the object, as with GL_COLOR_MATERIAL
+		if (colourData)
+		{
+			memcpy(&target[2], source, 4*sizeof(GLfloat));
+			source += 4;
+		}
+		else memcpy(&target[2], item.colour, 4*sizeof(GLfloat));
+
+		// Normal (rotated only - normalisation is left to GL)
+		target[6] = m[0]*source[0] + m[4]*source[1] + m[8]*source[2];
+		target[7] = m[1]*source[0] + m[5]*source[1] + m[9]*source[2];
+		target[8] = m[2]*source[0] + m[6]*source[1] + m[10]*source[2];
+
+		// Vertex
+		target[9] = m[0]*source[3] + m[4]*source[4] + m[8]*source[5] + m[12];
+		target[10] = m[1]*source[3] + m[5]*source[4] + m[9]*source[5] + m[13];
+		target[11] = m[2]*source[3] + m[6]*source[4] + m[10]*source[5] + m[14];
+	}
+}
+
+// Point vertex arrays at the stream
+void DrawQueue::bindStream()
+{
+	const GLfloat* base = (streamBuffer_ != 0 ? NULL : stream_.constData());
+	if (streamBuffer_ != 0) extensions_->glBindBuffer(GL_ARRAY_BUFFER, streamBuffer_);
+
+	// Stream vertices are already in eye space
+	GLfloat identity[16] = { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+	if (ShaderRenderer::active())
+	{
+		ShaderRenderer::setModelView(identity);
+		ShaderRenderer::setAttributes(base, true, true);
+	}
+	else
+	{
+		glLoadMatrixf(identity);
+		glInterleavedArrays(GL_T2F_C4F_N3F_V3F, 0, base);
+	}
+}
+
+// Disable vertex arrays pointing at the stream
+void DrawQueue::releaseStream()
+{
+	if (ShaderRenderer::active()) ShaderRenderer::clearAttributes(true, true);
+	else
+	{
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	}
+	if (streamBuffer_ != 0) extensions_->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Set modelview matrix and colour for an item drawn on its own
+void DrawQueue::setItemState(const DrawQueue::DrawItem& item)
+{
+	if (ShaderRenderer::active())
+	{
+		ShaderRenderer::setModelView(item.matrix);
+		ShaderRenderer::setColour(item.colour);
+	}
+	else
+	{
+		glLoadMatrixf(item.matrix);
+		glColor4fv(item.colour);
+	}
+}
+
+// Sort items, form batches and upload the stream, ready for submission (skipping items in the specified layers)
+void DrawQueue::prepare(GLExtensions* extensions, int skippedLayerFlags)
+{
+	extensions_ = extensions;
+	nBatches_ = 0;
+	nStreamVertices_ = 0;
+
+	// Items culled as they were added are counted even if nothing is left to draw
+	FrameProfiler::count(FrameProfiler::CulledBackgroundCounter, nCulled_[DrawQueue::BackgroundLayer]);
+	FrameProfiler::count(FrameProfiler::CulledPersistentCounter, nCulled_[DrawQueue::PersistentLayer]);
+	FrameProfiler::count(FrameProfiler::CulledForegroundCounter, nCulled_[DrawQueue::ForegroundLayer]);
+	if (nItems_ == 0) return;
+
+	sortEntries();
+
+	// Make sure the stream is large enough for all streamed items
+	int nVertices = 0;
+	for (int n=0; n<nItems_; ++n) nVertices += items_[n].nStreamVertices;
+	if (stream_.count() < nVertices*STREAM_VERTEX_SIZE) stream_.resize(nVertices*STREAM_VERTEX_SIZE);
+	if (batches_.count() < nItems_) batches_.resize(items_.count());
+
+	// Walk over items in key order, merging runs of streamed items with the same state into a single batch
+	const quint64 stateMask = ~(quint64(0xffffffff) << KEY_DEPTH_SHIFT);
+	const quint64 skippedLayers = skippedLayerFlags;
+	quint64 lastState = 0;
+	Batch* batch = NULL;
+	for (int n=0; n<nItems_; ++n)
+	{
+		const SortEntry& entry = sortEntries_[n];
+		const DrawItem& item = items_[entry.index];
+		quint64 state = entry.key & stateMask;
+
+		// Items in skipped layers (e.g. those drawn from a cache) need neither batches nor stream space
+		if (skippedLayers & (quint64(1) << (entry.key >> KEY_LAYER_SHIFT))) continue;
+
+		if ((item.nStreamVertices == 0) || (batch == NULL) || (!batch->streamed) || (state != lastState))
+		{
+			batch = &batches_[nBatches_++];
+			batch->layer = (Layer) (entry.key >> KEY_LAYER_SHIFT);
+			batch->streamed = (item.nStreamVertices > 0);
+			batch->type = (item.primitive ? item.primitive->type() : GL_TRIANGLES);
+			batch->texture = item.texture;
+			batch->blend = (BlendMode) ((entry.key >> KEY_BLEND_SHIFT) & 1);
+			batch->firstVertex = nStreamVertices_;
+			batch->nVertices = 0;
+			batch->item = entry.index;
+			lastState = state;
+		}
+
+		if (item.nStreamVertices == 0) continue;
+		writeVertices(item, nStreamVertices_);
+		batch->nVertices += item.nStreamVertices;
+		nStreamVertices_ += item.nStreamVertices;
+	}
+
+	// Upload stream in one go - the store is reallocated each frame, so the driver need not wait for the previous one to be drawn
+	if ((nStreamVertices_ > 0) && extensions_->hasVBO())
+	{
+		if (streamBuffer_ == 0) extensions_->glGenBuffers(1, &streamBuffer_);
+		extensions_->glBindBuffer(GL_ARRAY_BUFFER, streamBuffer_);
+		extensions_->glBufferData(GL_ARRAY_BUFFER, nStreamVertices_*STREAM_VERTEX_SIZE*sizeof(GLfloat), stream_.constData(), GL_STREAM_DRAW);
+		extensions_->glBindBuffer(GL_ARRAY_BUFFER, 0);
+		FrameProfiler::count(FrameProfiler::BufferUploadCounter);
+	}
+
+	FrameProfiler::count(FrameProfiler::DrawItemCounter, nItems_);
+	FrameProfiler::count(FrameProfiler::BatchCounter, nBatches_);
+}
+
+// Draw batches in specified layer
+void DrawQueue::submit(DrawQueue::Layer layer)
+{
+	bool streamBound = false;
+	GLuint boundTexture = 0;
+	for (int n=0; n<nBatches_; ++n)
+	{
+		const Batch& batch = batches_[n];
+		if (batch.layer != layer) continue;
+
+		// Overlays (e.g. glyph quads) don't write to the depth buffer, so that their transparent edges don't obscure each other
+		glDepthMask(batch.blend == DrawQueue::OverlayBlend ? GL_FALSE : GL_TRUE);
+
+		if (batch.streamed)
+		{
+			if (!streamBound)
+			{
+				bindStream();
+				streamBound = true;
+				boundTexture = 0;
+			}
+
+			// Bind texture if relevant
+			if ((batch.texture != 0) && (batch.texture != boundTexture))
+			{
+				glBindTexture(GL_TEXTURE_2D, batch.texture);
+				FrameProfiler::count(FrameProfiler::TextureBindCounter);
+				boundTexture = batch.texture;
+			}
+			if (ShaderRenderer::active()) ShaderRenderer::setSources(true, batch.texture != 0);
+			else if (batch.texture != 0) glEnable(GL_TEXTURE_2D);
+			else glDisable(GL_TEXTURE_2D);
+
+			glDrawArrays(batch.type, batch.firstVertex, batch.nVertices);
+			Primitive::countDrawCalls(1, batch.nVertices);
+		}
+		else
+		{
+			// Item is drawn on its own, using its own matrix and colour
+			if (streamBound)
+			{
+				releaseStream();
+				streamBound = false;
+			}
+			const DrawItem& item = items_[batch.item];
+			setItemState(item);
+			if (item.primitive) item.primitive->sendToGL();
+			else if (item.text) item.text->sendToGL();
+		}
+	}
+
+	if (streamBound) releaseStream();
+	glDepthMask(GL_TRUE);
+	glDisable(GL_TEXTURE_2D);
+}
+
+// Return number of batches formed
+int DrawQueue::nBatches()
+{
+	return nBatches_;
+}
+
+// Delete stream buffer (requires the context to be current)
+void DrawQueue::clearBuffers()
+{
+	if (streamBuffer_ != 0) extensions_->glDeleteBuffers(1, &streamBuffer_);
+	streamBuffer_ = 0;
+}
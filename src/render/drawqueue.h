@@ -0,0 +1,217 @@
+/*
+	*** Draw Queue
+	*** src/render/drawqueue.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_DRAWQUEUE_H
+#define QUAPP_DRAWQUEUE_H
+
+#ifndef __APPLE__
+#include <GL/gl.h>
+#else
+#include <OpenGL/gl3.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include "glext.h"
+#endif
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+
+// Forward Declarations
+class Cuboid;
+class GLExtensions;
+class Primitive;
+class TextPrimitive;
+
+/*!
+ * \brief Draw Queue
+ * \details Collects everything to be drawn in a frame as draw items, each keyed by (layer, depth, program, texture, blend).
+ * Items are radix-sorted on their keys, and runs of items sharing the same state are merged into batches whose vertices
+ * (transformed and coloured on the CPU) are written to a single stream uploaded once per frame. Each batch is then a
+ * single draw call. Items which cannot be merged (large or strip-type primitives, and FTGL text) are drawn on their own.
+ * A signature of each layer's contents is accumulated as items are added, so that unchanged layers may be drawn from a cache.
+ * Items which could not be seen (fully transparent, or lying outside their layer's view volume) are culled as they are added.
+ */
+class DrawQueue
+{
+	public:
+	// Constructor / Destructor
+	DrawQueue();
+	~DrawQueue();
+	// Layers, in the order in which they are drawn
+	enum Layer { BackgroundLayer, PersistentLayer, ForegroundLayer, nLayers };
+	// Layer flags, for selecting several layers at once
+	enum LayerFlag { BackgroundLayerFlag = 1, PersistentLayerFlag = 2, ForegroundLayerFlag = 4 };
+	// Programs through which items are drawn
+	enum Program { PrimitiveProgram, FixedFunctionProgram };
+	// Blend modes
+	enum BlendMode { AlphaBlend, OverlayBlend };
+
+	// Draw Item
+	struct DrawItem
+	{
+		// Primitive to draw (if any)
+		const Primitive* primitive;
+		// Text to draw through the fixed-function pipeline (if any)
+		const TextPrimitive* text;
+		// Modelview matrix (column-major)
+		GLfloat matrix[16];
+		// Object colour
+		GLfloat colour[4];
+		// Texture used by item
+		GLuint texture;
+		// Number of vertices written to the stream for the item (zero if it must be drawn on its own)
+		int nStreamVertices;
+	};
+	// Sort Entry
+	struct SortEntry
+	{
+		// Sort key
+		quint64 key;
+		// Index of item in queue
+		int index;
+	};
+	// Batch
+	struct Batch
+	{
+		// Layer in which the batch is drawn
+		Layer layer;
+		// Whether the batch is drawn from the stream (otherwise it is a single item drawn on its own)
+		bool streamed;
+		// Primitive type (GL)
+		GLenum type;
+		// Texture bound for batch
+		GLuint texture;
+		// Blend mode for batch
+		BlendMode blend;
+		// First vertex of batch in stream, and number of vertices
+		int firstVertex, nVertices;
+		// Index of item drawn (if not streamed)
+		int item;
+	};
+
+
+	/*
+	 * Items
+	 */
+	private:
+	// Items in queue (storage is kept between frames)
+	QVector<DrawItem> items_;
+	// Number of items currently in queue
+	int nItems_;
+	// Sort keys for items
+	QVector<SortEntry> sortEntries_, sortScratch_;
+	// Indices assigned to textures in the current frame (zero being no texture)
+	QHash<GLuint,int> textureIndices_;
+	// Maximum number of vertices a primitive may have for it to be written to the stream
+	static int maxStreamVertices_;
+	// Signatures of the contents of each layer, accumulated as items are added
+	quint64 layerSignatures_[nLayers];
+	// Whether the contents of each layer may be cached (i.e. are completely described by its signature, and are not animating)
+	bool layerCacheable_[nLayers];
+
+	private:
+	// Add new item to queue, returning it and its sort entry
+	DrawItem* addItem(Layer layer, const GLfloat* matrix, const GLfloat* colour, SortEntry*& entry);
+	// Fold data into signature of specified layer
+	void sign(Layer layer, const void* data, int nBytes);
+	// Return key for specified state (excluding depth)
+	quint64 stateKey(Layer layer, Program program, GLuint texture, BlendMode blend, GLenum type, bool streamed);
+	// Sort entries by key
+	void sortEntries();
+
+	public:
+	// Clear queue, ready for a new frame
+	void clear();
+	// Add primitive to queue
+	void addPrimitive(Layer layer, const Primitive* primitive, const GLfloat* matrix, const GLfloat* colour, BlendMode blend = DrawQueue::AlphaBlend);
+	// Add text to be drawn through the fixed-function pipeline
+	void addText(Layer layer, const TextPrimitive* text, const GLfloat* matrix, const GLfloat* colour);
+	// Return number of items in queue
+	int nItems();
+	// Flag that the specified layer should not be cached this frame
+	void setUncacheable(Layer layer);
+	// Return whether the specified layers may be cached
+	bool cacheable(int layerFlags);
+	// Return combined signature of the contents of the specified layers
+	quint64 signature(int layerFlags);
+
+
+	/*
+	 * Culling
+	 */
+	private:
+	// Projection matrices against which items in each layer are culled (column-major)
+	GLfloat projections_[nLayers][16];
+	// Whether a projection has been set for each layer (if not, items are culled on opacity alone)
+	bool projectionSet_[nLayers];
+	// Number of items culled in each layer in the current frame
+	int nCulled_[nLayers];
+
+	private:
+	// Return whether item with the specified colour (if used), bounds (if known) and modelview matrix would not be seen
+	bool culled(Layer layer, const GLfloat* colour, bool colourUsed, const Cuboid* bounds, const GLfloat* matrix);
+
+	public:
+	// Set projection against which items in specified layer are culled
+	void setProjection(Layer layer, const GLfloat* projection);
+	// Return number of items culled in specified layer in the current frame
+	int nCulled(Layer layer);
+
+
+	/*
+	 * Batches
+	 */
+	private:
+	// Batches formed from sorted items
+	QVector<Batch> batches_;
+	// Number of batches formed
+	int nBatches_;
+	// Stream of vertex data for merged batches (T2F_C4F_N3F_V3F)
+	QVector<GLfloat> stream_;
+	// Number of vertices in stream
+	int nStreamVertices_;
+	// GL extensions for the context in which the stream buffer lives
+	GLExtensions* extensions_;
+	// Buffer object holding stream (if VBOs are available)
+	GLuint streamBuffer_;
+
+	private:
+	// Write item's vertices, transformed and coloured, to the stream at the specified vertex
+	void writeVertices(const DrawItem& item, int firstVertex);
+	// Point vertex arrays at the stream
+	void bindStream();
+	// Disable vertex arrays pointing at the stream
+	void releaseStream();
+	// Set modelview matrix and colour for an item drawn on its own
+	void setItemState(const DrawItem& item);
+
+	public:
+	// Sort items, form batches and upload the stream, ready for submission (skipping items in the specified layers)
+	void prepare(GLExtensions* extensions, int skippedLayerFlags = 0);
+	// Draw batches in specified layer
+	void submit(Layer layer);
+	// Return number of batches formed
+	int nBatches();
+	// Delete stream buffer (requires the context to be current)
+	void clearBuffers();
+};
+
+#endif
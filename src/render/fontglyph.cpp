@@ -0,0 +1,136 @@
+/*
+	*** Font Glyph
+	*** src/render/fontglyph.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/fontglyph.h"
+
+// Constructor
+FontGlyph::FontGlyph() : ListItem<FontGlyph>()
+{
+	bold_ = false;
+	blank_ = true;
+	advance_ = 0.0;
+	x0_ = 0.0;
+	y0_ = 0.0;
+	x1_ = 0.0;
+	y1_ = 0.0;
+	s0_ = 0.0;
+	t0_ = 0.0;
+	s1_ = 0.0;
+	t1_ = 0.0;
+}
+
+// Destructor
+FontGlyph::~FontGlyph()
+{
+}
+
+/*
+ * Glyph Definition
+ */
+
+// Set glyph data
+void FontGlyph::set(QChar character, bool bold, bool blank, double advance, double x0, double y0, double x1, double y1, double s0, double t0, double s1, double t1)
+{
+	character_ = character;
+	bold_ = bold;
+	blank_ = blank;
+	advance_ = advance;
+	x0_ = x0;
+	y0_ = y0;
+	x1_ = x1;
+	y1_ = y1;
+	s0_ = s0;
+	t0_ = t0;
+	s1_ = s1;
+	t1_ = t1;
+}
+
+// Return character represented by glyph
+QChar FontGlyph::character()
+{
+	return character_;
+}
+
+// Return whether glyph is the bold variant of the character
+bool FontGlyph::bold()
+{
+	return bold_;
+}
+
+// Return whether glyph has no visible pixels
+bool FontGlyph::blank()
+{
+	return blank_;
+}
+
+// Return horizontal advance of glyph
+double FontGlyph::advance()
+{
+	return advance_;
+}
+
+// Return left extent of glyph quad
+double FontGlyph::x0()
+{
+	return x0_;
+}
+
+// Return bottom extent of glyph quad
+double FontGlyph::y0()
+{
+	return y0_;
+}
+
+// Return right extent of glyph quad
+double FontGlyph::x1()
+{
+	return x1_;
+}
+
+// Return top extent of glyph quad
+double FontGlyph::y1()
+{
+	return y1_;
+}
+
+// Return left texture coordinate of glyph quad
+double FontGlyph::s0()
+{
+	return s0_;
+}
+
+// Return bottom texture coordinate of glyph quad
+double FontGlyph::t0()
+{
+	return t0_;
+}
+
+// Return right texture coordinate of glyph quad
+double FontGlyph::s1()
+{
+	return s1_;
+}
+
+// Return top texture coordinate of glyph quad
+double FontGlyph::t1()
+{
+	return t1_;
+}
@@ -0,0 +1,86 @@
+/*
+	*** Font Glyph
+	*** src/render/fontglyph.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_FONTGLYPH_H
+#define QUAPP_FONTGLYPH_H
+
+#include "templates/list.h"
+#include <QtCore/QChar>
+
+// Forward Declarations
+/* none */
+
+// Font Glyph
+class FontGlyph : public ListItem<FontGlyph>
+{
+	public:
+	// Constructor / Destructor
+	FontGlyph();
+	~FontGlyph();
+
+
+	/*
+	 * Glyph Definition
+	 */
+	private:
+	// Character represented by glyph
+	QChar character_;
+	// Whether glyph is the bold variant of the character
+	bool bold_;
+	// Whether glyph has no visible pixels (e.g. whitespace)
+	bool blank_;
+	// Horizontal advance of glyph (in font units)
+	double advance_;
+	// Extents of glyph quad relative to the pen position (in font units)
+	double x0_, y0_, x1_, y1_;
+	// Texture coordinates of glyph quad in atlas
+	double s0_, t0_, s1_, t1_;
+
+	public:
+	// Set glyph data
+	void set(QChar character, bool bold, bool blank, double advance, double x0, double y0, double x1, double y1, double s0, double t0, double s1, double t1);
+	// Return character represented by glyph
+	QChar character();
+	// Return whether glyph is the bold variant of the character
+	bool bold();
+	// Return whether glyph has no visible pixels
+	bool blank();
+	// Return horizontal advance of glyph
+	double advance();
+	// Return left extent of glyph quad
+	double x0();
+	// Return bottom extent of glyph quad
+	double y0();
+	// Return right extent of glyph quad
+	double x1();
+	// Return top extent of glyph quad
+	double y1();
+	// Return left texture coordinate of glyph quad
+	double s0();
+	// Return bottom texture coordinate of glyph quad
+	double t0();
+	// Return right texture coordinate of glyph quad
+	double s1();
+	// Return top texture coordinate of glyph quad
+	double t1();
+};
+
+#endif
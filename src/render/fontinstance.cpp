@@ -21,6 +21,14 @@
 
 #include "render/fontinstance.h"
 #include "base/messenger.h"
+#include "render/frameprofiler.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QThread>
+#include <QtGui/QFontDatabase>
+#include <QtGui/QFontMetricsF>
+#include <QtGui/QPainter>
+#include <QtOpenGL/QGLWidget>
+#include <math.h>
 
 // Static Members
 QString FontInstance::fontFile_ = "";
@@ -28,10 +36,33 @@ FTFont* FontInstance::font_ = NULL;
 double FontInstance::fontBaseHeight_ = 0.0;
 double FontInstance::fontFullHeight_ = 0.0;
 double FontInstance::dotWidth_ = 0.0;
+QMutex FontInstance::mutex_;
+bool FontInstance::atlasOK_ = false;
+bool FontInstance::atlasFull_ = false;
+QImage FontInstance::atlasImage_;
+GLuint FontInstance::atlasTexture_ = 0;
+int FontInstance::atlasDirtyTop_ = 0;
+int FontInstance::atlasDirtyBottom_ = 0;
+QFont FontInstance::atlasFont_;
+QFont FontInstance::atlasBoldFont_;
+int FontInstance::atlasPixelSize_ = 64;
+int FontInstance::atlasX_ = 0;
+int FontInstance::atlasY_ = 0;
+int FontInstance::atlasRowHeight_ = 0;
+List<FontGlyph> FontInstance::glyphs_;
+QHash<uint,FontGlyph*> FontInstance::glyphHash_;
+
+// Return mutex serialising use of the font and glyph atlas (which text layout may do from a worker thread)
+QMutex& FontInstance::mutex()
+{
+	return mutex_;
+}
 
 // Setup font specified
 bool FontInstance::setupFont(QString fontName)
 {
+	QMutexLocker locker(&mutex_);
+
 	// If the current font is valid, and matches the name of the new font supplied, do nothing
 	if (font_ && (fontFile_ == fontName)) return true;
 
@@ -44,8 +75,6 @@ bool FontInstance::setupFont(QString fontName)
 	{
 		printf("Error generating font.\n");
 		delete newFont;
-		fontBaseHeight_ = 1.0;
-		return false;
 	}
 	else
 	{
@@ -57,21 +86,33 @@ bool FontInstance::setupFont(QString fontName)
 // 		font_->Depth(3.0);
 		font_->Outset(-.5, 1.5);
 		font_->FaceSize(1);
-		FTBBox boundingBox = font_->BBox("0123456789");
-		fontBaseHeight_ = boundingBox.Upper().Y() - boundingBox.Lower().Y();
-		boundingBox = font_->BBox("ABCDEfghijKLMNOpqrstUVWXYz");
-		fontFullHeight_ = boundingBox.Upper().Y() - boundingBox.Lower().Y();
-		boundingBox = font_->BBox("..");
+		FTBBox boundingBox = font_->BBox("..");
 		dotWidth_ = boundingBox.Upper().X() - boundingBox.Lower().X();
 	}
 
-	return (font_ != NULL);
+	// Create glyph atlas - if this fails, text will be rendered with the FTGL font instead
+	if (!createAtlas(fontName)) msg.print("Failed to create glyph atlas for font - text will be rendered as polygons.\n");
+
+	if (!fontOK())
+	{
+		fontBaseHeight_ = 1.0;
+		return false;
+	}
+
+	// Determine font heights
+	Vec3<double> lowerLeft, upperRight;
+	boundingBox("0123456789", lowerLeft, upperRight);
+	fontBaseHeight_ = upperRight.y - lowerLeft.y;
+	boundingBox("ABCDEfghijKLMNOpqrstUVWXYz", lowerLeft, upperRight);
+	fontFullHeight_ = upperRight.y - lowerLeft.y;
+
+	return true;
 }
 
 // Return whether font exists and is ready for use
 bool FontInstance::fontOK()
 {
-	return (font_ != NULL);
+	return (atlasOK_ || (font_ != NULL));
 }
 
 // Return current font
@@ -105,23 +146,240 @@ FTBBox FontInstance::boundingBox(QString text)
 }
 
 // Calculate bounding box for specified string
-void FontInstance::boundingBox(QString text, Vec3<double>& lowerLeft, Vec3<double>& upperRight)
+void FontInstance::boundingBox(QString text, Vec3<double>& lowerLeft, Vec3<double>& upperRight, bool bold)
 {
+	if (atlasOK_)
+	{
+		// Width is the sum of the glyph advances (so trailing spaces are accounted for), while height comes from the glyph extents
+		// Text with glyphs the atlas can't hold is rendered with the FTGL font, so is measured with it too
+		double width = 0.0, bottom = 0.0, top = 0.0;
+		bool first = true, complete = true;
+		FontGlyph* fontGlyph;
+		for (int n=0; n<text.length(); ++n)
+		{
+			fontGlyph = glyph(text.at(n), bold);
+			if (!fontGlyph)
+			{
+				complete = false;
+				continue;
+			}
+			width += fontGlyph->advance();
+			if (fontGlyph->blank()) continue;
+			if (first || (fontGlyph->y0() < bottom)) bottom = fontGlyph->y0();
+			if (first || (fontGlyph->y1() > top)) top = fontGlyph->y1();
+			first = false;
+		}
+		if (complete || (!font_))
+		{
+			lowerLeft.set(0.0, bottom, 0.0);
+			upperRight.set(width, top, 0.0);
+			return;
+		}
+	}
+
 	FTBBox box = boundingBox(text);
 	lowerLeft.set(box.Lower().X(), box.Lower().Y(), box.Lower().Z());
 	upperRight.set(box.Upper().X(), box.Upper().Y(), box.Upper().Z());
 }
 
 // Calculate bounding box width for specified string
-double FontInstance::boundingBoxWidth(QString text)
+double FontInstance::boundingBoxWidth(QString text, bool bold)
 {
-	FTBBox box = boundingBox(text);
-	return (box.Upper().X() - box.Lower().X());
+	Vec3<double> lowerLeft, upperRight;
+	boundingBox(text, lowerLeft, upperRight, bold);
+	return (upperRight.x - lowerLeft.x);
 }
 
 // Calculate bounding box height for specified string
-double FontInstance::boundingBoxHeight(QString text)
+double FontInstance::boundingBoxHeight(QString text, bool bold)
 {
-	FTBBox box = boundingBox(text);
-	return (box.Upper().Y() - box.Lower().Y());
+	Vec3<double> lowerLeft, upperRight;
+	boundingBox(text, lowerLeft, upperRight, bold);
+	return (upperRight.y - lowerLeft.y);
+}
+
+/*
+ * Glyph Atlas
+ */
+
+// Create glyph atlas for specified font file
+bool FontInstance::createAtlas(QString fontName)
+{
+	// Clear any existing atlas
+	atlasOK_ = false;
+	atlasFull_ = false;
+	glyphs_.clear();
+	glyphHash_.clear();
+	atlasX_ = 0;
+	atlasY_ = 0;
+	atlasRowHeight_ = 0;
+
+	// Register the font file with Qt so that we can rasterise its glyphs
+	int fontId = QFontDatabase::addApplicationFont(fontName);
+	if (fontId == -1) return false;
+	QStringList families = QFontDatabase::applicationFontFamilies(fontId);
+	if (families.count() == 0) return false;
+
+	atlasFont_ = QFont(families.at(0));
+	atlasFont_.setPixelSize(atlasPixelSize_);
+	atlasFont_.setStyleStrategy(QFont::PreferAntialias);
+	atlasBoldFont_ = atlasFont_;
+	atlasBoldFont_.setBold(true);
+
+	// Create (transparent) atlas image
+	atlasImage_ = QImage(2048, 2048, QImage::Format_ARGB32_Premultiplied);
+	if (atlasImage_.isNull()) return false;
+	atlasImage_.fill(0);
+	atlasOK_ = true;
+
+	// Any existing texture is reused, but must be uploaded again in full
+	atlasDirtyTop_ = 0;
+	atlasDirtyBottom_ = atlasImage_.height();
+
+	// Rasterise printable ASCII characters now - anything else will be added when first requested
+	for (int n=32; n<127; ++n)
+	{
+		rasteriseGlyph(QChar(n), false);
+		rasteriseGlyph(QChar(n), true);
+	}
+
+	return true;
+}
+
+// Rasterise glyph into atlas
+FontGlyph* FontInstance::rasteriseGlyph(QChar character, bool bold)
+{
+	const int padding = 4;
+	QFont& font = (bold ? atlasBoldFont_ : atlasFont_);
+	QFontMetricsF metrics(font);
+	QRectF rect = metrics.boundingRect(character);
+	double scale = 1.0 / atlasPixelSize_;
+
+	// If the glyph has no visible pixels, there is nothing to rasterise
+	FontGlyph* fontGlyph;
+	if (rect.isEmpty())
+	{
+		fontGlyph = glyphs_.add();
+		glyphHash_.insert((character.unicode() << 1) + (bold ? 1 : 0), fontGlyph);
+		fontGlyph->set(character, bold, true, metrics.width(character)*scale, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+		return fontGlyph;
+	}
+
+	// Determine size of glyph cell (including padding to prevent bleeding between neighbouring glyphs)
+	int width = int(ceil(rect.width())) + 2*padding;
+	int height = int(ceil(rect.height())) + 2*padding;
+
+	// Move to the next row of the atlas if the glyph won't fit on the current one
+	if ((atlasX_ + width) > atlasImage_.width())
+	{
+		atlasX_ = 0;
+		atlasY_ += atlasRowHeight_;
+		atlasRowHeight_ = 0;
+	}
+	if ((atlasY_ + height) > atlasImage_.height())
+	{
+		printf("Warning: Glyph atlas is full - text containing characters not already in it will be rendered as polygons.\n");
+		atlasFull_ = true;
+		return NULL;
+	}
+
+	// Draw the glyph (in white, so it can be coloured when rendered)
+	QPainter painter(&atlasImage_);
+	painter.setRenderHint(QPainter::TextAntialiasing);
+	painter.setFont(font);
+	painter.setPen(Qt::white);
+	painter.drawText(QPointF(atlasX_ + padding - rect.left(), atlasY_ + padding - rect.top()), QString(character));
+	painter.end();
+
+	// Note the rows changed, so that only these need to be uploaded
+	if (atlasDirtyTop_ == atlasDirtyBottom_) atlasDirtyTop_ = atlasY_;
+	else atlasDirtyTop_ = qMin(atlasDirtyTop_, atlasY_);
+	atlasDirtyBottom_ = qMax(atlasDirtyBottom_, atlasY_ + height);
+
+	// Add glyph to list and hash, storing its extents (in font units, relative to the pen position) and texture coordinates
+	// Texture coordinates are flipped vertically, since the atlas is inverted when bound as a texture
+	double x0 = (rect.left() - padding) * scale;
+	double y1 = (padding - rect.top()) * scale;
+	double w = atlasImage_.width(), h = atlasImage_.height();
+	fontGlyph = glyphs_.add();
+	glyphHash_.insert((character.unicode() << 1) + (bold ? 1 : 0), fontGlyph);
+	fontGlyph->set(character, bold, false, metrics.width(character)*scale, x0, y1 - height*scale, x0 + width*scale, y1, atlasX_/w, 1.0 - (atlasY_+height)/h, (atlasX_+width)/w, 1.0 - atlasY_/h);
+
+	// Move insertion point
+	atlasX_ += width;
+	if (height > atlasRowHeight_) atlasRowHeight_ = height;
+
+	return fontGlyph;
+}
+
+// Return whether glyph atlas is available
+bool FontInstance::atlasOK()
+{
+	return atlasOK_;
+}
+
+// Upload any glyphs rasterised since the atlas was last uploaded, creating its texture if necessary (requires a current GL context)
+void FontInstance::uploadAtlas()
+{
+	if (!atlasOK_) return;
+
+	QMutexLocker locker(&mutex_);
+	if ((atlasTexture_ != 0) && (atlasDirtyTop_ == atlasDirtyBottom_)) return;
+
+	// The texture is created empty, and filled in by uploading the changed rows - these are flipped, as the whole atlas is when bound
+	if (atlasTexture_ == 0)
+	{
+		glGenTextures(1, &atlasTexture_);
+		glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlasImage_.width(), atlasImage_.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		atlasDirtyTop_ = 0;
+		atlasDirtyBottom_ = atlasImage_.height();
+	}
+	else glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+	FrameProfiler::count(FrameProfiler::TextureBindCounter);
+
+	QImage rows = QGLWidget::convertToGLFormat(atlasImage_.copy(0, atlasDirtyTop_, atlasImage_.width(), atlasDirtyBottom_ - atlasDirtyTop_));
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, atlasImage_.height() - atlasDirtyBottom_, rows.width(), rows.height(), GL_RGBA, GL_UNSIGNED_BYTE, rows.bits());
+	glBindTexture(GL_TEXTURE_2D, 0);
+	atlasDirtyTop_ = atlasDirtyBottom_ = 0;
+}
+
+// Return texture object holding the atlas (zero until it has first been uploaded)
+GLuint FontInstance::atlasTexture()
+{
+	return atlasTexture_;
+}
+
+// Return glyph for specified character, rasterising it if necessary (or NULL if it is not available from the atlas)
+FontGlyph* FontInstance::glyph(QChar character, bool bold)
+{
+	if (!atlasOK_) return NULL;
+
+	FontGlyph* fontGlyph = glyphHash_.value((character.unicode() << 1) + (bold ? 1 : 0), NULL);
+	if (fontGlyph || atlasFull_) return fontGlyph;
+
+	// Some platforms (e.g. X11) can only rasterise text in the GUI thread - glyphs needed elsewhere must be prepared beforehand
+	if ((!QFontDatabase::supportsThreadedFontRendering()) && QCoreApplication::instance() && (QThread::currentThread() != QCoreApplication::instance()->thread()))
+	{
+		printf("Warning: Glyph for character '%s' was not prepared before use outside the GUI thread, and will not be rendered.\n", qPrintable(QString(character)));
+		return NULL;
+	}
+
+	return rasteriseGlyph(character, bold);
+}
+
+// Rasterise any characters of specified text which are not yet in the atlas, in both weights
+void FontInstance::prepareGlyphs(QString text)
+{
+	if (!atlasOK_) return;
+
+	QMutexLocker locker(&mutex_);
+	for (int n=0; n<text.length(); ++n)
+	{
+		glyph(text.at(n), false);
+		glyph(text.at(n), true);
+	}
 }
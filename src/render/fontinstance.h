@@ -22,9 +22,15 @@
 #ifndef QUAPP_FONTINSTANCE_H
 #define QUAPP_FONTINSTANCE_H
 
+#include "render/fontglyph.h"
 #include "templates/vector3.h"
+#include "templates/list.h"
 #include <FTGL/ftgl.h>
 #include <QtCore/QString>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtGui/QFont>
+#include <QtGui/QImage>
 
 // Forward Declarations
 /* none */
@@ -43,8 +49,12 @@ class FontInstance
 	static double fontBaseHeight_;
 	// Width of double dot (used for correction of width of strings with trailing spaces)
 	static double dotWidth_;
+	// Mutex serialising use of the font and glyph atlas
+	static QMutex mutex_;
 
 	public:
+	// Return mutex serialising use of the font and glyph atlas (which text layout may do from a worker thread)
+	static QMutex& mutex();
 	// Setup font specified
 	static bool setupFont(QString fontName);
 	// Return whether font exists and is ready for use
@@ -58,11 +68,55 @@ class FontInstance
 	// Return bounding box for specified string
 	static FTBBox boundingBox(QString text);
 	// Calculate bounding box for specified string
-	static void boundingBox(QString text, Vec3<double>& lowerLeft, Vec3<double>& upperRight);
+	static void boundingBox(QString text, Vec3<double>& lowerLeft, Vec3<double>& upperRight, bool bold = false);
 	// Calculate bounding box width for specified string
-	static double boundingBoxWidth(QString text);
+	static double boundingBoxWidth(QString text, bool bold = false);
 	// Calculate bounding box height for specified string
-	static double boundingBoxHeight(QString text);
+	static double boundingBoxHeight(QString text, bool bold = false);
+
+
+	/*
+	 * Glyph Atlas
+	 */
+	private:
+	// Whether the glyph atlas was successfully created
+	static bool atlasOK_;
+	// Whether the glyph atlas has no room for further glyphs
+	static bool atlasFull_;
+	// Image containing rasterised glyphs
+	static QImage atlasImage_;
+	// Texture object holding the atlas, shared by all text primitives (zero until first uploaded)
+	static GLuint atlasTexture_;
+	// Range of rows of the atlas image changed since it was last uploaded (empty if top and bottom are equal)
+	static int atlasDirtyTop_, atlasDirtyBottom_;
+	// Fonts used when rasterising normal and bold glyphs
+	static QFont atlasFont_, atlasBoldFont_;
+	// Pixel size of em square in atlas
+	static int atlasPixelSize_;
+	// Current insertion position and row height in atlas
+	static int atlasX_, atlasY_, atlasRowHeight_;
+	// List of glyphs in atlas
+	static List<FontGlyph> glyphs_;
+	// Hash of glyphs in atlas, keyed by character and style
+	static QHash<uint,FontGlyph*> glyphHash_;
+
+	private:
+	// Create glyph atlas for specified font file
+	static bool createAtlas(QString fontName);
+	// Rasterise glyph into atlas
+	static FontGlyph* rasteriseGlyph(QChar character, bool bold);
+
+	public:
+	// Return whether glyph atlas is available
+	static bool atlasOK();
+	// Upload any glyphs rasterised since the atlas was last uploaded, creating its texture if necessary (requires a current GL context)
+	static void uploadAtlas();
+	// Return texture object holding the atlas (zero until it has first been uploaded)
+	static GLuint atlasTexture();
+	// Return glyph for specified character, rasterising it if necessary (or NULL if it is not available from the atlas)
+	static FontGlyph* glyph(QChar character, bool bold);
+	// Rasterise any characters of specified text which are not yet in the atlas, in both weights
+	static void prepareGlyphs(QString text);
 };
 
 #endif
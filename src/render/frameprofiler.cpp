@@ -0,0 +1,239 @@
+/*
+	*** Frame Profiler
+	*** src/render/frameprofiler.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/frameprofiler.h"
+#include "base/lineparser.h"
+#include "base/messenger.h"
+#include <string.h>
+
+// Timer Keywords
+const char* FrameProfilerTimerKeywords[] = { "updateObjects", "updateBackground", "paint", "paintBackground", "paintPersistent", "paintForeground" };
+
+// Convert Timer to text string
+const char* FrameProfiler::timer(FrameProfiler::Timer id)
+{
+	return FrameProfilerTimerKeywords[id];
+}
+
+// Counter Keywords
+const char* FrameProfilerCounterKeywords[] = { "drawCalls", "textureBinds", "bufferUploads", "vertices", "drawItems", "batches", "transforming", "deleted", "cachedLayers", "cacheRedraws", "culledBackground", "culledPersistent", "culledForeground" };
+
+// Convert Counter to text string
+const char* FrameProfiler::counter(FrameProfiler::Counter id)
+{
+	return FrameProfilerCounterKeywords[id];
+}
+
+// Static Members
+QElapsedTimer FrameProfiler::clock_;
+qint64 FrameProfiler::startTimes_[FrameProfiler::nTimers];
+qint64 FrameProfiler::lastFrameEnd_ = -1;
+FrameProfiler::Frame FrameProfiler::current_;
+QVector<FrameProfiler::Frame> FrameProfiler::frames_(600);
+int FrameProfiler::nextFrame_ = 0;
+int FrameProfiler::nFrames_ = 0;
+bool FrameProfiler::overlay_ = false;
+
+/*
+ * Recording
+ */
+
+// Set number of frames to keep (zero to disable recording)
+void FrameProfiler::setHistoryLength(int nFrames)
+{
+	frames_.resize(qMax(0, nFrames));
+	clear();
+}
+
+// Return number of frames to keep
+int FrameProfiler::historyLength()
+{
+	return frames_.count();
+}
+
+// Mark start of timed section
+void FrameProfiler::startTimer(FrameProfiler::Timer id)
+{
+	if (frames_.count() == 0) return;
+	if (!clock_.isValid()) clock_.start();
+
+	startTimes_[id] = clock_.nsecsElapsed();
+}
+
+// Mark end of timed section
+void FrameProfiler::stopTimer(FrameProfiler::Timer id)
+{
+	if (frames_.count() == 0) return;
+
+	// Sections may be entered more than once per frame, so accumulate
+	current_.times[id] += (clock_.nsecsElapsed() - startTimes_[id]) * 1.0e-6;
+}
+
+// Register event(s)
+void FrameProfiler::count(FrameProfiler::Counter id, int n)
+{
+	current_.counts[id] += n;
+}
+
+// Finish current frame, storing it in the ring buffer
+void FrameProfiler::endFrame()
+{
+	if (frames_.count() != 0)
+	{
+		if (!clock_.isValid()) clock_.start();
+		qint64 now = clock_.nsecsElapsed();
+		current_.interval = (lastFrameEnd_ < 0 ? 0.0 : (now - lastFrameEnd_) * 1.0e-6);
+		lastFrameEnd_ = now;
+
+		frames_[nextFrame_] = current_;
+		nextFrame_ = (nextFrame_+1) % frames_.count();
+		if (nFrames_ < frames_.count()) ++nFrames_;
+	}
+
+	memset(&current_, 0, sizeof(Frame));
+}
+
+// Discard all recorded frames
+void FrameProfiler::clear()
+{
+	memset(&current_, 0, sizeof(Frame));
+	nextFrame_ = 0;
+	nFrames_ = 0;
+	lastFrameEnd_ = -1;
+}
+
+// Return number of recorded frames
+int FrameProfiler::nFrames()
+{
+	return nFrames_;
+}
+
+// Return recorded frame specified, oldest first
+const FrameProfiler::Frame& FrameProfiler::frame(int n)
+{
+	int index = (nextFrame_ - nFrames_ + n + frames_.count()) % frames_.count();
+	return frames_.at(index);
+}
+
+/*
+ * Output
+ */
+
+// Set whether the summary overlay is shown on the display
+void FrameProfiler::setOverlay(bool overlay)
+{
+	overlay_ = overlay;
+}
+
+// Return whether the summary overlay is shown on the display
+bool FrameProfiler::overlay()
+{
+	return overlay_;
+}
+
+// Return summary of recorded frames as lines of text
+QStringList FrameProfiler::summary()
+{
+	QStringList lines;
+	if (nFrames_ == 0)
+	{
+		lines << "No frames recorded";
+		return lines;
+	}
+
+	// Average times over all recorded frames, and find the longest interval
+	double meanTimes[nTimers], meanInterval = 0.0, maxInterval = 0.0;
+	for (int t=0; t<nTimers; ++t) meanTimes[t] = 0.0;
+	for (int n=0; n<nFrames_; ++n)
+	{
+		const Frame& record = frame(n);
+		for (int t=0; t<nTimers; ++t) meanTimes[t] += record.times[t];
+		meanInterval += record.interval;
+		if (record.interval > maxInterval) maxInterval = record.interval;
+	}
+	for (int t=0; t<nTimers; ++t) meanTimes[t] /= nFrames_;
+	meanInterval /= nFrames_;
+
+	// Counts are shown for the most recent frame
+	const Frame& last = frame(nFrames_-1);
+	lines << QString("Frame %1 ms (max %2 ms over %3 frames)").arg(meanInterval, 0, 'f', 2).arg(maxInterval, 0, 'f', 2).arg(nFrames_);
+	lines << QString("Update %1 ms, background %2 ms").arg(meanTimes[UpdateObjectsTimer], 0, 'f', 2).arg(meanTimes[UpdateBackgroundTimer], 0, 'f', 2);
+	lines << QString("Paint %1 ms (background %2, persistent %3, foreground %4)").arg(meanTimes[PaintTimer], 0, 'f', 2).arg(meanTimes[PaintBackgroundTimer], 0, 'f', 2).arg(meanTimes[PaintPersistentTimer], 0, 'f', 2).arg(meanTimes[PaintForegroundTimer], 0, 'f', 2);
+	lines << QString("Draw calls %1, texture binds %2, uploads %3, vertices %4").arg(last.counts[DrawCallCounter]).arg(last.counts[TextureBindCounter]).arg(last.counts[BufferUploadCounter]).arg(last.counts[VertexCounter]);
+	lines << QString("Draw items %1, merged into %2 batches").arg(last.counts[DrawItemCounter]).arg(last.counts[BatchCounter]);
+	lines << QString("Objects transforming %1, deleted %2").arg(last.counts[TransformingCounter]).arg(last.counts[DeletedCounter]);
+	lines << QString("Layers drawn from cache %1, cache redraws %2").arg(last.counts[CachedLayerCounter]).arg(last.counts[CacheRedrawCounter]);
+	lines << QString("Items culled - background %1, persistent %2, foreground %3").arg(last.counts[CulledBackgroundCounter]).arg(last.counts[CulledPersistentCounter]).arg(last.counts[CulledForegroundCounter]);
+
+	return lines;
+}
+
+// Export recorded frames to specified file, as JSON if the name ends in '.json', or CSV otherwise
+bool FrameProfiler::exportFrames(QString fileName)
+{
+	LineParser parser(fileName, true);
+	if (!parser.ready())
+	{
+		msg.print("Error: Couldn't open file '%s' for frame profile export.\n", qPrintable(fileName));
+		return false;
+	}
+
+	bool json = fileName.endsWith(".json", Qt::CaseInsensitive);
+	int n, t, c;
+
+	// Header
+	if (json) parser.writeLineF("{\n  \"frames\": [\n");
+	else
+	{
+		parser.writeLineF("frame,interval");
+		for (t=0; t<nTimers; ++t) parser.writeLineF(",%s", timer((Timer) t));
+		for (c=0; c<nCounters; ++c) parser.writeLineF(",%s", counter((Counter) c));
+		parser.writeLineF("\n");
+	}
+
+	// Frames, oldest first
+	for (n=0; n<nFrames_; ++n)
+	{
+		const Frame& record = frame(n);
+		if (json)
+		{
+			parser.writeLineF("    { \"frame\": %i, \"interval\": %.4f", n, record.interval);
+			for (t=0; t<nTimers; ++t) parser.writeLineF(", \"%s\": %.4f", timer((Timer) t), record.times[t]);
+			for (c=0; c<nCounters; ++c) parser.writeLineF(", \"%s\": %i", counter((Counter) c), record.counts[c]);
+			parser.writeLineF(" }%s\n", n < nFrames_-1 ? "," : "");
+		}
+		else
+		{
+			parser.writeLineF("%i,%.4f", n, record.interval);
+			for (t=0; t<nTimers; ++t) parser.writeLineF(",%.4f", record.times[t]);
+			for (c=0; c<nCounters; ++c) parser.writeLineF(",%i", record.counts[c]);
+			parser.writeLineF("\n");
+		}
+	}
+
+	if (json) parser.writeLineF("  ]\n}\n");
+
+	parser.closeFiles();
+
+	msg.print("Exported %i frame(s) to '%s'.\n", nFrames_, qPrintable(fileName));
+
+	return true;
+}
@@ -0,0 +1,121 @@
+/*
+	*** Frame Profiler
+	*** src/render/frameprofiler.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_FRAMEPROFILER_H
+#define QUAPP_FRAMEPROFILER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+// Forward Declarations
+/* none */
+
+/*!
+ * \brief Frame Profiler
+ * \details Records, for each displayed frame, the time spent in the main update and paint stages along with counts of GL work
+ * submitted. The last historyLength() frames are kept in a ring buffer, which may be summarised on the display or exported.
+ * Paint times are the CPU time taken to submit each layer, since GL itself runs asynchronously.
+ */
+class FrameProfiler
+{
+	public:
+	// Timed Sections
+	enum Timer { UpdateObjectsTimer, UpdateBackgroundTimer, PaintTimer, PaintBackgroundTimer, PaintPersistentTimer, PaintForegroundTimer, nTimers };
+	// Convert Timer to text string
+	static const char* timer(Timer id);
+	// Counted Events
+	enum Counter { DrawCallCounter, TextureBindCounter, BufferUploadCounter, VertexCounter, DrawItemCounter, BatchCounter, TransformingCounter, DeletedCounter, CachedLayerCounter, CacheRedrawCounter, CulledBackgroundCounter, CulledPersistentCounter, CulledForegroundCounter, nCounters };
+	// Convert Counter to text string
+	static const char* counter(Counter id);
+
+	// Frame Record
+	struct Frame
+	{
+		// Interval since the previous frame ended (in ms)
+		double interval;
+		// Time spent in each section (in ms)
+		double times[nTimers];
+		// Number of each event
+		int counts[nCounters];
+	};
+
+
+	/*
+	 * Recording
+	 */
+	private:
+	// Timer from which all section times are derived
+	static QElapsedTimer clock_;
+	// Start times of sections in progress (in ns)
+	static qint64 startTimes_[nTimers];
+	// Time at which the last frame ended (in ns)
+	static qint64 lastFrameEnd_;
+	// Frame currently being recorded
+	static Frame current_;
+	// Ring buffer of recorded frames
+	static QVector<Frame> frames_;
+	// Index in ring buffer at which the next frame will be stored
+	static int nextFrame_;
+	// Number of frames currently held in the ring buffer
+	static int nFrames_;
+
+	public:
+	// Set number of frames to keep (zero to disable recording)
+	static void setHistoryLength(int nFrames);
+	// Return number of frames to keep
+	static int historyLength();
+	// Mark start of timed section
+	static void startTimer(Timer id);
+	// Mark end of timed section
+	static void stopTimer(Timer id);
+	// Register event(s)
+	static void count(Counter id, int n = 1);
+	// Finish current frame, storing it in the ring buffer
+	static void endFrame();
+	// Discard all recorded frames
+	static void clear();
+	// Return number of recorded frames
+	static int nFrames();
+	// Return recorded frame specified, oldest first
+	static const Frame& frame(int n);
+
+
+	/*
+	 * Output
+	 */
+	private:
+	// Whether the summary overlay is shown on the display
+	static bool overlay_;
+
+	public:
+	// Set whether the summary overlay is shown on the display
+	static void setOverlay(bool overlay);
+	// Return whether the summary overlay is shown on the display
+	static bool overlay();
+	// Return summary of recorded frames as lines of text
+	static QStringList summary();
+	// Export recorded frames to specified file, as JSON if the name ends in '.json', or CSV otherwise
+	static bool exportFrames(QString fileName);
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*
+	*** Frame Write Job
+	*** src/render/framewritejob.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/framewritejob.h"
+#include "base/tracer.h"
+#include <QtCore/QSemaphore>
+#include <stdio.h>
+
+// Constructor
+FrameWriteJob::FrameWriteJob(const QImage& image, QString fileName, QSemaphore* queueSlots) : QRunnable()
+{
+	image_ = image;
+	fileName_ = fileName;
+	queueSlots_ = queueSlots;
+
+	// Nothing needs to be collected from the job, so it may be deleted by the thread pool as soon as it finishes
+	setAutoDelete(true);
+}
+
+// Destructor
+FrameWriteJob::~FrameWriteJob()
+{
+}
+
+/*
+ * Execution
+ */
+
+// Encode and write image (called from worker thread)
+void FrameWriteJob::run()
+{
+	TRACESPAN("FrameWriteJob::run");
+
+	if (!image_.save(fileName_, "PNG")) printf("Error: Failed to write frame '%s'.\n", qPrintable(fileName_));
+
+	// Free the image data before releasing our slot, so that memory held by queued frames really is limited
+	image_ = QImage();
+	if (queueSlots_) queueSlots_->release();
+}
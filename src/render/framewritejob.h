@@ -0,0 +1,61 @@
+/*
+	*** Frame Write Job
+	*** src/render/framewritejob.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_FRAMEWRITEJOB_H
+#define QUAPP_FRAMEWRITEJOB_H
+
+#include <QtCore/QRunnable>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+// Forward Declarations
+class QSemaphore;
+
+// Frame Write Job
+class FrameWriteJob : public QRunnable
+{
+	public:
+	// Constructor / Destructor
+	FrameWriteJob(const QImage& image, QString fileName, QSemaphore* queueSlots);
+	~FrameWriteJob();
+
+
+	/*
+	 * Job Data
+	 */
+	private:
+	// Image to write
+	QImage image_;
+	// Filename to write to
+	QString fileName_;
+	// Semaphore limiting the number of frames waiting to be written (released when the job finishes)
+	QSemaphore* queueSlots_;
+
+
+	/*
+	 * Execution
+	 */
+	public:
+	// Encode and write image (called from worker thread)
+	void run();
+};
+
+#endif
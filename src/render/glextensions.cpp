@@ -55,11 +55,31 @@ GLExtensions::GLExtensions() : ListItem<GLExtensions>()
 	glBufferSubData = NULL;
 	glDeleteBuffers = NULL;
 
+	// Pixel Buffers
+	glMapBuffer = NULL;
+	glUnmapBuffer = NULL;
+
+	// Instancing
+	glVertexAttribDivisor = NULL;
+	glDrawArraysInstanced = NULL;
+
+	// Vertex Array Objects
+	glGenVertexArrays = NULL;
+	glBindVertexArray = NULL;
+	glDeleteVertexArrays = NULL;
+
+	// Blending
+	glBlendFuncSeparate = NULL;
+
 	// Query OpenGL Extensions and set features
 	const GLubyte* glexts = NULL;
 	glexts = glGetString(GL_EXTENSIONS);
 	hasVBO_ = (strstr((const char*)glexts, "GL_ARB_vertex_buffer_object") != NULL);
 	hasQueries_ = (strstr((const char*)glexts, "GL_ARB_timer_query") != NULL);
+	hasPixelBuffers_ = (strstr((const char*)glexts, "GL_ARB_pixel_buffer_object") != NULL);
+	hasInstancing_ = (strstr((const char*)glexts, "GL_ARB_instanced_arrays") != NULL) && (strstr((const char*)glexts, "GL_ARB_draw_instanced") != NULL);
+	hasVertexArrays_ = (strstr((const char*)glexts, "GL_ARB_vertex_array_object") != NULL);
+	hasBlendFuncSeparate_ = (strstr((const char*)glexts, "GL_EXT_blend_func_separate") != NULL);
 
 	// Grab GL function pointers
 #ifdef _WIN32
@@ -75,6 +95,18 @@ GLExtensions::GLExtensions() : ListItem<GLExtensions>()
 	glBufferData = (PFNGLBUFFERDATAPROC) wglGetProcAddress("glBufferData");
 	glBufferSubData = (PFNGLBUFFERSUBDATAPROC) wglGetProcAddress("glBufferSubData");
 	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC) wglGetProcAddress("glDeleteBuffers");
+	// Pixel Buffers
+	glMapBuffer = (PFNGLMAPBUFFERPROC) wglGetProcAddress("glMapBuffer");
+	glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) wglGetProcAddress("glUnmapBuffer");
+	// Instancing
+	glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORARBPROC) wglGetProcAddress("glVertexAttribDivisorARB");
+	glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDARBPROC) wglGetProcAddress("glDrawArraysInstancedARB");
+	// Vertex Array Objects
+	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) wglGetProcAddress("glGenVertexArrays");
+	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC) wglGetProcAddress("glBindVertexArray");
+	glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC) wglGetProcAddress("glDeleteVertexArrays");
+	// Blending
+	glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC) wglGetProcAddress("glBlendFuncSeparate");
 #elif __APPLE__
 	// Queries
 	glBeginQuery = (PFNGLBEGINQUERYPROC) osxglGetProcAddress("glBeginQuery");
@@ -88,6 +120,18 @@ GLExtensions::GLExtensions() : ListItem<GLExtensions>()
 	glBufferData = (PFNGLBUFFERDATAPROC) osxglGetProcAddress("glBufferData");
 	glBufferSubData = (PFNGLBUFFERSUBDATAPROC) osxglGetProcAddress("glBufferSubData");
 	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC) osxglGetProcAddress("glDeleteBuffers");
+	// Pixel Buffers
+	glMapBuffer = (PFNGLMAPBUFFERPROC) osxglGetProcAddress("glMapBuffer");
+	glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) osxglGetProcAddress("glUnmapBuffer");
+	// Instancing
+	glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORARBPROC) osxglGetProcAddress("glVertexAttribDivisorARB");
+	glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDARBPROC) osxglGetProcAddress("glDrawArraysInstancedARB");
+	// Vertex Array Objects
+	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) osxglGetProcAddress("glGenVertexArrays");
+	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC) osxglGetProcAddress("glBindVertexArray");
+	glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC) osxglGetProcAddress("glDeleteVertexArrays");
+	// Blending
+	glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC) osxglGetProcAddress("glBlendFuncSeparate");
 #else
 	// Queries
 	glBeginQuery = (PFNGLBEGINQUERYPROC) glXGetProcAddress((const GLubyte*) "glBeginQuery");
@@ -101,6 +145,18 @@ GLExtensions::GLExtensions() : ListItem<GLExtensions>()
 	glBufferData = (PFNGLBUFFERDATAPROC) glXGetProcAddress((const GLubyte*) "glBufferData");
 	glBufferSubData = (PFNGLBUFFERSUBDATAPROC) glXGetProcAddress((const GLubyte*) "glBufferSubData");
 	glDeleteBuffers = (PFNGLDELETEBUFFERSPROC) glXGetProcAddress((const GLubyte*) "glDeleteBuffers");
+	// Pixel Buffers
+	glMapBuffer = (PFNGLMAPBUFFERPROC) glXGetProcAddress((const GLubyte*) "glMapBuffer");
+	glUnmapBuffer = (PFNGLUNMAPBUFFERPROC) glXGetProcAddress((const GLubyte*) "glUnmapBuffer");
+	// Instancing
+	glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORARBPROC) glXGetProcAddress((const GLubyte*) "glVertexAttribDivisorARB");
+	glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDARBPROC) glXGetProcAddress((const GLubyte*) "glDrawArraysInstancedARB");
+	// Vertex Array Objects
+	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC) glXGetProcAddress((const GLubyte*) "glGenVertexArrays");
+	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC) glXGetProcAddress((const GLubyte*) "glBindVertexArray");
+	glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC) glXGetProcAddress((const GLubyte*) "glDeleteVertexArrays");
+	// Blending
+	glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC) glXGetProcAddress((const GLubyte*) "glBlendFuncSeparate");
 #endif
 }
 
@@ -115,3 +171,27 @@ bool GLExtensions::hasVBO()
 {
 	return hasVBO_;
 }
+
+// Return whether we have the pixel buffer object extension (and the VBO functions it relies on)
+bool GLExtensions::hasPixelBuffers()
+{
+	return hasPixelBuffers_ && hasVBO_ && (glMapBuffer != NULL) && (glUnmapBuffer != NULL);
+}
+
+// Return whether we have the instanced arrays and instanced drawing extensions
+bool GLExtensions::hasInstancing()
+{
+	return hasInstancing_ && (glVertexAttribDivisor != NULL) && (glDrawArraysInstanced != NULL);
+}
+
+// Return whether we have the vertex array object extension (and the VBO functions it relies on)
+bool GLExtensions::hasVertexArrays()
+{
+	return hasVertexArrays_ && hasVBO_ && (glGenVertexArrays != NULL) && (glBindVertexArray != NULL) && (glDeleteVertexArrays != NULL);
+}
+
+// Return whether we have the separate blend function extension
+bool GLExtensions::hasBlendFuncSeparate()
+{
+	return hasBlendFuncSeparate_ && (glBlendFuncSeparate != NULL);
+}
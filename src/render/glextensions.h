@@ -75,6 +75,66 @@ class GLExtensions : public ListItem<GLExtensions>
 	PFNGLBUFFERDATAPROC glBufferData;
 	PFNGLBUFFERSUBDATAPROC glBufferSubData;
 	PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+
+
+	/*
+	 * Pixel Buffer Extensions
+	 */
+	private:
+	// Whether we have the pixel buffer object extension
+	bool hasPixelBuffers_;
+
+	public:
+	// Return whether we have the pixel buffer object extension (and the VBO functions it relies on)
+	bool hasPixelBuffers();
+	// Pixel buffer function pointers
+	PFNGLMAPBUFFERPROC glMapBuffer;
+	PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+
+
+	/*
+	 * Instancing Extensions
+	 */
+	private:
+	// Whether we have the instanced arrays and instanced drawing extensions
+	bool hasInstancing_;
+
+	public:
+	// Return whether we have the instanced arrays and instanced drawing extensions
+	bool hasInstancing();
+	// Instancing function pointers
+	PFNGLVERTEXATTRIBDIVISORARBPROC glVertexAttribDivisor;
+	PFNGLDRAWARRAYSINSTANCEDARBPROC glDrawArraysInstanced;
+
+
+	/*
+	 * Vertex Array Object Extensions
+	 */
+	private:
+	// Whether we have the vertex array object extension
+	bool hasVertexArrays_;
+
+	public:
+	// Return whether we have the vertex array object extension (and the VBO functions it relies on)
+	bool hasVertexArrays();
+	// Vertex array object function pointers
+	PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
+	PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
+	PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
+
+
+	/*
+	 * Blend Extensions
+	 */
+	private:
+	// Whether we have the separate blend function extension
+	bool hasBlendFuncSeparate_;
+
+	public:
+	// Return whether we have the separate blend function extension
+	bool hasBlendFuncSeparate();
+	// Blend function pointers
+	PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
 };
 
 #endif
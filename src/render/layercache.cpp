@@ -0,0 +1,221 @@
+/*
+	*** Layer Cache
+	*** src/render/layercache.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/layercache.h"
+#include "render/glextensions.h"
+#include "base/messenger.h"
+#include <QtOpenGL/QGLFramebufferObject>
+
+// Static Members
+bool LayerCache::enabled_ = true;
+
+// Constructor
+LayerCache::LayerCache()
+{
+	drawBuffer_ = NULL;
+	resolveBuffer_ = NULL;
+	width_ = 0;
+	height_ = 0;
+	valid_ = false;
+	signature_ = 0;
+	lastSignature_ = 0;
+	extensions_ = NULL;
+}
+
+// Destructor
+LayerCache::~LayerCache()
+{
+}
+
+/*
+ * Framebuffers
+ */
+
+// Create framebuffers of the specified size
+bool LayerCache::createBuffers(int width, int height)
+{
+	clear();
+
+	// Draw into a multisampled buffer where we can resolve it into a texture, so that edges look as they do in the window
+	if (QGLFramebufferObject::hasOpenGLFramebufferBlit())
+	{
+		QGLFramebufferObjectFormat format;
+		format.setAttachment(QGLFramebufferObject::Depth);
+		format.setSamples(4);
+		drawBuffer_ = new QGLFramebufferObject(width, height, format);
+		resolveBuffer_ = new QGLFramebufferObject(width, height);
+	}
+	else drawBuffer_ = new QGLFramebufferObject(width, height, QGLFramebufferObject::Depth);
+
+	if ((!drawBuffer_->isValid()) || (resolveBuffer_ && (!resolveBuffer_->isValid())))
+	{
+		msg.print("Warning: Failed to create %ix%i framebuffer for layer cache - layers will be drawn directly.\n", width, height);
+		clear();
+		enabled_ = false;
+		return false;
+	}
+
+	width_ = width;
+	height_ = height;
+
+	return true;
+}
+
+// Set whether layers should be cached when possible
+void LayerCache::setEnabled(bool enabled)
+{
+	enabled_ = enabled;
+}
+
+// Return whether layers should be cached when possible
+bool LayerCache::enabled()
+{
+	return enabled_;
+}
+
+// Return whether framebuffers can be drawn into and composited in the current context
+bool LayerCache::supported(GLExtensions* extensions)
+{
+	// Separate alpha blending is needed to accumulate correct coverage in the framebuffer
+	return QGLFramebufferObject::hasOpenGLFramebufferObjects() && extensions->hasBlendFuncSeparate();
+}
+
+// Return whether caching is enabled and possible in the current context
+bool LayerCache::available(GLExtensions* extensions)
+{
+	return enabled_ && supported(extensions);
+}
+
+// Delete framebuffers (requires the context to be current)
+void LayerCache::clear()
+{
+	if (drawBuffer_) delete drawBuffer_;
+	if (resolveBuffer_) delete resolveBuffer_;
+	drawBuffer_ = NULL;
+	resolveBuffer_ = NULL;
+	width_ = 0;
+	height_ = 0;
+	valid_ = false;
+}
+
+/*
+ * Contents
+ */
+
+// Invalidate cached contents
+void LayerCache::invalidate()
+{
+	valid_ = false;
+}
+
+// Note signature of this frame's contents, returning whether it is the same as last frame's
+bool LayerCache::stable(quint64 signature)
+{
+	bool result = (signature == lastSignature_);
+	lastSignature_ = signature;
+	return result;
+}
+
+// Return whether the cache holds contents with the specified signature, drawn at the specified size
+bool LayerCache::matches(quint64 signature, int width, int height)
+{
+	return valid_ && (signature == signature_) && (width == width_) && (height == height_);
+}
+
+// Begin drawing contents into the cache, returning false if this is not possible
+bool LayerCache::begin(GLExtensions* extensions, int width, int height)
+{
+	valid_ = false;
+	if ((!drawBuffer_) || (width != width_) || (height != height_))
+	{
+		if (!createBuffers(width, height)) return false;
+	}
+	extensions_ = extensions;
+
+	drawBuffer_->bind();
+
+	// Clear to transparent black, leaving the clear colour as it was
+	GLfloat clearColour[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColour);
+	glClearColor(0.0, 0.0, 0.0, 0.0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glClearColor(clearColour[0], clearColour[1], clearColour[2], clearColour[3]);
+
+	// Colour is blended as usual (giving premultiplied colour), but alpha must accumulate coverage
+	extensions_->glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	return true;
+}
+
+// Finish drawing contents with the specified signature
+void LayerCache::end(quint64 signature)
+{
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	drawBuffer_->release();
+
+	if (resolveBuffer_) QGLFramebufferObject::blitFramebuffer(resolveBuffer_, QRect(0, 0, width_, height_), drawBuffer_, QRect(0, 0, width_, height_));
+
+	signature_ = signature;
+	valid_ = true;
+}
+
+// Draw cached contents over the current target, optionally transformed (in normalised device coordinates) and faded
+void LayerCache::composite(const GLfloat* matrix, GLfloat opacity)
+{
+	if (!valid_) return;
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	if (matrix) glLoadMatrixf(matrix);
+	else glLoadIdentity();
+
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, resolveBuffer_ ? resolveBuffer_->texture() : drawBuffer_->texture());
+
+	// Cached colours are already premultiplied by alpha, so are faded by scaling all components
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(opacity, opacity, opacity, opacity);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.0f, 0.0f);
+	glVertex2f(-1.0f, -1.0f);
+	glTexCoord2f(1.0f, 0.0f);
+	glVertex2f(1.0f, -1.0f);
+	glTexCoord2f(1.0f, 1.0f);
+	glVertex2f(1.0f, 1.0f);
+	glTexCoord2f(0.0f, 1.0f);
+	glVertex2f(-1.0f, 1.0f);
+	glEnd();
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+}
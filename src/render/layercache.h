@@ -0,0 +1,113 @@
+/*
+	*** Layer Cache
+	*** src/render/layercache.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_LAYERCACHE_H
+#define QUAPP_LAYERCACHE_H
+
+#ifndef __APPLE__
+#include <GL/gl.h>
+#else
+#include <OpenGL/gl3.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include "glext.h"
+#endif
+#include <QtCore/QtGlobal>
+
+// Forward Declarations
+class GLExtensions;
+class QGLFramebufferObject;
+
+/*!
+ * \brief Layer Cache
+ * \details Holds the drawn contents of one or more layers in a framebuffer object, along with the signature of the draw items
+ * they were drawn from. While the signature of the layers is unchanged (nothing has moved, been recoloured, or been redefined)
+ * the cache is composited over the scene as a single textured quad, rather than drawing every item again. Colours are stored
+ * premultiplied by alpha, so that compositing gives the same result as drawing the layers directly.
+ */
+class LayerCache
+{
+	public:
+	// Constructor / Destructor
+	LayerCache();
+	~LayerCache();
+
+
+	/*
+	 * Framebuffers
+	 */
+	private:
+	// Whether layers should be cached when possible
+	static bool enabled_;
+	// Framebuffer into which layers are drawn (multisampled, if possible)
+	QGLFramebufferObject* drawBuffer_;
+	// Framebuffer into which a multisampled draw buffer is resolved, ready for use as a texture
+	QGLFramebufferObject* resolveBuffer_;
+	// Size of framebuffers
+	int width_, height_;
+
+	private:
+	// Create framebuffers of the specified size
+	bool createBuffers(int width, int height);
+
+	public:
+	// Set whether layers should be cached when possible
+	static void setEnabled(bool enabled);
+	// Return whether layers should be cached when possible
+	static bool enabled();
+	// Return whether framebuffers can be drawn into and composited in the current context
+	static bool supported(GLExtensions* extensions);
+	// Return whether caching is enabled and possible in the current context
+	bool available(GLExtensions* extensions);
+	// Delete framebuffers (requires the context to be current)
+	void clear();
+
+
+	/*
+	 * Contents
+	 */
+	private:
+	// Whether the cache holds valid contents
+	bool valid_;
+	// Signature of cached contents
+	quint64 signature_;
+	// Signature of contents offered in the last frame
+	quint64 lastSignature_;
+	// GL extensions used while drawing into the cache
+	GLExtensions* extensions_;
+
+	public:
+	// Invalidate cached contents
+	void invalidate();
+	// Note signature of this frame's contents, returning whether it is the same as last frame's
+	bool stable(quint64 signature);
+	// Return whether the cache holds contents with the specified signature, drawn at the specified size
+	bool matches(quint64 signature, int width, int height);
+	// Begin drawing contents into the cache, returning false if this is not possible
+	bool begin(GLExtensions* extensions, int width, int height);
+	// Finish drawing contents with the specified signature
+	void end(quint64 signature);
+	// Draw cached contents over the current target, optionally transformed (in normalised device coordinates) and faded
+	void composite(const GLfloat* matrix = NULL, GLfloat opacity = 1.0f);
+};
+
+#endif
@@ -21,13 +21,22 @@
 
 #include <QtOpenGL/QGLWidget>
 #include "render/primitive.h"
+#include "templates/objectpool.h"
 #include "base/messenger.h"
+#include "base/mediaregistry.h"
+#include "render/frameprofiler.h"
 #include "render/glextensions.h"
+#include "render/shaderrenderer.h"
+#include "render/vertexarena.h"
 #include <string.h>
 #ifdef __APPLE__
 #include <OpenGL/gl.h>
 #endif
 
+// Static Members
+int Primitive::nDrawCalls_ = 0;
+unsigned int Primitive::lastRevision_ = 0;
+
 // Constructor
 Primitive::Primitive() : ListItem<Primitive>()
 {
@@ -50,11 +59,29 @@ Primitive::Primitive() : ListItem<Primitive>()
 	type_ = GL_TRIANGLES;
 	interleaveType_ = GL_N3F_V3F;
 	useInstances_ = true;
+	textureObject_ = 0;
+	revision_ = ++lastRevision_;
+	boundsRevision_ = 0;
+	boundsVertices_ = -1;
 }
 
 // Destructor
 Primitive::~Primitive()
 {
+	// Return any arena space and vertex array objects held by our instances (display lists and textures need a context, so are left alone)
+	for (PrimitiveInstance* pi = instances_.first(); pi != NULL; pi = pi->next) if (pi->type() == PrimitiveInstance::VBOInstance) releaseRanges(pi);
+}
+
+// Allocate storage from object pool
+void* Primitive::operator new(size_t size)
+{
+	return ObjectPool<Primitive>::allocate(size);
+}
+
+// Return storage to object pool
+void Primitive::operator delete(void* object, size_t size)
+{
+	ObjectPool<Primitive>::release(object, size);
 }
 
 /*
@@ -119,6 +146,7 @@ void Primitive::initialise(int newMaxVertices, int newMaxIndices, GLenum type, b
 	nDefinedIndices_ = 0;
 	nDefinedTypes_ = 0;
 	vertexIndex_ = 0;
+	revision_ = ++lastRevision_;
 }
 
 // Forget all data, leaving arrays intact
@@ -128,11 +156,42 @@ void Primitive::forgetAll()
 	nDefinedVertices_ = 0;
 	nDefinedIndices_ = 0;
 	vertexIndex_ = 0;
+	revision_ = ++lastRevision_;
 	
 	// Clear centroid array if we were using it
 	if (calcCentroids_ && centroids_) for (int n=0; n<maxTypes_; ++n) centroids_[n] = 0.0f;
 }
 
+// Take vertex data from specified primitive, giving it our (now unwanted) arrays in return
+void Primitive::takeData(Primitive& source)
+{
+	qSwap(vertexData_, source.vertexData_);
+	qSwap(indexData_, source.indexData_);
+	qSwap(centroids_, source.centroids_);
+	qSwap(maxVertices_, source.maxVertices_);
+	qSwap(maxIndices_, source.maxIndices_);
+	qSwap(maxTypes_, source.maxTypes_);
+	qSwap(dataPerVertex_, source.dataPerVertex_);
+	nDefinedVertices_ = source.nDefinedVertices_;
+	nDefinedIndices_ = source.nDefinedIndices_;
+	nDefinedTypes_ = source.nDefinedTypes_;
+	vertexIndex_ = source.vertexIndex_;
+	hasIndices_ = source.hasIndices_;
+	hasColourData_ = source.hasColourData_;
+	hasTextureCoordinateData_ = source.hasTextureCoordinateData_;
+	type_ = source.type_;
+	interleaveType_ = source.interleaveType_;
+	verticesPerType_ = source.verticesPerType_;
+	calcCentroids_ = source.calcCentroids_;
+	textureImage_ = source.textureImage_;
+	textureObject_ = source.textureObject_;
+
+	// Our vertex data are now completely different, so anything derived from them (signatures, bounds) must be recalculated
+	revision_ = ++lastRevision_;
+
+	source.forgetAll();
+}
+
 // Return number of vertices currently defined in primitive
 int Primitive::nDefinedVertices() const
 {
@@ -157,6 +216,67 @@ bool Primitive::hasTextureCoordinateData() const
 	return hasTextureCoordinateData_;
 }
 
+// Return primitive type (GL)
+GLenum Primitive::type() const
+{
+	return type_;
+}
+
+// Return whether indices are used when rendering
+bool Primitive::hasIndices() const
+{
+	return hasIndices_;
+}
+
+// Return number of data points per vertex
+int Primitive::dataPerVertex() const
+{
+	return dataPerVertex_;
+}
+
+// Return vertex data array
+const GLfloat* Primitive::vertexData() const
+{
+	return vertexData_;
+}
+
+// Return index data array
+const GLuint* Primitive::indexData() const
+{
+	return indexData_;
+}
+
+// Return texture object of topmost instance (if relevant)
+GLuint Primitive::textureObject() const
+{
+	if ((!hasTextureCoordinateData_) || (!useInstances_)) return 0;
+	PrimitiveInstance* pi = instances_.last();
+	return (pi ? pi->textureObject() : 0);
+}
+
+// Return revision of vertex data (unique among all primitives)
+unsigned int Primitive::revision() const
+{
+	return revision_;
+}
+
+// Return bounding cuboid of defined vertices
+const Cuboid& Primitive::bounds() const
+{
+	// Recalculate only if the vertex data have changed since we last did so
+	if ((boundsRevision_ != revision_) || (boundsVertices_ != nDefinedVertices_))
+	{
+		bounds_ = Cuboid();
+		// Vertex coordinates are the last three values of each vertex
+		const GLfloat* vertex = vertexData_ + dataPerVertex_ - 3;
+		for (int n=0; n<nDefinedVertices_; ++n, vertex += dataPerVertex_) bounds_.updateExtremes(Vec3<double>(vertex[0], vertex[1], vertex[2]));
+		boundsRevision_ = revision_;
+		boundsVertices_ = nDefinedVertices_;
+	}
+
+	return bounds_;
+}
+
 // Flag that this primitive should not use instances (rendering will use vertex arrays)
 void Primitive::setNoInstances()
 {
@@ -164,7 +284,7 @@ void Primitive::setNoInstances()
 }
 
 // Push instance of primitive
-void Primitive::pushInstance(const QGLContext* context, GLExtensions* extensions, QGLWidget* glWidget)
+void Primitive::pushInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena)
 {
 	// Does this primitive use instances?
 	if (!useInstances_) return;
@@ -179,62 +299,36 @@ void Primitive::pushInstance(const QGLContext* context, GLExtensions* extensions
 	// Vertex buffer object or plain old display list?
 	if (PrimitiveInstance::globalInstanceType() == PrimitiveInstance::VBOInstance)
 	{
-		// Prepare local array of data to pass to VBO
-		int offset;
-		GLuint vertexVBO = 0, indexVBO = 0;
-		if (nDefinedVertices_ <= 0)
+		if ((nDefinedVertices_ <= 0) || (!arena))
 		{
 			// Store instance data
-			pi->setVBO(context, 0, 0);
-			msg.exit("Primitive::pushInstance");
+			pi->setVBO(context, NULL, NULL);
 			return;
 		}
 
-		// Determine total size of array (in bytes) for VBO
-		int vboSize = nDefinedVertices_ * dataPerVertex_ * sizeof(GLfloat);
-		
-		// Generate vertex array object
-		extensions->glGenBuffers(1, &vertexVBO);
-
-		// Bind VBO
-		extensions->glBindBuffer(GL_ARRAY_BUFFER, vertexVBO);
-		
-		// Initialise vertex array data
-		extensions->glBufferData(GL_ARRAY_BUFFER, vboSize, vertexData_, GL_STATIC_DRAW);
-		if (glGetError() != GL_NO_ERROR)
+		// Allocate space for our data in the arena - it is uploaded along with everything else at the start of the frame
+		VertexArenaRange* vertexRange = arena->allocateVertices(vertexData_, nDefinedVertices_ * dataPerVertex_ * sizeof(GLfloat));
+		if (!vertexRange)
 		{
-			extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
-			printf("Error occurred while generating vertex buffer object for Primitive.\n");
-			extensions->glDeleteBuffers(1, &vertexVBO);
-			vertexVBO = 0;
+			printf("Error occurred while allocating vertex buffer space for Primitive.\n");
+			pi->setVBO(context, NULL, NULL);
 			return;
 		}
-		extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-		// Generate index array object (if using indices)
+		VertexArenaRange* indexRange = NULL;
 		if (hasIndices_)
 		{
-			// Generate index array object
-			extensions->glGenBuffers(1, &indexVBO);
-
-			// Bind VBO
-			extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBO);
-			
-			// Initialise index array data
-			extensions->glBufferData(GL_ELEMENT_ARRAY_BUFFER, nDefinedIndices_*sizeof(GLuint), indexData_, GL_STATIC_DRAW);
-			if (glGetError() != GL_NO_ERROR)
+			indexRange = arena->allocateIndices(indexData_, nDefinedIndices_ * sizeof(GLuint));
+			if (!indexRange)
 			{
-				extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-				printf("Error occurred while generating index buffer object for Primitive.\n");
-				extensions->glDeleteBuffers(1, &indexVBO);
-				indexVBO = 0;
+				printf("Error occurred while allocating index buffer space for Primitive.\n");
+				arena->release(vertexRange);
+				pi->setVBO(context, NULL, NULL);
 				return;
 			}
-			extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 
 		// Store instance data
-		pi->setVBO(context, vertexVBO, hasIndices_ ? indexVBO : 0);
+		pi->setVBO(context, vertexRange, indexRange);
 	}
 	else
 	{
@@ -252,14 +346,26 @@ void Primitive::pushInstance(const QGLContext* context, GLExtensions* extensions
 		pi->setDisplayList(context, listId);
 	}
 
-	// Generate texture object (if relevant)
+	// Get (shared) texture object (if relevant)
 	if (hasTextureCoordinateData_)
 	{
-		GLuint texture = glWidget->bindTexture(textureImage_);
+		GLuint texture = (textureObject_ != 0 ? textureObject_ : MediaRegistry::acquireTexture(textureImage_));
 		pi->setTexture(texture);
 	}
 }
 
+// Return arena ranges (and any vertex array object using them) held by instance
+void Primitive::releaseRanges(PrimitiveInstance* pi)
+{
+	VertexArena::release(pi->vertexRange());
+	VertexArena::release(pi->indexRange());
+	pi->setVBO(pi->context(), NULL, NULL);
+
+	// Vertex array object refers to the ranges, so goes with them (deleted once the context is next current)
+	if (pi->vertexArrayObject() != 0) ShaderRenderer::releaseVertexArray(pi->vertexArrayObject());
+	pi->setVertexArrayObject(0);
+}
+
 // Pop topmost instance on primitive's stack
 void Primitive::popInstance(const QGLContext *context)
 {
@@ -271,18 +377,11 @@ void Primitive::popInstance(const QGLContext *context)
 		if (pi->context() == context)
 		{
 			// Vertex buffer object or plain old display list?
-			if (pi->type() == PrimitiveInstance::VBOInstance)
-			{
-				const GLExtensions* extensions = pi->extensions();
-				GLuint bufid  = pi->vboVertexObject();
-				if (bufid != 0) extensions->glDeleteBuffers(1, &bufid);
-				if (hasIndices_)
-				{
-					bufid = pi->vboIndexObject();
-					if (bufid != 0) extensions->glDeleteBuffers(1, &bufid);
-				}
-			}
+			if (pi->type() == PrimitiveInstance::VBOInstance) releaseRanges(pi);
 			else if (pi->listObject() != 0) glDeleteLists(pi->listObject(),1);
+
+			// Release texture object (unless it is owned elsewhere)
+			if ((pi->textureObject() != 0) && (pi->textureObject() != textureObject_)) MediaRegistry::releaseTexture(pi->textureObject());
 		}
 	}
 	instances_.removeLast();
@@ -300,6 +399,13 @@ void Primitive::sendToGL(bool drawSimple) const
 	// If no vertices are defined, nothing to do...
 	if (nDefinedVertices_ == 0) return;
 
+	// Programmable pipeline?
+	if (ShaderRenderer::active())
+	{
+		sendToShader();
+		return;
+	}
+
 	// Check if using instances...
 	if (useInstances_)
 	{
@@ -311,11 +417,15 @@ void Primitive::sendToGL(bool drawSimple) const
 			return;
 		}
 
+		// If no arena space could be allocated for the instance, there is nothing to draw
+		if ((pi->type() == PrimitiveInstance::VBOInstance) && (pi->vboVertexObject() == 0)) return;
+
 		// Bind texture object if relevant
 		if (hasTextureCoordinateData_ && pi->textureObject())
 		{
 			glBindTexture(GL_TEXTURE_2D, pi->textureObject());
 			glEnable(GL_TEXTURE_2D);
+			FrameProfiler::count(FrameProfiler::TextureBindCounter);
 		}
 
 		if (pi->type() == PrimitiveInstance::VBOInstance)
@@ -333,11 +443,12 @@ void Primitive::sendToGL(bool drawSimple) const
 			extensions->glBindBuffer(GL_ARRAY_BUFFER, pi->vboVertexObject());
 			if (hasIndices_) extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pi->vboIndexObject());
 
-			// Set interleave type for arrays
-			glInterleavedArrays(interleaveType_, 0, NULL);
+			// Set interleave type for arrays, pointing at our range within the arena buffer
+			glInterleavedArrays(interleaveType_, 0, pi->vboVertexOffset());
 
-			if (hasIndices_) glDrawElements(type_, nDefinedIndices_, GL_UNSIGNED_INT, 0);
+			if (hasIndices_) glDrawElements(type_, nDefinedIndices_, GL_UNSIGNED_INT, pi->vboIndexOffset());
 			else glDrawArrays(type_, 0, nDefinedVertices_);
+			countDrawCalls(1, hasIndices_ ? nDefinedIndices_ : nDefinedVertices_);
 
 			// Revert to normal operation - pass 0 as VBO index
 			extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -348,7 +459,11 @@ void Primitive::sendToGL(bool drawSimple) const
 			if (hasIndices_) glDisableClientState(GL_INDEX_ARRAY);
 			if (hasTextureCoordinateData_) glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		}
-		else if (pi->listObject() != 0) glCallList(pi->listObject());
+		else if (pi->listObject() != 0)
+		{
+			glCallList(pi->listObject());
+			countDrawCalls(1, hasIndices_ ? nDefinedIndices_ : nDefinedVertices_);
+		}
 	}
 	else
 	{
@@ -358,11 +473,97 @@ void Primitive::sendToGL(bool drawSimple) const
 		// Check if we are using indices
 		if (hasIndices_) glDrawElements(type_, nDefinedIndices_, GL_UNSIGNED_INT, indexData_);
 		else glDrawArrays(type_, 0, nDefinedVertices_);
+		countDrawCalls(1, hasIndices_ ? nDefinedIndices_ : nDefinedVertices_);
 	}
 
 	glDisable(GL_TEXTURE_2D);
 }
 
+// Send to OpenGL through the ShaderRenderer's program
+void Primitive::sendToShader() const
+{
+	// Check if using instances...
+	if (useInstances_)
+	{
+		// Grab topmost instance - the shader path is only used with VBO instances
+		PrimitiveInstance *pi = instances_.last();
+		if (pi == NULL)
+		{
+			printf("Internal Error: No instance on stack in primitive %p.\n", this);
+			return;
+		}
+		if (pi->vboVertexObject() == 0) return;
+		const GLExtensions* extensions = pi->extensions();
+
+		// Bind texture object if relevant
+		bool texturing = (hasTextureCoordinateData_ && pi->textureObject());
+		if (texturing)
+		{
+			glBindTexture(GL_TEXTURE_2D, pi->textureObject());
+			FrameProfiler::count(FrameProfiler::TextureBindCounter);
+		}
+		ShaderRenderer::setSources(hasColourData_, texturing);
+
+		// Create vertex array object on first use, recording our attribute layout within the arena buffers
+		if (pi->vertexArrayObject() == 0)
+		{
+			GLuint vertexArrayObject;
+			extensions->glGenVertexArrays(1, &vertexArrayObject);
+			extensions->glBindVertexArray(vertexArrayObject);
+			extensions->glBindBuffer(GL_ARRAY_BUFFER, pi->vboVertexObject());
+			ShaderRenderer::setAttributes(pi->vboVertexOffset(), hasColourData_, hasTextureCoordinateData_);
+			if (hasIndices_) extensions->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pi->vboIndexObject());
+			pi->setVertexArrayObject(vertexArrayObject);
+		}
+		else extensions->glBindVertexArray(pi->vertexArrayObject());
+
+		if (hasIndices_) glDrawElements(type_, nDefinedIndices_, GL_UNSIGNED_INT, pi->vboIndexOffset());
+		else glDrawArrays(type_, 0, nDefinedVertices_);
+		countDrawCalls(1, hasIndices_ ? nDefinedIndices_ : nDefinedVertices_);
+
+		// Revert to normal operation (buffer bindings are left in the vertex array object)
+		extensions->glBindVertexArray(0);
+		extensions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+	{
+		// Point attributes at our data in client memory
+		ShaderRenderer::setSources(hasColourData_, false);
+		ShaderRenderer::setAttributes(vertexData_, hasColourData_, hasTextureCoordinateData_);
+
+		// Check if we are using indices
+		if (hasIndices_) glDrawElements(type_, nDefinedIndices_, GL_UNSIGNED_INT, indexData_);
+		else glDrawArrays(type_, 0, nDefinedVertices_);
+		countDrawCalls(1, hasIndices_ ? nDefinedIndices_ : nDefinedVertices_);
+
+		ShaderRenderer::clearAttributes(hasColourData_, hasTextureCoordinateData_);
+	}
+}
+
+/*
+ * Statistics
+ */
+
+// Register draw call(s), and the number of vertices they submitted
+void Primitive::countDrawCalls(int nCalls, int nVertices)
+{
+	nDrawCalls_ += nCalls;
+	FrameProfiler::count(FrameProfiler::DrawCallCounter, nCalls);
+	FrameProfiler::count(FrameProfiler::VertexCounter, nVertices);
+}
+
+// Return number of draw calls issued since the counter was last reset
+int Primitive::nDrawCalls()
+{
+	return nDrawCalls_;
+}
+
+// Reset draw call counter
+void Primitive::resetDrawCalls()
+{
+	nDrawCalls_ = 0;
+}
+
 /*
  * Vertex / Index Generation
  */
@@ -627,9 +828,18 @@ bool Primitive::defineIndices(GLuint a, GLuint b, GLuint c)
  */
 
 // Set texture image
-void Primitive::setTextureImage(QImage& image)
+void Primitive::setTextureImage(const QImage& image)
 {
 	textureImage_ = image;
+	revision_ = ++lastRevision_;
+}
+
+// Set texture object owned elsewhere, to be used in place of the texture image
+void Primitive::setTextureObject(GLuint textureObject)
+{
+	if (textureObject == textureObject_) return;
+	textureObject_ = textureObject;
+	revision_ = ++lastRevision_;
 }
 
 /*
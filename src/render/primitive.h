@@ -28,12 +28,13 @@
 #include "glext.h"
 #endif
 #include "render/primitiveinstance.h"
+#include "math/cuboid.h"
 #include "math/matrix.h"
 #include "templates/list.h"
 #include <QtGui/QImage>
 
 // Forward Declarations
-class QGLWidget;
+class VertexArena;
 
 // Rendering Primitive
 class Primitive : public ListItem<Primitive>
@@ -42,6 +43,10 @@ class Primitive : public ListItem<Primitive>
 	// Constructor / Destructor
 	Primitive();
 	~Primitive();
+	// Allocate storage from object pool
+	static void* operator new(size_t size);
+	// Return storage to object pool
+	static void operator delete(void* object, size_t size);
 
 
 	/*
@@ -86,12 +91,29 @@ class Primitive : public ListItem<Primitive>
 	List<PrimitiveInstance> instances_;
 	// Flag stating whether or not instances should be used for this primitive
 	bool useInstances_;
+	// Revision of vertex data, changed whenever the data is (re)defined
+	unsigned int revision_;
+	// Last revision number handed out to any primitive
+	static unsigned int lastRevision_;
+	// Bounding cuboid of defined vertices (calculated when first needed)
+	mutable Cuboid bounds_;
+	// Revision and number of vertices for which bounds were last calculated
+	mutable unsigned int boundsRevision_;
+	mutable int boundsVertices_;
+
+	private:
+	// Return arena ranges (and any vertex array object using them) held by instance
+	void releaseRanges(PrimitiveInstance* pi);
+	// Send to OpenGL through the ShaderRenderer's program
+	void sendToShader() const;
 
 	public:
 	// Initialise primitive storage
 	void initialise(int newMaxVertices, int newMaxIndices, GLenum type, bool colourData, bool textureData);
 	// Forget all data, leaving arrays intact
 	void forgetAll();
+	// Take vertex data from specified primitive, giving it our (now unwanted) arrays in return
+	void takeData(Primitive& source);
 	// Return number of vertices currently defined in primitive
 	int nDefinedVertices() const;
 	// Return number of indices currently defined in primitive
@@ -100,10 +122,26 @@ class Primitive : public ListItem<Primitive>
 	bool hasColourData() const;
 	// Return whether vertex data contains texture coordinate information
 	bool hasTextureCoordinateData() const;
+	// Return primitive type (GL)
+	GLenum type() const;
+	// Return whether indices are used when rendering
+	bool hasIndices() const;
+	// Return number of data points per vertex
+	int dataPerVertex() const;
+	// Return vertex data array
+	const GLfloat* vertexData() const;
+	// Return index data array
+	const GLuint* indexData() const;
+	// Return texture object of topmost instance (if relevant)
+	GLuint textureObject() const;
+	// Return revision of vertex data (unique among all primitives)
+	unsigned int revision() const;
+	// Return bounding cuboid of defined vertices
+	const Cuboid& bounds() const;
 	// Flag that this primitive should not use instances (rendering will use vertex arrays)
 	void setNoInstances();
 	// Push instance layer from current vertex chunk list
-	void pushInstance(const QGLContext* context, GLExtensions* extensions, QGLWidget* glWidget);
+	void pushInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena);
 	// Pop topmost instance layer
 	void popInstance(const QGLContext *context);
 	// Return number of instances available
@@ -112,6 +150,22 @@ class Primitive : public ListItem<Primitive>
 	void sendToGL(bool drawSimple = false) const;
 
 
+	/*
+	 * Statistics
+	 */
+	private:
+	// Number of draw calls issued since the counter was last reset
+	static int nDrawCalls_;
+
+	public:
+	// Register draw call(s), and the number of vertices they submitted
+	static void countDrawCalls(int nCalls = 1, int nVertices = 0);
+	// Return number of draw calls issued since the counter was last reset
+	static int nDrawCalls();
+	// Reset draw call counter
+	static void resetDrawCalls();
+
+
 	/*
 	 * Vertex / Index Generation
 	 */
@@ -158,10 +212,14 @@ class Primitive : public ListItem<Primitive>
 	private:
 	// Image to use for texture
 	QImage textureImage_;
+	// Texture object owned elsewhere (e.g. the glyph atlas), used in place of the texture image (zero for none)
+	GLuint textureObject_;
 
 	public:
 	// Set texture image
-	void setTextureImage(QImage& image);
+	void setTextureImage(const QImage& image);
+	// Set texture object owned elsewhere, to be used in place of the texture image
+	void setTextureObject(GLuint textureObject);
 
 
 	/*
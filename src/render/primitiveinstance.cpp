@@ -21,6 +21,7 @@
 
 #include "render/glextensions.h"
 #include "render/primitiveinstance.h"
+#include "render/vertexarena.h"
 #include <string.h>
 
 // Static members
@@ -33,9 +34,10 @@ PrimitiveInstance::PrimitiveInstance() : ListItem<PrimitiveInstance>()
 	context_ = NULL;
 	type_ = PrimitiveInstance::ListInstance;
 	listObject_ = 0;
-	vboVertexObject_ = 0;
-	vboIndexObject_ = 0;
+	vertexRange_ = NULL;
+	indexRange_ = NULL;
 	textureObject_ = 0;
+	vertexArrayObject_ = 0;
 }
 
 // Return global instance type to use
@@ -83,24 +85,48 @@ GLuint PrimitiveInstance::listObject()
 }
 
 // Set vbo object data
-void PrimitiveInstance::setVBO(const QGLContext *context, GLuint vertexObject, GLuint indexObject)
+void PrimitiveInstance::setVBO(const QGLContext *context, VertexArenaRange* vertexRange, VertexArenaRange* indexRange)
 {
 	context_ = context;
 	type_ = PrimitiveInstance::VBOInstance;
-	vboVertexObject_ = vertexObject;
-	vboIndexObject_ = indexObject;
+	vertexRange_ = vertexRange;
+	indexRange_ = indexRange;
+}
+
+// Return arena range holding vertex array
+VertexArenaRange* PrimitiveInstance::vertexRange()
+{
+	return vertexRange_;
+}
+
+// Return arena range holding index array
+VertexArenaRange* PrimitiveInstance::indexRange()
+{
+	return indexRange_;
 }
 
 // Return VBO ID of vertex array for instance
-GLuint PrimitiveInstance::vboVertexObject()
+GLuint PrimitiveInstance::vboVertexObject() const
+{
+	return (vertexRange_ ? vertexRange_->bufferObject() : 0);
+}
+
+// Return offset of vertex array in its VBO
+GLvoid* PrimitiveInstance::vboVertexOffset() const
 {
-	return vboVertexObject_;
+	return (GLvoid*) (vertexRange_ ? (char*) NULL + vertexRange_->offset() : NULL);
 }
 
 // Return VBO ID of index array for instance
 GLuint PrimitiveInstance::vboIndexObject() const
 {
-	return vboIndexObject_;
+	return (indexRange_ ? indexRange_->bufferObject() : 0);
+}
+
+// Return offset of index array in its VBO
+GLvoid* PrimitiveInstance::vboIndexOffset() const
+{
+	return (GLvoid*) (indexRange_ ? (char*) NULL + indexRange_->offset() : NULL);
 }
 
 // Set texture object
@@ -115,6 +141,18 @@ GLuint PrimitiveInstance::textureObject()
 	return textureObject_;
 }
 
+// Set vertex array object
+void PrimitiveInstance::setVertexArrayObject(GLuint vertexArrayObject)
+{
+	vertexArrayObject_ = vertexArrayObject;
+}
+
+// Return vertex array object for instance
+GLuint PrimitiveInstance::vertexArrayObject() const
+{
+	return vertexArrayObject_;
+}
+
 // Return type of instance
 PrimitiveInstance::InstanceType PrimitiveInstance::type()
 {
@@ -36,6 +36,7 @@
 // Forward Declarations
 class QGLContext;
 class GLExtensions;
+class VertexArenaRange;
 
 // Primitive Instance
 class PrimitiveInstance : public ListItem<PrimitiveInstance>
@@ -57,12 +58,14 @@ class PrimitiveInstance : public ListItem<PrimitiveInstance>
 	InstanceType type_;
 	// List ID of instance (if using display lists)
 	GLuint listObject_;
-	// VBO ID of vertex array (if using VBOs)
-	GLuint vboVertexObject_;
-	// VBO ID of index array (if using indexed VBOs)
-	GLuint vboIndexObject_;
+	// Arena range holding vertex array (if using VBOs)
+	VertexArenaRange* vertexRange_;
+	// Arena range holding index array (if using indexed VBOs)
+	VertexArenaRange* indexRange_;
 	// Texture to use for primitive (if relevant)
 	GLuint textureObject_;
+	// Vertex array object recording the attribute layout of the instance (if drawn by the ShaderRenderer)
+	GLuint vertexArrayObject_;
 
 
 	public:
@@ -81,15 +84,27 @@ class PrimitiveInstance : public ListItem<PrimitiveInstance>
 	// Return display list object for instance
 	GLuint listObject();
 	// Set vbo object data
-	void setVBO(const QGLContext *context, GLuint vertexObject, GLuint indexObject);
+	void setVBO(const QGLContext *context, VertexArenaRange* vertexRange, VertexArenaRange* indexRange);
+	// Return arena range holding vertex array
+	VertexArenaRange* vertexRange();
+	// Return arena range holding index array
+	VertexArenaRange* indexRange();
 	// Return VBO ID of vertex array for instance
-	GLuint vboVertexObject();
+	GLuint vboVertexObject() const;
+	// Return offset of vertex array in its VBO
+	GLvoid* vboVertexOffset() const;
 	// Return VBO ID of index array for instance
 	GLuint vboIndexObject() const;
+	// Return offset of index array in its VBO
+	GLvoid* vboIndexOffset() const;
 	// Set texture object
 	void setTexture(GLuint textureObject);
 	// Return texture ID for instance
 	GLuint textureObject();
+	// Set vertex array object
+	void setVertexArrayObject(GLuint vertexArrayObject);
+	// Return vertex array object for instance
+	GLuint vertexArrayObject() const;
 	// Return type of instance
 	InstanceType type();
 };
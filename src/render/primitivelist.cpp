@@ -89,9 +89,9 @@ int PrimitiveList::nDefinedIndices()
 }
 
 // Push instance layer
-void PrimitiveList::pushInstance(const QGLContext* context, GLExtensions* extensions, QGLWidget* glWidget)
+void PrimitiveList::pushInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena)
 {
-	for (Primitive* prim = primitives_.first(); prim != NULL; prim = prim->next) prim->pushInstance(context, extensions, glWidget);
+	for (Primitive* prim = primitives_.first(); prim != NULL; prim = prim->next) prim->pushInstance(context, extensions, arena);
 }
 
 // Pop topmost instance layer
@@ -113,6 +113,12 @@ void PrimitiveList::sendToGL() const
 	for (Primitive* prim = primitives_.first(); prim != NULL; prim = prim->next) prim->sendToGL();
 }
 
+// Add primitives to draw queue
+void PrimitiveList::queue(DrawQueue& drawQueue, DrawQueue::Layer layer, const GLfloat* matrix, const GLfloat* colour, DrawQueue::BlendMode blend) const
+{
+	for (Primitive* prim = primitives_.first(); prim != NULL; prim = prim->next) drawQueue.addPrimitive(layer, prim, matrix, colour, blend);
+}
+
 /*
  * Operators
  */
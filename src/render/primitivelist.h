@@ -23,11 +23,13 @@
 #define QUAPP_PRIMITIVELIST_H
 
 #include "render/primitive.h"
+#include "render/drawqueue.h"
 #include "templates/list.h"
 
 // Forward Declarations
 class QGLContext;
 class Viewer;
+class VertexArena;
 
 // Rendering Primitive List
 class PrimitiveList
@@ -59,13 +61,15 @@ class PrimitiveList
 	// Return total number of defined indices
 	int nDefinedIndices();
 	// Push instance layer
-	void pushInstance(const QGLContext* context, GLExtensions* extensions, QGLWidget* glWidget);
+	void pushInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena);
 	// Pop topmost instance layer
 	void popInstance(const QGLContext *context);
 	// Return number of instances of topmost primitive
 	int nInstances();
 	// Send to OpenGL (i.e. render)
 	void sendToGL() const;
+	// Add primitives to draw queue
+	void queue(DrawQueue& drawQueue, DrawQueue::Layer layer, const GLfloat* matrix, const GLfloat* colour, DrawQueue::BlendMode blend = DrawQueue::AlphaBlend) const;
 
 
 	/*
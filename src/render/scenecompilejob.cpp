@@ -0,0 +1,45 @@
+/*
+	*** Scene Compile Job
+	*** src/render/scenecompilejob.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/scenecompilejob.h"
+#include "render/scenecompiler.h"
+
+// Constructor
+SceneCompileJob::SceneCompileJob() : QRunnable()
+{
+	// Job holds no data of its own, so may be deleted by the thread pool as soon as it finishes
+	setAutoDelete(true);
+}
+
+// Destructor
+SceneCompileJob::~SceneCompileJob()
+{
+}
+
+/*
+ * Execution
+ */
+
+// Compile queued fragments (called from worker thread)
+void SceneCompileJob::run()
+{
+	SceneCompiler::compileQueued();
+}
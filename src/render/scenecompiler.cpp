@@ -0,0 +1,159 @@
+/*
+	*** Scene Compiler
+	*** src/render/scenecompiler.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/scenecompiler.h"
+#include "render/scenecompilejob.h"
+#include "render/fontinstance.h"
+#include <QtGui/QFontDatabase>
+#include <QtCore/QThreadPool>
+
+// Static Members
+List<SceneFragment> SceneCompiler::fragments_;
+QMultiHash<QString,SceneFragment*> SceneCompiler::fragmentHash_;
+QVector<SceneFragment*> SceneCompiler::queue_;
+int SceneCompiler::nCompiled_ = 0;
+int SceneCompiler::nTaken_ = 0;
+int SceneCompiler::nMissed_ = 0;
+QThreadPool* SceneCompiler::threadPool_ = NULL;
+QMutex SceneCompiler::mutex_;
+bool SceneCompiler::abort_ = false;
+
+/*
+ * Fragments
+ */
+
+// Abandon any compilation in progress and clear all fragments
+void SceneCompiler::clear()
+{
+	// Ask the worker to stop, and wait for it before touching any fragments
+	if (threadPool_)
+	{
+		mutex_.lock();
+		abort_ = true;
+		mutex_.unlock();
+		threadPool_->waitForDone();
+	}
+	abort_ = false;
+
+	queue_.clear();
+	fragmentHash_.clear();
+	fragments_.clear();
+	nCompiled_ = 0;
+	nTaken_ = 0;
+	nMissed_ = 0;
+}
+
+// Register text to be compiled
+void SceneCompiler::addText(QString text, TextPrimitive::TextAnchor anchor, double textSize)
+{
+	if (text.isEmpty()) return;
+
+	SceneFragment* fragment = fragments_.add();
+	fragment->set(text, anchor, textSize);
+	fragmentHash_.insert(text, fragment);
+}
+
+// Start compiling registered text in the background
+void SceneCompiler::start()
+{
+	// Queue all fragments in the order they were registered (which is the order they will be needed)
+	queue_.clear();
+	for (SceneFragment* fragment = fragments_.first(); fragment != NULL; fragment = fragment->next) queue_.append(fragment);
+	if (queue_.isEmpty()) return;
+
+	// Qt can only rasterise text in the GUI thread on some platforms (e.g. X11), so add any glyphs the worker will need to the atlas now
+	if (!QFontDatabase::supportsThreadedFontRendering()) for (int n=0; n<queue_.count(); ++n) FontInstance::prepareGlyphs(queue_.at(n)->text());
+
+	// A single worker is sufficient, since layout is serialised on the FontInstance mutex anyway
+	if (!threadPool_)
+	{
+		threadPool_ = new QThreadPool;
+		threadPool_->setMaxThreadCount(1);
+	}
+	threadPool_->start(new SceneCompileJob);
+}
+
+// Set text of target primitive, taking a compiled layout if one is available
+void SceneCompiler::setText(TextPrimitive& target, QString text, TextPrimitive::TextAnchor anchor)
+{
+	// Look for a compiled fragment with matching definition
+	SceneFragment* fragment = NULL;
+	QMultiHash<QString,SceneFragment*>::iterator it = fragmentHash_.find(text);
+	mutex_.lock();
+	while ((it != fragmentHash_.end()) && (it.key() == text))
+	{
+		if (it.value()->matches(text, anchor, target.textSize()) && it.value()->compiled())
+		{
+			fragment = it.value();
+			break;
+		}
+		++it;
+	}
+	mutex_.unlock();
+
+	// No compiled fragment, so lay out the text now
+	if (!fragment)
+	{
+		target.set(text, anchor);
+		++nMissed_;
+		return;
+	}
+
+	// The worker is finished with a compiled fragment, so it is safe to take its layout and forget it
+	target.takeLayout(fragment->layout());
+	fragmentHash_.erase(it);
+	++nTaken_;
+}
+
+// Return number of fragments currently held
+int SceneCompiler::nFragments()
+{
+	return fragments_.nItems();
+}
+
+// Print compilation statistics
+void SceneCompiler::printStatistics()
+{
+	printf("Scene compiler: %i of %i text fragment(s) compiled, %i used, %i laid out on demand.\n", nCompiled_, queue_.count(), nTaken_, nMissed_);
+}
+
+/*
+ * Worker Thread
+ */
+
+// Compile queued fragments (called from worker thread)
+void SceneCompiler::compileQueued()
+{
+	for (int n=0; n<queue_.count(); ++n)
+	{
+		mutex_.lock();
+		bool stop = abort_;
+		mutex_.unlock();
+		if (stop) return;
+
+		queue_.at(n)->compile();
+
+		mutex_.lock();
+		queue_.at(n)->setCompiled();
+		++nCompiled_;
+		mutex_.unlock();
+	}
+}
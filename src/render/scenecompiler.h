@@ -0,0 +1,91 @@
+/*
+	*** Scene Compiler
+	*** src/render/scenecompiler.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_SCENECOMPILER_H
+#define QUAPP_SCENECOMPILER_H
+
+#include "render/scenefragment.h"
+#include "render/textprimitive.h"
+#include "templates/list.h"
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// Forward Declarations
+class QThreadPool;
+
+/*!
+ * \brief Scene Compiler
+ * \details Lays out, ahead of time, the text which the running order will display, so that advancing the quiz only has to hand
+ * over the finished layout rather than parse, measure, and build glyph quads while the audience watches. Text is registered with
+ * addText() when a run starts and laid out by a single worker thread. setText() then takes a compiled layout if a matching one is
+ * ready, or lays out the text immediately as before if it is not.
+ */
+class SceneCompiler
+{
+	/*
+	 * Fragments
+	 */
+	private:
+	// List of fragments to compile, or which have been compiled
+	static List<SceneFragment> fragments_;
+	// Fragments, hashed by text
+	static QMultiHash<QString,SceneFragment*> fragmentHash_;
+	// Fragments queued for the worker thread, in the order they will be needed
+	static QVector<SceneFragment*> queue_;
+	// Number of fragments compiled, and taken by setText(), since the last clear()
+	static int nCompiled_, nTaken_;
+	// Number of texts laid out on demand since the last clear()
+	static int nMissed_;
+
+	public:
+	// Abandon any compilation in progress and clear all fragments
+	static void clear();
+	// Register text to be compiled
+	static void addText(QString text, TextPrimitive::TextAnchor anchor, double textSize);
+	// Start compiling registered text in the background
+	static void start();
+	// Set text of target primitive, taking a compiled layout if one is available
+	static void setText(TextPrimitive& target, QString text, TextPrimitive::TextAnchor anchor);
+	// Return number of fragments currently held
+	static int nFragments();
+	// Print compilation statistics
+	static void printStatistics();
+
+
+	/*
+	 * Worker Thread
+	 */
+	private:
+	// Thread pool running the compile job
+	static QThreadPool* threadPool_;
+	// Mutex protecting compiled flags and abort request
+	static QMutex mutex_;
+	// Whether the worker should stop compiling
+	static bool abort_;
+
+	public:
+	// Compile queued fragments (called from worker thread)
+	static void compileQueued();
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+	*** Scene Fragment
+	*** src/render/scenefragment.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/scenefragment.h"
+#include "base/tracer.h"
+
+// Constructor
+SceneFragment::SceneFragment() : ListItem<SceneFragment>()
+{
+	anchor_ = TextPrimitive::CentralAnchor;
+	textSize_ = 0.0;
+	compiled_ = false;
+}
+
+// Destructor
+SceneFragment::~SceneFragment()
+{
+}
+
+/*
+ * Definition
+ */
+
+// Set definition of fragment
+void SceneFragment::set(QString text, TextPrimitive::TextAnchor anchor, double textSize)
+{
+	text_ = text;
+	anchor_ = anchor;
+	textSize_ = textSize;
+}
+
+// Return text to lay out
+QString SceneFragment::text()
+{
+	return text_;
+}
+
+// Return whether fragment matches the text, anchor, and size specified
+bool SceneFragment::matches(QString text, TextPrimitive::TextAnchor anchor, double textSize)
+{
+	return ((anchor == anchor_) && (textSize == textSize_) && (text == text_));
+}
+
+/*
+ * Compiled Data
+ */
+
+// Compile fragment (called from the SceneCompiler's worker thread)
+void SceneFragment::compile()
+{
+	TRACESPAN("SceneFragment::compile");
+
+	layout_.setTextSize(textSize_);
+	layout_.set(text_, anchor_);
+}
+
+// Flag that fragment has been compiled
+void SceneFragment::setCompiled()
+{
+	compiled_ = true;
+}
+
+// Return whether fragment has been compiled
+bool SceneFragment::compiled()
+{
+	return compiled_;
+}
+
+// Return laid-out text
+TextPrimitive& SceneFragment::layout()
+{
+	return layout_;
+}
@@ -0,0 +1,81 @@
+/*
+	*** Scene Fragment
+	*** src/render/scenefragment.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_SCENEFRAGMENT_H
+#define QUAPP_SCENEFRAGMENT_H
+
+#include "render/textprimitive.h"
+#include "templates/list.h"
+#include <QtCore/QString>
+
+// Forward Declarations
+/* none */
+
+// Scene Fragment
+class SceneFragment : public ListItem<SceneFragment>
+{
+	public:
+	// Constructor / Destructor
+	SceneFragment();
+	~SceneFragment();
+
+
+	/*
+	 * Definition
+	 */
+	private:
+	// Text to lay out
+	QString text_;
+	// Anchor position for text
+	TextPrimitive::TextAnchor anchor_;
+	// Text size
+	double textSize_;
+
+	public:
+	// Set definition of fragment
+	void set(QString text, TextPrimitive::TextAnchor anchor, double textSize);
+	// Return text to lay out
+	QString text();
+	// Return whether fragment matches the text, anchor, and size specified
+	bool matches(QString text, TextPrimitive::TextAnchor anchor, double textSize);
+
+
+	/*
+	 * Compiled Data
+	 */
+	private:
+	// Laid-out text
+	TextPrimitive layout_;
+	// Whether the fragment has been compiled (guarded by the SceneCompiler's mutex)
+	bool compiled_;
+
+	public:
+	// Compile fragment (called from the SceneCompiler's worker thread)
+	void compile();
+	// Flag that fragment has been compiled
+	void setCompiled();
+	// Return whether fragment has been compiled
+	bool compiled();
+	// Return laid-out text
+	TextPrimitive& layout();
+};
+
+#endif
@@ -0,0 +1,334 @@
+/*
+	*** Shader Renderer
+	*** src/render/shaderrenderer.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/shaderrenderer.h"
+#include "render/glextensions.h"
+#include <QtOpenGL/QGLShaderProgram>
+#include <string.h>
+#include <stdio.h>
+
+// Vertex shader
+// Lighting matches the fixed-function light set up in Viewer::setupLighting() - ambient from the light and light model, and diffuse from a light along -z
+static const char* primitiveVertexShader =
+	"#version 120\n"
+	"attribute vec3 vertex;\n"
+	"attribute vec3 normal;\n"
+	"attribute vec4 vertexColour;\n"
+	"attribute vec2 textureCoordinate;\n"
+	"uniform mat4 projection;\n"
+	"uniform mat4 modelView;\n"
+	"uniform vec4 colour;\n"
+	"uniform float vertexColours;\n"
+	"varying vec4 litColour;\n"
+	"varying vec2 texCoord;\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 base = mix(colour, vertexColour, vertexColours);\n"
+	"	float diffuse = 0.8*max(dot(normalize(mat3(modelView) * normal), vec3(0.0, 0.0, -1.0)), 0.0);\n"
+	"	litColour = vec4(min(base.rgb * (1.2 + diffuse), 1.0), base.a);\n"
+	"	texCoord = textureCoordinate;\n"
+	"	gl_Position = projection * (modelView * vec4(vertex, 1.0));\n"
+	"}\n";
+
+// Fragment shader
+static const char* primitiveFragmentShader =
+	"#version 120\n"
+	"uniform sampler2D image;\n"
+	"uniform float texturing;\n"
+	"varying vec4 litColour;\n"
+	"varying vec2 texCoord;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = (texturing > 0.5 ? litColour * texture2D(image, texCoord) : litColour);\n"
+	"}\n";
+
+// Static Members
+bool ShaderRenderer::enabled_ = true;
+QGLShaderProgram* ShaderRenderer::program_ = NULL;
+bool ShaderRenderer::bound_ = false;
+int ShaderRenderer::projectionLocation_ = -1;
+int ShaderRenderer::modelViewLocation_ = -1;
+int ShaderRenderer::colourLocation_ = -1;
+int ShaderRenderer::vertexColoursLocation_ = -1;
+int ShaderRenderer::texturingLocation_ = -1;
+GLfloat ShaderRenderer::projection_[16] = { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+GLfloat ShaderRenderer::modelView_[16] = { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 };
+GLfloat ShaderRenderer::colour_[4] = { 1.0, 1.0, 1.0, 1.0 };
+int ShaderRenderer::vertexColours_ = -1;
+int ShaderRenderer::texturing_ = -1;
+QVector<GLuint> ShaderRenderer::releasedVertexArrays_;
+
+/*
+ * Program
+ */
+
+// Set whether the shader path should be used if the context supports it
+void ShaderRenderer::setEnabled(bool enabled)
+{
+	enabled_ = enabled;
+}
+
+// Return whether the shader path should be used if the context supports it
+bool ShaderRenderer::enabled()
+{
+	return enabled_;
+}
+
+// Create program in the current context, returning whether the shader path is available
+bool ShaderRenderer::initialise()
+{
+	clear();
+	if (!enabled_) return false;
+
+	// Compile and link shader program
+	program_ = new QGLShaderProgram;
+	bool success = program_->addShaderFromSourceCode(QGLShader::Vertex, primitiveVertexShader);
+	if (success) success = program_->addShaderFromSourceCode(QGLShader::Fragment, primitiveFragmentShader);
+	if (success)
+	{
+		program_->bindAttributeLocation("vertex", ShaderRenderer::VertexAttribute);
+		program_->bindAttributeLocation("normal", ShaderRenderer::NormalAttribute);
+		program_->bindAttributeLocation("vertexColour", ShaderRenderer::ColourAttribute);
+		program_->bindAttributeLocation("textureCoordinate", ShaderRenderer::TextureCoordinateAttribute);
+		success = program_->link();
+	}
+	if (!success)
+	{
+		printf("Failed to create primitive shader program - falling back to fixed-function rendering.\n%s\n", qPrintable(program_->log()));
+		delete program_;
+		program_ = NULL;
+		return false;
+	}
+
+	// Get uniform locations
+	projectionLocation_ = program_->uniformLocation("projection");
+	modelViewLocation_ = program_->uniformLocation("modelView");
+	colourLocation_ = program_->uniformLocation("colour");
+	vertexColoursLocation_ = program_->uniformLocation("vertexColours");
+	texturingLocation_ = program_->uniformLocation("texturing");
+
+	// Textures are always taken from the first unit
+	program_->bind();
+	program_->setUniformValue(program_->uniformLocation("image"), (GLint) 0);
+	program_->release();
+
+	return true;
+}
+
+// Delete program (requires its context to be current)
+void ShaderRenderer::clear()
+{
+	if (bound_) release();
+	if (program_) delete program_;
+	program_ = NULL;
+}
+
+// Return whether the shader path is available
+bool ShaderRenderer::available()
+{
+	return (program_ != NULL);
+}
+
+// Return whether primitives are currently being drawn through the program
+bool ShaderRenderer::active()
+{
+	return bound_;
+}
+
+// Bind program, ready to draw primitives through it
+void ShaderRenderer::bind()
+{
+	if ((!program_) || bound_) return;
+
+	program_->bind();
+	bound_ = true;
+
+	// Send current state - colour and texture sources are sent on first use
+	program_->setUniformValue(projectionLocation_, (const GLfloat (*)[4]) projection_);
+	program_->setUniformValue(modelViewLocation_, (const GLfloat (*)[4]) modelView_);
+	program_->setUniformValue(colourLocation_, colour_[0], colour_[1], colour_[2], colour_[3]);
+	vertexColours_ = -1;
+	texturing_ = -1;
+}
+
+// Release program, returning to the fixed-function pipeline
+void ShaderRenderer::release()
+{
+	if (!bound_) return;
+
+	program_->release();
+	bound_ = false;
+}
+
+// Temporarily return to the fixed-function pipeline, loading it with the current modelview matrix and colour
+bool ShaderRenderer::suspend()
+{
+	if (!bound_) return false;
+
+	release();
+	glMatrixMode(GL_MODELVIEW);
+	glLoadMatrixf(modelView_);
+	glColor4fv(colour_);
+
+	return true;
+}
+
+// Rebind program after a suspend()
+void ShaderRenderer::resume()
+{
+	bind();
+}
+
+/*
+ * Uniforms
+ */
+
+// Create orthographic projection matrix (column-major), as glOrtho() would
+void ShaderRenderer::orthographicMatrix(GLfloat* matrix, double left, double right, double bottom, double top, double nearZ, double farZ)
+{
+	memset(matrix, 0, 16*sizeof(GLfloat));
+	matrix[0] = 2.0 / (right - left);
+	matrix[5] = 2.0 / (top - bottom);
+	matrix[10] = -2.0 / (farZ - nearZ);
+	matrix[12] = -(right + left) / (right - left);
+	matrix[13] = -(top + bottom) / (top - bottom);
+	matrix[14] = -(farZ + nearZ) / (farZ - nearZ);
+	matrix[15] = 1.0;
+}
+
+// Create perspective projection matrix (column-major), as glFrustum() would
+void ShaderRenderer::frustumMatrix(GLfloat* matrix, double left, double right, double bottom, double top, double nearZ, double farZ)
+{
+	memset(matrix, 0, 16*sizeof(GLfloat));
+	matrix[0] = 2.0*nearZ / (right - left);
+	matrix[5] = 2.0*nearZ / (top - bottom);
+	matrix[8] = (right + left) / (right - left);
+	matrix[9] = (top + bottom) / (top - bottom);
+	matrix[10] = -(farZ + nearZ) / (farZ - nearZ);
+	matrix[11] = -1.0;
+	matrix[14] = -2.0*farZ*nearZ / (farZ - nearZ);
+}
+
+// Set orthographic projection
+void ShaderRenderer::setOrthographic(double left, double right, double bottom, double top, double nearZ, double farZ)
+{
+	orthographicMatrix(projection_, left, right, bottom, top, nearZ, farZ);
+
+	if (bound_) program_->setUniformValue(projectionLocation_, (const GLfloat (*)[4]) projection_);
+}
+
+// Set perspective projection
+void ShaderRenderer::setFrustum(double left, double right, double bottom, double top, double nearZ, double farZ)
+{
+	frustumMatrix(projection_, left, right, bottom, top, nearZ, farZ);
+
+	if (bound_) program_->setUniformValue(projectionLocation_, (const GLfloat (*)[4]) projection_);
+}
+
+// Set modelview matrix (column-major)
+void ShaderRenderer::setModelView(const GLfloat* matrix)
+{
+	memcpy(modelView_, matrix, 16*sizeof(GLfloat));
+
+	if (bound_) program_->setUniformValue(modelViewLocation_, (const GLfloat (*)[4]) modelView_);
+}
+
+// Set object colour
+void ShaderRenderer::setColour(const GLfloat* colour)
+{
+	memcpy(colour_, colour, 4*sizeof(GLfloat));
+
+	if (bound_) program_->setUniformValue(colourLocation_, colour_[0], colour_[1], colour_[2], colour_[3]);
+}
+
+// Set whether colour comes from vertex data (rather than the object) and whether the bound texture is applied
+void ShaderRenderer::setSources(bool vertexColours, bool texturing)
+{
+	if (!bound_) return;
+
+	// Most consecutive primitives share their sources, so only send them when they change
+	if (vertexColours_ != int(vertexColours))
+	{
+		vertexColours_ = int(vertexColours);
+		program_->setUniformValue(vertexColoursLocation_, vertexColours ? 1.0f : 0.0f);
+	}
+	if (texturing_ != int(texturing))
+	{
+		texturing_ = int(texturing);
+		program_->setUniformValue(texturingLocation_, texturing ? 1.0f : 0.0f);
+	}
+}
+
+/*
+ * Vertex Layout
+ */
+
+// Point attributes at interleaved ([T2F_][C4F_]N3F_V3F) data, held in client memory or at an offset in the bound buffer
+void ShaderRenderer::setAttributes(const GLvoid* data, bool colourData, bool textureData)
+{
+	const GLfloat* values = (const GLfloat*) data;
+	int stride = (6 + (colourData ? 4 : 0) + (textureData ? 2 : 0)) * sizeof(GLfloat);
+
+	if (textureData)
+	{
+		program_->enableAttributeArray(ShaderRenderer::TextureCoordinateAttribute);
+		program_->setAttributeArray(ShaderRenderer::TextureCoordinateAttribute, values, 2, stride);
+		values += 2;
+	}
+	if (colourData)
+	{
+		program_->enableAttributeArray(ShaderRenderer::ColourAttribute);
+		program_->setAttributeArray(ShaderRenderer::ColourAttribute, values, 4, stride);
+		values += 4;
+	}
+	program_->enableAttributeArray(ShaderRenderer::NormalAttribute);
+	program_->setAttributeArray(ShaderRenderer::NormalAttribute, values, 3, stride);
+	program_->enableAttributeArray(ShaderRenderer::VertexAttribute);
+	program_->setAttributeArray(ShaderRenderer::VertexAttribute, values+3, 3, stride);
+}
+
+// Disable attribute arrays enabled by setAttributes()
+void ShaderRenderer::clearAttributes(bool colourData, bool textureData)
+{
+	program_->disableAttributeArray(ShaderRenderer::VertexAttribute);
+	program_->disableAttributeArray(ShaderRenderer::NormalAttribute);
+	if (colourData) program_->disableAttributeArray(ShaderRenderer::ColourAttribute);
+	if (textureData) program_->disableAttributeArray(ShaderRenderer::TextureCoordinateAttribute);
+}
+
+/*
+ * Vertex Array Objects
+ */
+
+// Queue vertex array object for deletion (no GL context required)
+void ShaderRenderer::releaseVertexArray(GLuint vertexArrayObject)
+{
+	releasedVertexArrays_.append(vertexArrayObject);
+}
+
+// Delete queued vertex array objects (requires the context to be current)
+void ShaderRenderer::deleteReleasedVertexArrays(GLExtensions* extensions)
+{
+	if (releasedVertexArrays_.isEmpty()) return;
+
+	extensions->glDeleteVertexArrays(releasedVertexArrays_.count(), releasedVertexArrays_.constData());
+	releasedVertexArrays_.clear();
+}
@@ -0,0 +1,135 @@
+/*
+	*** Shader Renderer
+	*** src/render/shaderrenderer.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_SHADERRENDERER_H
+#define QUAPP_SHADERRENDERER_H
+
+#ifndef __APPLE__
+#include <GL/gl.h>
+#else
+#include <OpenGL/gl3.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include "glext.h"
+#endif
+#include <QtCore/QVector>
+
+// Forward Declarations
+class GLExtensions;
+class QGLShaderProgram;
+
+// Shader Renderer
+class ShaderRenderer
+{
+	/*
+	 * Program
+	 */
+	public:
+	// Vertex attribute locations
+	enum Attribute { VertexAttribute, NormalAttribute, ColourAttribute, TextureCoordinateAttribute, nAttributes };
+
+	private:
+	// Whether the shader path should be used if the context supports it
+	static bool enabled_;
+	// Program used to draw all primitives
+	static QGLShaderProgram* program_;
+	// Whether the program is currently bound
+	static bool bound_;
+
+	public:
+	// Set whether the shader path should be used if the context supports it
+	static void setEnabled(bool enabled);
+	// Return whether the shader path should be used if the context supports it
+	static bool enabled();
+	// Create program in the current context, returning whether the shader path is available
+	static bool initialise();
+	// Delete program (requires its context to be current)
+	static void clear();
+	// Return whether the shader path is available
+	static bool available();
+	// Return whether primitives are currently being drawn through the program
+	static bool active();
+	// Bind program, ready to draw primitives through it
+	static void bind();
+	// Release program, returning to the fixed-function pipeline
+	static void release();
+	// Temporarily return to the fixed-function pipeline, loading it with the current modelview matrix and colour
+	static bool suspend();
+	// Rebind program after a suspend()
+	static void resume();
+
+
+	/*
+	 * Uniforms
+	 */
+	private:
+	// Uniform locations
+	static int projectionLocation_, modelViewLocation_, colourLocation_, vertexColoursLocation_, texturingLocation_;
+	// Current projection and modelview matrices (column-major)
+	static GLfloat projection_[16], modelView_[16];
+	// Current object colour
+	static GLfloat colour_[4];
+	// Colour and texture sources last sent to the program (-1 if unknown)
+	static int vertexColours_, texturing_;
+
+	public:
+	// Create orthographic projection matrix (column-major), as glOrtho() would
+	static void orthographicMatrix(GLfloat* matrix, double left, double right, double bottom, double top, double nearZ, double farZ);
+	// Create perspective projection matrix (column-major), as glFrustum() would
+	static void frustumMatrix(GLfloat* matrix, double left, double right, double bottom, double top, double nearZ, double farZ);
+	// Set orthographic projection
+	static void setOrthographic(double left, double right, double bottom, double top, double nearZ, double farZ);
+	// Set perspective projection
+	static void setFrustum(double left, double right, double bottom, double top, double nearZ, double farZ);
+	// Set modelview matrix (column-major)
+	static void setModelView(const GLfloat* matrix);
+	// Set object colour
+	static void setColour(const GLfloat* colour);
+	// Set whether colour comes from vertex data (rather than the object) and whether the bound texture is applied
+	static void setSources(bool vertexColours, bool texturing);
+
+
+	/*
+	 * Vertex Layout
+	 */
+	public:
+	// Point attributes at interleaved ([T2F_][C4F_]N3F_V3F) data, held in client memory or at an offset in the bound buffer
+	static void setAttributes(const GLvoid* data, bool colourData, bool textureData);
+	// Disable attribute arrays enabled by setAttributes()
+	static void clearAttributes(bool colourData, bool textureData);
+
+
+	/*
+	 * Vertex Array Objects
+	 */
+	private:
+	// Vertex array objects no longer in use, waiting for the context to be current so they can be deleted
+	static QVector<GLuint> releasedVertexArrays_;
+
+	public:
+	// Queue vertex array object for deletion (no GL context required)
+	static void releaseVertexArray(GLuint vertexArrayObject);
+	// Delete queued vertex array objects (requires the context to be current)
+	static void deleteReleasedVertexArrays(GLExtensions* extensions);
+};
+
+#endif
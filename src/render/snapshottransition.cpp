@@ -0,0 +1,168 @@
+/*
+	*** Snapshot Transition
+	*** src/render/snapshottransition.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/snapshottransition.h"
+#include "render/animationclock.h"
+#include <math.h>
+
+// TransitionType Keywords
+const char* TransitionTypeKeywords[] = { "fade", "slide", "rotate" };
+
+// Convert text string to TransitionType
+SnapshotTransition::TransitionType SnapshotTransition::transitionType(QString s)
+{
+	for (int n=0; n<SnapshotTransition::nTransitionTypes; ++n) if (s == TransitionTypeKeywords[n]) return (SnapshotTransition::TransitionType) n;
+	return SnapshotTransition::nTransitionTypes;
+}
+
+// Convert TransitionType to text string
+const char* SnapshotTransition::transitionType(SnapshotTransition::TransitionType tt)
+{
+	return TransitionTypeKeywords[tt];
+}
+
+// Static Members
+SnapshotTransition::TransitionType SnapshotTransition::defaultType_ = SnapshotTransition::FadeTransition;
+
+// Constructor
+SnapshotTransition::SnapshotTransition()
+{
+	type_ = SnapshotTransition::FadeTransition;
+	startTime_ = 0.0;
+	duration_ = 0.0;
+	started_ = false;
+}
+
+// Destructor
+SnapshotTransition::~SnapshotTransition()
+{
+}
+
+/*
+ * Snapshot
+ */
+
+// Return whether snapshots can be taken in the current context
+bool SnapshotTransition::supported(GLExtensions* extensions)
+{
+	return LayerCache::supported(extensions);
+}
+
+// Begin drawing outgoing scene into snapshot, returning false if this is not possible
+bool SnapshotTransition::beginCapture(GLExtensions* extensions, int width, int height)
+{
+	started_ = false;
+	return snapshot_.begin(extensions, width, height);
+}
+
+// Finish drawing outgoing scene into snapshot
+void SnapshotTransition::endCapture()
+{
+	snapshot_.end(0);
+}
+
+// Delete snapshot framebuffers (requires the context to be current)
+void SnapshotTransition::clear()
+{
+	snapshot_.clear();
+	started_ = false;
+}
+
+/*
+ * Animation
+ */
+
+// Set transformation and opacity of snapshot at specified progress (0.0 to 1.0) through transition
+void SnapshotTransition::transform(double progress, double aspectRatio, GLfloat* matrix, GLfloat& opacity)
+{
+	// Start from identity, with the snapshot filling the target
+	for (int n=0; n<16; ++n) matrix[n] = (n%5 == 0 ? 1.0f : 0.0f);
+	opacity = 1.0f;
+
+	// Ease in and out
+	double t = progress*progress*(3.0 - 2.0*progress);
+
+	switch (type_)
+	{
+		// Fade out where it stands
+		case (SnapshotTransition::FadeTransition):
+			opacity = 1.0 - t;
+			break;
+		// Slide off to the left
+		case (SnapshotTransition::SlideTransition):
+			matrix[12] = -2.0*t;
+			break;
+		// Spin and shrink into the centre, fading as it goes - rotation is applied in display space, so that the snapshot is not sheared
+		case (SnapshotTransition::RotateTransition):
+		{
+			double angle = t*M_PI, scale = 1.0 - t;
+			double c = cos(angle)*scale, s = sin(angle)*scale;
+			matrix[0] = c;
+			matrix[1] = s*aspectRatio;
+			matrix[4] = -s/aspectRatio;
+			matrix[5] = c;
+			opacity = 1.0 - t;
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+// Set transition type used when none is specified
+void SnapshotTransition::setDefaultType(SnapshotTransition::TransitionType tt)
+{
+	defaultType_ = tt;
+}
+
+// Return transition type used when none is specified
+SnapshotTransition::TransitionType SnapshotTransition::defaultType()
+{
+	return defaultType_;
+}
+
+// Start transition of captured snapshot from the current animation time
+void SnapshotTransition::start(SnapshotTransition::TransitionType tt, double duration)
+{
+	type_ = tt;
+	duration_ = duration;
+	startTime_ = AnimationClock::frameTime();
+	started_ = true;
+}
+
+// Return whether transition is still in progress at the current animation time
+bool SnapshotTransition::isActive()
+{
+	return started_ && ((AnimationClock::frameTime() - startTime_) < duration_);
+}
+
+// Draw snapshot at its current point in the transition
+void SnapshotTransition::draw(double aspectRatio)
+{
+	if (!isActive()) return;
+
+	double progress = (AnimationClock::frameTime() - startTime_) / duration_;
+	if (progress < 0.0) progress = 0.0;
+
+	GLfloat matrix[16], opacity;
+	transform(progress, aspectRatio, matrix, opacity);
+	snapshot_.composite(matrix, opacity);
+}
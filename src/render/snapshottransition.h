@@ -0,0 +1,102 @@
+/*
+	*** Snapshot Transition
+	*** src/render/snapshottransition.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_SNAPSHOTTRANSITION_H
+#define QUAPP_SNAPSHOTTRANSITION_H
+
+#include "render/layercache.h"
+#include <QtCore/QString>
+
+// Forward Declarations
+class GLExtensions;
+
+/*!
+ * \brief Snapshot Transition
+ * \details Holds a snapshot of the outgoing scene, captured once when moving between segments, and animates it out of view
+ * as a single quad. The objects making up the outgoing scene can therefore be freed as soon as the snapshot is taken.
+ * Each transition type is a function of the transition's progress, giving the snapshot's transformation and opacity - new
+ * types need only an entry in the TransitionType enum, its keyword, and a case in transform().
+ */
+class SnapshotTransition
+{
+	public:
+	// Constructor / Destructor
+	SnapshotTransition();
+	~SnapshotTransition();
+	// Transition types
+	enum TransitionType { FadeTransition, SlideTransition, RotateTransition, nTransitionTypes };
+	// Convert text string to TransitionType
+	static TransitionType transitionType(QString s);
+	// Convert TransitionType to text string
+	static const char* transitionType(TransitionType tt);
+
+
+	/*
+	 * Snapshot
+	 */
+	private:
+	// Framebuffer holding snapshot of outgoing scene
+	LayerCache snapshot_;
+
+	public:
+	// Return whether snapshots can be taken in the current context
+	static bool supported(GLExtensions* extensions);
+	// Begin drawing outgoing scene into snapshot, returning false if this is not possible
+	bool beginCapture(GLExtensions* extensions, int width, int height);
+	// Finish drawing outgoing scene into snapshot
+	void endCapture();
+	// Delete snapshot framebuffers (requires the context to be current)
+	void clear();
+
+
+	/*
+	 * Animation
+	 */
+	private:
+	// Transition type used when none is specified
+	static TransitionType defaultType_;
+	// Type of current transition
+	TransitionType type_;
+	// Animation time at which transition started
+	double startTime_;
+	// Duration of transition (in seconds)
+	double duration_;
+	// Whether a transition has been started
+	bool started_;
+
+	private:
+	// Set transformation and opacity of snapshot at specified progress (0.0 to 1.0) through transition
+	void transform(double progress, double aspectRatio, GLfloat* matrix, GLfloat& opacity);
+
+	public:
+	// Set transition type used when none is specified
+	static void setDefaultType(TransitionType tt);
+	// Return transition type used when none is specified
+	static TransitionType defaultType();
+	// Start transition of captured snapshot from the current animation time
+	void start(TransitionType tt, double duration);
+	// Return whether transition is still in progress at the current animation time
+	bool isActive();
+	// Draw snapshot at its current point in the transition
+	void draw(double aspectRatio);
+};
+
+#endif
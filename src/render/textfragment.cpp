@@ -20,6 +20,7 @@
 */
 
 #include "render/textfragment.h"
+#include "templates/objectpool.h"
 
 // Constructor
 TextFragment::TextFragment() : ListItem<TextFragment>()
@@ -35,6 +36,18 @@ TextFragment::~TextFragment()
 
 }
 
+// Allocate storage from object pool
+void* TextFragment::operator new(size_t size)
+{
+	return ObjectPool<TextFragment>::allocate(size);
+}
+
+// Return storage to object pool
+void TextFragment::operator delete(void* object, size_t size)
+{
+	ObjectPool<TextFragment>::release(object, size);
+}
+
 // Set fragment data
 void TextFragment::set(QString& text, double scale, Vec3<double> translation, bool italic, bool bold)
 {
@@ -74,3 +87,38 @@ bool TextFragment::bold()
 {
 	return bold_;
 }
+
+/*
+ * Layout
+ */
+
+// Set unscaled bounding box of fragment text
+void TextFragment::setBoundingBox(Vec3<double> lowerLeft, Vec3<double> upperRight)
+{
+	lowerLeft_ = lowerLeft;
+	upperRight_ = upperRight;
+}
+
+// Return lower left coordinate of unscaled bounding box
+Vec3<double> TextFragment::lowerLeft()
+{
+	return lowerLeft_;
+}
+
+// Return upper right coordinate of unscaled bounding box
+Vec3<double> TextFragment::upperRight()
+{
+	return upperRight_;
+}
+
+// Set cached transformation matrix for fragment
+void TextFragment::setTransformationMatrix(const Matrix& matrix)
+{
+	transformationMatrix_ = matrix;
+}
+
+// Return cached transformation matrix for fragment
+const Matrix& TextFragment::transformationMatrix()
+{
+	return transformationMatrix_;
+}
@@ -22,6 +22,7 @@
 #ifndef QUAPP_TEXTFRAGMENT_H
 #define QUAPP_TEXTFRAGMENT_H
 
+#include "math/matrix.h"
 #include "templates/vector3.h"
 #include "templates/list.h"
 #include <QtCore/QString>
@@ -36,6 +37,10 @@ class TextFragment : public ListItem<TextFragment>
 	// Constructor / Destructor
 	TextFragment();
 	~TextFragment();
+	// Allocate storage from object pool
+	static void* operator new(size_t size);
+	// Return storage to object pool
+	static void operator delete(void* object, size_t size);
 
 
 	/*
@@ -66,6 +71,28 @@ class TextFragment : public ListItem<TextFragment>
 	bool italic();
 	// Return whether fragment is to be drawn bold
 	bool bold();
+
+
+	/*
+	 * Layout
+	 */
+	private:
+	// Unscaled bounding box of fragment text
+	Vec3<double> lowerLeft_, upperRight_;
+	// Cached transformation matrix for fragment
+	Matrix transformationMatrix_;
+
+	public:
+	// Set unscaled bounding box of fragment text
+	void setBoundingBox(Vec3<double> lowerLeft, Vec3<double> upperRight);
+	// Return lower left coordinate of unscaled bounding box
+	Vec3<double> lowerLeft();
+	// Return upper right coordinate of unscaled bounding box
+	Vec3<double> upperRight();
+	// Set cached transformation matrix for fragment
+	void setTransformationMatrix(const Matrix& matrix);
+	// Return cached transformation matrix for fragment
+	const Matrix& transformationMatrix();
 };
 
 #endif
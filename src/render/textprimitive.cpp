@@ -22,6 +22,7 @@
 #include "render/textprimitive.h"
 #include "render/textprimitive_grammar.hh"
 #include "render/fontinstance.h"
+#include "render/shaderrenderer.h"
 
 // Static members
 TextPrimitive* TextPrimitive::target_ = NULL;
@@ -34,6 +35,9 @@ double TextPrimitive::horizontalPosition_;
 TextPrimitive::TextPrimitive() : ListItem<TextPrimitive>()
 {
 	textSize_ = 1.0;
+	anchorPosition_ = TextPrimitive::CentralAnchor;
+	glyphQuadsChanged_ = false;
+	useAtlas_ = false;
 }
 
 // Destructor
@@ -70,13 +74,20 @@ TextPrimitive::EscapeSequence TextPrimitive::escapeSequence(QString s)
 // Clear fragments
 void TextPrimitive::clear()
 {
+	QMutexLocker locker(&FontInstance::mutex());
 	fragments_.clear();
+	updateLayout();
 }
 
 // Set text size
 void TextPrimitive::setTextSize(double textSize)
 {
+	if (textSize == textSize_) return;
+	QMutexLocker locker(&FontInstance::mutex());
 	textSize_ = textSize;
+
+	// Transformation matrices depend on the text size, so must be recalculated
+	updateLayout();
 }
 
 // Return text size
@@ -88,59 +99,209 @@ double TextPrimitive::textSize()
 // Set text
 void TextPrimitive::set(QString text, TextPrimitive::TextAnchor anchorPosition)
 {
-	TextFragment* fragment;
-	Vec3<double> ll, ur, translation;
-	double scale, y;
-	QString fragmentText;
-	int supSub = 0;
+	// The parser and font are shared by all primitives, and text may also be laid out by the SceneCompiler's worker thread
+	QMutexLocker locker(&FontInstance::mutex());
 
 	// Call the parser // TODO Note return value!
 	generateFragments(this, text);
 
 	anchorPosition_ = anchorPosition;
+
+	// Lay out the new fragments now, rather than every time the primitive is drawn
+	updateLayout();
+}
+
+// Take fragments and layout from specified (compiled) primitive, leaving it empty
+void TextPrimitive::takeLayout(TextPrimitive& source)
+{
+	fragments_.clear();
+	TextFragment* fragment;
+	while ((fragment = source.fragments_.first()) != NULL)
+	{
+		source.fragments_.disown(fragment);
+		fragments_.own(fragment);
+	}
+
+	anchorPosition_ = source.anchorPosition_;
+	textSize_ = source.textSize_;
+	lowerLeft_ = source.lowerLeft_;
+	upperRight_ = source.upperRight_;
+	textMatrix_ = source.textMatrix_;
+
+	glyphQuads_.takeData(source.glyphQuads_);
+	useAtlas_ = source.useAtlas_;
+
+	// If an instance already exists it is now out of date
+	if (glyphQuads_.nInstances() > 0) glyphQuadsChanged_ = true;
 }
 
 // Return transformation matrix to use when rendering the text
 Matrix TextPrimitive::transformationMatrix(TextFragment* fragment) const
+{
+	return (fragment ? fragment->transformationMatrix() : textMatrix_);
+}
+
+// Return bounding box of primitive
+void TextPrimitive::boundingBox(Vec3<double>& lowerLeft, Vec3<double>& upperRight) const
+{
+	lowerLeft = lowerLeft_;
+	upperRight = upperRight_;
+}
+
+// Return total width of text primitive
+double TextPrimitive::textWidth()
+{
+	return upperRight_.x - lowerLeft_.x;
+}
+
+// Render primitive
+void TextPrimitive::sendToGL() const
+{
+	// If we are using the glyph atlas, the glyph quads are already in their final positions and may be drawn in one go
+	// Don't write to the depth buffer, otherwise the transparent edges of overlapping glyph quads will obscure each other
+	if (useAtlas_)
+	{
+		glDepthMask(GL_FALSE);
+		glyphQuads_.sendToGL();
+		glDepthMask(GL_TRUE);
+		return;
+	}
+
+	// No glyph atlas, so render fragments using the FTGL font
+	QMutexLocker locker(&FontInstance::mutex());
+	if (!FontInstance::font()) return;
+
+	// FTGL draws through the fixed-function pipeline
+	bool suspended = ShaderRenderer::suspend();
+
+	// Loop over fragments
+	for (TextFragment* fragment = fragments_.first(); fragment != NULL; fragment = fragment->next)
+	{
+		glPushMatrix();
+		glMultMatrixd(fragment->transformationMatrix().matrix());
+
+		// Draw bounding boxes around each fragment
+		if (false)
+		{
+			glDisable(GL_LINE_STIPPLE);
+			glLineWidth(1.0);
+			Vec3<double> ll = fragment->lowerLeft(), ur = fragment->upperRight();
+			glBegin(GL_LINE_LOOP);
+			glVertex3d(ll.x, ll.y, 0.0);
+			glVertex3d(ur.x, ll.y, 0.0);
+			glVertex3d(ur.x, ur.y, 0.0);
+			glVertex3d(ll.x, ur.y, 0.0);
+			glEnd();
+		}
+
+		if (fragment->bold())
+		{
+			// Render the text twice - once with lines, and once with polygon fill
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			FontInstance::font()->Render(qPrintable(fragment->text()));
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			FontInstance::font()->Render(qPrintable(fragment->text()));
+		}
+		else FontInstance::font()->Render(qPrintable(fragment->text()));
+
+		glPopMatrix();
+	}
+
+	if (suspended) ShaderRenderer::resume();
+}
+
+// Add to draw queue
+void TextPrimitive::queue(DrawQueue& drawQueue, DrawQueue::Layer layer, const GLfloat* matrix, const GLfloat* colour) const
+{
+	// Glyph quads may be merged with those of other primitives, but FTGL text must be drawn on its own
+	if (useAtlas_) drawQueue.addPrimitive(layer, &glyphQuads_, matrix, colour, DrawQueue::OverlayBlend);
+	else if (fragments_.nItems() > 0) drawQueue.addText(layer, this, matrix, colour);
+}
+
+/*
+ * Layout
+ */
+
+// Calculate bounding box of primitive from fragment data
+void TextPrimitive::calculateBoundingBox()
+{
+	// Set initial lowerLeft and upperRight from the first primitive in the list
+	if (fragments_.first())
+	{
+		lowerLeft_ = fragments_.first()->lowerLeft();
+		upperRight_ = fragments_.first()->upperRight();
+	}
+	else
+	{
+		// No fragments in list!
+		lowerLeft_.zero();
+		upperRight_.zero();
+		return;
+	}
+	
+	// Loop over remaining fragments, keeping track of the total width of the primitive and the max/min y values
+	Vec3<double> ll, ur;
+	for (TextFragment* fragment = fragments_.first()->next; fragment != NULL; fragment = fragment->next)
+	{
+		// Get bounding box for this fragment
+		ll = fragment->lowerLeft();
+		ur = fragment->upperRight();
+
+		// Scale the box by the current scaling factor...
+		ur.x = ll.x + (ur.x - ll.x)*fragment->scale();
+		ur.y = ll.y + (ur.y - ll.y)*fragment->scale();
+
+		// Translate the box by the defined amount
+		ll += fragment->translation();
+		ur += fragment->translation();
+
+		// Update lowerLeft and upperRight values
+		if (ll.y < lowerLeft_.y) lowerLeft_.y = ll.y;
+		if (ur.y > upperRight_.y) upperRight_.y = ur.y;
+		if (ur.x > upperRight_.x) upperRight_.x = ur.x;
+	}
+}
+
+// Calculate transformation matrix (including fragment scale/translation if one is specified)
+Matrix TextPrimitive::calculateTransformationMatrix(TextFragment* fragment) const
 {
 	Matrix textMatrix;
-	Vec3<double> lowerLeft, upperRight, anchorPos, textCentre;
+	Vec3<double> anchorPos, textCentre;
 	
-	// Calculate bounding box and anchor position on it
-	boundingBox(lowerLeft, upperRight);
+	// Determine anchor position on bounding box
 	switch (anchorPosition_)
 	{
 		case (TextPrimitive::TopLeftAnchor):
-			anchorPos.set(lowerLeft.x, upperRight.y, 0.0);
+			anchorPos.set(lowerLeft_.x, upperRight_.y, 0.0);
 			break;
 		case (TextPrimitive::TopMiddleAnchor):
-			anchorPos.set((lowerLeft.x+upperRight.x)*0.5, upperRight.y, 0.0);
+			anchorPos.set((lowerLeft_.x+upperRight_.x)*0.5, upperRight_.y, 0.0);
 			break;
 		case (TextPrimitive::TopRightAnchor):
-			anchorPos = upperRight;
+			anchorPos = upperRight_;
 			break;
 		case (TextPrimitive::MiddleLeftAnchor):
-			anchorPos.set(lowerLeft.x, (lowerLeft.y+upperRight.y)*0.5, 0.0);
+			anchorPos.set(lowerLeft_.x, (lowerLeft_.y+upperRight_.y)*0.5, 0.0);
 			break;
 		case (TextPrimitive::CentralAnchor):
-			anchorPos.set((lowerLeft.x+upperRight.x)*0.5, (lowerLeft.y+upperRight.y)*0.5, 0.0);
+			anchorPos.set((lowerLeft_.x+upperRight_.x)*0.5, (lowerLeft_.y+upperRight_.y)*0.5, 0.0);
 			break;
 		case (TextPrimitive::MiddleRightAnchor):
-			anchorPos.set(upperRight.x, (lowerLeft.y+upperRight.y)*0.5, 0.0);
+			anchorPos.set(upperRight_.x, (lowerLeft_.y+upperRight_.y)*0.5, 0.0);
 			break;
 		case (TextPrimitive::BottomLeftAnchor):
-			anchorPos = lowerLeft;
+			anchorPos = lowerLeft_;
 			break;
 		case (TextPrimitive::BottomMiddleAnchor):
-			anchorPos.set((lowerLeft.x+upperRight.x)*0.5, lowerLeft.y, 0.0);
+			anchorPos.set((lowerLeft_.x+upperRight_.x)*0.5, lowerLeft_.y, 0.0);
 			break;
 		case (TextPrimitive::BottomRightAnchor):
-			anchorPos.set(upperRight.x, lowerLeft.y, 0.0);
+			anchorPos.set(upperRight_.x, lowerLeft_.y, 0.0);
 			break;
 	}
 
 	// Set anchor position
-	textCentre = (lowerLeft + upperRight) * 0.5;
+	textCentre = (lowerLeft_ + upperRight_) * 0.5;
 	anchorPos -= textCentre;
 
 	// Construct matrix
@@ -162,89 +323,85 @@ Matrix TextPrimitive::transformationMatrix(TextFragment* fragment) const
 	return textMatrix;
 }
 
-// Calculate bounding box of primitive
-void TextPrimitive::boundingBox(Vec3<double>& lowerLeft, Vec3<double>& upperRight) const
+// Update cached layout (bounding box and transformation matrices)
+void TextPrimitive::updateLayout()
 {
-	// Set initial lowerLeft and upperRight from the first primitive in the list
-	if (fragments_.first()) FontInstance::boundingBox(fragments_.first()->text(), lowerLeft, upperRight);
-	else
-	{
-		// No fragments in list!
-		lowerLeft.zero();
-		upperRight.zero();
-		return;
-	}
-	
-	// Loop over remaining fragments, keeping track of the total width of the primitive and the max/min y values
-	Vec3<double> ll, ur;
-	double width = upperRight.x - lowerLeft.x;
-	for (TextFragment* fragment = fragments_.first()->next; fragment != NULL; fragment = fragment->next)
-	{
-		// Get bounding box for this fragment
-		FontInstance::boundingBox(fragment->text(), ll, ur);
+	calculateBoundingBox();
 
-		// Scale the box by the current scaling factor...
-		ur.x = ll.x + (ur.x - ll.x)*fragment->scale();
-		ur.y = ll.y + (ur.y - ll.y)*fragment->scale();
+	textMatrix_ = calculateTransformationMatrix();
+	for (TextFragment* fragment = fragments_.first(); fragment != NULL; fragment = fragment->next) fragment->setTransformationMatrix(calculateTransformationMatrix(fragment));
 
-		// Translate the box by the defined amount
-		ll += fragment->translation();
-		ur += fragment->translation();
-
-		// Update lowerLeft and upperRight values
-		if (ll.y < lowerLeft.y) lowerLeft.y = ll.y;
-		if (ur.y > upperRight.y) upperRight.y = ur.y;
-		if (ur.x > upperRight.x) upperRight.x = ur.x;
-	}
+	createGlyphQuads();
 }
 
-// Return total width of text primitive
-double TextPrimitive::textWidth()
-{
-	Vec3<double> ll, ur;
-	boundingBox(ll, ur);
-	return ur.x-ll.x;
-}
+/*
+ * Glyph Quads
+ */
 
-// Render primitive
-void TextPrimitive::sendToGL() const
+// Create textured glyph quads from fragment data
+void TextPrimitive::createGlyphQuads()
 {
-	Matrix textMatrix;
-
-	// Loop over fragments
+	useAtlas_ = FontInstance::atlasOK();
+	if (!useAtlas_) return;
+
+	// Count total number of characters so we can size the primitive
+	int nCharacters = 0;
+	for (TextFragment* fragment = fragments_.first(); fragment != NULL; fragment = fragment->next) nCharacters += fragment->text().length();
+	if (nCharacters == 0) glyphQuads_.forgetAll();
+	else glyphQuads_.initialise(nCharacters*4, nCharacters*6, GL_TRIANGLES, false, true);
+
+	// Loop over fragments, generating a quad for each glyph
+	// Bold glyphs come from the bold section of the atlas, while italic shear and sub/superscript scaling are contained in the fragment matrix
+	FontGlyph* glyph;
+	QString text;
+	Vec3<double> normal(0.0, 0.0, 1.0);
+	GLuint a, b, c, d;
+	double penX;
 	for (TextFragment* fragment = fragments_.first(); fragment != NULL; fragment = fragment->next)
 	{
-		textMatrix = transformationMatrix(fragment);
-		glPushMatrix();
-		glMultMatrixd(textMatrix.matrix());
-
-		// Draw bounding boxes around each fragment
-		if (false)
+		const Matrix& matrix = fragment->transformationMatrix();
+		text = fragment->text();
+		penX = 0.0;
+		for (int n=0; n<text.length(); ++n)
 		{
-			glDisable(GL_LINE_STIPPLE);
-			glLineWidth(1.0);
-			Vec3<double> ll, ur;
-			FontInstance::boundingBox(fragment->text(), ll, ur);
-			glBegin(GL_LINE_LOOP);
-			glVertex3d(ll.x, ll.y, 0.0);
-			glVertex3d(ur.x, ll.y, 0.0);
-			glVertex3d(ur.x, ur.y, 0.0);
-			glVertex3d(ll.x, ur.y, 0.0);
-			glEnd();
-		}
+			glyph = FontInstance::glyph(text.at(n), fragment->bold());
+			if (!glyph)
+			{
+				// The atlas has no room for this glyph, so the whole primitive is drawn with the FTGL font instead (if we have one)
+				if (FontInstance::font()) useAtlas_ = false;
+				continue;
+			}
 
-		if (fragment->bold())
-		{
-			// Render the text twice - once with lines, and once with polygon fill
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-			FontInstance::font()->Render(qPrintable(fragment->text()));
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			FontInstance::font()->Render(qPrintable(fragment->text()));
-		}
-		else FontInstance::font()->Render(qPrintable(fragment->text()));
+			if (!glyph->blank())
+			{
+				a = glyphQuads_.defineVertexNT(matrix.transform(penX+glyph->x0(), glyph->y0(), 0.0), normal, glyph->s0(), glyph->t0());
+				b = glyphQuads_.defineVertexNT(matrix.transform(penX+glyph->x1(), glyph->y0(), 0.0), normal, glyph->s1(), glyph->t0());
+				c = glyphQuads_.defineVertexNT(matrix.transform(penX+glyph->x1(), glyph->y1(), 0.0), normal, glyph->s1(), glyph->t1());
+				d = glyphQuads_.defineVertexNT(matrix.transform(penX+glyph->x0(), glyph->y1(), 0.0), normal, glyph->s0(), glyph->t1());
+				glyphQuads_.defineIndices(a, b, c);
+				glyphQuads_.defineIndices(a, c, d);
+			}
 
-		glPopMatrix();
+			penX += glyph->advance();
+		}
 	}
+
+	if (!useAtlas_) glyphQuads_.forgetAll();
+
+	// If an instance already exists it is now out of date
+	if (glyphQuads_.nInstances() > 0) glyphQuadsChanged_ = true;
+}
+
+// Push instance of glyph quads, if one does not exist or the current one is out of date
+void TextPrimitive::updateInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena)
+{
+	if ((!useAtlas_) || (FontInstance::atlasTexture() == 0)) return;
+
+	// All primitives share the atlas texture, which is kept up to date by the Viewer (so holds any glyphs we have just added)
+	glyphQuads_.setTextureObject(FontInstance::atlasTexture());
+	if (glyphQuadsChanged_ && (glyphQuads_.nInstances() > 0)) glyphQuads_.popInstance(context);
+	if (glyphQuads_.nInstances() == 0) glyphQuads_.pushInstance(context, extensions, arena);
+	glyphQuadsChanged_ = false;
 }
 
 /*
@@ -390,9 +547,14 @@ bool TextPrimitive::addFragment(QString text)
 	// Set fragment info
 	Vec3<double> translation(horizontalPosition_, format->y(), 0.0); 
 	fragment->set(text, format->scale(), translation, format->italic(), format->bold());
+
+	// Store the bounding box of the fragment text, so we need only query the font once
+	Vec3<double> ll, ur;
+	FontInstance::boundingBox(text, ll, ur, format->bold());
+	fragment->setBoundingBox(ll, ur);
 	
 	// We have just added some text, so update the horizontal position
-	horizontalPosition_ += FontInstance::boundingBoxWidth(text) * format->scale();
+	horizontalPosition_ += (ur.x - ll.x) * format->scale();
 
 	return true;
 }
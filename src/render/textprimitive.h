@@ -24,6 +24,8 @@
 
 #include "render/textfragment.h"
 #include "render/textformat.h"
+#include "render/primitive.h"
+#include "render/drawqueue.h"
 #include "math/matrix.h"
 #include "math/cuboid.h"
 #include "templates/vector3.h"
@@ -34,7 +36,9 @@
 extern int TextPrimitiveParser_parse();
 
 // Forward Declarations
-/* none */
+class GLExtensions;
+class QGLContext;
+class VertexArena;
 
 // Text Primitive
 class TextPrimitive : public ListItem<TextPrimitive>
@@ -75,14 +79,56 @@ class TextPrimitive : public ListItem<TextPrimitive>
 	double textSize();
 	// Set text
 	void set(QString text, TextAnchor anchorPosition);
+	// Take fragments and layout from specified (compiled) primitive, leaving it empty
+	void takeLayout(TextPrimitive& source);
 	// Return transformation matrix to use when rendering (including fragment scale/translation if one is specified)
 	Matrix transformationMatrix(TextFragment* fragment = 0) const;
-	// Calculate bounding box of primitive
+	// Return bounding box of primitive
 	void boundingBox(Vec3<double>& lowerLeft, Vec3<double>& upperRight) const;
 	// Return total width of text primitive
 	double textWidth();
 	// Sent to GL
 	void sendToGL() const;
+	// Add to draw queue
+	void queue(DrawQueue& drawQueue, DrawQueue::Layer layer, const GLfloat* matrix, const GLfloat* colour) const;
+
+
+	/*
+	 * Layout
+	 */
+	private:
+	// Bounding box of primitive
+	Vec3<double> lowerLeft_, upperRight_;
+	// Transformation matrix for whole primitive (excluding fragment-specific operations)
+	Matrix textMatrix_;
+
+	private:
+	// Calculate bounding box of primitive from fragment data
+	void calculateBoundingBox();
+	// Calculate transformation matrix (including fragment scale/translation if one is specified)
+	Matrix calculateTransformationMatrix(TextFragment* fragment = 0) const;
+	// Update cached layout (bounding box and transformation matrices)
+	void updateLayout();
+
+
+	/*
+	 * Glyph Quads
+	 */
+	private:
+	// Textured quads for all glyphs in primitive (used when the glyph atlas is available and holds all of them)
+	Primitive glyphQuads_;
+	// Whether glyph quads have changed since the current instance was pushed
+	bool glyphQuadsChanged_;
+	// Whether the glyph quads are drawn (otherwise the FTGL font is used, e.g. if the atlas could not hold all of our glyphs)
+	bool useAtlas_;
+
+	private:
+	// Create textured glyph quads from fragment data
+	void createGlyphQuads();
+
+	public:
+	// Push instance of glyph quads, if one does not exist or the current one is out of date
+	void updateInstance(const QGLContext* context, GLExtensions* extensions, VertexArena* arena);
 
 
 	/*
@@ -20,6 +20,7 @@
 */
 
 #include "render/transform.h"
+#include "render/animationclock.h"
 
 // Constructor
 Transform::Transform() : ListItem<Transform>()
@@ -27,8 +28,9 @@ Transform::Transform() : ListItem<Transform>()
 	type_ = Transform::nTransformTypes;
 	colourOrigin_.set(1.0, 1.0, 1.0, 0.0);
 	colourDestination_.set(1.0, 1.0, 1.0, 0.0);
-	speed_ = 0.01;
-	coordinate_ = -speed_;
+	duration_ = 2.5;
+	startTime_ = -1.0;
+	coordinate_ = 0.0;
 	transforming_ = true;
 	continueAt_ = 0.9999;
 }
@@ -43,13 +45,14 @@ Transform::~Transform()
  */
 
 // Set translation transform
-void Transform::setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double speed, double continueAt)
+void Transform::setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
 {
 	type_ = Transform::TranslateTransform;
 	origin_ = origin;
 	destination_ = destination;
-	speed_ = speed;
-	coordinate_ = -speed_;
+	duration_ = duration;
+	startTime_ = -1.0;
+	coordinate_ = 0.0;
 	continueAt_ = continueAt;
 }
 
@@ -59,51 +62,67 @@ void Transform::setTranslationTransform(Vec3<double> coordinates)
 	type_ = TranslateTransform;
 	origin_ = coordinates;
 	destination_ = coordinates;
-	speed_ = 1.0;
+	duration_ = 0.0;
+	startTime_ = -1.0;
 	coordinate_ = 0.0;
 	continueAt_ = -1.0;
 }
 
 // Set colour transform
-void Transform::setColourTransform(QColor origin, QColor dest, double speed, double continueAt)
+void Transform::setColourTransform(QColor origin, QColor dest, double duration, double continueAt)
 {
 	type_ = Transform::ColourTransform;
 	colourOrigin_.set(origin.redF(), origin.greenF(), origin.blueF(), origin.alphaF());
 	colourDestination_.set(dest.redF(), dest.greenF(), dest.blueF(), dest.alphaF());
 	colourDelta_ = colourDestination_ - colourOrigin_;
-	speed_ = speed;
-	coordinate_ = -speed_;
+	duration_ = duration;
+	startTime_ = -1.0;
+	coordinate_ = 0.0;
 	continueAt_ = continueAt;
 }
 
 // Set scale transform
-void Transform::setScaleTransform(Vec3<double> origin, Vec3<double> destination, double speed, double continueAt)
+void Transform::setScaleTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt)
 {
 	type_ = Transform::ScaleTransform;
 	origin_ = origin;
 	destination_ = destination;
-	speed_ = speed;
-	coordinate_ = -speed_;
+	duration_ = duration;
+	startTime_ = -1.0;
+	coordinate_ = 0.0;
 	continueAt_ = continueAt;
 }
 
 // Set rotation transform
-void Transform::setRotationTransform(int axis, double origin, double destination, double speed, double continueAt)
+void Transform::setRotationTransform(int axis, double origin, double destination, double duration, double continueAt)
 {
 	if (axis == 0) type_ = Transform::RotateXTransform;
 	else if (axis == 1) type_ = Transform::RotateYTransform;
 	else type_ = Transform::RotateZTransform;
 	origin_.x = origin;
 	destination_.x = destination;
-	speed_ = speed;
-	coordinate_ = -speed_;
+	duration_ = duration;
+	startTime_ = -1.0;
+	coordinate_ = 0.0;
 	continueAt_ = continueAt;
 }
 
-// Apply transform to supplied QColor and Matrix, returning whether to continue with subsequent transforms
+// Apply transform (at the current animation time) to supplied QColor and Matrix, returning whether to continue with subsequent transforms
 bool Transform::applyTransform(Matrix& matrix, QColor& colour, bool progress)
 {
-	if (transforming_ && progress) coordinate_ += speed_;
+	// Coordinate is the fraction of the duration elapsed since the transform was first progressed
+	if (transforming_ && progress)
+	{
+		if (startTime_ < 0.0) startTime_ = AnimationClock::frameTime();
+		coordinate_ = (duration_ > 0.0 ? (AnimationClock::frameTime() - startTime_) / duration_ : 1.0);
+
+		// Transform finished?
+		if (coordinate_ >= 1.0)
+		{
+			coordinate_ = 1.0;
+			transforming_ = false;
+		}
+	}
 
 	Vec3<double> v;
 	Vec4<double> newColour;
@@ -136,13 +155,6 @@ bool Transform::applyTransform(Matrix& matrix, QColor& colour, bool progress)
 			break;
 	}
 
-	// Transform finished?
-	if (coordinate_ > 1.0)
-	{
-		coordinate_ = 1.0;
-		transforming_ = false;
-	}
-
 	return (coordinate_ > continueAt_);
 }
 
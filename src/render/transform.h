@@ -29,7 +29,7 @@
 // Forward Declarations
 /* none */
 
-// Transform
+// Transform (per-object transform list, superseded by AnimationStore and kept as the reference for AnimationBenchmark)
 class Transform : public ListItem<Transform>
 {
 	public:
@@ -56,8 +56,10 @@ class Transform : public ListItem<Transform>
 	Vec4<double> colourDestination_;
 	// Colour delta
 	Vec4<double> colourDelta_;
-	// Speed of transformation
-	double speed_;
+	// Duration of transformation (in seconds)
+	double duration_;
+	// Animation time at which transformation started (or -1.0 if not yet started)
+	double startTime_;
 	// Coordinate for transformation
 	double coordinate_;
 	// Whether we are transforming, or have finished
@@ -67,16 +69,16 @@ class Transform : public ListItem<Transform>
 
 	public:
 	// Set translation transform
-	void setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double speed, double continueAt = 0.0);
+	void setTranslationTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
 	// Set translation transform (no dynamics)
 	void setTranslationTransform(Vec3<double> coordinates);
 	// Set colour transform
-	void setColourTransform(QColor origin, QColor dest, double speed, double continueAt = 0.0);
+	void setColourTransform(QColor origin, QColor dest, double duration, double continueAt = 0.0);
 	// Add scale transform
-	void setScaleTransform(Vec3<double> origin, Vec3<double> destination, double speed, double continueAt = 0.0);
+	void setScaleTransform(Vec3<double> origin, Vec3<double> destination, double duration, double continueAt = 0.0);
 	// Add rotation transform
-	void setRotationTransform(int axis, double origin, double dest, double speed, double continueAt = 0.0);
-	// Apply transform to supplied QColor and Matrix, returning whether to continue with subsequent transforms
+	void setRotationTransform(int axis, double origin, double dest, double duration, double continueAt = 0.0);
+	// Apply transform (at the current animation time) to supplied QColor and Matrix, returning whether to continue with subsequent transforms
 	bool applyTransform(Matrix& matrix, QColor& colour, bool progress = true);
 	// Return current coordinate
 	double coordinate();
@@ -0,0 +1,400 @@
+/*
+	*** Vertex Arena
+	*** src/render/vertexarena.cpp
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "render/frameprofiler.h"
+#include "render/glextensions.h"
+#include "render/vertexarena.h"
+#include <stdio.h>
+
+/*
+ * Vertex Arena Range
+ */
+
+// Constructor
+VertexArenaRange::VertexArenaRange() : ListItem<VertexArenaRange>()
+{
+	arena_ = NULL;
+	block_ = NULL;
+	offset_ = 0;
+	size_ = 0;
+	pendingData_ = NULL;
+	pendingSize_ = 0;
+}
+
+// Destructor
+VertexArenaRange::~VertexArenaRange()
+{
+}
+
+// Set range definition
+void VertexArenaRange::set(VertexArena* arena, VertexArenaBlock* block, int offset, int size)
+{
+	arena_ = arena;
+	block_ = block;
+	offset_ = offset;
+	size_ = size;
+}
+
+// Return arena which owns the range
+VertexArena* VertexArenaRange::arena()
+{
+	return arena_;
+}
+
+// Return block in which the range lies
+VertexArenaBlock* VertexArenaRange::block()
+{
+	return block_;
+}
+
+// Return offset of range within block (in bytes)
+int VertexArenaRange::offset()
+{
+	return offset_;
+}
+
+// Return size of range (in bytes)
+int VertexArenaRange::size()
+{
+	return size_;
+}
+
+// Return buffer object in which the range lies
+GLuint VertexArenaRange::bufferObject()
+{
+	return (block_ ? block_->bufferObject() : 0);
+}
+
+// Set data waiting to be uploaded to the range
+void VertexArenaRange::setPendingData(const GLvoid* data, int nBytes)
+{
+	pendingData_ = data;
+	pendingSize_ = nBytes;
+}
+
+// Return data waiting to be uploaded to the range
+const GLvoid* VertexArenaRange::pendingData()
+{
+	return pendingData_;
+}
+
+// Return size of data waiting to be uploaded
+int VertexArenaRange::pendingSize()
+{
+	return pendingSize_;
+}
+
+/*
+ * Vertex Arena Block
+ */
+
+// Constructor
+VertexArenaBlock::VertexArenaBlock() : ListItem<VertexArenaBlock>()
+{
+	target_ = GL_ARRAY_BUFFER;
+	bufferObject_ = 0;
+	size_ = 0;
+	nBytesUsed_ = 0;
+}
+
+// Destructor
+VertexArenaBlock::~VertexArenaBlock()
+{
+}
+
+// Create buffer object of specified size
+bool VertexArenaBlock::create(GLExtensions* extensions, GLenum target, int size)
+{
+	target_ = target;
+	size_ = size;
+
+	// Clear the error flag
+	glGetError();
+
+	// Generate buffer object, and reserve its storage (data is uploaded later, range by range)
+	extensions->glGenBuffers(1, &bufferObject_);
+	extensions->glBindBuffer(target_, bufferObject_);
+	extensions->glBufferData(target_, size_, NULL, GL_STATIC_DRAW);
+	extensions->glBindBuffer(target_, 0);
+	if (glGetError() != GL_NO_ERROR)
+	{
+		printf("Error occurred while creating buffer object of %i bytes for VertexArena.\n", size_);
+		extensions->glDeleteBuffers(1, &bufferObject_);
+		bufferObject_ = 0;
+		return false;
+	}
+
+	// The whole buffer is free to begin with
+	freeRanges_.add()->set(NULL, this, 0, size_);
+
+	return true;
+}
+
+// Destroy buffer object
+void VertexArenaBlock::destroy(GLExtensions* extensions)
+{
+	if (bufferObject_ != 0) extensions->glDeleteBuffers(1, &bufferObject_);
+	bufferObject_ = 0;
+	freeRanges_.clear();
+}
+
+// Return buffer target
+GLenum VertexArenaBlock::target()
+{
+	return target_;
+}
+
+// Return buffer object
+GLuint VertexArenaBlock::bufferObject()
+{
+	return bufferObject_;
+}
+
+// Return size of buffer (in bytes)
+int VertexArenaBlock::size()
+{
+	return size_;
+}
+
+// Return number of bytes currently allocated
+int VertexArenaBlock::nBytesUsed()
+{
+	return nBytesUsed_;
+}
+
+// Allocate space in the buffer, returning its offset (or -1 if there is no room)
+int VertexArenaBlock::allocate(int nBytes)
+{
+	// First fit
+	for (VertexArenaRange* range = freeRanges_.first(); range != NULL; range = range->next)
+	{
+		if (range->size() < nBytes) continue;
+
+		int offset = range->offset();
+		if (range->size() == nBytes) freeRanges_.remove(range);
+		else range->set(NULL, this, offset+nBytes, range->size()-nBytes);
+		nBytesUsed_ += nBytes;
+
+		return offset;
+	}
+
+	return -1;
+}
+
+// Return space to the buffer
+void VertexArenaBlock::release(int offset, int nBytes)
+{
+	nBytesUsed_ -= nBytes;
+
+	// Find free ranges either side of the one being returned
+	VertexArenaRange* after = freeRanges_.first();
+	while (after && (after->offset() < offset)) after = after->next;
+	VertexArenaRange* before = (after ? after->prev : freeRanges_.last());
+
+	// Merge with neighbouring free ranges where possible, so the buffer doesn't fragment over time
+	if (before && ((before->offset() + before->size()) == offset))
+	{
+		before->set(NULL, this, before->offset(), before->size() + nBytes);
+		if (after && ((before->offset() + before->size()) == after->offset()))
+		{
+			before->set(NULL, this, before->offset(), before->size() + after->size());
+			freeRanges_.remove(after);
+		}
+	}
+	else if (after && ((offset + nBytes) == after->offset())) after->set(NULL, this, offset, nBytes + after->size());
+	else
+	{
+		VertexArenaRange* range = (after ? freeRanges_.insertBefore(after) : freeRanges_.add());
+		range->set(NULL, this, offset, nBytes);
+	}
+}
+
+/*
+ * Vertex Arena
+ */
+
+// Constructor
+VertexArena::VertexArena()
+{
+	extensions_ = NULL;
+	vertexBlockSize_ = 4*1024*1024;
+	indexBlockSize_ = 1024*1024;
+}
+
+// Destructor
+VertexArena::~VertexArena()
+{
+	// Primitives may outlive us, so must not be left holding ranges which refer back to our blocks
+	orphanRanges();
+}
+
+/*
+ * Blocks
+ */
+
+// Allocate range in specified list of blocks, creating a new block if necessary
+VertexArenaRange* VertexArena::allocate(List<VertexArenaBlock>& blocks, GLenum target, int blockSize, const GLvoid* data, int nBytes)
+{
+	if ((!extensions_) || (nBytes <= 0)) return NULL;
+
+	// Keep ranges aligned to 16 bytes
+	int alignedSize = ((nBytes + 15) / 16) * 16;
+
+	// Find room in an existing block
+	int offset = -1;
+	VertexArenaBlock* block;
+	for (block = blocks.first(); block != NULL; block = block->next)
+	{
+		offset = block->allocate(alignedSize);
+		if (offset != -1) break;
+	}
+
+	// No room, so create a new block (larger than standard if the data wouldn't otherwise fit)
+	if (!block)
+	{
+		block = blocks.add();
+		if (!block->create(extensions_, target, alignedSize > blockSize ? alignedSize : blockSize))
+		{
+			blocks.remove(block);
+			return NULL;
+		}
+		offset = block->allocate(alignedSize);
+	}
+
+	VertexArenaRange* range = liveRanges_.add();
+	range->set(this, block, offset, alignedSize);
+	range->setPendingData(data, nBytes);
+	pendingUploads_.add(range);
+
+	return range;
+}
+
+// Detach all allocated ranges from the arena, so that releasing them later simply deletes them
+void VertexArena::orphanRanges()
+{
+	pendingUploads_.clear();
+	VertexArenaRange* range;
+	while ((range = liveRanges_.first()) != NULL)
+	{
+		liveRanges_.disown(range);
+		range->set(NULL, NULL, 0, 0);
+		range->setPendingData(NULL, 0);
+	}
+}
+
+// Set GL extensions for the context in which the arena lives
+void VertexArena::setExtensions(GLExtensions* extensions)
+{
+	extensions_ = extensions;
+}
+
+// Allocate range for vertex data, queueing the data for upload
+VertexArenaRange* VertexArena::allocateVertices(const GLfloat* data, int nBytes)
+{
+	return allocate(vertexBlocks_, GL_ARRAY_BUFFER, vertexBlockSize_, data, nBytes);
+}
+
+// Allocate range for index data, queueing the data for upload
+VertexArenaRange* VertexArena::allocateIndices(const GLuint* data, int nBytes)
+{
+	return allocate(indexBlocks_, GL_ELEMENT_ARRAY_BUFFER, indexBlockSize_, data, nBytes);
+}
+
+// Return range to the arena which owns it, or just delete it if it has been orphaned (no GL context required)
+void VertexArena::release(VertexArenaRange* range)
+{
+	if (!range) return;
+
+	VertexArena* arena = range->arena();
+	if (!arena)
+	{
+		delete range;
+		return;
+	}
+
+	arena->pendingUploads_.remove(range);
+	if (range->block()) range->block()->release(range->offset(), range->size());
+	arena->liveRanges_.remove(range);
+}
+
+// Destroy all blocks (requires a current GL context)
+void VertexArena::clear()
+{
+	// Ranges still held by primitives would otherwise refer to blocks which no longer exist
+	orphanRanges();
+	for (VertexArenaBlock* block = vertexBlocks_.first(); block != NULL; block = block->next) block->destroy(extensions_);
+	for (VertexArenaBlock* block = indexBlocks_.first(); block != NULL; block = block->next) block->destroy(extensions_);
+	vertexBlocks_.clear();
+	indexBlocks_.clear();
+}
+
+// Return number of blocks held
+int VertexArena::nBlocks()
+{
+	return vertexBlocks_.nItems() + indexBlocks_.nItems();
+}
+
+// Return number of bytes currently allocated
+int VertexArena::nBytesUsed()
+{
+	int nBytes = 0;
+	for (VertexArenaBlock* block = vertexBlocks_.first(); block != NULL; block = block->next) nBytes += block->nBytesUsed();
+	for (VertexArenaBlock* block = indexBlocks_.first(); block != NULL; block = block->next) nBytes += block->nBytesUsed();
+	return nBytes;
+}
+
+/*
+ * Uploads
+ */
+
+// Upload all pending data (requires a current GL context)
+void VertexArena::flushUploads()
+{
+	if (pendingUploads_.nItems() == 0) return;
+
+	// Bind each buffer only when it changes - ranges are queued in allocation order, so consecutive ranges usually share a block
+	GLuint boundBuffer[2] = { 0, 0 };
+	VertexArenaRange* range;
+	int targetIndex;
+	for (RefListItem<VertexArenaRange,int>* ri = pendingUploads_.first(); ri != NULL; ri = ri->next)
+	{
+		range = ri->item;
+		targetIndex = (range->block()->target() == GL_ARRAY_BUFFER ? 0 : 1);
+		if (boundBuffer[targetIndex] != range->bufferObject())
+		{
+			boundBuffer[targetIndex] = range->bufferObject();
+			extensions_->glBindBuffer(range->block()->target(), boundBuffer[targetIndex]);
+		}
+		extensions_->glBufferSubData(range->block()->target(), range->offset(), range->pendingSize(), range->pendingData());
+		FrameProfiler::count(FrameProfiler::BufferUploadCounter);
+		range->setPendingData(NULL, 0);
+	}
+	extensions_->glBindBuffer(GL_ARRAY_BUFFER, 0);
+	extensions_->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	pendingUploads_.clear();
+}
+
+// Return whether there is data waiting to be uploaded
+bool VertexArena::hasPendingUploads()
+{
+	return (pendingUploads_.nItems() > 0);
+}
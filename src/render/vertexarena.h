@@ -0,0 +1,193 @@
+/*
+	*** Vertex Arena
+	*** src/render/vertexarena.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_VERTEXARENA_H
+#define QUAPP_VERTEXARENA_H
+
+#ifndef __APPLE__
+#include <GL/gl.h>
+#else
+#include <OpenGL/gl3.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#include "glext.h"
+#endif
+#include "templates/list.h"
+#include "templates/reflist.h"
+
+// Forward Declarations
+class GLExtensions;
+class VertexArena;
+class VertexArenaBlock;
+
+// Vertex Arena Range
+class VertexArenaRange : public ListItem<VertexArenaRange>
+{
+	public:
+	// Constructor / Destructor
+	VertexArenaRange();
+	~VertexArenaRange();
+
+
+	/*
+	 * Definition
+	 */
+	private:
+	// Arena which owns the range
+	VertexArena* arena_;
+	// Block in which the range lies
+	VertexArenaBlock* block_;
+	// Offset of range within block (in bytes)
+	int offset_;
+	// Size of range (in bytes)
+	int size_;
+	// Data waiting to be uploaded to the range (if any)
+	const GLvoid* pendingData_;
+	// Size of data waiting to be uploaded (in bytes)
+	int pendingSize_;
+
+	public:
+	// Set range definition
+	void set(VertexArena* arena, VertexArenaBlock* block, int offset, int size);
+	// Return arena which owns the range
+	VertexArena* arena();
+	// Return block in which the range lies
+	VertexArenaBlock* block();
+	// Return offset of range within block (in bytes)
+	int offset();
+	// Return size of range (in bytes)
+	int size();
+	// Return buffer object in which the range lies
+	GLuint bufferObject();
+	// Set data waiting to be uploaded to the range
+	void setPendingData(const GLvoid* data, int nBytes);
+	// Return data waiting to be uploaded to the range
+	const GLvoid* pendingData();
+	// Return size of data waiting to be uploaded
+	int pendingSize();
+};
+
+// Vertex Arena Block
+class VertexArenaBlock : public ListItem<VertexArenaBlock>
+{
+	public:
+	// Constructor / Destructor
+	VertexArenaBlock();
+	~VertexArenaBlock();
+
+
+	/*
+	 * Buffer
+	 */
+	private:
+	// Buffer target (GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER)
+	GLenum target_;
+	// Buffer object
+	GLuint bufferObject_;
+	// Size of buffer (in bytes)
+	int size_;
+	// Free ranges within buffer, in order of offset
+	List<VertexArenaRange> freeRanges_;
+	// Number of bytes currently allocated
+	int nBytesUsed_;
+
+	public:
+	// Create buffer object of specified size
+	bool create(GLExtensions* extensions, GLenum target, int size);
+	// Destroy buffer object
+	void destroy(GLExtensions* extensions);
+	// Return buffer target
+	GLenum target();
+	// Return buffer object
+	GLuint bufferObject();
+	// Return size of buffer (in bytes)
+	int size();
+	// Return number of bytes currently allocated
+	int nBytesUsed();
+	// Allocate space in the buffer, returning its offset (or -1 if there is no room)
+	int allocate(int nBytes);
+	// Return space to the buffer
+	void release(int offset, int nBytes);
+};
+
+// Vertex Arena
+class VertexArena
+{
+	public:
+	// Constructor / Destructor
+	VertexArena();
+	~VertexArena();
+
+
+	/*
+	 * Blocks
+	 */
+	private:
+	// GL extensions for the context in which the arena lives
+	GLExtensions* extensions_;
+	// Blocks for vertex data
+	List<VertexArenaBlock> vertexBlocks_;
+	// Blocks for index data
+	List<VertexArenaBlock> indexBlocks_;
+	// Standard block sizes for vertex and index data (in bytes)
+	int vertexBlockSize_, indexBlockSize_;
+	// Ranges currently allocated from the arena
+	List<VertexArenaRange> liveRanges_;
+
+	private:
+	// Allocate range in specified list of blocks, creating a new block if necessary
+	VertexArenaRange* allocate(List<VertexArenaBlock>& blocks, GLenum target, int blockSize, const GLvoid* data, int nBytes);
+	// Detach all allocated ranges from the arena, so that releasing them later simply deletes them
+	void orphanRanges();
+
+	public:
+	// Set GL extensions for the context in which the arena lives
+	void setExtensions(GLExtensions* extensions);
+	// Allocate range for vertex data, queueing the data for upload
+	VertexArenaRange* allocateVertices(const GLfloat* data, int nBytes);
+	// Allocate range for index data, queueing the data for upload
+	VertexArenaRange* allocateIndices(const GLuint* data, int nBytes);
+	// Return range to the arena which owns it, or just delete it if it has been orphaned (no GL context required)
+	static void release(VertexArenaRange* range);
+	// Destroy all blocks (requires a current GL context)
+	void clear();
+	// Return number of blocks held
+	int nBlocks();
+	// Return number of bytes currently allocated
+	int nBytesUsed();
+
+
+	/*
+	 * Uploads
+	 */
+	private:
+	// Ranges waiting for their data to be uploaded
+	RefList<VertexArenaRange,int> pendingUploads_;
+
+	public:
+	// Upload all pending data (requires a current GL context)
+	void flushUploads();
+	// Return whether there is data waiting to be uploaded
+	bool hasPendingUploads();
+};
+
+#endif
@@ -0,0 +1,153 @@
+/*
+	*** Object Pool Class
+	*** src/templates/objectpool.h
+	Copyright T. Youngs 2013-2014
+
+	This file is part of Quapp.
+
+	Quapp is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	Quapp is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Quapp.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUAPP_OBJECTPOOL_H
+#define QUAPP_OBJECTPOOL_H
+
+#include <QtCore/QMutex>
+#include <stdlib.h>
+#include <stdio.h>
+#include <new>
+
+/*!
+ * \brief Object Pool Class
+ * \details Free-list allocator for classes which are created and destroyed frequently. A class opts in by defining its own
+ * operator new / delete in terms of allocate() and release(), after which every List<T>::add() / remove() recycles storage
+ * from the pool instead of going to the heap. The object's constructor runs again on reuse, so recycled objects always start
+ * from a clean state. Storage is taken from the heap in chunks, and is never returned to it. Allocation and release are
+ * serialised by a mutex, since some pooled objects (e.g. TextFragments) are created by the scene compiler's worker thread.
+ */
+template <class T> class ObjectPool
+{
+	private:
+	// Unused slot (overlaid on released object storage)
+	struct FreeSlot
+	{
+		FreeSlot* next;
+	};
+	// Number of objects in each chunk taken from the heap
+	static const int chunkSize_ = 64;
+	// List of released slots, ready for reuse
+	static FreeSlot* freeSlots_;
+	// Next never-used slot in the current chunk
+	static char* chunkSlot_;
+	// Number of never-used slots remaining in the current chunk
+	static int nChunkSlots_;
+	// Number of chunks taken from the heap
+	static int nChunks_;
+	// Number of objects currently allocated
+	static int nLive_;
+	// Maximum number of objects allocated at any one time
+	static int nPeakLive_;
+	// Number of allocations satisfied by reusing a released slot
+	static int nPoolHits_;
+	// Total number of allocations
+	static int nAllocations_;
+	// Mutex protecting pool data
+	static QMutex mutex_;
+
+	public:
+	// Allocate storage for an object
+	static void* allocate(size_t size)
+	{
+		// Subclasses with a different size go to the heap as normal
+		if (size != sizeof(T)) return ::operator new(size);
+
+		QMutexLocker locker(&mutex_);
+		void* object;
+		if (freeSlots_ != NULL)
+		{
+			object = freeSlots_;
+			freeSlots_ = freeSlots_->next;
+			++nPoolHits_;
+		}
+		else
+		{
+			if (nChunkSlots_ == 0)
+			{
+				chunkSlot_ = (char*) ::operator new(chunkSize_*sizeof(T));
+				nChunkSlots_ = chunkSize_;
+				++nChunks_;
+			}
+			object = chunkSlot_;
+			chunkSlot_ += sizeof(T);
+			--nChunkSlots_;
+		}
+
+		++nAllocations_;
+		if (++nLive_ > nPeakLive_) nPeakLive_ = nLive_;
+
+		return object;
+	}
+	// Return storage for an object to the pool
+	static void release(void* object, size_t size)
+	{
+		if (object == NULL) return;
+		if (size != sizeof(T))
+		{
+			::operator delete(object);
+			return;
+		}
+
+		QMutexLocker locker(&mutex_);
+		FreeSlot* slot = (FreeSlot*) object;
+		slot->next = freeSlots_;
+		freeSlots_ = slot;
+		--nLive_;
+	}
+	// Return number of objects currently allocated
+	static int nLive()
+	{
+		return nLive_;
+	}
+	// Return maximum number of objects allocated at any one time
+	static int nPeakLive()
+	{
+		return nPeakLive_;
+	}
+	// Return number of allocations satisfied by reusing a released slot
+	static int nPoolHits()
+	{
+		return nPoolHits_;
+	}
+	// Return total number of allocations
+	static int nAllocations()
+	{
+		return nAllocations_;
+	}
+	// Print pool statistics
+	static void printStatistics(const char* name)
+	{
+		printf("Object pool '%s': %i live (peak %i), %i allocation(s) of which %i reused, %i chunk(s) of %i.\n", name, nLive_, nPeakLive_, nAllocations_, nPoolHits_, nChunks_, chunkSize_);
+	}
+};
+
+template <class T> typename ObjectPool<T>::FreeSlot* ObjectPool<T>::freeSlots_ = NULL;
+template <class T> char* ObjectPool<T>::chunkSlot_ = NULL;
+template <class T> int ObjectPool<T>::nChunkSlots_ = 0;
+template <class T> int ObjectPool<T>::nChunks_ = 0;
+template <class T> int ObjectPool<T>::nLive_ = 0;
+template <class T> int ObjectPool<T>::nPeakLive_ = 0;
+template <class T> int ObjectPool<T>::nPoolHits_ = 0;
+template <class T> int ObjectPool<T>::nAllocations_ = 0;
+template <class T> QMutex ObjectPool<T>::mutex_;
+
+#endif